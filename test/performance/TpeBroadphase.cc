@@ -0,0 +1,169 @@
+/*
+ * Copyright (C) 2020 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "Broadphase.hh"
+
+using namespace ignition;
+using namespace physics;
+using namespace tpelib;
+
+std::size_t gNumSteps = 100;
+
+/// \brief A crowd of boxes that each move by a small random amount per step
+struct Crowd
+{
+  /// \brief Centers of the boxes
+  std::vector<math::Vector3d> centers;
+
+  /// \brief Velocities of the boxes
+  std::vector<math::Vector3d> velocities;
+
+  /// \brief Half sizes of the boxes
+  std::vector<math::Vector3d> halfSizes;
+};
+
+/////////////////////////////////////////////////
+/// \brief Create a crowd with boxes spread over a region
+/// \param[in] _count Number of boxes
+/// \param[in] _extent Half size of the region
+/// \return Crowd with randomly placed boxes
+Crowd CreateCrowd(std::size_t _count, const math::Vector3d &_extent)
+{
+  std::mt19937 rng(1234);
+  std::uniform_real_distribution<double> dist(-1.0, 1.0);
+
+  Crowd crowd;
+  for (std::size_t i = 0; i < _count; ++i)
+  {
+    crowd.centers.emplace_back(_extent.X() * dist(rng),
+        _extent.Y() * dist(rng), _extent.Z() * dist(rng));
+    crowd.halfSizes.emplace_back(0.5, 0.5, 0.5);
+    crowd.velocities.push_back(0.05 * math::Vector3d(dist(rng), dist(rng),
+        _extent.Z() > 0.0 ? dist(rng) : 0.0));
+  }
+  return crowd;
+}
+
+/////////////////////////////////////////////////
+/// \brief Step a crowd with a broadphase and measure the average time taken
+/// to update the nodes and to find the pairs of overlapping nodes
+/// \param[in] _type Broadphase type
+/// \param[in] _crowd Crowd to simulate
+/// \param[out] _pairCount Number of pairs found in the last step
+/// \return Average time per step in microseconds
+double RunCrowd(BroadphaseType _type, Crowd _crowd, std::size_t &_pairCount)
+{
+  std::unique_ptr<Broadphase> broadphase = createBroadphase(_type);
+  broadphase->SetMargin(0.05);
+  broadphase->SetDisplacementScale(1.0);
+  for (std::size_t i = 0; i < _crowd.centers.size(); ++i)
+  {
+    broadphase->AddNode(i, math::AxisAlignedBox(
+        _crowd.centers[i] - _crowd.halfSizes[i],
+        _crowd.centers[i] + _crowd.halfSizes[i]));
+  }
+
+  std::vector<std::pair<std::size_t, std::size_t>> pairs;
+  const auto start = std::chrono::high_resolution_clock::now();
+  for (std::size_t step = 0; step < gNumSteps; ++step)
+  {
+    for (std::size_t i = 0; i < _crowd.centers.size(); ++i)
+    {
+      _crowd.centers[i] += _crowd.velocities[i];
+      broadphase->UpdateNode(i, math::AxisAlignedBox(
+          _crowd.centers[i] - _crowd.halfSizes[i],
+          _crowd.centers[i] + _crowd.halfSizes[i]));
+    }
+    broadphase->Collisions(pairs);
+  }
+  const auto finish = std::chrono::high_resolution_clock::now();
+
+  _pairCount = pairs.size();
+  const auto time = std::chrono::duration_cast<std::chrono::microseconds>(
+      finish - start).count();
+  return static_cast<double>(time) / static_cast<double>(gNumSteps);
+}
+
+/////////////////////////////////////////////////
+/// \brief Run a crowd with every broadphase type and print the timings
+/// \param[in] _name Name of the scenario
+/// \param[in] _crowd Crowd to simulate
+void CompareBroadphases(const std::string &_name, const Crowd &_crowd)
+{
+  std::size_t treePairs = 0;
+  std::size_t sapPairs = 0;
+  std::size_t gridPairs = 0;
+  const double treeTime =
+      RunCrowd(BroadphaseType::AABB_TREE, _crowd, treePairs);
+  const double sapTime =
+      RunCrowd(BroadphaseType::SWEEP_AND_PRUNE, _crowd, sapPairs);
+  const double gridTime =
+      RunCrowd(BroadphaseType::UNIFORM_GRID, _crowd, gridPairs);
+
+  std::cout << _name << " (" << _crowd.centers.size() << " boxes)\n"
+            << std::setw(18) << "AABB tree: " << std::setw(10) << treeTime
+            << " us/step, " << treePairs << " candidate pairs\n"
+            << std::setw(18) << "Sweep and prune: " << std::setw(10)
+            << sapTime << " us/step, " << sapPairs << " candidate pairs\n"
+            << std::setw(18) << "Uniform grid: " << std::setw(10)
+            << gridTime << " us/step, " << gridPairs << " candidate pairs"
+            << std::endl;
+
+  // all broadphases find every overlapping pair, but may report different
+  // candidates from their fat boxes
+  EXPECT_LT(0u, treePairs);
+  EXPECT_LT(0u, sapPairs);
+  EXPECT_LT(0u, gridPairs);
+}
+
+/////////////////////////////////////////////////
+TEST(TpeBroadphase, PlanarCrowd)
+{
+  // a crowd walking on a long, narrow ground plane
+  CompareBroadphases("Planar crowd",
+      CreateCrowd(5000, math::Vector3d(500, 10, 0)));
+}
+
+/////////////////////////////////////////////////
+TEST(TpeBroadphase, DenseCrowd)
+{
+  // a dense crowd filling a volume
+  CompareBroadphases("Dense crowd",
+      CreateCrowd(5000, math::Vector3d(15, 15, 15)));
+}
+
+/////////////////////////////////////////////////
+TEST(TpeBroadphase, Swarm)
+{
+  // a large swarm of identical agents above a ground plane
+  Crowd crowd = CreateCrowd(20000, math::Vector3d(100, 100, 5));
+  crowd.centers.push_back(math::Vector3d(0, 0, -5.5));
+  crowd.velocities.push_back(math::Vector3d::Zero);
+  crowd.halfSizes.emplace_back(200, 200, 0.5);
+  CompareBroadphases("Swarm", crowd);
+}
@@ -15,27 +15,193 @@
  *
 */
 
+#include <algorithm>
+#include <cstdint>
+#include <limits>
 #include <set>
+#include <unordered_map>
+#include <utility>
+#include <vector>
 
 #include <ignition/common/Console.hh>
 
-#include "aabb_tree/AABB.h"
-
 #include "AABBTree.hh"
 
 namespace ignition {
 namespace physics {
 namespace tpelib {
 
+/// \brief Index of an invalid node
+static const std::uint32_t kNullNode =
+    std::numeric_limits<std::uint32_t>::max();
+
+/// \brief Size of the traversal stack allocated on the calling thread by
+/// box queries
+static const std::size_t kQueryStackSize = 64u;
+
+/// \brief A node in the tree. Leaf nodes hold the box of one user node and
+/// internal nodes hold the union of the boxes of their two children.
+/// Nodes are stored contiguously and refer to each other by index.
+struct AABBTreeNode
+{
+  /// \brief Get whether this node is a leaf
+  /// \return True if the node is a leaf
+  public: bool IsLeaf() const
+  {
+    return this->left == kNullNode;
+  }
+
+  /// \brief Lower bound of box
+  public: double min[3];
+
+  /// \brief Upper bound of box
+  public: double max[3];
+
+  /// \brief Index of parent node. For nodes in the free list, this is the
+  /// index of the next free node.
+  public: std::uint32_t parent = kNullNode;
+
+  /// \brief Index of left child
+  public: std::uint32_t left = kNullNode;
+
+  /// \brief Index of right child
+  public: std::uint32_t right = kNullNode;
+
+  /// \brief Height of node. Leaves are 0 and free nodes are -1.
+  public: std::int32_t height = -1;
+
+  /// \brief Id of the user node stored in a leaf
+  public: std::size_t id = 0u;
+};
+
+/// \brief Bookkeeping for a user node
+struct AABBTreeLeaf
+{
+  /// \brief Index of the leaf node in the tree
+  public: std::uint32_t node = kNullNode;
+
+  /// \brief Lower bound of the tight box
+  public: double min[3];
+
+  /// \brief Upper bound of the tight box
+  public: double max[3];
+};
+
+/// \brief Get whether two boxes overlap. Touching boxes are considered
+/// overlapping.
+/// \param[in] _min1 Lower bound of first box
+/// \param[in] _max1 Upper bound of first box
+/// \param[in] _min2 Lower bound of second box
+/// \param[in] _max2 Upper bound of second box
+/// \return True if the boxes overlap
+static inline bool BoxesOverlap(const double *_min1, const double *_max1,
+    const double *_min2, const double *_max2)
+{
+  return _max1[0] >= _min2[0] && _min1[0] <= _max2[0] &&
+         _max1[1] >= _min2[1] && _min1[1] <= _max2[1] &&
+         _max1[2] >= _min2[2] && _min1[2] <= _max2[2];
+}
+
 /// \brief Private data class for AABBTree
 class AABBTreePrivate
 {
-  /// \brief Pointer to the AABB tree
-  public: std::unique_ptr<aabb::Tree> aabbTree;
+  /// \brief Allocate a node, reusing nodes from the free list if possible
+  /// \return Index of the new node
+  public: std::uint32_t AllocateNode();
+
+  /// \brief Return a node to the free list
+  /// \param[in] _node Index of node to free
+  public: void FreeNode(std::uint32_t _node);
+
+  /// \brief Insert a leaf into the tree
+  /// \param[in] _leaf Index of the leaf node
+  public: void InsertLeaf(std::uint32_t _leaf);
+
+  /// \brief Remove a leaf from the tree. The leaf node is not freed.
+  /// \param[in] _leaf Index of the leaf node
+  public: void RemoveLeaf(std::uint32_t _leaf);
+
+  /// \brief Perform a left or right rotation if the node is imbalanced
+  /// \param[in] _node Index of node to balance
+  /// \return Index of the new root of the sub-tree
+  public: std::uint32_t Balance(std::uint32_t _node);
+
+  /// \brief Refit the boxes and heights of all ancestors of a node,
+  /// rebalancing along the way
+  /// \param[in] _node Index of the first node to refit
+  public: void Refit(std::uint32_t _node);
 
-  /// \brief A map of node id and its AABB object in the tree
-  // public: std::unordered_map<std::size_t, unsigned int> nodeIds;
-  public: std::set<std::size_t> nodeIds;
+  /// \brief Set the box of a node to the union of the boxes of two nodes
+  /// \param[in] _node Index of node to set
+  /// \param[in] _a Index of first node
+  /// \param[in] _b Index of second node
+  public: void Merge(std::uint32_t _node, std::uint32_t _a,
+      std::uint32_t _b);
+
+  /// \brief Set the tight box of a leaf
+  /// \param[in] _leaf Leaf to set
+  /// \param[in] _aabb New box
+  public: void SetTightBox(AABBTreeLeaf &_leaf,
+      const math::AxisAlignedBox &_aabb);
+
+  /// \brief Set the box of a leaf node to the fat box of a leaf
+  /// \param[in] _leaf Leaf whose tight box is enlarged
+  /// \param[in] _displacement Displacement of the tight box since the last
+  /// update
+  public: void SetFatBox(const AABBTreeLeaf &_leaf,
+      const double *_displacement);
+
+  /// \brief Get whether the fat box of a leaf node still needs no update
+  /// for the new tight box of a leaf, i.e. it contains the tight box and is
+  /// not excessively large.
+  /// \param[in] _leaf Leaf with the new tight box
+  /// \param[in] _displacement Displacement of the tight box since the last
+  /// update
+  /// \return True if the leaf does not need to be reinserted
+  public: bool FatBoxValid(const AABBTreeLeaf &_leaf,
+      const double *_displacement) const;
+
+  /// \brief Get whether the boxes of two nodes overlap. Touching boxes are
+  /// considered overlapping.
+  /// \param[in] _a Index of first node
+  /// \param[in] _b Index of second node
+  /// \return True if the boxes overlap
+  public: bool Overlaps(std::uint32_t _a, std::uint32_t _b) const;
+
+  /// \brief Get the surface area of a node's box
+  /// \param[in] _node Index of node
+  /// \return Surface area
+  public: double SurfaceArea(std::uint32_t _node) const;
+
+  /// \brief Get the surface area of the union of the boxes of two nodes
+  /// \param[in] _a Index of first node
+  /// \param[in] _b Index of second node
+  /// \return Surface area of the combined box
+  public: double MergedSurfaceArea(std::uint32_t _a, std::uint32_t _b) const;
+
+  /// \brief Contiguous node storage
+  public: std::vector<AABBTreeNode> nodes;
+
+  /// \brief Index of root node
+  public: std::uint32_t root = kNullNode;
+
+  /// \brief Index of the first node in the free list
+  public: std::uint32_t freeList = kNullNode;
+
+  /// \brief A map of user node id to its leaf
+  public: std::unordered_map<std::size_t, AABBTreeLeaf> leaves;
+
+  /// \brief Margin used to enlarge the tight boxes
+  public: double margin = 0.0;
+
+  /// \brief Scale applied to displacement when enlarging the tight boxes
+  public: double displacementScale = 0.0;
+
+  /// \brief Traversal stack reused by queries
+  public: std::vector<std::uint32_t> stack;
+
+  /// \brief Node pair stack reused by the self-traversal
+  public: std::vector<std::pair<std::uint32_t, std::uint32_t>> pairStack;
 };
 }
 }
@@ -45,11 +211,311 @@ using namespace ignition;
 using namespace physics;
 using namespace tpelib;
 
+//////////////////////////////////////////////////
+std::uint32_t AABBTreePrivate::AllocateNode()
+{
+  std::uint32_t node;
+  if (this->freeList != kNullNode)
+  {
+    node = this->freeList;
+    this->freeList = this->nodes[node].parent;
+  }
+  else
+  {
+    node = static_cast<std::uint32_t>(this->nodes.size());
+    this->nodes.emplace_back();
+  }
+
+  AABBTreeNode &n = this->nodes[node];
+  n.parent = kNullNode;
+  n.left = kNullNode;
+  n.right = kNullNode;
+  n.height = 0;
+  return node;
+}
+
+//////////////////////////////////////////////////
+void AABBTreePrivate::FreeNode(std::uint32_t _node)
+{
+  this->nodes[_node].parent = this->freeList;
+  this->nodes[_node].height = -1;
+  this->freeList = _node;
+}
+
+//////////////////////////////////////////////////
+void AABBTreePrivate::SetTightBox(AABBTreeLeaf &_leaf,
+    const math::AxisAlignedBox &_aabb)
+{
+  _leaf.min[0] = _aabb.Min().X();
+  _leaf.min[1] = _aabb.Min().Y();
+  _leaf.min[2] = _aabb.Min().Z();
+  _leaf.max[0] = _aabb.Max().X();
+  _leaf.max[1] = _aabb.Max().Y();
+  _leaf.max[2] = _aabb.Max().Z();
+}
+
+//////////////////////////////////////////////////
+void AABBTreePrivate::SetFatBox(const AABBTreeLeaf &_leaf,
+    const double *_displacement)
+{
+  AABBTreeNode &n = this->nodes[_leaf.node];
+  fattenBox(_leaf.min, _leaf.max, this->margin, this->displacementScale,
+      _displacement, n.min, n.max);
+}
+
+//////////////////////////////////////////////////
+bool AABBTreePrivate::FatBoxValid(const AABBTreeLeaf &_leaf,
+    const double *_displacement) const
+{
+  const AABBTreeNode &n = this->nodes[_leaf.node];
+  return fatBoxValid(_leaf.min, _leaf.max, n.min, n.max, this->margin,
+      this->displacementScale, _displacement);
+}
+
+//////////////////////////////////////////////////
+void AABBTreePrivate::Merge(std::uint32_t _node, std::uint32_t _a,
+    std::uint32_t _b)
+{
+  AABBTreeNode &n = this->nodes[_node];
+  const AABBTreeNode &a = this->nodes[_a];
+  const AABBTreeNode &b = this->nodes[_b];
+  for (int i = 0; i < 3; ++i)
+  {
+    n.min[i] = std::min(a.min[i], b.min[i]);
+    n.max[i] = std::max(a.max[i], b.max[i]);
+  }
+}
+
+//////////////////////////////////////////////////
+bool AABBTreePrivate::Overlaps(std::uint32_t _a, std::uint32_t _b) const
+{
+  const AABBTreeNode &a = this->nodes[_a];
+  const AABBTreeNode &b = this->nodes[_b];
+  return a.max[0] >= b.min[0] && a.min[0] <= b.max[0] &&
+         a.max[1] >= b.min[1] && a.min[1] <= b.max[1] &&
+         a.max[2] >= b.min[2] && a.min[2] <= b.max[2];
+}
+
+//////////////////////////////////////////////////
+double AABBTreePrivate::SurfaceArea(std::uint32_t _node) const
+{
+  const AABBTreeNode &n = this->nodes[_node];
+  double x = n.max[0] - n.min[0];
+  double y = n.max[1] - n.min[1];
+  double z = n.max[2] - n.min[2];
+  return 2.0 * (x * y + y * z + z * x);
+}
+
+//////////////////////////////////////////////////
+double AABBTreePrivate::MergedSurfaceArea(std::uint32_t _a,
+    std::uint32_t _b) const
+{
+  const AABBTreeNode &a = this->nodes[_a];
+  const AABBTreeNode &b = this->nodes[_b];
+  double x = std::max(a.max[0], b.max[0]) - std::min(a.min[0], b.min[0]);
+  double y = std::max(a.max[1], b.max[1]) - std::min(a.min[1], b.min[1]);
+  double z = std::max(a.max[2], b.max[2]) - std::min(a.min[2], b.min[2]);
+  return 2.0 * (x * y + y * z + z * x);
+}
+
+//////////////////////////////////////////////////
+void AABBTreePrivate::InsertLeaf(std::uint32_t _leaf)
+{
+  if (this->root == kNullNode)
+  {
+    this->root = _leaf;
+    this->nodes[_leaf].parent = kNullNode;
+    return;
+  }
+
+  // Find the best sibling for the new leaf using the surface area
+  // heuristic: descend into the child that results in the smallest increase
+  // in total surface area, and stop when pairing with the current node is
+  // cheaper than descending any further.
+  std::uint32_t index = this->root;
+  while (!this->nodes[index].IsLeaf())
+  {
+    std::uint32_t left = this->nodes[index].left;
+    std::uint32_t right = this->nodes[index].right;
+
+    double area = this->SurfaceArea(index);
+    double combinedArea = this->MergedSurfaceArea(index, _leaf);
+
+    // cost of creating a new parent for this node and the new leaf
+    double cost = 2.0 * combinedArea;
+
+    // minimum cost of pushing the leaf further down the tree
+    double inheritanceCost = 2.0 * (combinedArea - area);
+
+    // cost of descending into each child
+    double costLeft = this->MergedSurfaceArea(left, _leaf) + inheritanceCost;
+    if (!this->nodes[left].IsLeaf())
+      costLeft -= this->SurfaceArea(left);
+
+    double costRight = this->MergedSurfaceArea(right, _leaf) +
+        inheritanceCost;
+    if (!this->nodes[right].IsLeaf())
+      costRight -= this->SurfaceArea(right);
+
+    if (cost < costLeft && cost < costRight)
+      break;
+
+    index = costLeft < costRight ? left : right;
+  }
+
+  std::uint32_t sibling = index;
+
+  // create a new parent for the sibling and the new leaf
+  std::uint32_t oldParent = this->nodes[sibling].parent;
+  std::uint32_t newParent = this->AllocateNode();
+  this->nodes[newParent].parent = oldParent;
+  this->nodes[newParent].height = this->nodes[sibling].height + 1;
+  this->nodes[newParent].left = sibling;
+  this->nodes[newParent].right = _leaf;
+  this->Merge(newParent, sibling, _leaf);
+  this->nodes[sibling].parent = newParent;
+  this->nodes[_leaf].parent = newParent;
+
+  if (oldParent != kNullNode)
+  {
+    if (this->nodes[oldParent].left == sibling)
+      this->nodes[oldParent].left = newParent;
+    else
+      this->nodes[oldParent].right = newParent;
+  }
+  else
+  {
+    this->root = newParent;
+  }
+
+  this->Refit(this->nodes[_leaf].parent);
+}
+
+//////////////////////////////////////////////////
+void AABBTreePrivate::RemoveLeaf(std::uint32_t _leaf)
+{
+  if (_leaf == this->root)
+  {
+    this->root = kNullNode;
+    return;
+  }
+
+  std::uint32_t parent = this->nodes[_leaf].parent;
+  std::uint32_t grandParent = this->nodes[parent].parent;
+  std::uint32_t sibling = this->nodes[parent].left == _leaf ?
+      this->nodes[parent].right : this->nodes[parent].left;
+
+  if (grandParent != kNullNode)
+  {
+    // destroy parent and connect sibling to grand parent
+    if (this->nodes[grandParent].left == parent)
+      this->nodes[grandParent].left = sibling;
+    else
+      this->nodes[grandParent].right = sibling;
+    this->nodes[sibling].parent = grandParent;
+    this->FreeNode(parent);
+
+    this->Refit(grandParent);
+  }
+  else
+  {
+    this->root = sibling;
+    this->nodes[sibling].parent = kNullNode;
+    this->FreeNode(parent);
+  }
+}
+
+//////////////////////////////////////////////////
+void AABBTreePrivate::Refit(std::uint32_t _node)
+{
+  std::uint32_t index = _node;
+  while (index != kNullNode)
+  {
+    index = this->Balance(index);
+
+    std::uint32_t left = this->nodes[index].left;
+    std::uint32_t right = this->nodes[index].right;
+    this->nodes[index].height = 1 + std::max(this->nodes[left].height,
+        this->nodes[right].height);
+    this->Merge(index, left, right);
+
+    index = this->nodes[index].parent;
+  }
+}
+
+//////////////////////////////////////////////////
+std::uint32_t AABBTreePrivate::Balance(std::uint32_t _node)
+{
+  std::uint32_t a = _node;
+  if (this->nodes[a].IsLeaf() || this->nodes[a].height < 2)
+    return a;
+
+  std::uint32_t b = this->nodes[a].left;
+  std::uint32_t c = this->nodes[a].right;
+  int balance = this->nodes[c].height - this->nodes[b].height;
+
+  // rotate c up if the right branch is too deep, or b up if the left branch
+  // is too deep. The two cases are mirror images of each other so they share
+  // the same code with the roles of the children swapped.
+  if (balance > 1 || balance < -1)
+  {
+    bool rotateRight = balance > 1;
+    std::uint32_t up = rotateRight ? c : b;
+    std::uint32_t other = rotateRight ? b : c;
+    std::uint32_t f = this->nodes[up].left;
+    std::uint32_t g = this->nodes[up].right;
+
+    // swap a and up
+    this->nodes[up].left = a;
+    this->nodes[up].parent = this->nodes[a].parent;
+    this->nodes[a].parent = up;
+
+    // a's old parent should point to up
+    std::uint32_t upParent = this->nodes[up].parent;
+    if (upParent != kNullNode)
+    {
+      if (this->nodes[upParent].left == a)
+        this->nodes[upParent].left = up;
+      else
+        this->nodes[upParent].right = up;
+    }
+    else
+    {
+      this->root = up;
+    }
+
+    // keep the taller grand child under up and give the other one to a
+    std::uint32_t keep = f;
+    std::uint32_t give = g;
+    if (this->nodes[g].height > this->nodes[f].height)
+    {
+      keep = g;
+      give = f;
+    }
+    this->nodes[up].right = keep;
+    if (rotateRight)
+      this->nodes[a].right = give;
+    else
+      this->nodes[a].left = give;
+    this->nodes[give].parent = a;
+
+    this->Merge(a, other, give);
+    this->Merge(up, a, keep);
+    this->nodes[a].height = 1 + std::max(this->nodes[other].height,
+        this->nodes[give].height);
+    this->nodes[up].height = 1 + std::max(this->nodes[a].height,
+        this->nodes[keep].height);
+
+    return up;
+  }
+
+  return a;
+}
+
 //////////////////////////////////////////////////
 AABBTree::AABBTree()
-  : dataPtr(new ::tpelib::AABBTreePrivate)
+  : dataPtr(new AABBTreePrivate)
 {
-  this->dataPtr->aabbTree = std::make_unique<aabb::Tree>(3, 0.0, 100000);
 }
 
 //////////////////////////////////////////////////
@@ -57,36 +523,64 @@ AABBTree::~AABBTree()
 {
 }
 
+//////////////////////////////////////////////////
+void AABBTree::SetMargin(double _margin)
+{
+  this->dataPtr->margin = std::max(0.0, _margin);
+}
+
+//////////////////////////////////////////////////
+double AABBTree::Margin() const
+{
+  return this->dataPtr->margin;
+}
+
+//////////////////////////////////////////////////
+void AABBTree::SetDisplacementScale(double _scale)
+{
+  this->dataPtr->displacementScale = std::max(0.0, _scale);
+}
+
+//////////////////////////////////////////////////
+double AABBTree::DisplacementScale() const
+{
+  return this->dataPtr->displacementScale;
+}
+
 //////////////////////////////////////////////////
 void AABBTree::AddNode(std::size_t _id, const math::AxisAlignedBox &_aabb)
 {
-  std::vector<double> lowerBound(3);
-  lowerBound[0] = _aabb.Min().X();
-  lowerBound[1] = _aabb.Min().Y();
-  lowerBound[2] = _aabb.Min().Z();
+  if (this->dataPtr->leaves.find(_id) != this->dataPtr->leaves.end())
+  {
+    ignerr << "Unable to add node '" << _id << "'. "
+           << "Node already exists." << std::endl;
+    return;
+  }
 
-  std::vector<double> upperBound(3);
-  upperBound[0] = _aabb.Max().X();
-  upperBound[1] = _aabb.Max().Y();
-  upperBound[2] = _aabb.Max().Z();
+  AABBTreeLeaf &leaf = this->dataPtr->leaves[_id];
+  leaf.node = this->dataPtr->AllocateNode();
+  this->dataPtr->nodes[leaf.node].id = _id;
+  this->dataPtr->SetTightBox(leaf, _aabb);
 
-  this->dataPtr->aabbTree->insertParticle(_id, lowerBound, upperBound);
-  this->dataPtr->nodeIds.insert(_id);
+  const double noDisplacement[3] = {0.0, 0.0, 0.0};
+  this->dataPtr->SetFatBox(leaf, noDisplacement);
+  this->dataPtr->InsertLeaf(leaf.node);
 }
 
 //////////////////////////////////////////////////
 bool AABBTree::RemoveNode(std::size_t _id)
 {
-  auto it = this->dataPtr->nodeIds.find(_id);
-  if (it == this->dataPtr->nodeIds.end())
+  auto it = this->dataPtr->leaves.find(_id);
+  if (it == this->dataPtr->leaves.end())
   {
     ignerr << "Unable to remove node '" << _id << "'. "
            << "Node not found." << std::endl;
     return false;
   }
 
-  this->dataPtr->aabbTree->removeParticle(_id);
-  this->dataPtr->nodeIds.erase(it);
+  this->dataPtr->RemoveLeaf(it->second.node);
+  this->dataPtr->FreeNode(it->second.node);
+  this->dataPtr->leaves.erase(it);
   return true;
 }
 
@@ -94,75 +588,296 @@ bool AABBTree::RemoveNode(std::size_t _id)
 bool AABBTree::UpdateNode(std::size_t _id,
     const math::AxisAlignedBox &_aabb)
 {
-  auto it = this->dataPtr->nodeIds.find(_id);
-  if (it == this->dataPtr->nodeIds.end())
+  auto it = this->dataPtr->leaves.find(_id);
+  if (it == this->dataPtr->leaves.end())
   {
     ignerr << "Unable to update node '" << _id << "'. "
            << "Node not found." << std::endl;
     return false;
   }
 
-  std::vector<double> lowerBound(3);
-  lowerBound[0] = _aabb.Min().X();
-  lowerBound[1] = _aabb.Min().Y();
-  lowerBound[2] = _aabb.Min().Z();
-
-  std::vector<double> upperBound(3);
-  upperBound[0] = _aabb.Max().X();
-  upperBound[1] = _aabb.Max().Y();
-  upperBound[2] = _aabb.Max().Z();
+  AABBTreeLeaf &leaf = it->second;
+  double displacement[3];
+  for (int i = 0; i < 3; ++i)
+  {
+    displacement[i] = 0.5 * ((_aabb.Min()[i] + _aabb.Max()[i]) -
+        (leaf.min[i] + leaf.max[i]));
+  }
+  this->dataPtr->SetTightBox(leaf, _aabb);
 
+  // the tree structure only changes if the tight box moved out of the fat box
+  if (this->dataPtr->FatBoxValid(leaf, displacement))
+    return true;
 
-  this->dataPtr->aabbTree->updateParticle(_id, lowerBound, upperBound);
+  // reinsert the leaf. The leaf and its old parent node are recycled through
+  // the free list so no memory is allocated.
+  this->dataPtr->RemoveLeaf(leaf.node);
+  this->dataPtr->SetFatBox(leaf, displacement);
+  this->dataPtr->InsertLeaf(leaf.node);
   return true;
 }
 
 //////////////////////////////////////////////////
 unsigned int AABBTree::NodeCount() const
 {
-  return this->dataPtr->nodeIds.size();
+  return this->dataPtr->leaves.size();
 }
 
 //////////////////////////////////////////////////
 std::set<std::size_t> AABBTree::Collisions(std::size_t _id) const
 {
   std::set<std::size_t> result;
-  auto it = this->dataPtr->nodeIds.find(_id);
-  if (it == this->dataPtr->nodeIds.end())
+  auto it = this->dataPtr->leaves.find(_id);
+  if (it == this->dataPtr->leaves.end())
   {
     ignerr << "Unable to compute collisions for node '" << _id << "'. "
            << "Node not found." << std::endl;
     return result;
   }
 
-  auto collisions  = this->dataPtr->aabbTree->query(_id);
-  result = std::set<std::size_t>(collisions.begin(), collisions.end());
+  // traverse the fat boxes and check the tight boxes at the leaves
+  const AABBTreeLeaf &leaf = it->second;
+  auto &stack = this->dataPtr->stack;
+  stack.clear();
+  stack.push_back(this->dataPtr->root);
+  while (!stack.empty())
+  {
+    std::uint32_t node = stack.back();
+    stack.pop_back();
+
+    const AABBTreeNode &n = this->dataPtr->nodes[node];
+    if (node == leaf.node || !BoxesOverlap(n.min, n.max, leaf.min, leaf.max))
+      continue;
+
+    if (n.IsLeaf())
+    {
+      const AABBTreeLeaf &other = this->dataPtr->leaves.at(n.id);
+      if (BoxesOverlap(other.min, other.max, leaf.min, leaf.max))
+        result.insert(n.id);
+    }
+    else
+    {
+      stack.push_back(n.left);
+      stack.push_back(n.right);
+    }
+  }
   return result;
 }
 
+//////////////////////////////////////////////////
+void AABBTree::Collisions(const math::AxisAlignedBox &_box,
+    std::vector<std::size_t> &_ids) const
+{
+  _ids.clear();
+
+  const auto &nodes = this->dataPtr->nodes;
+  std::uint32_t root = this->dataPtr->root;
+  if (root == kNullNode)
+    return;
+
+  const double min[3] = {_box.Min().X(), _box.Min().Y(), _box.Min().Z()};
+  const double max[3] = {_box.Max().X(), _box.Max().Y(), _box.Max().Z()};
+
+  // The depth-first traversal holds at most one node per level plus one, so
+  // a small stack on the calling thread is enough for any balanced tree.
+  // Deeper trees fall back to a heap allocated stack.
+  std::uint32_t localStack[kQueryStackSize];
+  std::vector<std::uint32_t> heapStack;
+  std::uint32_t *stack = localStack;
+  if (nodes[root].height + 2 > static_cast<int>(kQueryStackSize))
+  {
+    heapStack.resize(nodes[root].height + 2);
+    stack = heapStack.data();
+  }
+
+  std::size_t size = 0u;
+  stack[size++] = root;
+  while (size > 0u)
+  {
+    const AABBTreeNode &n = nodes[stack[--size]];
+    if (!BoxesOverlap(n.min, n.max, min, max))
+      continue;
+
+    if (n.IsLeaf())
+    {
+      const AABBTreeLeaf &leaf = this->dataPtr->leaves.at(n.id);
+      if (BoxesOverlap(leaf.min, leaf.max, min, max))
+        _ids.push_back(n.id);
+    }
+    else
+    {
+      stack[size++] = n.left;
+      stack[size++] = n.right;
+    }
+  }
+}
+
+//////////////////////////////////////////////////
+void AABBTree::Collisions(
+    std::vector<std::pair<std::size_t, std::size_t>> &_pairs) const
+{
+  _pairs.clear();
+
+  const auto &nodes = this->dataPtr->nodes;
+  std::uint32_t root = this->dataPtr->root;
+  if (root == kNullNode || nodes[root].IsLeaf())
+    return;
+
+  // Each stack entry is a pair of sub-trees to test against each other.
+  // A pair with identical nodes tests the sub-tree against itself.
+  auto &stack = this->dataPtr->pairStack;
+  stack.clear();
+  stack.emplace_back(root, root);
+  while (!stack.empty())
+  {
+    std::uint32_t a = stack.back().first;
+    std::uint32_t b = stack.back().second;
+    stack.pop_back();
+
+    const AABBTreeNode &na = nodes[a];
+    if (a == b)
+    {
+      if (na.IsLeaf())
+        continue;
+      stack.emplace_back(na.left, na.left);
+      stack.emplace_back(na.right, na.right);
+      stack.emplace_back(na.left, na.right);
+      continue;
+    }
+
+    if (!this->dataPtr->Overlaps(a, b))
+      continue;
+
+    const AABBTreeNode &nb = nodes[b];
+    if (na.IsLeaf() && nb.IsLeaf())
+    {
+      if (na.id < nb.id)
+        _pairs.emplace_back(na.id, nb.id);
+      else
+        _pairs.emplace_back(nb.id, na.id);
+    }
+    // descend into the larger of the two sub-trees
+    else if (nb.IsLeaf() || (!na.IsLeaf() &&
+        this->dataPtr->SurfaceArea(a) >= this->dataPtr->SurfaceArea(b)))
+    {
+      stack.emplace_back(na.left, b);
+      stack.emplace_back(na.right, b);
+    }
+    else
+    {
+      stack.emplace_back(a, nb.left);
+      stack.emplace_back(a, nb.right);
+    }
+  }
+
+  // sort so that the result does not depend on the tree structure
+  std::sort(_pairs.begin(), _pairs.end());
+}
+
+//////////////////////////////////////////////////
+void AABBTree::Collisions(const Broadphase &_other,
+    std::vector<std::pair<std::size_t, std::size_t>> &_pairs) const
+{
+  _pairs.clear();
+
+  const auto &nodes = this->dataPtr->nodes;
+  const AABBTree *otherTree = dynamic_cast<const AABBTree *>(&_other);
+  if (!otherTree)
+  {
+    // query the other broadphase with the fat box of each leaf
+    std::vector<std::size_t> ids;
+    for (const auto &it : this->dataPtr->leaves)
+    {
+      const AABBTreeNode &n = nodes[it.second.node];
+      _other.Collisions(math::AxisAlignedBox(
+          math::Vector3d(n.min[0], n.min[1], n.min[2]),
+          math::Vector3d(n.max[0], n.max[1], n.max[2])), ids);
+      for (std::size_t id : ids)
+        _pairs.emplace_back(it.first, id);
+    }
+    std::sort(_pairs.begin(), _pairs.end());
+    return;
+  }
+
+  const AABBTree &other = *otherTree;
+  const auto &otherNodes = other.dataPtr->nodes;
+  if (this->dataPtr->root == kNullNode || other.dataPtr->root == kNullNode)
+    return;
+
+  // Each stack entry is a pair of sub-trees, the first from this tree and
+  // the second from the other tree.
+  auto &stack = this->dataPtr->pairStack;
+  stack.clear();
+  stack.emplace_back(this->dataPtr->root, other.dataPtr->root);
+  while (!stack.empty())
+  {
+    std::uint32_t a = stack.back().first;
+    std::uint32_t b = stack.back().second;
+    stack.pop_back();
+
+    const AABBTreeNode &na = nodes[a];
+    const AABBTreeNode &nb = otherNodes[b];
+    if (!BoxesOverlap(na.min, na.max, nb.min, nb.max))
+      continue;
+
+    if (na.IsLeaf() && nb.IsLeaf())
+    {
+      _pairs.emplace_back(na.id, nb.id);
+    }
+    // descend into the larger of the two sub-trees
+    else if (nb.IsLeaf() || (!na.IsLeaf() && this->dataPtr->SurfaceArea(a)
+        >= other.dataPtr->SurfaceArea(b)))
+    {
+      stack.emplace_back(na.left, b);
+      stack.emplace_back(na.right, b);
+    }
+    else
+    {
+      stack.emplace_back(a, nb.left);
+      stack.emplace_back(a, nb.right);
+    }
+  }
+
+  // sort so that the result does not depend on the tree structure
+  std::sort(_pairs.begin(), _pairs.end());
+}
+
 //////////////////////////////////////////////////
 math::AxisAlignedBox AABBTree::AABB(std::size_t _id) const
 {
-  auto it = this->dataPtr->nodeIds.find(_id);
-  if (it == this->dataPtr->nodeIds.end())
+  auto it = this->dataPtr->leaves.find(_id);
+  if (it == this->dataPtr->leaves.end())
   {
     ignerr << "Unable to get AABB for node '" << _id << "'. "
            << "Node not found." << std::endl;
     return math::AxisAlignedBox();
   }
 
-  auto aabb = this->dataPtr->aabbTree->getAABB(_id);
+  const AABBTreeLeaf &leaf = it->second;
+  return math::AxisAlignedBox(
+      math::Vector3d(leaf.min[0], leaf.min[1], leaf.min[2]),
+      math::Vector3d(leaf.max[0], leaf.max[1], leaf.max[2]));
+}
+
+//////////////////////////////////////////////////
+math::AxisAlignedBox AABBTree::FatAABB(std::size_t _id) const
+{
+  auto it = this->dataPtr->leaves.find(_id);
+  if (it == this->dataPtr->leaves.end())
+  {
+    ignerr << "Unable to get fat AABB for node '" << _id << "'. "
+           << "Node not found." << std::endl;
+    return math::AxisAlignedBox();
+  }
 
+  const AABBTreeNode &n = this->dataPtr->nodes[it->second.node];
   return math::AxisAlignedBox(
-      math::Vector3d(
-      aabb.lowerBound[0], aabb.lowerBound[1], aabb.lowerBound[2]),
-      math::Vector3d(
-      aabb.upperBound[0], aabb.upperBound[1], aabb.upperBound[2]));
+      math::Vector3d(n.min[0], n.min[1], n.min[2]),
+      math::Vector3d(n.max[0], n.max[1], n.max[2]));
 }
 
 //////////////////////////////////////////////////
 bool AABBTree::HasNode(std::size_t _id) const
 {
-  auto it = this->dataPtr->nodeIds.find(_id);
-  return it != this->dataPtr->nodeIds.end();
+  return this->dataPtr->leaves.find(_id) != this->dataPtr->leaves.end();
 }
@@ -20,12 +20,16 @@
 
 #include <memory>
 #include <set>
+#include <utility>
+#include <vector>
 
 #include <ignition/math/AxisAlignedBox.hh>
 #include <ignition/utilities/SuppressWarning.hh>
 
 #include "ignition/physics/tpelib/Export.hh"
 
+#include "Broadphase.hh"
+
 namespace ignition {
 namespace physics {
 namespace tpelib {
@@ -33,48 +37,76 @@ namespace tpelib {
 // forward declaration
 class AABBTreePrivate;
 
-class IGNITION_PHYSICS_TPELIB_VISIBLE AABBTree
+/// \brief Broadphase that stores nodes in a dynamic bounding volume
+/// hierarchy. Leaves are inserted where they increase the surface area of
+/// the tree the least and the tree is kept balanced with rotations.
+class IGNITION_PHYSICS_TPELIB_VISIBLE AABBTree : public Broadphase
 {
   /// \brief Constructor
   public: AABBTree();
 
   /// \brief Destructor
-  public: ~AABBTree();
-
-  /// \brief Add a node to the tree
-  /// \param[in] _aabb Axis aligned bounding box of the node
-  /// \param[in] _id Unique id of this node
-  public: void AddNode(std::size_t _id, const math::AxisAlignedBox &_aabb);
-
-  /// \brief Remove a node from the tree
-  /// \param[in] _id Node id
-  /// \return True if the node was successfully removed, false otherwise
-  public: bool RemoveNode(std::size_t _id);
-
-  /// \brief Update a node's axis aligned bounding box
-  /// \param[in] _id Node id
-  /// \param[in] _aabb New axis aligned bounding box
-  /// \return True if the update was successful, false otherwise
-  public: bool UpdateNode(std::size_t _id, const math::AxisAlignedBox &_aabb);
-
-  /// \brief Get the number of nodes in the tree
-  /// \return Number of nodes
-  public: unsigned int NodeCount() const;
-
-  /// \brief Get all the nodes that collide / intersect with input node
-  /// \param[in] _id Input node id
-  /// \return A set of node ids that collide with the input node
-  public: std::set<std::size_t> Collisions(std::size_t _id) const;
-
-  /// \brief Get the AABB for a node
-  /// \param[in] _id Node id
-  /// \return Node's AABB
-  public: math::AxisAlignedBox AABB(std::size_t _id) const;
-
-  /// \brief Get whether the tree has a node with specified id
-  /// \param[in] _id Node id
-  /// \return True if tree has node, false otherwise
-  public: bool HasNode(std::size_t _id) const;
+  public: ~AABBTree() override;
+
+  // Documentation inherited
+  public: void AddNode(std::size_t _id,
+      const math::AxisAlignedBox &_aabb) override;
+
+  // Documentation inherited
+  public: bool RemoveNode(std::size_t _id) override;
+
+  // Documentation inherited
+  public: bool UpdateNode(std::size_t _id,
+      const math::AxisAlignedBox &_aabb) override;
+
+  // Documentation inherited
+  public: void SetMargin(double _margin) override;
+
+  // Documentation inherited
+  public: double Margin() const override;
+
+  // Documentation inherited
+  public: void SetDisplacementScale(double _scale) override;
+
+  // Documentation inherited
+  public: double DisplacementScale() const override;
+
+  // Documentation inherited
+  public: unsigned int NodeCount() const override;
+
+  // Documentation inherited
+  public: std::set<std::size_t> Collisions(std::size_t _id) const override;
+
+  // Documentation inherited
+  public: void Collisions(const math::AxisAlignedBox &_box,
+      std::vector<std::size_t> &_ids) const override;
+
+  // Documentation inherited
+  public: void Collisions(
+      std::vector<std::pair<std::size_t, std::size_t>> &_pairs)
+      const override;
+
+  /// \brief Get all pairs of nodes in this tree and nodes in another
+  /// broadphase that may collide / intersect with each other. Two trees are
+  /// traversed against each other, otherwise the other broadphase is queried
+  /// with the fat AABB of each node in this tree.
+  /// \param[in] _other Other broadphase to check against
+  /// \param[out] _pairs Vector to be filled with pairs of node ids. The first
+  /// id of each pair is the id of the node in this tree and the second is the
+  /// id of the node in the other broadphase. Pairs are sorted. The vector is
+  /// cleared first so the same buffer can be reused across calls.
+  public: void Collisions(const Broadphase &_other,
+      std::vector<std::pair<std::size_t, std::size_t>> &_pairs)
+      const override;
+
+  // Documentation inherited
+  public: math::AxisAlignedBox AABB(std::size_t _id) const override;
+
+  // Documentation inherited
+  public: math::AxisAlignedBox FatAABB(std::size_t _id) const override;
+
+  // Documentation inherited
+  public: bool HasNode(std::size_t _id) const override;
 
   /// \brief Pointer to the private data
   IGN_UTILS_WARN_IGNORE__DLL_INTERFACE_MISSING
@@ -17,6 +17,12 @@
 
 #include <gtest/gtest.h>
 
+#include <algorithm>
+#include <map>
+#include <random>
+#include <utility>
+#include <vector>
+
 #include "AABBTree.hh"
 
 using namespace ignition;
@@ -163,3 +169,114 @@ TEST(AABBTree, AABBTree)
   result = tree.Collisions(eId);
   EXPECT_EQ(0u, result.size());
 }
+
+/////////////////////////////////////////////////
+TEST(AABBTree, CollisionPairs)
+{
+  AABBTree tree;
+  std::vector<std::pair<std::size_t, std::size_t>> pairs;
+
+  // empty tree
+  tree.Collisions(pairs);
+  EXPECT_TRUE(pairs.empty());
+
+  // single node can not collide with itself
+  tree.AddNode(1u, math::AxisAlignedBox(-math::Vector3d::One,
+      math::Vector3d::One));
+  tree.Collisions(pairs);
+  EXPECT_TRUE(pairs.empty());
+
+  // a row of unit boxes where each box overlaps only with its neighbors
+  tree.RemoveNode(1u);
+  const std::size_t count = 50u;
+  for (std::size_t i = 0u; i < count; ++i)
+  {
+    math::Vector3d center(i * 1.5, 0, 0);
+    tree.AddNode(i, math::AxisAlignedBox(center - math::Vector3d::One,
+        center + math::Vector3d::One));
+  }
+
+  // each overlapping pair is reported exactly once with the smaller id first
+  tree.Collisions(pairs);
+  ASSERT_EQ(count - 1u, pairs.size());
+  for (std::size_t i = 0u; i < pairs.size(); ++i)
+  {
+    EXPECT_EQ(i, pairs[i].first);
+    EXPECT_EQ(i + 1u, pairs[i].second);
+  }
+
+  // pairs should match the per node query results
+  std::size_t queried = 0u;
+  for (std::size_t i = 0u; i < count; ++i)
+  {
+    for (auto id : tree.Collisions(i))
+    {
+      if (id > i)
+      {
+        EXPECT_NE(pairs.end(), std::find(pairs.begin(), pairs.end(),
+            std::make_pair(i, id)));
+        queried++;
+      }
+    }
+  }
+  EXPECT_EQ(pairs.size(), queried);
+
+  // move the first box away and verify the buffer is refilled
+  EXPECT_TRUE(tree.UpdateNode(0u, math::AxisAlignedBox(
+      math::Vector3d(-40, -40, -40), math::Vector3d(-10, -10, -10))));
+  tree.Collisions(pairs);
+  ASSERT_EQ(count - 2u, pairs.size());
+  EXPECT_EQ(std::make_pair(std::size_t(1u), std::size_t(2u)), pairs.front());
+}
+
+/////////////////////////////////////////////////
+TEST(AABBTree, BoxQuery)
+{
+  std::mt19937 rng(4321);
+  std::uniform_real_distribution<double> posDist(-20.0, 20.0);
+  std::uniform_real_distribution<double> sizeDist(0.1, 3.0);
+
+  auto randomBox = [&]()
+  {
+    math::Vector3d center(posDist(rng), posDist(rng), posDist(rng));
+    math::Vector3d halfSize(sizeDist(rng), sizeDist(rng), sizeDist(rng));
+    return math::AxisAlignedBox(center - halfSize, center + halfSize);
+  };
+
+  AABBTree tree;
+  std::vector<std::size_t> ids;
+
+  // empty tree
+  tree.Collisions(randomBox(), ids);
+  EXPECT_TRUE(ids.empty());
+
+  // use a margin so the fat boxes differ from the tight boxes checked at the
+  // leaves
+  tree.SetMargin(1.0);
+  std::map<std::size_t, math::AxisAlignedBox> boxes;
+  for (std::size_t i = 0u; i < 500u; ++i)
+  {
+    boxes[i] = randomBox();
+    tree.AddNode(i, boxes[i]);
+  }
+
+  for (unsigned int i = 0u; i < 50u; ++i)
+  {
+    math::AxisAlignedBox box = randomBox();
+    std::vector<std::size_t> expected;
+    for (const auto &b : boxes)
+    {
+      if (b.second.Intersects(box))
+        expected.push_back(b.first);
+    }
+
+    tree.Collisions(box, ids);
+    std::sort(ids.begin(), ids.end());
+    EXPECT_EQ(expected, ids);
+  }
+
+  // box that does not intersect any node
+  tree.Collisions(math::AxisAlignedBox(math::Vector3d(100, 100, 100),
+      math::Vector3d(101, 101, 101)), ids);
+  EXPECT_TRUE(ids.empty());
+}
@@ -0,0 +1,95 @@
+/*
+ * Copyright (C) 2020 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <cmath>
+#include <memory>
+
+#include "AABBTree.hh"
+#include "Broadphase.hh"
+#include "SweepAndPrune.hh"
+#include "UniformGrid.hh"
+
+namespace ignition {
+namespace physics {
+namespace tpelib {
+
+//////////////////////////////////////////////////
+std::unique_ptr<Broadphase> createBroadphase(BroadphaseType _type)
+{
+  switch (_type)
+  {
+    case BroadphaseType::SWEEP_AND_PRUNE:
+      return std::make_unique<SweepAndPrune>();
+    case BroadphaseType::UNIFORM_GRID:
+      return std::make_unique<UniformGrid>();
+    case BroadphaseType::AABB_TREE:
+    default:
+      return std::make_unique<AABBTree>();
+  }
+}
+
+//////////////////////////////////////////////////
+void fattenBox(const double *_min, const double *_max, double _margin,
+    double _displacementScale, const double *_displacement,
+    double *_fatMin, double *_fatMax)
+{
+  for (int i = 0; i < 3; ++i)
+  {
+    _fatMin[i] = _min[i] - _margin;
+    _fatMax[i] = _max[i] + _margin;
+
+    // predict motion and extend the box in the direction of displacement
+    double d = _displacementScale * _displacement[i];
+    if (d < 0.0)
+      _fatMin[i] += d;
+    else
+      _fatMax[i] += d;
+  }
+}
+
+//////////////////////////////////////////////////
+bool fatBoxValid(const double *_min, const double *_max,
+    const double *_fatMin, const double *_fatMax, double _margin,
+    double _displacementScale, const double *_displacement)
+{
+  // The fat box is too large if it does not fit in the fat box computed
+  // from the current displacement, grown by 4 margins and by the predicted
+  // displacement on the trailing side. A node moving at a constant speed
+  // then keeps its fat box until it leaves it, while a fat box that grew
+  // large from a fast motion is shrunk once the node slows down, otherwise
+  // it would keep generating false candidate pairs.
+  double newFatMin[3];
+  double newFatMax[3];
+  fattenBox(_min, _max, _margin, _displacementScale, _displacement,
+      newFatMin, newFatMax);
+  for (int i = 0; i < 3; ++i)
+  {
+    if (_min[i] < _fatMin[i] || _max[i] > _fatMax[i])
+      return false;
+    const double slack = 4.0 * _margin +
+        std::abs(_displacementScale * _displacement[i]);
+    if (_fatMin[i] < newFatMin[i] - slack ||
+        _fatMax[i] > newFatMax[i] + slack)
+    {
+      return false;
+    }
+  }
+  return true;
+}
+}
+}
+}
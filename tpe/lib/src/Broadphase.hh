@@ -0,0 +1,202 @@
+/*
+ * Copyright (C) 2020 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#ifndef IGNITION_PHYSICS_TPE_LIB_SRC_BROADPHASE_HH_
+#define IGNITION_PHYSICS_TPE_LIB_SRC_BROADPHASE_HH_
+
+#include <memory>
+#include <set>
+#include <utility>
+#include <vector>
+
+#include <ignition/math/AxisAlignedBox.hh>
+
+#include "ignition/physics/tpelib/Export.hh"
+
+namespace ignition {
+namespace physics {
+namespace tpelib {
+
+/// \brief Type of broadphase used to find pairs of entities whose AABBs
+/// overlap
+enum class BroadphaseType
+{
+  /// \brief Dynamic AABB tree, see AABBTree. Suited to most worlds.
+  AABB_TREE,
+
+  /// \brief Boxes sorted along one axis, see SweepAndPrune. Suited to
+  /// worlds whose entities are spread along one axis and move by small
+  /// amounts in each step.
+  SWEEP_AND_PRUNE,
+
+  /// \brief Boxes hashed into the cells of a uniform grid, see UniformGrid.
+  /// Suited to worlds with many entities of similar size, such as swarms.
+  UNIFORM_GRID
+};
+
+/// \brief Interface of a broadphase, which stores the axis aligned bounding
+/// boxes of nodes and finds the nodes whose boxes overlap. Each node is
+/// stored with a fat AABB that is larger than its actual (tight) AABB, so
+/// nodes that move by small amounts do not need to change the broadphase's
+/// structure.
+class IGNITION_PHYSICS_TPELIB_VISIBLE Broadphase
+{
+  /// \brief Destructor
+  public: virtual ~Broadphase() = default;
+
+  /// \brief Add a node
+  /// \param[in] _aabb Axis aligned bounding box of the node
+  /// \param[in] _id Unique id of this node
+  public: virtual void AddNode(std::size_t _id,
+      const math::AxisAlignedBox &_aabb) = 0;
+
+  /// \brief Remove a node
+  /// \param[in] _id Node id
+  /// \return True if the node was successfully removed, false otherwise
+  public: virtual bool RemoveNode(std::size_t _id) = 0;
+
+  /// \brief Update a node's axis aligned bounding box
+  /// \param[in] _id Node id
+  /// \param[in] _aabb New axis aligned bounding box
+  /// \return True if the update was successful, false otherwise
+  public: virtual bool UpdateNode(std::size_t _id,
+      const math::AxisAlignedBox &_aabb) = 0;
+
+  /// \brief Set the margin used to enlarge node AABBs. Each node is stored
+  /// with a fat AABB that is larger than its actual (tight) AABB by this
+  /// margin on every side. Updating a node does not change the structure of
+  /// the broadphase as long as its tight AABB stays inside its fat AABB.
+  /// The margin takes effect the next time each node is inserted.
+  /// \param[in] _margin Margin, defaults to 0 which disables fat AABBs
+  public: virtual void SetMargin(double _margin) = 0;
+
+  /// \brief Get the margin used to enlarge node AABBs
+  /// \return AABB margin
+  public: virtual double Margin() const = 0;
+
+  /// \brief Set the scale applied to a node's displacement when it is
+  /// reinserted. The fat AABB is extended in the direction of motion by
+  /// the displacement of the tight AABB since the last update multiplied by
+  /// this scale, so nodes moving at a constant velocity are reinserted less
+  /// often.
+  /// \param[in] _scale Displacement scale, defaults to 0 which disables
+  /// extending the fat AABB in the direction of motion
+  public: virtual void SetDisplacementScale(double _scale) = 0;
+
+  /// \brief Get the scale applied to a node's displacement
+  /// \return Displacement scale
+  public: virtual double DisplacementScale() const = 0;
+
+  /// \brief Get the number of nodes
+  /// \return Number of nodes
+  public: virtual unsigned int NodeCount() const = 0;
+
+  /// \brief Get all the nodes that collide / intersect with input node
+  /// \param[in] _id Input node id
+  /// \return A set of node ids that collide with the input node
+  public: virtual std::set<std::size_t> Collisions(std::size_t _id) const = 0;
+
+  /// \brief Get all the nodes whose tight AABBs intersect with a box. This
+  /// query does not use any buffers owned by the broadphase so it can be
+  /// called from multiple threads at the same time.
+  /// \param[in] _box Box to check against
+  /// \param[out] _ids Vector to be filled with ids of the intersecting
+  /// nodes. It is cleared first so the same buffer can be reused across
+  /// calls.
+  public: virtual void Collisions(const math::AxisAlignedBox &_box,
+      std::vector<std::size_t> &_ids) const = 0;
+
+  /// \brief Get all pairs of nodes that may collide / intersect with each
+  /// other. Each pair is found only once. The pairs are found using the fat
+  /// AABBs of the nodes, so callers need to check the tight AABBs returned
+  /// by AABB() to confirm intersection. Pairs are sorted and store the
+  /// smaller node id first.
+  /// \param[out] _pairs Vector to be filled with pairs of node ids. It is
+  /// cleared first so the same buffer can be reused across calls.
+  public: virtual void Collisions(
+      std::vector<std::pair<std::size_t, std::size_t>> &_pairs) const = 0;
+
+  /// \brief Get all pairs of nodes in this broadphase and nodes in another
+  /// broadphase that may collide / intersect with each other. As with the
+  /// self query, the pairs are found using the fat AABBs of the nodes.
+  /// It is fastest when both broadphases are of the same type.
+  /// \param[in] _other Other broadphase to check against
+  /// \param[out] _pairs Vector to be filled with pairs of node ids. The first
+  /// id of each pair is the id of the node in this broadphase and the second
+  /// is the id of the node in the other broadphase. Pairs are sorted. The
+  /// vector is cleared first so the same buffer can be reused across calls.
+  public: virtual void Collisions(const Broadphase &_other,
+      std::vector<std::pair<std::size_t, std::size_t>> &_pairs) const = 0;
+
+  /// \brief Get the AABB for a node
+  /// \param[in] _id Node id
+  /// \return Node's AABB
+  public: virtual math::AxisAlignedBox AABB(std::size_t _id) const = 0;
+
+  /// \brief Get the fat AABB that a node is stored with
+  /// \param[in] _id Node id
+  /// \return Node's fat AABB
+  /// \sa SetMargin
+  public: virtual math::AxisAlignedBox FatAABB(std::size_t _id) const = 0;
+
+  /// \brief Get whether the broadphase has a node with specified id
+  /// \param[in] _id Node id
+  /// \return True if the broadphase has the node, false otherwise
+  public: virtual bool HasNode(std::size_t _id) const = 0;
+};
+
+/// \brief Create a broadphase
+/// \param[in] _type Type of broadphase
+/// \return New broadphase with no nodes
+IGNITION_PHYSICS_TPELIB_VISIBLE
+std::unique_ptr<Broadphase> createBroadphase(BroadphaseType _type);
+
+/// \brief Compute the fat box of a node from its tight box
+/// \param[in] _min Minimum corner of the tight box
+/// \param[in] _max Maximum corner of the tight box
+/// \param[in] _margin Margin added on every side
+/// \param[in] _displacementScale Scale applied to the displacement
+/// \param[in] _displacement Displacement of the tight box since the last
+/// update, used to extend the fat box in the direction of motion
+/// \param[out] _fatMin Minimum corner of the fat box
+/// \param[out] _fatMax Maximum corner of the fat box
+IGNITION_PHYSICS_TPELIB_VISIBLE
+void fattenBox(const double *_min, const double *_max, double _margin,
+    double _displacementScale, const double *_displacement,
+    double *_fatMin, double *_fatMax);
+
+/// \brief Get whether a fat box still needs no update for a new tight box,
+/// i.e. it contains the tight box and is not excessively large compared to
+/// the fat box that fattenBox would compute for the tight box.
+/// \param[in] _min Minimum corner of the tight box
+/// \param[in] _max Maximum corner of the tight box
+/// \param[in] _fatMin Minimum corner of the fat box
+/// \param[in] _fatMax Maximum corner of the fat box
+/// \param[in] _margin Margin used to compute fat boxes
+/// \param[in] _displacementScale Scale applied to the displacement
+/// \param[in] _displacement Displacement of the tight box since the last
+/// update
+/// \return True if the fat box is still valid
+IGNITION_PHYSICS_TPELIB_VISIBLE
+bool fatBoxValid(const double *_min, const double *_max,
+    const double *_fatMin, const double *_fatMax, double _margin,
+    double _displacementScale, const double *_displacement);
+}
+}
+}
+
+#endif
@@ -0,0 +1,338 @@
+/*
+ * Copyright (C) 2020 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <iterator>
+#include <map>
+#include <memory>
+#include <random>
+#include <set>
+#include <utility>
+#include <vector>
+
+#include "AABBTree.hh"
+#include "Broadphase.hh"
+#include "SweepAndPrune.hh"
+#include "UniformGrid.hh"
+
+using namespace ignition;
+using namespace physics;
+using namespace tpelib;
+
+/////////////////////////////////////////////////
+/// \brief Create a random box, a few of which are much larger than the
+/// others
+/// \param[in] _rng Random number generator
+/// \return Random box
+static math::AxisAlignedBox randomBox(std::mt19937 &_rng)
+{
+  std::uniform_real_distribution<double> posDist(-20.0, 20.0);
+  std::uniform_real_distribution<double> sizeDist(0.1, 3.0);
+  math::Vector3d center(posDist(_rng), posDist(_rng), posDist(_rng));
+  math::Vector3d halfSize(sizeDist(_rng), sizeDist(_rng), sizeDist(_rng));
+  if (_rng() % 50u == 0u)
+    halfSize *= 10.0;
+  return math::AxisAlignedBox(center - halfSize, center + halfSize);
+}
+
+/////////////////////////////////////////////////
+/// \brief Test fixture for tests that run for each type of broadphase
+template <typename T>
+class BroadphaseTest : public ::testing::Test
+{
+};
+
+using BroadphaseTypes = ::testing::Types<AABBTree, SweepAndPrune, UniformGrid>;
+TYPED_TEST_CASE(BroadphaseTest, BroadphaseTypes);
+
+/////////////////////////////////////////////////
+TEST(Broadphase, CreateBroadphase)
+{
+  EXPECT_NE(nullptr, dynamic_cast<AABBTree *>(
+      createBroadphase(BroadphaseType::AABB_TREE).get()));
+  EXPECT_NE(nullptr, dynamic_cast<SweepAndPrune *>(
+      createBroadphase(BroadphaseType::SWEEP_AND_PRUNE).get()));
+  EXPECT_NE(nullptr, dynamic_cast<UniformGrid *>(
+      createBroadphase(BroadphaseType::UNIFORM_GRID).get()));
+}
+
+/////////////////////////////////////////////////
+TYPED_TEST(BroadphaseTest, Margin)
+{
+  TypeParam broadphase;
+  EXPECT_DOUBLE_EQ(0.0, broadphase.Margin());
+  EXPECT_DOUBLE_EQ(0.0, broadphase.DisplacementScale());
+  broadphase.SetMargin(0.5);
+  EXPECT_DOUBLE_EQ(0.5, broadphase.Margin());
+  broadphase.SetDisplacementScale(2.0);
+  EXPECT_DOUBLE_EQ(2.0, broadphase.DisplacementScale());
+
+  // negative values are not allowed
+  broadphase.SetMargin(-1.0);
+  EXPECT_DOUBLE_EQ(0.0, broadphase.Margin());
+  broadphase.SetMargin(0.5);
+
+  math::AxisAlignedBox box1(
+      math::Vector3d(-0.5, -0.5, -0.5), math::Vector3d(0.5, 0.5, 0.5));
+  broadphase.AddNode(0u, box1);
+  EXPECT_EQ(box1, broadphase.AABB(0u));
+  EXPECT_EQ(math::AxisAlignedBox(math::Vector3d(-1, -1, -1),
+      math::Vector3d(1, 1, 1)), broadphase.FatAABB(0u));
+
+  // a box that only overlaps the fat box of node 0
+  math::AxisAlignedBox box2(
+      math::Vector3d(1.3, -0.5, -0.5), math::Vector3d(2.3, 0.5, 0.5));
+  broadphase.AddNode(1u, box2);
+  EXPECT_TRUE(broadphase.Collisions(0u).empty());
+  EXPECT_TRUE(broadphase.Collisions(1u).empty());
+
+  // pairs are candidates found with the fat boxes
+  std::vector<std::pair<std::size_t, std::size_t>> pairs;
+  broadphase.Collisions(pairs);
+  ASSERT_EQ(1u, pairs.size());
+  EXPECT_EQ(std::make_pair(std::size_t(0u), std::size_t(1u)), pairs[0]);
+
+  // small motion stays within the fat box, only the tight box changes
+  math::AxisAlignedBox fat = broadphase.FatAABB(0u);
+  math::AxisAlignedBox box1Moved(
+      math::Vector3d(-0.3, -0.5, -0.5), math::Vector3d(0.7, 0.5, 0.5));
+  EXPECT_TRUE(broadphase.UpdateNode(0u, box1Moved));
+  EXPECT_EQ(box1Moved, broadphase.AABB(0u));
+  EXPECT_EQ(fat, broadphase.FatAABB(0u));
+
+  // large motion extends the fat box in the direction of motion
+  box1Moved = math::AxisAlignedBox(
+      math::Vector3d(1.0, -0.5, -0.5), math::Vector3d(2.0, 0.5, 0.5));
+  EXPECT_TRUE(broadphase.UpdateNode(0u, box1Moved));
+  EXPECT_EQ(box1Moved, broadphase.AABB(0u));
+  EXPECT_EQ(math::AxisAlignedBox(math::Vector3d(0.5, -1, -1),
+      math::Vector3d(5.1, 1, 1)), broadphase.FatAABB(0u));
+  EXPECT_EQ(std::set<std::size_t>({1u}), broadphase.Collisions(0u));
+  EXPECT_EQ(std::set<std::size_t>({0u}), broadphase.Collisions(1u));
+
+  // a fat box that is too large is shrunk once the node stops moving
+  EXPECT_TRUE(broadphase.UpdateNode(0u, box1Moved));
+  EXPECT_EQ(math::AxisAlignedBox(math::Vector3d(0.5, -1, -1),
+      math::Vector3d(2.5, 1, 1)), broadphase.FatAABB(0u));
+
+  EXPECT_EQ(math::AxisAlignedBox(), broadphase.FatAABB(2u));
+}
+
+/////////////////////////////////////////////////
+TYPED_TEST(BroadphaseTest, ConstantSpeed)
+{
+  // a node moving by more than 3 margins per update keeps the fat box
+  // extended in the direction of motion until it leaves it, also without
+  // margin
+  for (double margin : {0.0, 0.1})
+  {
+    TypeParam broadphase;
+    broadphase.SetMargin(margin);
+    broadphase.SetDisplacementScale(4.0);
+    const math::Vector3d halfSize(0.5, 0.5, 0.5);
+    const math::Vector3d step(0.5, 0, 0);
+    math::Vector3d pos;
+    broadphase.AddNode(0u,
+        math::AxisAlignedBox(pos - halfSize, pos + halfSize));
+
+    // the first update sets a fat box that covers the next 4 updates
+    pos += step;
+    EXPECT_TRUE(broadphase.UpdateNode(0u,
+        math::AxisAlignedBox(pos - halfSize, pos + halfSize)));
+    const math::AxisAlignedBox fat = broadphase.FatAABB(0u);
+    EXPECT_DOUBLE_EQ(pos.X() + 0.5 + margin + 2.0, fat.Max().X());
+    for (int i = 0; i < 4; ++i)
+    {
+      pos += step;
+      EXPECT_TRUE(broadphase.UpdateNode(0u,
+          math::AxisAlignedBox(pos - halfSize, pos + halfSize)));
+      EXPECT_EQ(fat, broadphase.FatAABB(0u));
+    }
+
+    pos += step;
+    EXPECT_TRUE(broadphase.UpdateNode(0u,
+        math::AxisAlignedBox(pos - halfSize, pos + halfSize)));
+    EXPECT_NE(fat, broadphase.FatAABB(0u));
+  }
+}
+
+/////////////////////////////////////////////////
+TYPED_TEST(BroadphaseTest, RandomUpdates)
+{
+  // compare queries against brute force checks while nodes are randomly
+  // added, moved and removed
+  std::mt19937 rng(1234);
+  std::uniform_real_distribution<double> moveDist(-0.5, 0.5);
+
+  TypeParam broadphase;
+  broadphase.SetMargin(0.2);
+  broadphase.SetDisplacementScale(1.0);
+  std::map<std::size_t, math::AxisAlignedBox> boxes;
+  const std::size_t count = 300u;
+  for (std::size_t i = 0u; i < count; ++i)
+  {
+    boxes[i] = randomBox(rng);
+    broadphase.AddNode(i, boxes[i]);
+  }
+
+  std::vector<std::pair<std::size_t, std::size_t>> pairs;
+  std::vector<std::size_t> ids;
+  for (unsigned int iteration = 0u; iteration < 10u; ++iteration)
+  {
+    // move most nodes by small amounts and a few by large amounts
+    for (auto &it : boxes)
+    {
+      if (rng() % 10u == 0u)
+      {
+        it.second = randomBox(rng);
+      }
+      else
+      {
+        math::Vector3d move(moveDist(rng), moveDist(rng), moveDist(rng));
+        it.second = math::AxisAlignedBox(
+            it.second.Min() + move, it.second.Max() + move);
+      }
+      EXPECT_TRUE(broadphase.UpdateNode(it.first, it.second));
+    }
+
+    // remove a few nodes and add new ones
+    for (unsigned int i = 0u; i < 10u; ++i)
+    {
+      auto it = boxes.begin();
+      std::advance(it, rng() % boxes.size());
+      EXPECT_TRUE(broadphase.RemoveNode(it->first));
+      boxes.erase(it);
+    }
+    for (unsigned int i = 0u; i < 10u; ++i)
+    {
+      std::size_t id = count + iteration * 10u + i;
+      boxes[id] = randomBox(rng);
+      broadphase.AddNode(id, boxes[id]);
+    }
+    ASSERT_EQ(boxes.size(), broadphase.NodeCount());
+
+    // pairs include every pair of overlapping tight boxes and only pairs of
+    // overlapping fat boxes
+    std::set<std::pair<std::size_t, std::size_t>> tightPairs;
+    std::set<std::pair<std::size_t, std::size_t>> fatPairs;
+    for (auto it1 = boxes.begin(); it1 != boxes.end(); ++it1)
+    {
+      EXPECT_EQ(it1->second, broadphase.AABB(it1->first));
+
+      std::set<std::size_t> expected;
+      for (auto it2 = boxes.begin(); it2 != boxes.end(); ++it2)
+      {
+        if (it1 == it2)
+          continue;
+        if (it1->second.Intersects(it2->second))
+        {
+          expected.insert(it2->first);
+          if (it1->first < it2->first)
+            tightPairs.emplace(it1->first, it2->first);
+        }
+        if (it1->first < it2->first && broadphase.FatAABB(it1->first)
+            .Intersects(broadphase.FatAABB(it2->first)))
+        {
+          fatPairs.emplace(it1->first, it2->first);
+        }
+      }
+      EXPECT_EQ(expected, broadphase.Collisions(it1->first));
+
+      broadphase.Collisions(it1->second, ids);
+      EXPECT_EQ(expected.size() + 1u, ids.size());
+      expected.insert(it1->first);
+      EXPECT_EQ(expected, std::set<std::size_t>(ids.begin(), ids.end()));
+    }
+
+    broadphase.Collisions(pairs);
+    EXPECT_TRUE(std::is_sorted(pairs.begin(), pairs.end()));
+    std::set<std::pair<std::size_t, std::size_t>> pairSet(
+        pairs.begin(), pairs.end());
+    EXPECT_EQ(pairSet.size(), pairs.size());
+    EXPECT_TRUE(std::includes(pairSet.begin(), pairSet.end(),
+        tightPairs.begin(), tightPairs.end()));
+    EXPECT_TRUE(std::includes(fatPairs.begin(), fatPairs.end(),
+        pairSet.begin(), pairSet.end()));
+  }
+}
+
+/////////////////////////////////////////////////
+TYPED_TEST(BroadphaseTest, BroadphaseCollisionPairs)
+{
+  // pairs against each type of broadphase are the pairs of overlapping
+  // tight boxes
+  for (BroadphaseType type : {BroadphaseType::AABB_TREE,
+      BroadphaseType::SWEEP_AND_PRUNE, BroadphaseType::UNIFORM_GRID})
+  {
+    std::mt19937 rng(5678);
+    TypeParam broadphase;
+    std::unique_ptr<Broadphase> other = createBroadphase(type);
+    std::vector<std::pair<std::size_t, std::size_t>> pairs;
+
+    // empty broadphases
+    broadphase.Collisions(*other, pairs);
+    EXPECT_TRUE(pairs.empty());
+
+    std::map<std::size_t, math::AxisAlignedBox> boxes1;
+    std::map<std::size_t, math::AxisAlignedBox> boxes2;
+    for (std::size_t i = 0u; i < 200u; ++i)
+    {
+      boxes1[i] = randomBox(rng);
+      broadphase.AddNode(i, boxes1[i]);
+    }
+
+    // the other broadphase is empty
+    broadphase.Collisions(*other, pairs);
+    EXPECT_TRUE(pairs.empty());
+    other->Collisions(broadphase, pairs);
+    EXPECT_TRUE(pairs.empty());
+
+    // a ground plane and boxes with larger ids so the pairs are not
+    // reordered
+    boxes2[999u] = math::AxisAlignedBox(math::Vector3d(-100, -100, -1),
+        math::Vector3d(100, 100, 0));
+    other->AddNode(999u, boxes2[999u]);
+    for (std::size_t i = 1000u; i < 1300u; ++i)
+    {
+      boxes2[i] = randomBox(rng);
+      other->AddNode(i, boxes2[i]);
+    }
+
+    std::vector<std::pair<std::size_t, std::size_t>> expectedPairs;
+    for (const auto &b1 : boxes1)
+    {
+      for (const auto &b2 : boxes2)
+      {
+        if (b1.second.Intersects(b2.second))
+          expectedPairs.emplace_back(b1.first, b2.first);
+      }
+    }
+    EXPECT_FALSE(expectedPairs.empty());
+
+    broadphase.Collisions(*other, pairs);
+    EXPECT_EQ(expectedPairs, pairs);
+
+    // swapping the broadphases swaps the pairs
+    for (auto &p : expectedPairs)
+      std::swap(p.first, p.second);
+    std::sort(expectedPairs.begin(), expectedPairs.end());
+    other->Collisions(broadphase, pairs);
+    EXPECT_EQ(expectedPairs, pairs);
+  }
+}
@@ -15,15 +15,19 @@
  *
 */
 
+#include <memory>
+#include <utility>
+
 #include <ignition/common/Console.hh>
 
 #include "Collision.hh"
+#include "EntityPool.hh"
 
 /// \brief Private data class for Collision
 class ignition::physics::tpelib::CollisionPrivate
 {
   /// \brief Collision's geometry shape
-  public: std::shared_ptr<Shape> shape = nullptr;
+  public: std::shared_ptr<const Shape> shape = nullptr;
 
   /// \brief Collide bitmask
   public: uint16_t collideBitmask = 0xFF;
@@ -45,6 +49,13 @@ Collision::Collision(std::size_t _id)
 {
 }
 
+//////////////////////////////////////////////////
+Collision::Collision(std::size_t _id, std::shared_ptr<EntityPool> _pool)
+  : Entity(_id, std::move(_pool)),
+    dataPtr(poolNew<CollisionPrivate>(this->GetEntityPool().get()))
+{
+}
+
 //////////////////////////////////////////////////
 Collision::Collision(const Collision &_other)
   : Entity(), dataPtr(new CollisionPrivate)
@@ -62,47 +73,69 @@ Collision &Collision::operator=(const Collision &_other)
 //////////////////////////////////////////////////
 Collision::~Collision()
 {
-  delete this->dataPtr;
+  poolDelete(this->GetEntityPool().get(), this->dataPtr);
   this->dataPtr = nullptr;
 }
 
 //////////////////////////////////////////////////
 void Collision::SetShape(const Shape &_shape)
 {
+  // shapes are copied into the pool of the collision's world
+  const auto &pool = this->GetEntityPool();
+
   // \todo(anyone) use templates?
   if (_shape.GetType() == ShapeType::BOX)
   {
     const BoxShape *typedShape = static_cast<const BoxShape *>(&_shape);
-    this->dataPtr->shape.reset(new BoxShape(*typedShape));
+    this->dataPtr->shape = allocateShared<BoxShape>(pool, *typedShape);
   }
   else if (_shape.GetType() == ShapeType::CYLINDER)
   {
     const CylinderShape *typedShape =
       static_cast<const CylinderShape *>(&_shape);
-    this->dataPtr->shape.reset(new CylinderShape(*typedShape));
+    this->dataPtr->shape =
+      allocateShared<CylinderShape>(pool, *typedShape);
   }
   else if (_shape.GetType() == ShapeType::SPHERE)
   {
     const SphereShape *typedShape = dynamic_cast<const SphereShape *>(&_shape);
-    this->dataPtr->shape.reset(new SphereShape(*typedShape));
+    this->dataPtr->shape =
+      allocateShared<SphereShape>(pool, *typedShape);
   }
   else if (_shape.GetType() == ShapeType::MESH)
   {
     const MeshShape *typedShape = dynamic_cast<const MeshShape *>(&_shape);
-    this->dataPtr->shape.reset(new MeshShape(*typedShape));
+    this->dataPtr->shape = allocateShared<MeshShape>(pool, *typedShape);
   }
   else
   {
     ignwarn << "Failed to set shape." << std::endl;
+    return;
   }
+
+  if (this->GetParent())
+    this->GetParent()->ChildChanged(*this);
 }
 
 //////////////////////////////////////////////////
-Shape *Collision::GetShape() const
+const Shape *Collision::GetShape() const
 {
   return this->dataPtr->shape.get();
 }
 
+//////////////////////////////////////////////////
+void Collision::ShareShape(const Collision &_other)
+{
+  // compute the bounding box of the shape now so that it is only read
+  // afterwards, possibly by different threads
+  if (_other.dataPtr->shape)
+    _other.dataPtr->shape->GetBoundingBox();
+
+  this->dataPtr->shape = _other.dataPtr->shape;
+  if (this->GetParent())
+    this->GetParent()->ChildChanged(*this);
+}
+
 //////////////////////////////////////////////////
 math::AxisAlignedBox Collision::GetBoundingBox(bool /*_force*/) // NOLINT
 {
@@ -116,7 +149,7 @@ void Collision::SetCollideBitmask(uint16_t _mask)
 {
   this->dataPtr->collideBitmask = _mask;
   if (this->GetParent())
-    this->GetParent()->ChildrenChanged();
+    this->GetParent()->ChildChanged(*this);
 }
 
 //////////////////////////////////////////////////
@@ -42,6 +42,12 @@ class IGNITION_PHYSICS_TPELIB_VISIBLE Collision : public Entity
   /// \param[in] _id Collision id
   public: explicit Collision(std::size_t _id);
 
+  /// \brief Constructor of a collision allocated from a pool
+  /// \param[in] _id Collision id
+  /// \param[in] _pool Pool to allocate the collision's data and shape from,
+  /// null to use the heap
+  public: Collision(std::size_t _id, std::shared_ptr<EntityPool> _pool);
+
   /// \brief Copy Constructor
   /// \param[in] _other The other collision to copy from
   public: Collision(const Collision &_other);
@@ -58,9 +64,18 @@ class IGNITION_PHYSICS_TPELIB_VISIBLE Collision : public Entity
   /// \param[in] _shape shape
   public: void SetShape(const Shape &_shape);
 
-  /// \brief Get Shape
+  /// \brief Get Shape. The shape may be shared with the copies of this
+  /// collision in cloned worlds, so it is read only. Use SetShape to change
+  /// it.
   /// \return shape of collision
-  public: Shape *GetShape() const;
+  public: const Shape *GetShape() const;
+
+  /// \internal
+  /// \brief Share the shape of another collision instead of copying it.
+  /// Shapes are read only once set and SetShape replaces the shape with a
+  /// new copy, so the collisions only share it until one of them changes.
+  /// \param[in] _other Collision whose shape to share
+  public: void ShareShape(const Collision &_other);
 
   /// \brief Set collide bitmask
   /// \param[in] _mask Bitmask to set
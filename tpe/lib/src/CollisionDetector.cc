@@ -15,47 +15,293 @@
  *
 */
 
+#include <algorithm>
+#include <map>
 #include <set>
-#include <unordered_map>
+#include <utility>
+#include <vector>
 
 #include <ignition/common/Profiler.hh>
 
+#include "Collision.hh"
 #include "CollisionDetector.hh"
+#include "Model.hh"
+#include "NarrowPhase.hh"
 #include "Utils.hh"
 
 #include "AABBTree.hh"
+#include "Broadphase.hh"
+
+namespace ignition {
+namespace physics {
+namespace tpelib {
+
+/// \brief Collision shape of an entity in the broadphase
+struct BroadphaseShape
+{
+  /// \brief Id of the collision
+  public: std::size_t id = kNullEntityId;
+
+  /// \brief Collide bitmask of the collision
+  public: uint16_t collideBitmask = 0xFF;
+
+  /// \brief Geometry of the collision's shape in the entity's frame
+  public: ShapeGeometry localGeometry;
+
+  /// \brief Geometry of the collision's shape in world frame
+  public: ShapeGeometry geometry;
+};
+
+/// \brief Broadphase state of an entity
+struct BroadphaseNode
+{
+  /// \brief Pose of the entity when its AABB was last computed
+  public: math::Pose3d pose;
+
+  /// \brief Local bounding box of the entity when its AABB was last computed
+  public: math::AxisAlignedBox localBox;
+
+  /// \brief AABB of the entity in world frame
+  public: math::AxisAlignedBox aabb;
+
+  /// \brief Collide bitmask of the entity
+  public: uint16_t collideBitmask = 0xFF;
+
+  /// \brief True if the entity is in the static broadphase
+  public: bool isStatic = false;
+
+  /// \brief True if the entity changed in the current collision check
+  public: bool changed = false;
+
+  /// \brief Ids of static entities whose AABBs overlap with this entity's
+  /// AABB. Only used for static entities.
+  public: std::vector<std::size_t> staticNeighbors;
+
+  /// \brief Collision shapes of the entity. They are copied from the
+  /// entity when it changes so the narrow phase does not access entities.
+  public: std::vector<BroadphaseShape> shapes;
+
+  /// \brief AABB tree of the entity's collision shapes in the entity's
+  /// frame. Node ids are indices in the vector of shapes. Moving the entity
+  /// does not change the tree, it is only refit when shapes move relative to
+  /// the entity, e.g. when a link moves.
+  public: AABBTree shapeTree;
+};
+
+/// \brief Pair of entities in contact in a collision check
+struct ContactPair
+{
+  /// \brief Ids of the entities, smaller id first
+  public: std::pair<std::size_t, std::size_t> entities;
+
+  /// \brief Id of the contact
+  public: std::size_t id = kNullContactId;
+
+  /// \brief Index of the first contact point of the pair in the contacts of
+  /// the collision check
+  public: std::size_t first = 0u;
+
+  /// \brief Number of contact points of the pair
+  public: std::size_t count = 0u;
+};
+
+/// \brief Collect the collision shapes of an entity and its descendants
+/// \param[in] _entity Entity
+/// \param[in] _pose Pose of the entity in the frame of the root entity
+/// \param[out] _shapes Shapes to append to, with their local geometry
+/// expressed in the frame of the root entity
+static void collectShapes(Entity &_entity, const math::Pose3d &_pose,
+    std::vector<BroadphaseShape> &_shapes)
+{
+  const Collision *collision = dynamic_cast<const Collision *>(&_entity);
+  if (collision)
+  {
+    const Shape *shape = collision->GetShape();
+    BroadphaseShape s;
+    if (shape && shapeGeometry(*shape, _pose, s.localGeometry))
+    {
+      s.id = collision->GetId();
+      s.collideBitmask = collision->GetCollideBitmask();
+      _shapes.push_back(s);
+    }
+    return;
+  }
+
+  _entity.VisitChildren([&](Entity &_child)
+  {
+    collectShapes(_child, _pose * _child.GetPose(), _shapes);
+  });
+}
+
+/// \brief Get whether two vectors are exactly equal
+/// \param[in] _v1 First vector
+/// \param[in] _v2 Second vector
+/// \return True if all components are equal
+static bool sameVector(const math::Vector3d &_v1, const math::Vector3d &_v2)
+{
+  return _v1.X() == _v2.X() && _v1.Y() == _v2.Y() && _v1.Z() == _v2.Z();
+}
+
+/// \brief Get whether two shape geometries are exactly equal. The tolerances
+/// of the math comparison operators would hide small link motions.
+/// \param[in] _g1 First geometry
+/// \param[in] _g2 Second geometry
+/// \return True if the geometries have the same type, pose and size
+static bool sameGeometry(const ShapeGeometry &_g1, const ShapeGeometry &_g2)
+{
+  const math::Quaterniond &r1 = _g1.pose.Rot();
+  const math::Quaterniond &r2 = _g2.pose.Rot();
+  return _g1.type == _g2.type &&
+      sameVector(_g1.pose.Pos(), _g2.pose.Pos()) &&
+      r1.W() == r2.W() && r1.X() == r2.X() && r1.Y() == r2.Y() &&
+      r1.Z() == r2.Z() &&
+      sameVector(_g1.halfSize, _g2.halfSize) &&
+      _g1.radius == _g2.radius && _g1.halfLength == _g2.halfLength;
+}
+
+}
+}
+}
 
 /// \brief Private data class for CollisionDetector
 class ignition::physics::tpelib::CollisionDetectorPrivate
 {
-  /// \brief Helper function to check if collisions for a pair of nodes have
-  /// already been recorded or not
-  /// \param[in] _a Node A Id
-  /// \param[in] _b Node B Id
-  /// \return True if this is a duplicate collision
-  public: bool CheckDuplicateCollisionPair(std::size_t _a, std::size_t _b);
-
-  /// \brief AABB tree
-  public: AABBTree aabbTree;
-
-  /// \brief Set of entity id
-  public: std::set<std::size_t> nodeIds;
-
-  /// \brief Keep track of pairs of node ids that collided. The map is cleared
-  /// after each collision detection iteration. The key and value are:
-  ///   std::unorderd_map<node_a_id, std::unordered_map<node_b_id, collided>
-  public: std::unordered_map<std::size_t, std::unordered_map<std::size_t, bool>>
-    collisionStateMap;
+  /// \brief Move a node from the dynamic broadphase to the static
+  /// broadphase and find its overlaps with other static nodes
+  /// \param[in] _id Node id
+  /// \param[in] _node Node to move
+  public: void MakeStatic(std::size_t _id, BroadphaseNode &_node);
+
+  /// \brief Move a node from the static broadphase to the dynamic
+  /// broadphase
+  /// \param[in] _id Node id
+  /// \param[in] _node Node to move
+  public: void MakeDynamic(std::size_t _id, BroadphaseNode &_node);
+
+  /// \brief Remove a node from the static broadphase and the static pairs
+  /// \param[in] _id Node id
+  /// \param[in] _node Node to remove
+  public: void RemoveStatic(std::size_t _id, BroadphaseNode &_node);
+
+  /// \brief Assign contact ids to new contacts and find the contact events
+  /// by comparing the pairs of entities in contact against the last
+  /// collision check
+  /// \param[in,out] _contacts Contacts of the current check sorted by the
+  /// ids of the entities
+  public: void UpdateContactPairs(std::vector<Contact> &_contacts);
+
+  /// \brief Update the collision shapes of a node and refit the boxes of
+  /// the shapes that moved relative to the node's entity
+  /// \param[in] _node Node to update
+  /// \param[in] _shapes Current shapes of the node's entity
+  public: void UpdateShapes(BroadphaseNode &_node,
+      const std::vector<BroadphaseShape> &_shapes);
+
+  /// \brief Type of the broadphases
+  public: BroadphaseType broadphaseType = BroadphaseType::AABB_TREE;
+
+  /// \brief Broadphase of entities that are moving or have changed. Nodes
+  /// in it are tested against each other and against the static broadphase.
+  public: std::unique_ptr<Broadphase> dynamicBroadphase;
+
+  /// \brief Broadphase of entities that have not changed since the last
+  /// collision check. It is never updated or tested against itself.
+  public: std::unique_ptr<Broadphase> staticBroadphase;
+
+  /// \brief Broadphase state of entities in the broadphases
+  public: std::map<std::size_t, BroadphaseNode> nodes;
+
+  /// \brief Pairs of static entities whose AABBs overlap. They are found once
+  /// when an entity becomes static and stay valid until one of the entities
+  /// becomes dynamic or is removed.
+  public: std::set<std::pair<std::size_t, std::size_t>> staticPairs;
+
+  /// \brief Pairs of node ids whose AABBs overlap. The buffer is kept
+  /// across collision detection iterations to reuse its capacity.
+  public: std::vector<std::pair<std::size_t, std::size_t>> pairs;
+
+  /// \brief Pairs of dynamic and static node ids whose AABBs overlap
+  public: std::vector<std::pair<std::size_t, std::size_t>> dynamicStaticPairs;
+
+  /// \brief Ids of nodes in the dynamic broadphase
+  public: std::vector<std::size_t> dynamicIds;
+
+  /// \brief Ids of nodes that changed in the current collision check
+  public: std::vector<std::size_t> changedIds;
+
+  /// \brief Thread pool used to find contacts between pairs of nodes
+  public: std::shared_ptr<ThreadPool> threadPool;
+
+  /// \brief Contacts found in each chunk of pairs
+  public: std::vector<std::vector<Contact>> chunkContacts;
+
+  /// \brief Intersection points found in each chunk of pairs
+  public: std::vector<std::vector<math::Vector3d>> chunkPoints;
+
+  /// \brief Shapes found by the shape tree queries in each chunk of pairs
+  public: std::vector<std::vector<std::size_t>> chunkShapes;
+
+  /// \brief Collision shapes of a changed entity, used to find the shapes
+  /// that moved relative to the entity
+  public: std::vector<BroadphaseShape> shapeBuffer;
+
+  /// \brief Pairs of entities in contact in the last collision check,
+  /// sorted by the ids of the entities
+  public: std::vector<ContactPair> contactPairs;
+
+  /// \brief Pairs of entities in contact in the current collision check
+  public: std::vector<ContactPair> newContactPairs;
+
+  /// \brief Contacts found in the last collision check, sorted by the ids
+  /// of the entities. Contacts between entities that did not change since
+  /// then are copied from here.
+  public: std::vector<Contact> contacts;
+
+  /// \brief Contacts found in the current collision check. The buffer is
+  /// swapped with the contacts of the last check when the check is done, so
+  /// the contacts are never copied as a whole.
+  public: std::vector<Contact> newContacts;
+
+  /// \brief Contact events of the last collision check
+  public: std::vector<ContactEvent> events;
+
+  /// \brief Id assigned to the next pair of entities that start touching
+  public: std::size_t nextContactId = 0u;
+
+  /// \brief Value of the single contact flag in the last collision check.
+  /// The cached contacts can not be reused if it changes.
+  public: bool singleContact = false;
+
+  /// \brief Ids of entities that changed, used when the changes are not
+  /// provided by the caller
+  public: std::vector<std::size_t> changedBuffer;
+
+  /// \brief Ids of entities that were removed, used when the changes are not
+  /// provided by the caller
+  public: std::vector<std::size_t> removedBuffer;
 };
 
 using namespace ignition;
 using namespace physics;
 using namespace tpelib;
 
+/// \brief Minimum number of pairs checked by a thread. A chunk needs enough
+/// pairs to be worth waking a thread.
+static const std::size_t kMinPairsPerChunk = 64u;
+
+/// \brief Maximum number of collision shapes an entity can have for its
+/// shapes to be tested against all shapes of another entity instead of
+/// querying its shape tree
+static const std::size_t kMaxShapesWithoutTree = 4u;
+
 //////////////////////////////////////////////////
 CollisionDetector::CollisionDetector()
   : dataPtr(new CollisionDetectorPrivate)
 {
+  this->dataPtr->dynamicBroadphase =
+      createBroadphase(this->dataPtr->broadphaseType);
+  this->dataPtr->staticBroadphase =
+      createBroadphase(this->dataPtr->broadphaseType);
 }
 
 //////////////////////////////////////////////////
@@ -64,116 +310,655 @@ CollisionDetector::~CollisionDetector()
 }
 
 //////////////////////////////////////////////////
-std::vector<Contact> CollisionDetector::CheckCollisions(
-    const std::map<std::size_t, std::shared_ptr<Entity>> &_entities,
-    bool _singleContact)
+void CollisionDetectorPrivate::MakeStatic(std::size_t _id,
+    BroadphaseNode &_node)
 {
-  IGN_PROFILE("tpelib::CollisionDetector::CheckCollisions");
+  this->dynamicBroadphase->RemoveNode(_id);
+  this->staticBroadphase->AddNode(_id, _node.aabb);
+  _node.isStatic = true;
 
-  // contacts to be filled and returned
-  std::vector<Contact> contacts;
+  for (std::size_t other : this->staticBroadphase->Collisions(_id))
+  {
+    _node.staticNeighbors.push_back(other);
+    this->nodes[other].staticNeighbors.push_back(_id);
+    this->staticPairs.insert(std::minmax(_id, other));
+  }
+}
 
-  // update AABB tree
-  // remove nodes that no longer exist
-  auto nodesToCheckForRemoval = this->dataPtr->nodeIds;
-  for (auto id : nodesToCheckForRemoval)
+//////////////////////////////////////////////////
+void CollisionDetectorPrivate::MakeDynamic(std::size_t _id,
+    BroadphaseNode &_node)
+{
+  this->RemoveStatic(_id, _node);
+  this->dynamicBroadphase->AddNode(_id, _node.aabb);
+}
+
+//////////////////////////////////////////////////
+void CollisionDetectorPrivate::RemoveStatic(std::size_t _id,
+    BroadphaseNode &_node)
+{
+  for (std::size_t other : _node.staticNeighbors)
+  {
+    auto &neighbors = this->nodes[other].staticNeighbors;
+    neighbors.erase(std::find(neighbors.begin(), neighbors.end(), _id));
+    this->staticPairs.erase(std::minmax(_id, other));
+  }
+  _node.staticNeighbors.clear();
+  this->staticBroadphase->RemoveNode(_id);
+  _node.isStatic = false;
+}
+
+//////////////////////////////////////////////////
+void CollisionDetectorPrivate::UpdateShapes(BroadphaseNode &_node,
+    const std::vector<BroadphaseShape> &_shapes)
+{
+  for (std::size_t i = 0u; i < _shapes.size(); ++i)
   {
-    if (_entities.find(id) == _entities.end())
+    if (i >= _node.shapes.size())
     {
-      this->dataPtr->aabbTree.RemoveNode(id);
-      this->dataPtr->nodeIds.erase(id);
+      _node.shapes.push_back(_shapes[i]);
+      _node.shapeTree.AddNode(i, _shapes[i].localGeometry.aabb);
+      continue;
     }
+
+    BroadphaseShape &shape = _node.shapes[i];
+    shape.id = _shapes[i].id;
+    shape.collideBitmask = _shapes[i].collideBitmask;
+    if (sameGeometry(shape.localGeometry, _shapes[i].localGeometry))
+      continue;
+
+    shape.localGeometry = _shapes[i].localGeometry;
+    _node.shapeTree.UpdateNode(i, shape.localGeometry.aabb);
   }
 
-  // add and update nodes in the tree
-  for (auto it = _entities.begin(); it != _entities.end(); ++it)
+  for (std::size_t i = _shapes.size(); i < _node.shapes.size(); ++i)
+    _node.shapeTree.RemoveNode(i);
+  _node.shapes.resize(_shapes.size());
+}
+
+//////////////////////////////////////////////////
+void CollisionDetectorPrivate::UpdateContactPairs(
+    std::vector<Contact> &_contacts)
+{
+  auto addEvent = [this](ContactEventType _type, const ContactPair &_pair)
   {
-    std::shared_ptr<Entity> e = it->second;
-    // add new nodes
-    if (!this->dataPtr->aabbTree.HasNode(it->first))
-    {
-      math::AxisAlignedBox b = e->GetBoundingBox();
+    ContactEvent event;
+    event.type = _type;
+    event.id = _pair.id;
+    event.entity1 = _pair.entities.first;
+    event.entity2 = _pair.entities.second;
+    this->events.push_back(event);
+  };
 
-      if (b == math::AxisAlignedBox())
-        continue;
+  // Both the contacts and the pairs of the last check are sorted by the ids
+  // of the entities, so they are compared in a single pass.
+  this->events.clear();
+  this->newContactPairs.clear();
+  std::size_t last = 0u;
+  for (std::size_t i = 0u; i < _contacts.size();)
+  {
+    ContactPair pair;
+    pair.entities = std::make_pair(_contacts[i].entity1, _contacts[i].entity2);
+    pair.first = i;
+    while (i < _contacts.size() && _contacts[i].entity1 == pair.entities.first
+        && _contacts[i].entity2 == pair.entities.second)
+    {
+      ++i;
+    }
+    pair.count = i - pair.first;
 
-      // convert to world aabb
-      math::AxisAlignedBox aabb;
-      math::Pose3d p = e->GetPose();
-      aabb = transformAxisAlignedBox(b, p);
-      this->dataPtr->aabbTree.AddNode(e->GetId(), aabb);
+    // pairs of the last check that are not in the current check ended
+    while (last < this->contactPairs.size() &&
+        this->contactPairs[last].entities < pair.entities)
+    {
+      addEvent(ContactEventType::END, this->contactPairs[last++]);
+    }
 
-      this->dataPtr->nodeIds.insert(it->first);
+    if (last < this->contactPairs.size() &&
+        this->contactPairs[last].entities == pair.entities)
+    {
+      pair.id = this->contactPairs[last++].id;
+      addEvent(ContactEventType::PERSIST, pair);
     }
-    // update existing nodes
-    else if (e->PoseDirty())
+    else
     {
-      math::AxisAlignedBox b = e->GetBoundingBox();
+      pair.id = this->nextContactId++;
+      addEvent(ContactEventType::BEGIN, pair);
+    }
 
-      if (b == math::AxisAlignedBox())
-        continue;
+    for (std::size_t j = pair.first; j < i; ++j)
+      _contacts[j].id = pair.id;
+    this->newContactPairs.push_back(pair);
+  }
+  while (last < this->contactPairs.size())
+    addEvent(ContactEventType::END, this->contactPairs[last++]);
+
+  std::swap(this->contactPairs, this->newContactPairs);
+}
+
+//////////////////////////////////////////////////
+std::vector<ContactEvent> CollisionDetector::GetContactEvents() const
+{
+  return this->dataPtr->events;
+}
+
+//////////////////////////////////////////////////
+void CollisionDetector::SaveState(StateWriter &_writer) const
+{
+  _writer.Write(this->dataPtr->nextContactId);
+  _writer.Write(this->dataPtr->singleContact);
+
+  _writer.Write(this->dataPtr->contactPairs.size());
+  for (const auto &pair : this->dataPtr->contactPairs)
+  {
+    _writer.Write(pair.entities.first);
+    _writer.Write(pair.entities.second);
+    _writer.Write(pair.id);
+    _writer.Write(pair.first);
+    _writer.Write(pair.count);
+  }
+
+  _writer.Write(this->dataPtr->events.size());
+  for (const auto &event : this->dataPtr->events)
+  {
+    _writer.Write(static_cast<uint8_t>(event.type));
+    _writer.Write(event.id);
+    _writer.Write(event.entity1);
+    _writer.Write(event.entity2);
+  }
+}
+
+//////////////////////////////////////////////////
+bool CollisionDetector::RestoreState(StateReader &_reader,
+    std::vector<Contact> &&_contacts)
+{
+  std::size_t nextContactId = 0u;
+  bool singleContact = false;
+  std::size_t pairCount = 0u;
+  if (!_reader.Read(nextContactId) || !_reader.Read(singleContact) ||
+      !_reader.Read(pairCount) || pairCount > _contacts.size())
+  {
+    return false;
+  }
+
+  std::vector<ContactPair> contactPairs(pairCount);
+  for (auto &pair : contactPairs)
+  {
+    if (!_reader.Read(pair.entities.first) ||
+        !_reader.Read(pair.entities.second) || !_reader.Read(pair.id) ||
+        !_reader.Read(pair.first) || !_reader.Read(pair.count) ||
+        pair.first > _contacts.size() ||
+        pair.count > _contacts.size() - pair.first)
+    {
+      return false;
+    }
+  }
 
-      // convert to world aabb
-      math::AxisAlignedBox aabb;
-      math::Pose3d p = e->GetPose();
-      aabb = transformAxisAlignedBox(b, p);
-      this->dataPtr->aabbTree.UpdateNode(e->GetId(), aabb);
+  std::size_t eventCount = 0u;
+  if (!_reader.Read(eventCount))
+    return false;
+  std::vector<ContactEvent> events;
+  for (std::size_t i = 0u; i < eventCount; ++i)
+  {
+    uint8_t type = 0u;
+    ContactEvent event;
+    if (!_reader.Read(type) ||
+        type > static_cast<uint8_t>(ContactEventType::END) ||
+        !_reader.Read(event.id) || !_reader.Read(event.entity1) ||
+        !_reader.Read(event.entity2))
+    {
+      return false;
     }
+    event.type = static_cast<ContactEventType>(type);
+    events.push_back(event);
   }
 
-  // query AABB tree for collisions
+  this->dataPtr->nextContactId = nextContactId;
+  this->dataPtr->singleContact = singleContact;
+  this->dataPtr->contactPairs = std::move(contactPairs);
+  this->dataPtr->contacts = std::move(_contacts);
+  this->dataPtr->events = std::move(events);
+  return true;
+}
+
+//////////////////////////////////////////////////
+void CollisionDetector::CopyContactState(const CollisionDetector &_other,
+    const std::function<std::size_t(std::size_t)> &_mapId,
+    std::vector<Contact> &&_contacts)
+{
+  this->dataPtr->nextContactId = _other.dataPtr->nextContactId;
+  this->dataPtr->singleContact = _other.dataPtr->singleContact;
+
+  // the ids are remapped in order, so the pairs and events stay sorted
+  this->dataPtr->contactPairs = _other.dataPtr->contactPairs;
+  for (auto &pair : this->dataPtr->contactPairs)
+  {
+    pair.entities.first = _mapId(pair.entities.first);
+    pair.entities.second = _mapId(pair.entities.second);
+  }
+
+  this->dataPtr->events = _other.dataPtr->events;
+  for (auto &event : this->dataPtr->events)
+  {
+    event.entity1 = _mapId(event.entity1);
+    event.entity2 = _mapId(event.entity2);
+  }
+
+  this->dataPtr->contacts = std::move(_contacts);
+}
+
+//////////////////////////////////////////////////
+void CollisionDetector::SetThreadPool(
+    const std::shared_ptr<ThreadPool> &_threadPool)
+{
+  this->dataPtr->threadPool = _threadPool;
+}
+
+//////////////////////////////////////////////////
+void CollisionDetector::SetBroadphaseType(BroadphaseType _type)
+{
+  if (_type == this->dataPtr->broadphaseType)
+    return;
+
+  // move all nodes to new broadphases of the requested type. Static nodes
+  // stay static so the cached static pairs remain valid.
+  auto dynamicBroadphase = createBroadphase(_type);
+  auto staticBroadphase = createBroadphase(_type);
+  dynamicBroadphase->SetMargin(this->dataPtr->dynamicBroadphase->Margin());
+  dynamicBroadphase->SetDisplacementScale(
+      this->dataPtr->dynamicBroadphase->DisplacementScale());
+  for (const auto &it : this->dataPtr->nodes)
+  {
+    if (it.second.isStatic)
+      staticBroadphase->AddNode(it.first, it.second.aabb);
+    else
+      dynamicBroadphase->AddNode(it.first, it.second.aabb);
+  }
+
+  this->dataPtr->dynamicBroadphase = std::move(dynamicBroadphase);
+  this->dataPtr->staticBroadphase = std::move(staticBroadphase);
+  this->dataPtr->broadphaseType = _type;
+}
+
+//////////////////////////////////////////////////
+BroadphaseType CollisionDetector::GetBroadphaseType() const
+{
+  return this->dataPtr->broadphaseType;
+}
+
+//////////////////////////////////////////////////
+void CollisionDetector::SetAABBMargin(double _margin)
+{
+  this->dataPtr->dynamicBroadphase->SetMargin(_margin);
+}
+
+//////////////////////////////////////////////////
+double CollisionDetector::GetAABBMargin() const
+{
+  return this->dataPtr->dynamicBroadphase->Margin();
+}
+
+//////////////////////////////////////////////////
+void CollisionDetector::SetAABBDisplacementScale(double _scale)
+{
+  this->dataPtr->dynamicBroadphase->SetDisplacementScale(_scale);
+}
+
+//////////////////////////////////////////////////
+double CollisionDetector::GetAABBDisplacementScale() const
+{
+  return this->dataPtr->dynamicBroadphase->DisplacementScale();
+}
+
+//////////////////////////////////////////////////
+std::vector<Contact> CollisionDetector::CheckCollisions(
+    const std::map<std::size_t, std::shared_ptr<Entity>> &_entities,
+    bool _singleContact)
+{
+  // find entities that were removed or changed since the last check by
+  // comparing them against the state stored in the broadphase
+  auto &nodes = this->dataPtr->nodes;
+  auto &removed = this->dataPtr->removedBuffer;
+  removed.clear();
+  for (const auto &it : nodes)
+  {
+    if (_entities.find(it.first) == _entities.end())
+      removed.push_back(it.first);
+  }
+
+  auto &changed = this->dataPtr->changedBuffer;
+  changed.clear();
   for (auto it = _entities.begin(); it != _entities.end(); ++it)
   {
-    std::shared_ptr<Entity> e = it->second;
+    auto nodeIt = nodes.find(it->first);
+    if (nodeIt == nodes.end() ||
+        nodeIt->second.pose != it->second->GetPose() ||
+        nodeIt->second.localBox != it->second->GetBoundingBox() ||
+        nodeIt->second.collideBitmask != it->second->GetCollideBitmask())
+    {
+      changed.push_back(it->first);
+    }
+  }
+
+  return this->CheckCollisions(_entities, changed, removed, _singleContact);
+}
+
+//////////////////////////////////////////////////
+std::vector<Contact> CollisionDetector::CheckCollisions(
+    const std::map<std::size_t, std::shared_ptr<Entity>> &_entities,
+    const std::vector<std::size_t> &_changed,
+    const std::vector<std::size_t> &_removed,
+    bool _singleContact)
+{
+  return this->CheckCollisions(_entities, _changed, _removed,
+      _singleContact, nullptr);
+}
+
+//////////////////////////////////////////////////
+const std::vector<Contact> &CollisionDetector::CheckCollisions(
+    const std::map<std::size_t, std::shared_ptr<Entity>> &_entities,
+    const std::vector<std::size_t> &_changed,
+    const std::vector<std::size_t> &_removed,
+    bool _singleContact,
+    const std::function<math::AxisAlignedBox(const Entity &)> &_worldBox)
+{
+  IGN_PROFILE("tpelib::CollisionDetector::CheckCollisions");
 
+  // update broadphases
+  // remove nodes that no longer exist
+  auto &nodes = this->dataPtr->nodes;
+  for (std::size_t id : _removed)
+  {
+    auto it = nodes.find(id);
+    if (it == nodes.end())
+      continue;
+
+    if (it->second.isStatic)
+      this->dataPtr->RemoveStatic(it->first, it->second);
+    else
+      this->dataPtr->dynamicBroadphase->RemoveNode(it->first);
+    nodes.erase(it);
+  }
+
+  // Add and update nodes of changed entities. Changed entities are dynamic,
+  // i.e. moving, and placed in the dynamic broadphase.
+  // The world boxes of the nodes are taken from the caller or computed in
+  // batches, after which the nodes are added to or updated in the dynamic
+  // broadphase.
+  auto &changedIds = this->dataPtr->changedIds;
+  changedIds.clear();
+  auto updateNode = [&](std::size_t _id, BroadphaseNode &_node, bool _isNew)
+  {
+    // add new nodes
+    if (_isNew)
+      this->dataPtr->dynamicBroadphase->AddNode(_id, _node.aabb);
+    // update existing nodes
+    else if (_node.isStatic)
+      this->dataPtr->MakeDynamic(_id, _node);
+    else
+      this->dataPtr->dynamicBroadphase->UpdateNode(_id, _node.aabb);
+  };
+  AxisAlignedBoxBatch batch;
+  std::size_t batchIds[AxisAlignedBoxBatch::kCapacity];
+  BroadphaseNode *batchNodes[AxisAlignedBoxBatch::kCapacity];
+  bool batchNew[AxisAlignedBoxBatch::kCapacity];
+  auto flushBatch = [&]()
+  {
+    transformAxisAlignedBoxes(batch);
+    for (std::size_t i = 0u; i < batch.Size(); ++i)
+    {
+      batchNodes[i]->aabb = batch.Box(i);
+      updateNode(batchIds[i], *batchNodes[i], batchNew[i]);
+    }
+    batch.Clear();
+  };
+  for (std::size_t id : _changed)
+  {
+    auto it = _entities.find(id);
+    if (it == _entities.end())
+      continue;
+
+    std::shared_ptr<Entity> e = it->second;
     math::AxisAlignedBox b = e->GetBoundingBox();
     if (b == math::AxisAlignedBox())
-        continue;
+      continue;
 
-    // check collisions
-    auto result = this->dataPtr->aabbTree.Collisions(e->GetId());
-    if (result.empty())
+    auto nodeIt = nodes.find(id);
+    bool isNew = nodeIt == nodes.end();
+    BroadphaseNode &node = isNew ? nodes[id] : nodeIt->second;
+    if (node.changed)
       continue;
 
-    math::AxisAlignedBox wb1 = this->dataPtr->aabbTree.AABB(e->GetId());
+    node.changed = true;
+    changedIds.push_back(id);
+    node.pose = e->GetPose();
+    node.localBox = b;
+    node.collideBitmask = e->GetCollideBitmask();
 
-    // Get collide bitmask for entity 1
-    uint16_t cb1 = e->GetCollideBitmask();
+    // the shapes are collected in the entity's frame so the shape tree is
+    // only refit when shapes move relative to the entity. Models that only
+    // moved keep the shapes collected before.
+    const Model *model = dynamic_cast<const Model *>(e.get());
+    if (isNew || !model || model->ShapesChanged())
+    {
+      auto &shapes = this->dataPtr->shapeBuffer;
+      shapes.clear();
+      collectShapes(*e, math::Pose3d::Zero, shapes);
+      this->dataPtr->UpdateShapes(node, shapes);
+    }
+    for (auto &shape : node.shapes)
+      shape.geometry = transformShapeGeometry(shape.localGeometry, node.pose);
 
-    // Check intersection
-    for (const auto &nId : result)
+    if (_worldBox)
     {
-      // skip if we have already checked collision for this pair of nodes
-      if (this->dataPtr->CheckDuplicateCollisionPair(e->GetId(), nId))
-        continue;
+      node.aabb = _worldBox(*e);
+      updateNode(id, node, isNew);
+      continue;
+    }
 
-      // Get collide bitmask for entity 2
-      uint16_t cb2 = _entities.at(nId)->GetCollideBitmask();
+    // convert to world aabb with the rest of the batch
+    const std::size_t i = batch.Add(b, node.pose);
+    batchIds[i] = id;
+    batchNodes[i] = &node;
+    batchNew[i] = isNew;
+    if (batch.Full())
+      flushBatch();
+  }
+  flushBatch();
+
+  // dynamic nodes that stopped changing become static
+  for (std::size_t id : this->dataPtr->dynamicIds)
+  {
+    auto it = nodes.find(id);
+    if (it != nodes.end() && !it->second.changed && !it->second.isStatic)
+      this->dataPtr->MakeStatic(id, it->second);
+  }
+  for (std::size_t id : changedIds)
+    nodes[id].changed = false;
+  std::swap(this->dataPtr->dynamicIds, changedIds);
+
+  // Collect all pairs of overlapping nodes: dynamic nodes against each other,
+  // dynamic nodes against static nodes, and the cached static pairs.
+  auto &pairs = this->dataPtr->pairs;
+  this->dataPtr->dynamicBroadphase->Collisions(pairs);
+  this->dataPtr->dynamicBroadphase->Collisions(
+      *this->dataPtr->staticBroadphase, this->dataPtr->dynamicStaticPairs);
+  for (const auto &pair : this->dataPtr->dynamicStaticPairs)
+    pairs.push_back(std::minmax(pair.first, pair.second));
+  pairs.insert(pairs.end(), this->dataPtr->staticPairs.begin(),
+      this->dataPtr->staticPairs.end());
+
+  // sort so that the order of contacts does not depend on which broadphase
+  // the nodes are in
+  std::sort(pairs.begin(), pairs.end());
+
+  // Find contacts between pairs in parallel. Pairs are split into contiguous
+  // chunks and each chunk writes to its own buffer. The buffers are merged in
+  // order so contacts are sorted by pair for any number of threads.
+  const auto &constNodes = nodes;
+  const auto &cachedPairs = this->dataPtr->contactPairs;
+  const auto &cachedContacts = this->dataPtr->contacts;
+  bool useCache = this->dataPtr->singleContact == _singleContact;
+  auto narrowPhase = [&](std::size_t _chunk, std::size_t _begin,
+      std::size_t _end)
+  {
+    auto &chunkContacts = this->dataPtr->chunkContacts[_chunk];
+    auto &points = this->dataPtr->chunkPoints[_chunk];
+    auto &candidates = this->dataPtr->chunkShapes[_chunk];
+    chunkContacts.clear();
+    for (std::size_t i = _begin; i < _end; ++i)
+    {
+      const auto &pair = pairs[i];
+      const BroadphaseNode &node1 = constNodes.at(pair.first);
+      const BroadphaseNode &node2 = constNodes.at(pair.second);
+
+      // Entities in the static broadphase did not change in this check, so the
+      // contacts between two of them are the same as in the last check.
+      // Pairs that are not in the cache were not in contact.
+      if (useCache && node1.isStatic && node2.isStatic)
+      {
+        auto it = std::lower_bound(cachedPairs.begin(), cachedPairs.end(),
+            pair, [](const ContactPair &_cached,
+            const std::pair<std::size_t, std::size_t> &_pair)
+            {
+              return _cached.entities < _pair;
+            });
+        if (it != cachedPairs.end() && it->entities == pair)
+        {
+          chunkContacts.insert(chunkContacts.end(),
+              cachedContacts.begin() + it->first,
+              cachedContacts.begin() + it->first + it->count);
+        }
+        continue;
+      }
 
       // collision filtering using collide bitmask
-      if ((cb1 & cb2) == 0)
+      if ((node1.collideBitmask & node2.collideBitmask) == 0)
+        continue;
+
+      // Check intersection using the tight AABBs. The broadphase pairs are
+      // found using the enlarged AABBs so they may not actually intersect.
+      if (!node1.aabb.Intersects(node2.aabb))
         continue;
 
-      std::vector<math::Vector3d> points;
-      math::AxisAlignedBox wb2 = this->dataPtr->aabbTree.AABB(nId);
-      if (this->GetIntersectionPoints(wb1, wb2, points, _singleContact))
+      Contact c;
+      c.entity1 = pair.first;
+      c.entity2 = pair.second;
+
+      // fall back to the intersection of the AABBs for entities without
+      // any supported collision shapes
+      if (node1.shapes.empty() || node2.shapes.empty())
       {
-        Contact c;
-        // TPE checks collisions in the model level so contacts are associated
-        // with models and not collisions!
-        c.entity1 = e->GetId();
-        c.entity2 = nId;
+        points.clear();
+        this->GetIntersectionPoints(node1.aabb, node2.aabb, points,
+            _singleContact);
         for (const auto &p : points)
         {
           c.point = p;
-          contacts.push_back(c);
+          chunkContacts.push_back(c);
+        }
+        continue;
+      }
+
+      // Find contacts between the actual shapes of the collisions. Each
+      // shape of the entity with fewer shapes is tested against the shapes
+      // of the other entity whose boxes overlap with it, which are found
+      // from the other entity's shape tree.
+      bool firstIsSmaller = node1.shapes.size() <= node2.shapes.size();
+      const BroadphaseNode &small = firstIsSmaller ? node1 : node2;
+      const BroadphaseNode &large = firstIsSmaller ? node2 : node1;
+      bool useTree = large.shapes.size() > kMaxShapesWithoutTree;
+      math::Pose3d smallToLarge;
+      if (useTree)
+        smallToLarge = large.pose.Inverse() * small.pose;
+
+      bool found = false;
+      for (const auto &smallShape : small.shapes)
+      {
+        if (useTree)
+        {
+          // sort so that contacts do not depend on the tree structure
+          large.shapeTree.Collisions(transformAxisAlignedBox(
+              smallShape.localGeometry.aabb, smallToLarge), candidates);
+          std::sort(candidates.begin(), candidates.end());
+        }
+
+        std::size_t count = useTree ? candidates.size() : large.shapes.size();
+        for (std::size_t k = 0u; k < count; ++k)
+        {
+          const BroadphaseShape &largeShape =
+              large.shapes[useTree ? candidates[k] : k];
+          const BroadphaseShape &shape1 =
+              firstIsSmaller ? smallShape : largeShape;
+          const BroadphaseShape &shape2 =
+              firstIsSmaller ? largeShape : smallShape;
+          if ((shape1.collideBitmask & shape2.collideBitmask) == 0 ||
+              !shape1.geometry.aabb.Intersects(shape2.geometry.aabb))
+            continue;
+
+          ShapeContact shapeContact;
+          if (!collideShapes(shape1.geometry, shape2.geometry, shapeContact))
+            continue;
+
+          // keep the deepest contact if only one is needed
+          if (_singleContact && found && shapeContact.depth <= c.depth)
+            continue;
+
+          c.collision1 = shape1.id;
+          c.collision2 = shape2.id;
+          c.point = shapeContact.point;
+          c.normal = shapeContact.normal;
+          c.depth = shapeContact.depth;
+          found = true;
+          if (!_singleContact)
+            chunkContacts.push_back(c);
         }
       }
+      if (_singleContact && found)
+        chunkContacts.push_back(c);
     }
+  };
+
+  auto &threadPool = this->dataPtr->threadPool;
+  std::size_t chunkCount = threadPool ?
+      threadPool->ChunkCount(pairs.size(), kMinPairsPerChunk) :
+      std::min<std::size_t>(pairs.size(), 1u);
+  if (this->dataPtr->chunkContacts.size() < chunkCount)
+  {
+    this->dataPtr->chunkContacts.resize(chunkCount);
+    this->dataPtr->chunkPoints.resize(chunkCount);
+    this->dataPtr->chunkShapes.resize(chunkCount);
+  }
+
+  if (threadPool)
+    threadPool->ParallelFor(pairs.size(), narrowPhase, kMinPairsPerChunk);
+  else if (chunkCount > 0u)
+    narrowPhase(0u, 0u, pairs.size());
+
+  // merge the chunks into the buffer of the current check, which then
+  // replaces the contacts of the last check
+  auto &contacts = this->dataPtr->newContacts;
+  contacts.clear();
+  std::size_t contactCount = 0u;
+  for (std::size_t i = 0u; i < chunkCount; ++i)
+    contactCount += this->dataPtr->chunkContacts[i].size();
+  contacts.reserve(contactCount);
+  for (std::size_t i = 0u; i < chunkCount; ++i)
+  {
+    contacts.insert(contacts.end(), this->dataPtr->chunkContacts[i].begin(),
+        this->dataPtr->chunkContacts[i].end());
   }
 
-  this->dataPtr->collisionStateMap.clear();
-  return contacts;
+  this->dataPtr->UpdateContactPairs(contacts);
+  std::swap(this->dataPtr->contacts, contacts);
+  this->dataPtr->singleContact = _singleContact;
+  return this->dataPtr->contacts;
+}
+
+//////////////////////////////////////////////////
+const std::vector<Contact> &CollisionDetector::GetContacts() const
+{
+  return this->dataPtr->contacts;
 }
 
 //////////////////////////////////////////////////
@@ -240,33 +1025,3 @@ bool CollisionDetector::GetIntersectionPoints(const math::AxisAlignedBox &_b1,
   }
   return false;
 }
-
-//////////////////////////////////////////////////
-bool CollisionDetectorPrivate::CheckDuplicateCollisionPair(
-    std::size_t _a, std::size_t _b)
-{
-  // use a 2d map to keep track of pairs of collisions
-  // mark the corresponding elements in the 2d map to true to indicate
-  // the check is done
-  bool duplicate = true;
-  auto aIt = this->collisionStateMap.find(_a);
-  if (aIt == this->collisionStateMap.end())
-  {
-    duplicate = false;
-  }
-  else
-  {
-    auto bIt = aIt->second.find(_b);
-    if (bIt == aIt->second.end())
-    {
-      duplicate = false;
-    }
-  }
-
-  if (!duplicate)
-  {
-    this->collisionStateMap[_a][_b] = true;
-    this->collisionStateMap[_b][_a] = true;
-  }
-  return duplicate;
-}
@@ -18,6 +18,7 @@
 #ifndef IGNITION_PHYSICS_TPE_LIB_SRC_COLLISIONDETECTOR_HH_
 #define IGNITION_PHYSICS_TPE_LIB_SRC_COLLISIONDETECTOR_HH_
 
+#include <functional>
 #include <map>
 #include <memory>
 #include <string>
@@ -30,7 +31,9 @@
 
 #include "Entity.hh"
 
-#include "AABBTree.hh"
+#include "Broadphase.hh"
+#include "StateBuffer.hh"
+#include "ThreadPool.hh"
 
 namespace ignition {
 namespace physics {
@@ -39,19 +42,77 @@ namespace tpelib {
 // forward declaration
 class CollisionDetectorPrivate;
 
+/// \brief Id of an invalid contact
+static const std::size_t kNullContactId = math::MAX_UI64;
+
 /// \brief A data structure to store contact properties
 class IGNITION_PHYSICS_TPELIB_VISIBLE Contact
 {
-  /// \brief Id of frst collision entity
+  /// \brief Id of the contact between the two entities. It stays the same
+  /// in consecutive collision checks for as long as the entities are in
+  /// contact and is shared by all contact points of the two entities.
+  public: std::size_t id = kNullContactId;
+
+  /// \brief Id of first entity, i.e. the model
   public: std::size_t entity1 = kNullEntityId;
 
-  /// \brief Id of second collision entity
+  /// \brief Id of second entity, i.e. the model
   public: std::size_t entity2 = kNullEntityId;
 
+  /// \brief Id of the collision of the first entity whose shape is in
+  /// contact. It is kNullEntityId if the contact was found from the bounding
+  /// boxes of entities that have no supported collision shapes.
+  public: std::size_t collision1 = kNullEntityId;
+
+  /// \brief Id of the collision of the second entity whose shape is in
+  /// contact. It is kNullEntityId if the contact was found from the bounding
+  /// boxes of entities that have no supported collision shapes.
+  public: std::size_t collision2 = kNullEntityId;
+
   IGN_UTILS_WARN_IGNORE__DLL_INTERFACE_MISSING
   /// \brief Point of contact in world frame;
   public: math::Vector3d point;
+
+  /// \brief Unit contact normal in world frame pointing from the first
+  /// entity to the second entity
+  public: math::Vector3d normal;
   IGN_UTILS_WARN_RESUME__DLL_INTERFACE_MISSING
+
+  /// \brief Penetration depth along the contact normal
+  public: double depth = 0.0;
+};
+
+/// \brief Type of change in the contact between two entities
+enum class ContactEventType
+{
+  /// \brief The entities started touching in the last collision check
+  BEGIN,
+
+  /// \brief The entities were touching in the previous collision check and
+  /// are still touching
+  PERSIST,
+
+  /// \brief The entities were touching in the previous collision check and
+  /// stopped touching, or one of them was removed
+  END
+};
+
+/// \brief Change in the contact between two entities from one collision
+/// check to the next
+class IGNITION_PHYSICS_TPELIB_VISIBLE ContactEvent
+{
+  /// \brief Type of change
+  public: ContactEventType type = ContactEventType::BEGIN;
+
+  /// \brief Id of the contact, which matches the id of the contact points
+  /// of the two entities
+  public: std::size_t id = kNullContactId;
+
+  /// \brief Id of first entity
+  public: std::size_t entity1 = kNullEntityId;
+
+  /// \brief Id of second entity
+  public: std::size_t entity2 = kNullEntityId;
 };
 
 /// \brief Collision Detector that checks collisions between a list of entities
@@ -63,16 +124,151 @@ class IGNITION_PHYSICS_TPELIB_VISIBLE CollisionDetector
   /// \brief Destructor
   public: ~CollisionDetector();
 
-  /// \brief Check collisions between a list entities and get all contact points
+  /// \brief Check collisions between a list entities and get all contacts.
+  /// Pairs of entities whose AABBs overlap are found first. For each pair,
+  /// the AABB tree of one entity's collision shapes is queried with the
+  /// shapes of the other entity, and contacts are computed between the
+  /// actual shapes of the overlapping collisions.
+  /// \param[in] _entities List of entities
+  /// \param[in] _singleContact Get only 1 contact point, the deepest one,
+  /// for each pair of entities. Otherwise 1 contact point is returned for
+  /// each pair of intersecting collision shapes.
+  /// \return A list of contact points
+  public: std::vector<Contact> CheckCollisions(
+      const std::map<std::size_t, std::shared_ptr<Entity>> &_entities,
+      bool _singleContact = false);
+
+  /// \brief Check collisions between a list of entities and get all contact
+  /// points. Only entities that are known to have changed or been removed
+  /// since the last check are updated. Entities that are not in the list of
+  /// changed entities are assumed to have the same pose and bounding box as
+  /// in the last check, so the contacts between two such entities are
+  /// taken from the last check instead of being computed again.
   /// \param[in] _entities List of entities
-  /// \param[in] _singleContact Get only 1 contact point for each pair of
-  /// collisions.
-  /// The contact point will be at the center of all points
+  /// \param[in] _changed Ids of entities that were added or whose pose or
+  /// bounding box changed since the last check
+  /// \param[in] _removed Ids of entities that were removed since the last
+  /// check
+  /// \param[in] _singleContact Get only 1 contact point, the deepest one,
+  /// for each pair of entities. Otherwise 1 contact point is returned for
+  /// each pair of intersecting collision shapes.
   /// \return A list of contact points
   public: std::vector<Contact> CheckCollisions(
       const std::map<std::size_t, std::shared_ptr<Entity>> &_entities,
+      const std::vector<std::size_t> &_changed,
+      const std::vector<std::size_t> &_removed,
       bool _singleContact = false);
 
+  /// \brief Check collisions between a list of entities and get all contact
+  /// points without copying them. This is the same as the function above
+  /// except that the contacts are returned by reference to the buffer owned
+  /// by the collision detector, which is reused across checks without
+  /// allocating.
+  /// \param[in] _entities List of entities
+  /// \param[in] _changed Ids of entities that were added or whose pose or
+  /// bounding box changed since the last check
+  /// \param[in] _removed Ids of entities that were removed since the last
+  /// check
+  /// \param[in] _singleContact Get only 1 contact point, the deepest one,
+  /// for each pair of entities. Otherwise 1 contact point is returned for
+  /// each pair of intersecting collision shapes.
+  /// \param[in] _worldBox Function that returns the world AABB of a changed
+  /// entity already computed by the caller. If empty, the world AABBs are
+  /// computed from the bounding boxes and poses of the entities.
+  /// \return Contact points, valid until the next collision check
+  public: const std::vector<Contact> &CheckCollisions(
+      const std::map<std::size_t, std::shared_ptr<Entity>> &_entities,
+      const std::vector<std::size_t> &_changed,
+      const std::vector<std::size_t> &_removed,
+      bool _singleContact,
+      const std::function<math::AxisAlignedBox(const Entity &)> &_worldBox);
+
+  /// \brief Get the contact points found by the last collision check
+  /// \return Contact points, valid until the next collision check
+  public: const std::vector<Contact> &GetContacts() const;
+
+  /// \brief Get the changes in contacts found by the last collision check
+  /// compared to the check before it. There is one event for each pair of
+  /// entities that started touching, are still touching or stopped touching.
+  /// Events are sorted by the ids of the entities.
+  /// \return Contact events of the last collision check
+  public: std::vector<ContactEvent> GetContactEvents() const;
+
+  /// \brief Write the contact state of the last collision check, i.e. the
+  /// pairs of entities in contact, the contact events and the next contact
+  /// id. The contacts themselves are not written, the caller saves them
+  /// along with the rest of its state.
+  /// \param[in] _writer Writer to append the state to
+  public: void SaveState(StateWriter &_writer) const;
+
+  /// \brief Restore the contact state written by SaveState, so that the
+  /// contact ids and events of the next collision check continue from it.
+  /// The broadphase is not restored: entities whose pose differs from the
+  /// broadphase are updated as usual when they are passed as changed in the
+  /// next check.
+  /// \param[in] _reader Reader positioned at the state
+  /// \param[in] _contacts Contacts of the collision check when the state was
+  /// saved. They are moved into the collision detector if the state is
+  /// restored.
+  /// \return True if the state was restored, false if it could not be read,
+  /// in which case the collision detector and the contacts are unchanged
+  public: bool RestoreState(StateReader &_reader,
+      std::vector<Contact> &&_contacts);
+
+  /// \brief Copy the contact state of another collision detector whose
+  /// entities were copied with new ids, so that the contact ids and events
+  /// of the next collision check continue from the other detector. The
+  /// broadphase is not copied, entities are inserted when they are passed as
+  /// changed in the next check.
+  /// \param[in] _other Collision detector to copy from
+  /// \param[in] _mapId Function that returns the id of the copy of an
+  /// entity given its id in the other detector. It must preserve the order
+  /// of the ids.
+  /// \param[in] _contacts Contacts of the last collision check of the other
+  /// detector, with the ids of the copied entities. They are moved into this
+  /// collision detector.
+  public: void CopyContactState(const CollisionDetector &_other,
+      const std::function<std::size_t(std::size_t)> &_mapId,
+      std::vector<Contact> &&_contacts);
+
+  /// \brief Set the thread pool used to find contacts between pairs of
+  /// entities whose AABBs overlap. Contacts are returned in the same order
+  /// regardless of the number of threads.
+  /// \param[in] _threadPool Thread pool, null to find contacts on the calling
+  /// thread only
+  public: void SetThreadPool(const std::shared_ptr<ThreadPool> &_threadPool);
+
+  /// \brief Set the type of broadphase used to find pairs of entities whose
+  /// AABBs overlap. Entities already in the broadphase are moved to the new
+  /// one.
+  /// \param[in] _type Broadphase type, defaults to BroadphaseType::AABB_TREE
+  public: void SetBroadphaseType(BroadphaseType _type);
+
+  /// \brief Get the type of broadphase
+  /// \return Broadphase type
+  public: BroadphaseType GetBroadphaseType() const;
+
+  /// \brief Set the margin used to enlarge the AABBs of entities in the
+  /// broadphase. A larger margin reduces the number of broadphase updates for
+  /// entities that move by small amounts at the cost of more candidate pairs.
+  /// Contacts are always computed from the actual AABBs.
+  /// \param[in] _margin AABB margin, 0 to disable
+  public: void SetAABBMargin(double _margin);
+
+  /// \brief Get the margin used to enlarge the AABBs of entities
+  /// \return AABB margin
+  public: double GetAABBMargin() const;
+
+  /// \brief Set the scale applied to the displacement of an entity to further
+  /// enlarge its AABB in the direction of motion, i.e. its velocity times
+  /// time step when updated every step.
+  /// \param[in] _scale Displacement scale, 0 to disable
+  public: void SetAABBDisplacementScale(double _scale);
+
+  /// \brief Get the scale applied to the displacement of an entity
+  /// \return Displacement scale
+  public: double GetAABBDisplacementScale() const;
+
   /// \brief Get a vector of intersection points between two axis aligned boxes
   /// \param[in] _b1 Axis aligned box 1
   /// \param[in] _b2 Axis aligned box 2
@@ -16,6 +16,12 @@
 */
 
 #include <gtest/gtest.h>
+
+#include <algorithm>
+#include <random>
+#include <set>
+#include <utility>
+
 #include <ignition/math/AxisAlignedBox.hh>
 
 #include "Collision.hh"
@@ -133,7 +139,7 @@ TEST(CollisionDetector, CheckCollisions)
   modelB->SetPose(math::Pose3d(0, 0, 0, 0, 0, 0));
   modelC->SetPose(math::Pose3d(100, 0, 0, 0, 0, 0));
   contacts = cd.CheckCollisions(entities);
-  EXPECT_EQ(8u, contacts.size());
+  EXPECT_EQ(1u, contacts.size());
 
   for (const auto &c : contacts)
   {
@@ -157,7 +163,7 @@ TEST(CollisionDetector, CheckCollisions)
   modelB->SetPose(math::Pose3d(100, 0, 0, 0, 0, 0));
   modelC->SetPose(math::Pose3d(2, 3, 4, 0, 0, 0));
   contacts = cd.CheckCollisions(entities);
-  EXPECT_EQ(8u, contacts.size());
+  EXPECT_EQ(1u, contacts.size());
 
   for (const auto &c : contacts)
   {
@@ -181,7 +187,7 @@ TEST(CollisionDetector, CheckCollisions)
   modelB->SetPose(math::Pose3d(0, 0, 0, 0, 0, 0));
   modelC->SetPose(math::Pose3d(3, 3, 3, 0, 0, 0));
   contacts = cd.CheckCollisions(entities);
-  EXPECT_EQ(16u, contacts.size());
+  EXPECT_EQ(2u, contacts.size());
 
   unsigned int contactAB = 0u;
   unsigned int contactBC = 0u;
@@ -197,8 +203,8 @@ TEST(CollisionDetector, CheckCollisions)
         (c.entity1 == modelC->GetId() || c.entity2 == modelC->GetId()))
       FAIL() << "There should be no contacts between model A and C";
   }
-  EXPECT_EQ(8u, contactAB);
-  EXPECT_EQ(8u, contactBC);
+  EXPECT_EQ(1u, contactAB);
+  EXPECT_EQ(1u, contactBC);
 
   // check single contact point
   contacts = cd.CheckCollisions(entities, true);
@@ -209,7 +215,7 @@ TEST(CollisionDetector, CheckCollisions)
   modelB->SetPose(math::Pose3d(0, 0, 0, 0, 0, 0));
   modelC->SetPose(math::Pose3d(1, 1, 1, 0, 0, 0));
   contacts = cd.CheckCollisions(entities);
-  EXPECT_EQ(24u, contacts.size());
+  EXPECT_EQ(3u, contacts.size());
 
   contactAB = 0u;
   contactBC = 0u;
@@ -226,9 +232,9 @@ TEST(CollisionDetector, CheckCollisions)
         (c.entity1 == modelC->GetId() || c.entity2 == modelC->GetId()))
       contactAC++;
   }
-  EXPECT_EQ(8u, contactAB);
-  EXPECT_EQ(8u, contactBC);
-  EXPECT_EQ(8u, contactAC);
+  EXPECT_EQ(1u, contactAB);
+  EXPECT_EQ(1u, contactBC);
+  EXPECT_EQ(1u, contactAC);
 
   // check single contact point
   contacts = cd.CheckCollisions(entities, true);
@@ -237,7 +243,524 @@ TEST(CollisionDetector, CheckCollisions)
   // remove entity and check again
   entities.erase(modelC->GetId());
   contacts = cd.CheckCollisions(entities, false);
-  EXPECT_EQ(8u, contacts.size());
+  EXPECT_EQ(1u, contacts.size());
   contacts = cd.CheckCollisions(entities, true);
   EXPECT_EQ(1u, contacts.size());
 }
+
+/////////////////////////////////////////////////
+TEST(CollisionDetector, CheckCollisionsWithMargin)
+{
+  // two boxes of size 4
+  std::shared_ptr<Model> modelA(new Model);
+  Entity &linkAEnt = modelA->AddLink();
+  Link *linkA = static_cast<Link *>(&linkAEnt);
+  Entity &collisionAEnt = linkA->AddCollision();
+  Collision *collisionA = static_cast<Collision *>(&collisionAEnt);
+  BoxShape boxShape;
+  boxShape.SetSize(ignition::math::Vector3d(4, 4, 4));
+  collisionA->SetShape(boxShape);
+
+  std::shared_ptr<Model> modelB(new Model);
+  Entity &linkBEnt = modelB->AddLink();
+  Link *linkB = static_cast<Link *>(&linkBEnt);
+  Entity &collisionBEnt = linkB->AddCollision();
+  Collision *collisionB = static_cast<Collision *>(&collisionBEnt);
+  collisionB->SetShape(boxShape);
+
+  CollisionDetector cd;
+  EXPECT_DOUBLE_EQ(0.0, cd.GetAABBMargin());
+  cd.SetAABBMargin(1.0);
+  EXPECT_DOUBLE_EQ(1.0, cd.GetAABBMargin());
+  EXPECT_DOUBLE_EQ(0.0, cd.GetAABBDisplacementScale());
+  cd.SetAABBDisplacementScale(1.0);
+  EXPECT_DOUBLE_EQ(1.0, cd.GetAABBDisplacementScale());
+
+  // the enlarged AABBs overlap but the actual AABBs do not
+  std::map<std::size_t, std::shared_ptr<Entity>> entities;
+  modelA->SetPose(math::Pose3d(0, 0, 0, 0, 0, 0));
+  modelB->SetPose(math::Pose3d(4.5, 0, 0, 0, 0, 0));
+  entities[modelA->GetId()] = modelA;
+  entities[modelB->GetId()] = modelB;
+  std::vector<Contact> contacts = cd.CheckCollisions(entities, true);
+  EXPECT_TRUE(contacts.empty());
+
+  // move within the margin into contact
+  modelB->SetPose(math::Pose3d(3.5, 0, 0, 0, 0, 0));
+  contacts = cd.CheckCollisions(entities, true);
+  ASSERT_EQ(1u, contacts.size());
+  EXPECT_EQ(math::Vector3d(1.75, 0, 0), contacts[0].point);
+
+  // move out of the margin
+  modelB->SetPose(math::Pose3d(10, 0, 0, 0, 0, 0));
+  contacts = cd.CheckCollisions(entities, true);
+  EXPECT_TRUE(contacts.empty());
+}
+
+/////////////////////////////////////////////////
+TEST(CollisionDetector, StaticAndDynamicEntities)
+{
+  // Randomly move some models while the others stay in place, and compare
+  // the detected contacts against brute force checks. Models that do not
+  // move end up in the static tree, including ones that touch each other.
+  std::mt19937 rng(1234);
+  std::uniform_real_distribution<double> posDist(-10.0, 10.0);
+
+  BoxShape boxShape;
+  boxShape.SetSize(ignition::math::Vector3d(2, 2, 2));
+
+  std::map<std::size_t, std::shared_ptr<Entity>> entities;
+  for (unsigned int i = 0u; i < 100u; ++i)
+  {
+    std::shared_ptr<Model> model(new Model);
+    Entity &linkEnt = model->AddLink();
+    Link *link = static_cast<Link *>(&linkEnt);
+    Entity &collisionEnt = link->AddCollision();
+    Collision *collision = static_cast<Collision *>(&collisionEnt);
+    collision->SetShape(boxShape);
+    model->SetPose(math::Pose3d(posDist(rng), posDist(rng), posDist(rng),
+        0, 0, 0));
+    entities[model->GetId()] = model;
+  }
+
+  CollisionDetector cd;
+  for (unsigned int iteration = 0u; iteration < 20u; ++iteration)
+  {
+    // move a few models
+    for (auto &it : entities)
+    {
+      if (rng() % 10u != 0u)
+        continue;
+      it.second->SetPose(math::Pose3d(posDist(rng), posDist(rng),
+          posDist(rng), 0, 0, 0));
+    }
+
+    // remove a model
+    if (iteration % 5u == 4u)
+      entities.erase(entities.begin());
+
+    std::set<std::pair<std::size_t, std::size_t>> expected;
+    for (auto it1 = entities.begin(); it1 != entities.end(); ++it1)
+    {
+      math::AxisAlignedBox b1(it1->second->GetPose().Pos() -
+          math::Vector3d::One, it1->second->GetPose().Pos() +
+          math::Vector3d::One);
+      for (auto it2 = std::next(it1); it2 != entities.end(); ++it2)
+      {
+        math::AxisAlignedBox b2(it2->second->GetPose().Pos() -
+            math::Vector3d::One, it2->second->GetPose().Pos() +
+            math::Vector3d::One);
+        if (b1.Intersects(b2))
+          expected.insert(std::make_pair(it1->first, it2->first));
+      }
+    }
+
+    std::vector<Contact> contacts = cd.CheckCollisions(entities, true);
+    std::set<std::pair<std::size_t, std::size_t>> actual;
+    for (const auto &c : contacts)
+      actual.insert(std::minmax(c.entity1, c.entity2));
+    EXPECT_EQ(expected.size(), contacts.size());
+    EXPECT_EQ(expected, actual);
+
+    // contacts are in a deterministic order
+    EXPECT_TRUE(std::is_sorted(contacts.begin(), contacts.end(),
+        [](const Contact &_a, const Contact &_b)
+        {
+          return std::make_pair(_a.entity1, _a.entity2) <
+              std::make_pair(_b.entity1, _b.entity2);
+        }));
+  }
+}
+
+/////////////////////////////////////////////////
+TEST(CollisionDetector, ThreadPool)
+{
+  // contacts found with multiple threads are the same as with one thread
+  std::mt19937 rng(4321);
+  std::uniform_real_distribution<double> posDist(-5.0, 5.0);
+
+  BoxShape boxShape;
+  boxShape.SetSize(ignition::math::Vector3d(2, 2, 2));
+
+  std::map<std::size_t, std::shared_ptr<Entity>> entities;
+  for (unsigned int i = 0u; i < 400u; ++i)
+  {
+    std::shared_ptr<Model> model(new Model);
+    Entity &linkEnt = model->AddLink();
+    Link *link = static_cast<Link *>(&linkEnt);
+    Entity &collisionEnt = link->AddCollision();
+    Collision *collision = static_cast<Collision *>(&collisionEnt);
+    collision->SetShape(boxShape);
+    // filter out some of the pairs
+    if (i % 3u == 0u)
+      collision->SetCollideBitmask(0x01);
+    else if (i % 3u == 1u)
+      collision->SetCollideBitmask(0x02);
+    model->SetPose(math::Pose3d(posDist(rng), posDist(rng), posDist(rng),
+        0, 0, 0));
+    entities[model->GetId()] = model;
+  }
+
+  CollisionDetector cd;
+  CollisionDetector cdParallel;
+  cdParallel.SetThreadPool(std::make_shared<ThreadPool>(4u));
+  for (bool singleContact : {true, false})
+  {
+    std::vector<Contact> contacts = cd.CheckCollisions(entities,
+        singleContact);
+    std::vector<Contact> parallelContacts = cdParallel.CheckCollisions(
+        entities, singleContact);
+    EXPECT_LT(1000u, contacts.size());
+    ASSERT_EQ(contacts.size(), parallelContacts.size());
+    for (std::size_t i = 0u; i < contacts.size(); ++i)
+    {
+      EXPECT_EQ(contacts[i].entity1, parallelContacts[i].entity1);
+      EXPECT_EQ(contacts[i].entity2, parallelContacts[i].entity2);
+      EXPECT_EQ(contacts[i].collision1, parallelContacts[i].collision1);
+      EXPECT_EQ(contacts[i].collision2, parallelContacts[i].collision2);
+      EXPECT_EQ(contacts[i].point, parallelContacts[i].point);
+      EXPECT_NE(0, (entities[contacts[i].entity1]->GetCollideBitmask() &
+          entities[contacts[i].entity2]->GetCollideBitmask()));
+    }
+  }
+}
+
+/////////////////////////////////////////////////
+TEST(CollisionDetector, CollisionShapeTree)
+{
+  // model A has a row of links with one sphere each, enough for the shapes
+  // of the model to be queried through its shape tree
+  SphereShape sphereShape;
+  sphereShape.SetRadius(0.5);
+
+  std::shared_ptr<Model> modelA(new Model);
+  std::vector<Link *> linksA;
+  std::vector<std::size_t> collisionsA;
+  for (unsigned int i = 0u; i < 10u; ++i)
+  {
+    Link *link = static_cast<Link *>(&modelA->AddLink());
+    link->SetPose(math::Pose3d(2.0 * i, 0, 0, 0, 0, 0));
+    Collision *collision = static_cast<Collision *>(&link->AddCollision());
+    collision->SetShape(sphereShape);
+    linksA.push_back(link);
+    collisionsA.push_back(collision->GetId());
+  }
+  // rotate the model so the row of links is along the y axis
+  modelA->SetPose(math::Pose3d(0, 0, 0, 0, 0, IGN_PI_2));
+
+  // model B has a single sphere next to the third link of model A
+  std::shared_ptr<Model> modelB(new Model);
+  Link *linkB = static_cast<Link *>(&modelB->AddLink());
+  Collision *collisionB = static_cast<Collision *>(&linkB->AddCollision());
+  collisionB->SetShape(sphereShape);
+  modelB->SetPose(math::Pose3d(0.8, 4, 0, 0, 0, 0));
+
+  std::map<std::size_t, std::shared_ptr<Entity>> entities;
+  entities[modelA->GetId()] = modelA;
+  entities[modelB->GetId()] = modelB;
+
+  // contacts are associated with the collisions that intersect
+  CollisionDetector cd;
+  std::vector<std::size_t> changed = {modelA->GetId(), modelB->GetId()};
+  std::vector<std::size_t> removed;
+  std::vector<Contact> contacts = cd.CheckCollisions(entities, changed,
+      removed);
+  ASSERT_EQ(1u, contacts.size());
+  EXPECT_EQ(modelA->GetId(), contacts[0].entity1);
+  EXPECT_EQ(modelB->GetId(), contacts[0].entity2);
+  EXPECT_EQ(collisionsA[2], contacts[0].collision1);
+  EXPECT_EQ(collisionB->GetId(), contacts[0].collision2);
+  EXPECT_NEAR(0.2, contacts[0].depth, 1e-6);
+  EXPECT_EQ(math::Vector3d(1, 0, 0), contacts[0].normal);
+
+  // move the third link away and another link next to model B
+  linksA[2]->SetPose(math::Pose3d(4, 10, 0, 0, 0, 0));
+  linksA[5]->SetPose(math::Pose3d(4, -0.5, 0, 0, 0, 0));
+  changed = {modelA->GetId()};
+  contacts = cd.CheckCollisions(entities, changed, removed);
+  ASSERT_EQ(1u, contacts.size());
+  EXPECT_EQ(collisionsA[5], contacts[0].collision1);
+  EXPECT_EQ(collisionB->GetId(), contacts[0].collision2);
+  EXPECT_NEAR(0.7, contacts[0].depth, 1e-6);
+
+  // moving the model keeps the shapes relative to the model
+  modelA->SetPose(math::Pose3d(0, 18, 0, 0, 0, -IGN_PI_2));
+  changed = {modelA->GetId()};
+  contacts = cd.CheckCollisions(entities, changed, removed);
+  ASSERT_EQ(1u, contacts.size());
+  EXPECT_EQ(collisionsA[7], contacts[0].collision1);
+  EXPECT_EQ(collisionB->GetId(), contacts[0].collision2);
+
+  // model B overlaps the boxes of several links
+  modelB->SetPose(math::Pose3d(0, 3.2, 0, 0, 0, 0));
+  sphereShape.SetRadius(2.5);
+  collisionB->SetShape(sphereShape);
+  changed = {modelB->GetId()};
+  contacts = cd.CheckCollisions(entities, changed, removed);
+  std::set<std::size_t> expected = {collisionsA[6], collisionsA[7],
+      collisionsA[8]};
+  std::set<std::size_t> found;
+  for (const auto &c : contacts)
+  {
+    EXPECT_EQ(collisionB->GetId(), c.collision2);
+    found.insert(c.collision1);
+  }
+  EXPECT_EQ(expected, found);
+  EXPECT_EQ(expected.size(), contacts.size());
+}
+
+/////////////////////////////////////////////////
+TEST(CollisionDetector, ContactEvents)
+{
+  BoxShape boxShape;
+  boxShape.SetSize(ignition::math::Vector3d(1, 1, 1));
+
+  std::map<std::size_t, std::shared_ptr<Entity>> entities;
+  std::vector<std::shared_ptr<Model>> models;
+  for (unsigned int i = 0u; i < 3u; ++i)
+  {
+    std::shared_ptr<Model> model(new Model);
+    Link *link = static_cast<Link *>(&model->AddLink());
+    Collision *collision = static_cast<Collision *>(&link->AddCollision());
+    collision->SetShape(boxShape);
+    model->SetPose(math::Pose3d(10.0 * i, 0, 0, 0, 0, 0));
+    entities[model->GetId()] = model;
+    models.push_back(model);
+  }
+  std::size_t id0 = models[0]->GetId();
+  std::size_t id1 = models[1]->GetId();
+  std::size_t id2 = models[2]->GetId();
+
+  CollisionDetector cd;
+  std::vector<std::size_t> changed = {id0, id1, id2};
+  std::vector<std::size_t> removed;
+  std::vector<Contact> contacts = cd.CheckCollisions(entities, changed,
+      removed);
+  EXPECT_TRUE(contacts.empty());
+  EXPECT_TRUE(cd.GetContactEvents().empty());
+
+  // model 1 starts touching model 0
+  models[1]->SetPose(math::Pose3d(0.5, 0, 0, 0, 0, 0));
+  changed = {id1};
+  contacts = cd.CheckCollisions(entities, changed, removed);
+  ASSERT_EQ(1u, contacts.size());
+  std::vector<ContactEvent> events = cd.GetContactEvents();
+  ASSERT_EQ(1u, events.size());
+  EXPECT_EQ(ContactEventType::BEGIN, events[0].type);
+  EXPECT_EQ(id0, events[0].entity1);
+  EXPECT_EQ(id1, events[0].entity2);
+  EXPECT_NE(kNullContactId, events[0].id);
+  EXPECT_EQ(events[0].id, contacts[0].id);
+  std::size_t contactId01 = events[0].id;
+
+  // nothing changes, the contact is taken from the cache and persists
+  for (unsigned int i = 0u; i < 3u; ++i)
+  {
+    changed.clear();
+    std::vector<Contact> cachedContacts = cd.CheckCollisions(entities,
+        changed, removed);
+    ASSERT_EQ(1u, cachedContacts.size());
+    EXPECT_EQ(contactId01, cachedContacts[0].id);
+    EXPECT_EQ(contacts[0].point, cachedContacts[0].point);
+    EXPECT_EQ(contacts[0].normal, cachedContacts[0].normal);
+    EXPECT_DOUBLE_EQ(contacts[0].depth, cachedContacts[0].depth);
+    events = cd.GetContactEvents();
+    ASSERT_EQ(1u, events.size());
+    EXPECT_EQ(ContactEventType::PERSIST, events[0].type);
+    EXPECT_EQ(contactId01, events[0].id);
+  }
+
+  // model 2 starts touching model 1 while model 1 keeps touching model 0
+  models[2]->SetPose(math::Pose3d(1.2, 0, 0, 0, 0, 0));
+  changed = {id2};
+  contacts = cd.CheckCollisions(entities, changed, removed);
+  ASSERT_EQ(2u, contacts.size());
+  events = cd.GetContactEvents();
+  ASSERT_EQ(2u, events.size());
+  EXPECT_EQ(ContactEventType::PERSIST, events[0].type);
+  EXPECT_EQ(contactId01, events[0].id);
+  EXPECT_EQ(ContactEventType::BEGIN, events[1].type);
+  EXPECT_EQ(id1, events[1].entity1);
+  EXPECT_EQ(id2, events[1].entity2);
+  EXPECT_NE(contactId01, events[1].id);
+  std::size_t contactId12 = events[1].id;
+
+  // model 1 moves away from model 0 but still touches model 2
+  models[1]->SetPose(math::Pose3d(1.6, 0, 0, 0, 0, 0));
+  changed = {id1};
+  contacts = cd.CheckCollisions(entities, changed, removed);
+  ASSERT_EQ(1u, contacts.size());
+  EXPECT_EQ(contactId12, contacts[0].id);
+  events = cd.GetContactEvents();
+  ASSERT_EQ(2u, events.size());
+  EXPECT_EQ(ContactEventType::END, events[0].type);
+  EXPECT_EQ(contactId01, events[0].id);
+  EXPECT_EQ(id0, events[0].entity1);
+  EXPECT_EQ(id1, events[0].entity2);
+  EXPECT_EQ(ContactEventType::PERSIST, events[1].type);
+  EXPECT_EQ(contactId12, events[1].id);
+
+  // touching again gives a new contact id
+  models[1]->SetPose(math::Pose3d(0.9, 0, 0, 0, 0, 0));
+  changed = {id1};
+  contacts = cd.CheckCollisions(entities, changed, removed);
+  ASSERT_EQ(2u, contacts.size());
+  events = cd.GetContactEvents();
+  ASSERT_EQ(2u, events.size());
+  EXPECT_EQ(ContactEventType::BEGIN, events[0].type);
+  EXPECT_NE(contactId01, events[0].id);
+  EXPECT_NE(contactId12, events[0].id);
+  EXPECT_EQ(ContactEventType::PERSIST, events[1].type);
+  EXPECT_EQ(contactId12, events[1].id);
+
+  // removing a model ends its contacts
+  entities.erase(id1);
+  changed.clear();
+  removed = {id1};
+  contacts = cd.CheckCollisions(entities, changed, removed);
+  EXPECT_TRUE(contacts.empty());
+  events = cd.GetContactEvents();
+  ASSERT_EQ(2u, events.size());
+  EXPECT_EQ(ContactEventType::END, events[0].type);
+  EXPECT_EQ(ContactEventType::END, events[1].type);
+  EXPECT_EQ(contactId12, events[1].id);
+
+  removed.clear();
+  contacts = cd.CheckCollisions(entities, changed, removed);
+  EXPECT_TRUE(cd.GetContactEvents().empty());
+}
+
+/////////////////////////////////////////////////
+TEST(CollisionDetector, ContactCache)
+{
+  // contacts taken from the cache are the same as contacts computed from
+  // scratch while some of the models move
+  std::mt19937 rng(2468);
+  std::uniform_real_distribution<double> posDist(-5.0, 5.0);
+
+  BoxShape boxShape;
+  boxShape.SetSize(ignition::math::Vector3d(2, 2, 2));
+
+  std::map<std::size_t, std::shared_ptr<Entity>> entities;
+  for (unsigned int i = 0u; i < 200u; ++i)
+  {
+    std::shared_ptr<Model> model(new Model);
+    Link *link = static_cast<Link *>(&model->AddLink());
+    Collision *collision = static_cast<Collision *>(&link->AddCollision());
+    collision->SetShape(boxShape);
+    model->SetPose(math::Pose3d(posDist(rng), posDist(rng), posDist(rng),
+        0, 0, 0));
+    entities[model->GetId()] = model;
+  }
+
+  CollisionDetector cd;
+  for (unsigned int i = 0u; i < 10u; ++i)
+  {
+    for (auto &it : entities)
+    {
+      if (rng() % 10u == 0u)
+      {
+        it.second->SetPose(math::Pose3d(posDist(rng), posDist(rng),
+            posDist(rng), 0, 0, 0));
+      }
+    }
+
+    std::vector<Contact> contacts = cd.CheckCollisions(entities, true);
+    CollisionDetector fresh;
+    std::vector<Contact> expected = fresh.CheckCollisions(entities, true);
+
+    // the contacts owned by the collision detector are the same and their
+    // buffers are swapped between checks instead of being reallocated
+    std::vector<std::size_t> noChanges;
+    const std::vector<Contact> &buffer =
+        fresh.CheckCollisions(entities, noChanges, noChanges, true, nullptr);
+    EXPECT_EQ(&buffer, &fresh.GetContacts());
+    const Contact *data = buffer.data();
+    fresh.CheckCollisions(entities, noChanges, noChanges, true, nullptr);
+    fresh.CheckCollisions(entities, noChanges, noChanges, true, nullptr);
+    ASSERT_EQ(expected.size(), buffer.size());
+    if (!buffer.empty())
+    {
+      EXPECT_EQ(data, buffer.data());
+    }
+    for (std::size_t j = 0u; j < buffer.size(); ++j)
+    {
+      EXPECT_EQ(expected[j].id, buffer[j].id);
+      EXPECT_EQ(expected[j].point, buffer[j].point);
+    }
+    ASSERT_EQ(expected.size(), contacts.size());
+    for (std::size_t j = 0u; j < contacts.size(); ++j)
+    {
+      EXPECT_EQ(expected[j].entity1, contacts[j].entity1);
+      EXPECT_EQ(expected[j].entity2, contacts[j].entity2);
+      EXPECT_EQ(expected[j].point, contacts[j].point);
+      EXPECT_DOUBLE_EQ(expected[j].depth, contacts[j].depth);
+    }
+  }
+}
+
+/////////////////////////////////////////////////
+TEST(CollisionDetector, BroadphaseType)
+{
+  // contacts found with each type of broadphase are the same, including
+  // after switching the broadphase type between checks
+  std::mt19937 rng(1357);
+  std::uniform_real_distribution<double> posDist(-5.0, 5.0);
+
+  BoxShape boxShape;
+  boxShape.SetSize(ignition::math::Vector3d(2, 2, 2));
+
+  std::map<std::size_t, std::shared_ptr<Entity>> entities;
+  for (unsigned int i = 0u; i < 200u; ++i)
+  {
+    std::shared_ptr<Model> model(new Model);
+    Link *link = static_cast<Link *>(&model->AddLink());
+    Collision *collision = static_cast<Collision *>(&link->AddCollision());
+    collision->SetShape(boxShape);
+    model->SetPose(math::Pose3d(posDist(rng), posDist(rng), posDist(rng),
+        0, 0, 0));
+    entities[model->GetId()] = model;
+  }
+
+  CollisionDetector tree;
+  EXPECT_EQ(BroadphaseType::AABB_TREE, tree.GetBroadphaseType());
+  CollisionDetector sap;
+  sap.SetBroadphaseType(BroadphaseType::SWEEP_AND_PRUNE);
+  EXPECT_EQ(BroadphaseType::SWEEP_AND_PRUNE, sap.GetBroadphaseType());
+  sap.SetAABBMargin(0.1);
+
+  for (unsigned int i = 0u; i < 10u; ++i)
+  {
+    for (auto &it : entities)
+    {
+      if (rng() % 10u == 0u)
+      {
+        it.second->SetPose(math::Pose3d(posDist(rng), posDist(rng),
+            posDist(rng), 0, 0, 0));
+      }
+    }
+
+    // switch the broadphase type while nodes are stored
+    if (i == 5u)
+    {
+      sap.SetBroadphaseType(BroadphaseType::AABB_TREE);
+      EXPECT_DOUBLE_EQ(0.1, sap.GetAABBMargin());
+    }
+    else if (i == 7u)
+    {
+      sap.SetBroadphaseType(BroadphaseType::UNIFORM_GRID);
+      EXPECT_EQ(BroadphaseType::UNIFORM_GRID, sap.GetBroadphaseType());
+    }
+
+    std::vector<Contact> expected = tree.CheckCollisions(entities, true);
+    std::vector<Contact> contacts = sap.CheckCollisions(entities, true);
+    EXPECT_FALSE(expected.empty());
+    ASSERT_EQ(expected.size(), contacts.size());
+    for (std::size_t j = 0u; j < contacts.size(); ++j)
+    {
+      EXPECT_EQ(expected[j].entity1, contacts[j].entity1);
+      EXPECT_EQ(expected[j].entity2, contacts[j].entity2);
+      EXPECT_EQ(expected[j].point, contacts[j].point);
+    }
+  }
+}
@@ -17,6 +17,9 @@
 
 #include <gtest/gtest.h>
 
+#include <type_traits>
+#include <utility>
+
 #include "Collision.hh"
 #include "Shape.hh"
 #include "Link.hh"
@@ -104,3 +107,29 @@ TEST(Collision, MeshShape)
   auto result = collision.GetShape();
   ASSERT_NE(nullptr, result);
 }
+
+/////////////////////////////////////////////////
+TEST(Collision, ShareShape)
+{
+  // shared shapes are read only and copied when a shape is set
+  static_assert(std::is_same<const Shape *,
+      decltype(std::declval<Collision &>().GetShape())>::value,
+      "shapes must be read only");
+
+  Collision collision;
+  BoxShape boxShape;
+  boxShape.SetSize(math::Vector3d(1, 1, 1));
+  collision.SetShape(boxShape);
+
+  Collision collision2;
+  collision2.ShareShape(collision);
+  EXPECT_EQ(collision.GetShape(), collision2.GetShape());
+
+  boxShape.SetSize(math::Vector3d(2, 2, 2));
+  collision2.SetShape(boxShape);
+  EXPECT_NE(collision.GetShape(), collision2.GetShape());
+  EXPECT_EQ(math::Vector3d(1, 1, 1),
+      static_cast<const BoxShape *>(collision.GetShape())->GetSize());
+  EXPECT_EQ(math::Vector3d(2, 2, 2),
+      static_cast<const BoxShape *>(collision2.GetShape())->GetSize());
+}
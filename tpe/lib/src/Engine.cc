@@ -17,6 +17,9 @@
 
 #include <string>
 #include <map>
+#include <vector>
+
+#include <ignition/common/Profiler.hh>
 
 #include "World.hh"
 #include "Engine.hh"
@@ -26,7 +29,7 @@ using namespace physics;
 using namespace tpelib;
 
 /////////////////////////////////////////////////
-Engine::Engine()
+Engine::Engine() : threadPool(std::make_shared<ThreadPool>())
 {
 }
 
@@ -73,3 +76,48 @@ bool Engine::RemoveWorldById(std::size_t _worldId)
   }
   return false;
 }
+
+/////////////////////////////////////////////////
+Entity &Engine::CloneWorld(std::size_t _worldId)
+{
+  auto it = this->worlds.find(_worldId);
+  if (it == this->worlds.end())
+    return Entity::kNullEntity;
+
+  auto clone = static_cast<World *>(it->second.get())->Clone();
+  const auto[cloneIt, success] =
+    this->worlds.insert({clone->GetId(), clone});
+  return *cloneIt->second;
+}
+
+/////////////////////////////////////////////////
+void Engine::SetThreadCount(unsigned int _threadCount)
+{
+  this->threadPool->SetThreadCount(_threadCount);
+}
+
+/////////////////////////////////////////////////
+unsigned int Engine::GetThreadCount() const
+{
+  return this->threadPool->ThreadCount();
+}
+
+/////////////////////////////////////////////////
+void Engine::StepWorlds()
+{
+  std::vector<World *> worldPtrs;
+  worldPtrs.reserve(this->worlds.size());
+  for (auto &it : this->worlds)
+    worldPtrs.push_back(static_cast<World *>(it.second.get()));
+  this->StepWorlds(worldPtrs);
+}
+
+/////////////////////////////////////////////////
+void Engine::StepWorlds(const std::vector<World *> &_worlds)
+{
+  IGN_PROFILE("tpelib::Engine::StepWorlds");
+  this->threadPool->ParallelForEach(_worlds.size(), [&](std::size_t _index)
+  {
+    _worlds[_index]->Step();
+  });
+}
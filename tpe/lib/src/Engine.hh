@@ -20,12 +20,14 @@
 
 #include <map>
 #include <memory>
+#include <vector>
 
 #include <ignition/utilities/SuppressWarning.hh>
 
 #include "ignition/physics/tpelib/Export.hh"
 
 #include "Entity.hh"
+#include "ThreadPool.hh"
 
 namespace ignition {
 namespace physics {
@@ -62,9 +64,39 @@ class IGNITION_PHYSICS_TPELIB_VISIBLE Engine
   /// \return true/false if world is removed/not
   public: bool RemoveWorldById(std::size_t _worldId);
 
+  /// \brief Add a copy of a world to the engine, see World::Clone. A world
+  /// can be copied several times and the copies stepped in parallel with
+  /// StepWorlds, e.g. to try different actions from the same state.
+  /// \param[in] _worldId Id of the world to copy
+  /// \return Copy of the world, or a null entity if the world is not found
+  public: Entity &CloneWorld(std::size_t _worldId);
+
+  /// \brief Set the number of threads used to step worlds in parallel
+  /// \param[in] _threadCount Number of threads. 1 steps worlds on the
+  /// calling thread only and 0 uses the number of hardware threads.
+  public: void SetThreadCount(unsigned int _threadCount);
+
+  /// \brief Get the number of threads used to step worlds in parallel
+  /// \return Number of threads
+  public: unsigned int GetThreadCount() const;
+
+  /// \brief Step all worlds in the engine once, in parallel
+  public: void StepWorlds();
+
+  /// \brief Step a set of worlds once, in parallel. Each world is stepped
+  /// by a single thread, and a thread that finishes a world takes the next
+  /// one that has not been started, so worlds of different sizes keep all
+  /// threads busy. Worlds may be owned by this engine or not. This function
+  /// returns once all worlds are stepped.
+  /// \param[in] _worlds Worlds to step, each world at most once
+  public: void StepWorlds(const std::vector<World *> &_worlds);
+
   IGN_UTILS_WARN_IGNORE__DLL_INTERFACE_MISSING
   /// \brief World entities in engine
   protected: std::map<std::size_t, std::shared_ptr<Entity>> worlds;
+
+  /// \brief Thread pool used to step worlds
+  protected: std::shared_ptr<ThreadPool> threadPool;
   IGN_UTILS_WARN_RESUME__DLL_INTERFACE_MISSING
 };
 
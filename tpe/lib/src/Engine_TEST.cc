@@ -17,8 +17,15 @@
 
 #include <gtest/gtest.h>
 
-#include "World.hh"
+#include <string>
+#include <vector>
+
+#include "Collision.hh"
 #include "Engine.hh"
+#include "Link.hh"
+#include "Model.hh"
+#include "Shape.hh"
+#include "World.hh"
 
 using namespace ignition;
 using namespace physics;
@@ -61,3 +68,206 @@ TEST(Engine, World)
   Entity nullWorld = engine.GetWorldById(worldId);
   EXPECT_EQ(Entity::kNullEntity.GetId(), nullWorld.GetId());
 }
+
+/////////////////////////////////////////////////
+TEST(Engine, StepWorlds)
+{
+  Engine engine;
+  EXPECT_EQ(1u, engine.GetThreadCount());
+  engine.SetThreadCount(4u);
+  EXPECT_EQ(4u, engine.GetThreadCount());
+
+  // worlds of different sizes, each with a row of falling boxes that
+  // overlap their neighbors
+  BoxShape boxShape;
+  boxShape.SetSize(math::Vector3d(1, 1, 1));
+  const std::size_t worldCount = 12u;
+  std::vector<World *> worlds;
+  for (std::size_t w = 0u; w < worldCount; ++w)
+  {
+    World *world = static_cast<World *>(&engine.AddWorld());
+    for (std::size_t i = 0u; i < 10u * (w + 1u); ++i)
+    {
+      Model &model = static_cast<Model &>(world->AddModel());
+      model.SetPose(math::Pose3d(0.75 * i, 0, 0, 0, 0, 0));
+      model.SetLinearVelocity(math::Vector3d(0, 0, -1));
+      Link &link = static_cast<Link &>(model.AddLink());
+      static_cast<Collision &>(link.AddCollision()).SetShape(boxShape);
+    }
+    worlds.push_back(world);
+  }
+
+  // step all worlds owned by the engine
+  engine.StepWorlds();
+  for (std::size_t w = 0u; w < worldCount; ++w)
+  {
+    EXPECT_DOUBLE_EQ(worlds[w]->GetTimeStep(), worlds[w]->GetTime());
+    EXPECT_EQ(10u * (w + 1u) - 1u, worlds[w]->GetContactCount());
+  }
+
+  // step a subset of worlds while other threads look up missing entities,
+  // which all share the null entity
+  std::vector<World *> subset = {worlds[0], worlds[5], worlds[11]};
+  engine.StepWorlds(subset);
+  EXPECT_DOUBLE_EQ(2.0 * worlds[0]->GetTimeStep(), worlds[0]->GetTime());
+  EXPECT_DOUBLE_EQ(worlds[1]->GetTimeStep(), worlds[1]->GetTime());
+  EXPECT_DOUBLE_EQ(2.0 * worlds[11]->GetTimeStep(), worlds[11]->GetTime());
+  ThreadPool pool(4u);
+  pool.ParallelForEach(worldCount, [&](std::size_t _index)
+  {
+    Entity &missing = worlds[_index]->GetChildByName("missing");
+    EXPECT_EQ(kNullEntityId, missing.GetId());
+    EXPECT_EQ(math::AxisAlignedBox(), missing.GetBoundingBox());
+    EXPECT_EQ(0u, missing.GetCollideBitmask());
+  });
+
+  // stepping in parallel gives the same poses as stepping serially
+  Model &model = static_cast<Model &>(worlds[3]->GetChildByIndex(2u));
+  EXPECT_EQ(math::Pose3d(1.5, 0, -0.1, 0, 0, 0), model.GetPose());
+  engine.SetThreadCount(1u);
+  engine.StepWorlds();
+  EXPECT_EQ(math::Pose3d(1.5, 0, -0.2, 0, 0, 0), model.GetPose());
+}
+
+/////////////////////////////////////////////////
+TEST(Engine, CloneWorld)
+{
+  Engine engine;
+  engine.SetThreadCount(4u);
+  EXPECT_EQ(kNullEntityId, engine.CloneWorld(kNullEntityId).GetId());
+
+  // a row of boxes that overlap their neighbors, half of them sliding
+  // sideways so that some contacts end
+  BoxShape boxShape;
+  boxShape.SetSize(math::Vector3d(1, 1, 1));
+  World &world = static_cast<World &>(engine.AddWorld());
+  world.SetName("world");
+  world.SetSleepSteps(2u);
+  for (std::size_t i = 0u; i < 20u; ++i)
+  {
+    Model &model = static_cast<Model &>(world.AddModel());
+    model.SetName("model" + std::to_string(i));
+    model.SetPose(math::Pose3d(0.75 * i, 0, 0, 0, 0, 0));
+    if (i % 2u == 0u)
+      model.SetLinearVelocity(math::Vector3d(0, 1, 0));
+    Link &link = static_cast<Link &>(model.AddLink());
+    link.SetPose(math::Pose3d(0, 0, 0.1, 0, 0, 0));
+    Collision &collision = static_cast<Collision &>(link.AddCollision());
+    collision.SetShape(boxShape);
+    collision.SetCollideBitmask(0x03);
+  }
+  for (int i = 0; i < 3; ++i)
+    world.Step();
+  ASSERT_LT(0u, world.GetContactCount());
+
+  // fork the world
+  std::vector<World *> forks;
+  for (int i = 0; i < 4; ++i)
+    forks.push_back(static_cast<World *>(&engine.CloneWorld(world.GetId())));
+  EXPECT_EQ(5u, engine.GetWorldCount());
+
+  for (World *fork : forks)
+  {
+    EXPECT_NE(world.GetId(), fork->GetId());
+    EXPECT_EQ("world", fork->GetName());
+    EXPECT_DOUBLE_EQ(world.GetTime(), fork->GetTime());
+    EXPECT_EQ(2u, fork->GetSleepSteps());
+    ASSERT_EQ(world.GetChildCount(), fork->GetChildCount());
+    for (unsigned int i = 0u; i < world.GetChildCount(); ++i)
+    {
+      Model &model = static_cast<Model &>(world.GetChildByIndex(i));
+      Model &modelCopy = static_cast<Model &>(fork->GetChildByIndex(i));
+      EXPECT_NE(model.GetId(), modelCopy.GetId());
+      EXPECT_EQ(model.GetName(), modelCopy.GetName());
+      EXPECT_EQ(model.GetPose(), modelCopy.GetPose());
+      EXPECT_EQ(model.GetLinearVelocity(), modelCopy.GetLinearVelocity());
+      EXPECT_EQ(model.IsSleeping(), modelCopy.IsSleeping());
+
+      Link &link = static_cast<Link &>(model.GetChildByIndex(0u));
+      Link &linkCopy = static_cast<Link &>(modelCopy.GetChildByIndex(0u));
+      EXPECT_NE(link.GetId(), linkCopy.GetId());
+      EXPECT_EQ(link.GetPose(), linkCopy.GetPose());
+
+      // shapes are shared
+      Collision &collision =
+          static_cast<Collision &>(link.GetChildByIndex(0u));
+      Collision &collisionCopy =
+          static_cast<Collision &>(linkCopy.GetChildByIndex(0u));
+      EXPECT_NE(collision.GetId(), collisionCopy.GetId());
+      EXPECT_EQ(collision.GetShape(), collisionCopy.GetShape());
+      EXPECT_EQ(0x03, collisionCopy.GetCollideBitmask());
+    }
+
+    // contacts refer to the copied entities
+    auto contacts = world.GetContacts();
+    auto contactsCopy = fork->GetContacts();
+    ASSERT_EQ(contacts.size(), contactsCopy.size());
+    for (std::size_t i = 0u; i < contacts.size(); ++i)
+    {
+      EXPECT_EQ(contacts[i].id, contactsCopy[i].id);
+      EXPECT_EQ(world.GetChildById(contacts[i].entity1).GetName(),
+          fork->GetChildById(contactsCopy[i].entity1).GetName());
+      EXPECT_EQ(world.GetChildById(contacts[i].entity2).GetName(),
+          fork->GetChildById(contactsCopy[i].entity2).GetName());
+    }
+  }
+
+  // change the first fork only: move a model and replace a shape
+  Model &movedModel = static_cast<Model &>(forks[1]->GetChildByIndex(0u));
+  movedModel.SetPose(math::Pose3d(0, 10, 0, 0, 0, 0));
+  Collision &resized = static_cast<Collision &>(
+      movedModel.GetChildByIndex(0u).GetChildByIndex(0u));
+  BoxShape smallShape;
+  smallShape.SetSize(math::Vector3d(0.1, 0.1, 0.1));
+  resized.SetShape(smallShape);
+  Model &model0 = static_cast<Model &>(world.GetChildByIndex(0u));
+  Collision &collision0 = static_cast<Collision &>(
+      model0.GetChildByIndex(0u).GetChildByIndex(0u));
+  EXPECT_NE(collision0.GetShape(), resized.GetShape());
+  EXPECT_EQ(math::Vector3d(1, 1, 1),
+      static_cast<const BoxShape *>(collision0.GetShape())->GetSize());
+  EXPECT_NE(math::Pose3d(0, 10, 0, 0, 0, 0), model0.GetPose());
+
+  // step the source world and the forks in parallel. The unchanged forks
+  // give the same results as the source world.
+  for (int s = 0; s < 5; ++s)
+  {
+    engine.StepWorlds();
+    auto contacts = world.GetContacts();
+    auto events = world.GetContactEvents();
+    for (std::size_t f : {0u, 2u, 3u})
+    {
+      World *fork = forks[f];
+      for (unsigned int i = 0u; i < world.GetChildCount(); ++i)
+      {
+        EXPECT_EQ(world.GetChildByIndex(i).GetPose(),
+            fork->GetChildByIndex(i).GetPose());
+      }
+      auto contactsCopy = fork->GetContacts();
+      ASSERT_EQ(contacts.size(), contactsCopy.size());
+      for (std::size_t i = 0u; i < contacts.size(); ++i)
+      {
+        EXPECT_EQ(contacts[i].id, contactsCopy[i].id);
+        EXPECT_EQ(contacts[i].point, contactsCopy[i].point);
+        EXPECT_DOUBLE_EQ(contacts[i].depth, contactsCopy[i].depth);
+        EXPECT_EQ(world.GetChildById(contacts[i].entity1).GetName(),
+            fork->GetChildById(contactsCopy[i].entity1).GetName());
+      }
+      auto eventsCopy = fork->GetContactEvents();
+      ASSERT_EQ(events.size(), eventsCopy.size());
+      for (std::size_t i = 0u; i < events.size(); ++i)
+      {
+        EXPECT_EQ(events[i].type, eventsCopy[i].type);
+        EXPECT_EQ(events[i].id, eventsCopy[i].id);
+      }
+    }
+  }
+  EXPECT_NE(world.GetContactCount(), forks[1]->GetContactCount());
+
+  // the source world can be removed while its forks use its shapes
+  engine.RemoveWorldById(world.GetId());
+  forks[0]->Step();
+  EXPECT_EQ(math::Vector3d(1, 1, 1), static_cast<const BoxShape *>(
+      static_cast<Collision &>(forks[0]->GetChildByIndex(0u)
+      .GetChildByIndex(0u).GetChildByIndex(0u)).GetShape())->GetSize());
+}
@@ -15,7 +15,13 @@
  *
 */
 
+#include <algorithm>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
 #include "Entity.hh"
+#include "EntityPool.hh"
 #include "Utils.hh"
 
 /// \brief Private data class for entity
@@ -33,6 +39,10 @@ class ignition::physics::tpelib::EntityPrivate
   /// \brief Child entities
   public: std::map<std::size_t, std::shared_ptr<Entity>> children;
 
+  /// \brief Ids of the child entities with each name, in increasing order
+  public: std::unordered_map<std::string, std::vector<std::size_t>>
+      childNames;
+
   /// \brief Bounding Box
   public: math::AxisAlignedBox bbox;
 
@@ -42,22 +52,94 @@ class ignition::physics::tpelib::EntityPrivate
   /// \brief Flag to indicate if bounding box changed
   public: bool bboxDirty = true;
 
+  /// \brief Flag to indicate if the boxes of all children need to be
+  /// transformed again because it is not known which children changed
+  public: bool bboxRefitAll = true;
+
+  /// \brief Flag to indicate if the bounding box needs to be merged again
+  /// from the boxes of all children because it may have shrunk
+  public: bool bboxMergeAll = false;
+
+  /// \brief Bounding boxes of the children in the frame of this entity, as
+  /// of the last bounding box update
+  public: std::unordered_map<std::size_t, math::AxisAlignedBox> childBoxes;
+
+  /// \brief Ids of the children whose bounding box or pose changed since
+  /// the last bounding box update, possibly repeated
+  public: std::vector<std::size_t> changedChildren;
+
   /// \brief Flag to indicate if pose changed
   public: bool poseDirty = false;
 
+  /// \brief Cached world pose, valid if worldPoseDirty is false
+  public: math::Pose3d worldPose;
+
+  /// \brief Flag to indicate if the cached world pose needs to be
+  /// recomputed. If an entity's flag is set, the flags of all its
+  /// descendants are set as well.
+  public: bool worldPoseDirty = true;
+
   /// \brief Flag to indicate if collide bitmask changed
   public: bool collideBitmaskDirty = true;
 
   /// \brief Parent of this entity
   public: Entity *parent = nullptr;
+
+  /// \brief Pool this data and the entity were allocated from
+  public: std::shared_ptr<EntityPool> pool;
 };
 
 using namespace ignition;
 using namespace physics;
 using namespace tpelib;
 
-std::size_t Entity::nextId = 0;
-Entity Entity::kNullEntity = Entity(kNullEntityId);
+/// \brief Check if a box touches the boundary of the box it was merged into
+/// \param[in] _box Non empty box merged into _bounds, or empty box
+/// \param[in] _bounds Box that contains _box
+/// \return True if a face of _box lies on a face of _bounds
+static bool touchesBoundary(const math::AxisAlignedBox &_box,
+    const math::AxisAlignedBox &_bounds)
+{
+  if (_box == math::AxisAlignedBox())
+    return false;
+
+  for (int i = 0; i < 3; ++i)
+  {
+    if (_box.Min()[i] <= _bounds.Min()[i] || _box.Max()[i] >= _bounds.Max()[i])
+      return true;
+  }
+  return false;
+}
+
+/// \brief Check if a box contains another box
+/// \param[in] _outer Outer box
+/// \param[in] _inner Inner box
+/// \return True if _inner is inside _outer
+static bool containsBox(const math::AxisAlignedBox &_outer,
+    const math::AxisAlignedBox &_inner)
+{
+  for (int i = 0; i < 3; ++i)
+  {
+    if (_inner.Min()[i] < _outer.Min()[i] || _inner.Max()[i] > _outer.Max()[i])
+      return false;
+  }
+  return true;
+}
+
+std::atomic<std::size_t> Entity::nextId{0u};
+// The bounding box and collide bitmask of the null entity are up to date so
+// that reading them, possibly from several threads at once, never writes to
+// the shared instance.
+Entity Entity::kNullEntity = []()
+{
+  Entity entity(kNullEntityId);
+  entity.dataPtr->collideBitmask = 0u;
+  entity.dataPtr->bboxDirty = false;
+  entity.dataPtr->bboxRefitAll = false;
+  entity.dataPtr->collideBitmaskDirty = false;
+  entity.dataPtr->worldPoseDirty = false;
+  return entity;
+}();
 
 //////////////////////////////////////////////////
 Entity::Entity()
@@ -72,8 +154,10 @@ Entity::Entity(const Entity &_other)
 {
   this->dataPtr->id = _other.dataPtr->id;
   this->dataPtr->name = _other.dataPtr->name;
-  this->dataPtr->pose = _other.dataPtr->pose;
+  // derived classes may store their pose elsewhere
+  this->dataPtr->pose = _other.GetPose();
   this->dataPtr->children = _other.dataPtr->children;
+  this->dataPtr->childNames = _other.dataPtr->childNames;
   this->dataPtr->bbox = _other.dataPtr->bbox;
   this->dataPtr->collideBitmask = _other.dataPtr->collideBitmask;
 }
@@ -94,10 +178,22 @@ Entity::Entity(std::size_t _id)
   this->dataPtr->id = _id;
 }
 
+//////////////////////////////////////////////////
+Entity::Entity(std::size_t _id, std::shared_ptr<EntityPool> _pool)
+  : dataPtr(poolNew<EntityPrivate>(_pool.get()))
+{
+  this->dataPtr->id = _id;
+  this->dataPtr->pool = std::move(_pool);
+}
+
 //////////////////////////////////////////////////
 Entity::~Entity()
 {
-  delete this->dataPtr;
+  // the data holds a reference to its pool, which is released last
+  std::shared_ptr<EntityPool> pool;
+  if (this->dataPtr)
+    pool = std::move(this->dataPtr->pool);
+  poolDelete(pool.get(), this->dataPtr);
   this->dataPtr = nullptr;
 }
 
@@ -105,12 +201,24 @@ Entity::~Entity()
 Entity &Entity::operator=(const Entity &_other)
 {
   this->dataPtr->children = _other.dataPtr->children;
+  this->dataPtr->childNames = _other.dataPtr->childNames;
+  this->dataPtr->bboxDirty = true;
+  this->dataPtr->bboxRefitAll = true;
+  this->dataPtr->collideBitmaskDirty = true;
   return *this;
 }
 
 //////////////////////////////////////////////////
 void Entity::SetName(const std::string &_name)
 {
+  if (this->dataPtr->parent)
+  {
+    this->dataPtr->parent->RemoveChildName(*this);
+    this->dataPtr->name = _name;
+    this->dataPtr->parent->AddChildName(*this);
+    return;
+  }
+
   this->dataPtr->name = _name;
 }
 
@@ -130,7 +238,17 @@ const std::string &Entity::GetNameRef() const
 void Entity::SetPose(const math::Pose3d &_pose)
 {
   this->dataPtr->pose = _pose;
+  this->PoseChanged();
+}
+
+//////////////////////////////////////////////////
+void Entity::PoseChanged()
+{
   this->dataPtr->poseDirty = true;
+  this->InvalidateWorldPose();
+
+  if (this->dataPtr->parent)
+    this->dataPtr->parent->ChildChanged(*this);
 }
 
 //////////////////////////////////////////////////
@@ -142,10 +260,34 @@ math::Pose3d Entity::GetPose() const
 //////////////////////////////////////////////////
 math::Pose3d Entity::GetWorldPose() const
 {
-  if (this->dataPtr->parent)
-    return this->dataPtr->parent->GetWorldPose() * this->dataPtr->pose;
+  if (this->dataPtr->worldPoseDirty)
+  {
+    if (this->dataPtr->parent)
+    {
+      this->dataPtr->worldPose =
+          this->dataPtr->parent->GetWorldPose() * this->GetPose();
+    }
+    else
+    {
+      this->dataPtr->worldPose = this->GetPose();
+    }
+    this->dataPtr->worldPoseDirty = false;
+  }
 
-  return this->dataPtr->pose;
+  return this->dataPtr->worldPose;
+}
+
+//////////////////////////////////////////////////
+void Entity::InvalidateWorldPose()
+{
+  // the descendants of an entity whose world pose is out of date are out of
+  // date as well
+  if (this->dataPtr->worldPoseDirty)
+    return;
+
+  this->dataPtr->worldPoseDirty = true;
+  for (auto &it : this->dataPtr->children)
+    it.second->InvalidateWorldPose();
 }
 
 //////////////////////////////////////////////////
@@ -175,16 +317,11 @@ Entity &Entity::GetChildById(std::size_t _id) const
 //////////////////////////////////////////////////
 Entity &Entity::GetChildByName(const std::string &_name) const
 {
-  for (auto it = this->dataPtr->children.begin();
-      it != this->dataPtr->children.end(); ++it)
-  {
-    if (it->second->GetName() == _name)
-    {
-      return *it->second.get();
-    }
-  }
+  auto nameIt = this->dataPtr->childNames.find(_name);
+  if (nameIt == this->dataPtr->childNames.end())
+    return kNullEntity;
 
-  return kNullEntity;
+  return this->GetChildById(nameIt->second.front());
 }
 
 //////////////////////////////////////////////////
@@ -209,8 +346,20 @@ bool Entity::RemoveChildById(std::size_t _id)
   auto it = this->dataPtr->children.find(_id);
   if (it != this->dataPtr->children.end())
   {
+    this->RemoveChildName(*it->second);
+    it->second->dataPtr->parent = nullptr;
+    it->second->InvalidateWorldPose();
     this->dataPtr->children.erase(it);
-    this->ChildrenChanged();
+
+    // the bounding box only shrinks if the child was on its boundary
+    auto boxIt = this->dataPtr->childBoxes.find(_id);
+    if (boxIt != this->dataPtr->childBoxes.end())
+    {
+      if (touchesBoundary(boxIt->second, this->dataPtr->bbox))
+        this->dataPtr->bboxMergeAll = true;
+      this->dataPtr->childBoxes.erase(boxIt);
+    }
+    this->MarkChanged();
     return true;
   }
 
@@ -220,17 +369,11 @@ bool Entity::RemoveChildById(std::size_t _id)
 //////////////////////////////////////////////////
 bool Entity::RemoveChildByName(const std::string &_name)
 {
-  for (auto it = this->dataPtr->children.begin();
-      it != this->dataPtr->children.end(); ++it)
-  {
-    if (it->second->GetName() == _name)
-    {
-      this->dataPtr->children.erase(it);
-      this->ChildrenChanged();
-      return true;
-    }
-  }
-  return false;
+  auto nameIt = this->dataPtr->childNames.find(_name);
+  if (nameIt == this->dataPtr->childNames.end())
+    return false;
+
+  return this->RemoveChildById(nameIt->second.front());
 }
 
 //////////////////////////////////////////////////
@@ -239,6 +382,14 @@ size_t Entity::GetChildCount() const
   return this->dataPtr->children.size();
 }
 
+//////////////////////////////////////////////////
+void Entity::VisitChildren(
+    const std::function<void(Entity &)> &_visitor) const
+{
+  for (const auto &it : this->dataPtr->children)
+    _visitor(*it.second);
+}
+
 //////////////////////////////////////////////////
 math::AxisAlignedBox Entity::GetBoundingBox(bool _force)
 {
@@ -253,16 +404,84 @@ math::AxisAlignedBox Entity::GetBoundingBox(bool _force)
 //////////////////////////////////////////////////
 void Entity::UpdateBoundingBox(bool _force)
 {
-  math::AxisAlignedBox box;
-  for (auto &it : this->dataPtr->children)
+  auto &children = this->dataPtr->children;
+  auto &childBoxes = this->dataPtr->childBoxes;
+  auto &changed = this->dataPtr->changedChildren;
+  math::AxisAlignedBox &box = this->dataPtr->bbox;
+
+  if (_force || this->dataPtr->bboxRefitAll)
+  {
+    changed.clear();
+    for (auto &it : children)
+      changed.push_back(it.first);
+    childBoxes.clear();
+    box = math::AxisAlignedBox();
+    this->dataPtr->bboxMergeAll = false;
+  }
+  else
   {
-    auto transformedBox =
-        transformAxisAlignedBox(it.second->GetBoundingBox(_force),
-        it.second->GetPose());
-    box.Merge(transformedBox);
+    std::sort(changed.begin(), changed.end());
+    changed.erase(std::unique(changed.begin(), changed.end()), changed.end());
   }
 
-  this->dataPtr->bbox = box;
+  // transform the boxes of the changed children in batches. Boxes that grow
+  // are merged into the bounding box. If a child on the boundary of the
+  // bounding box shrinks or moves, the bounding box is merged again from
+  // the boxes of all children once they are up to date.
+  bool mergeAll = this->dataPtr->bboxMergeAll;
+  auto setChildBox = [&](std::size_t _id, const math::AxisAlignedBox &_box)
+  {
+    math::AxisAlignedBox &childBox = childBoxes[_id];
+    if (!mergeAll && touchesBoundary(childBox, box) &&
+        !containsBox(_box, childBox))
+    {
+      mergeAll = true;
+    }
+    childBox = _box;
+    if (!mergeAll && _box != math::AxisAlignedBox())
+      box.Merge(_box);
+  };
+
+  AxisAlignedBoxBatch batch;
+  std::size_t batchIds[AxisAlignedBoxBatch::kCapacity];
+  auto refitBatch = [&]()
+  {
+    transformAxisAlignedBoxes(batch);
+    for (std::size_t i = 0u; i < batch.Size(); ++i)
+      setChildBox(batchIds[i], batch.Box(i));
+    batch.Clear();
+  };
+  for (std::size_t id : changed)
+  {
+    // removed children are dropped from the boxes when they are removed
+    auto it = children.find(id);
+    if (it == children.end())
+      continue;
+
+    math::AxisAlignedBox childBox = it->second->GetBoundingBox(_force);
+    if (childBox == math::AxisAlignedBox())
+    {
+      setChildBox(id, childBox);
+      continue;
+    }
+    batchIds[batch.Add(childBox, it->second->GetPose())] = id;
+    if (batch.Full())
+      refitBatch();
+  }
+  refitBatch();
+  changed.clear();
+
+  if (mergeAll)
+  {
+    box = math::AxisAlignedBox();
+    for (auto &it : childBoxes)
+    {
+      if (it.second != math::AxisAlignedBox())
+        box.Merge(it.second);
+    }
+  }
+  this->dataPtr->bboxRefitAll = false;
+  this->dataPtr->bboxMergeAll = false;
 }
 
 //////////////////////////////////////////////////
@@ -291,23 +510,80 @@ std::map<std::size_t, std::shared_ptr<Entity>> &Entity::GetChildren() const
 //////////////////////////////////////////////////
 std::size_t Entity::GetNextId()
 {
-  return nextId++;
+  return nextId.fetch_add(1u, std::memory_order_relaxed);
+}
+
+//////////////////////////////////////////////////
+std::size_t Entity::ReserveIds(std::size_t _count)
+{
+  return nextId.fetch_add(_count, std::memory_order_relaxed);
+}
+
+//////////////////////////////////////////////////
+const std::shared_ptr<EntityPool> &Entity::GetEntityPool() const
+{
+  return this->dataPtr->pool;
+}
+
+//////////////////////////////////////////////////
+std::size_t Entity::AllocateId()
+{
+  if (this->dataPtr->parent)
+    return this->dataPtr->parent->AllocateId();
+
+  return GetNextId();
 }
 
 //////////////////////////////////////////////////
 void Entity::ChildrenChanged()
+{
+  this->dataPtr->bboxRefitAll = true;
+  this->dataPtr->changedChildren.clear();
+  this->MarkChanged();
+}
+
+//////////////////////////////////////////////////
+void Entity::ChildChanged(Entity &_child)
+{
+  // the changed children are bounded by the number of children, beyond
+  // which all children are refit
+  if (!this->dataPtr->bboxRefitAll)
+  {
+    auto &changed = this->dataPtr->changedChildren;
+    if (changed.size() < this->dataPtr->children.size())
+    {
+      changed.push_back(_child.GetId());
+    }
+    else
+    {
+      this->dataPtr->bboxRefitAll = true;
+      changed.clear();
+    }
+  }
+  this->MarkChanged();
+}
+
+//////////////////////////////////////////////////
+void Entity::MarkChanged()
 {
   this->dataPtr->bboxDirty = true;
   this->dataPtr->collideBitmaskDirty = true;
 
   if (this->dataPtr->parent)
-    this->dataPtr->parent->ChildrenChanged();
+    this->dataPtr->parent->ChildChanged(*this);
 }
 
 //////////////////////////////////////////////////
 void Entity::SetParent(Entity *_parent)
 {
+  if (this->dataPtr->parent)
+    this->dataPtr->parent->RemoveChildName(*this);
+
   this->dataPtr->parent = _parent;
+  this->InvalidateWorldPose();
+
+  if (this->dataPtr->parent)
+    this->dataPtr->parent->AddChildName(*this);
 }
 
 //////////////////////////////////////////////////
@@ -319,7 +595,7 @@ Entity *Entity::GetParent() const
 //////////////////////////////////////////////////
 bool Entity::PoseDirty() const
 {
-  return this->dataPtr->poseDirty = true;
+  return this->dataPtr->poseDirty;
 }
 
 //////////////////////////////////////////////////
@@ -327,3 +603,28 @@ void Entity::ResetPoseDirty()
 {
   this->dataPtr->poseDirty = false;
 }
+
+//////////////////////////////////////////////////
+void Entity::AddChildName(const Entity &_child)
+{
+  // ids are kept sorted so that the child with the lowest id is found first
+  auto &ids = this->dataPtr->childNames[_child.GetNameRef()];
+  auto idIt = std::lower_bound(ids.begin(), ids.end(), _child.GetId());
+  if (idIt == ids.end() || *idIt != _child.GetId())
+    ids.insert(idIt, _child.GetId());
+}
+
+//////////////////////////////////////////////////
+void Entity::RemoveChildName(const Entity &_child)
+{
+  auto nameIt = this->dataPtr->childNames.find(_child.GetNameRef());
+  if (nameIt == this->dataPtr->childNames.end())
+    return;
+
+  auto &ids = nameIt->second;
+  auto idIt = std::lower_bound(ids.begin(), ids.end(), _child.GetId());
+  if (idIt != ids.end() && *idIt == _child.GetId())
+    ids.erase(idIt);
+  if (ids.empty())
+    this->dataPtr->childNames.erase(nameIt);
+}
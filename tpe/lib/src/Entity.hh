@@ -18,7 +18,9 @@
 #ifndef IGNITION_PHYSICS_TPE_LIB_SRC_ENTITY_HH_
 #define IGNITION_PHYSICS_TPE_LIB_SRC_ENTITY_HH_
 
+#include <atomic>
 #include <cstddef>
+#include <functional>
 #include <map>
 #include <memory>
 #include <string>
@@ -32,6 +34,7 @@ namespace physics {
 namespace tpelib {
 
 // forward declaration
+class EntityPool;
 class EntityPrivate;
 
 /// \brief Represents an invalid Id.
@@ -59,6 +62,12 @@ class IGNITION_PHYSICS_TPELIB_VISIBLE Entity
   /// \param[in] _id Id to set the entity to
   protected: explicit Entity(std::size_t _id);
 
+  /// \brief Constructor with id that allocates the private data of the
+  /// entity from a pool
+  /// \param[in] _id Id to set the entity to
+  /// \param[in] _pool Pool to allocate from, null to use the heap
+  protected: Entity(std::size_t _id, std::shared_ptr<EntityPool> _pool);
+
   /// \brief Destructor
   public: ~Entity();
 
@@ -94,7 +103,10 @@ class IGNITION_PHYSICS_TPELIB_VISIBLE Entity
   /// \return Pose of entity
   public: virtual math::Pose3d GetPose() const;
 
-  /// \brief Get the world pose of the entity
+  /// \brief Get the world pose of the entity. The world pose is cached
+  /// and only recomputed after the pose of the entity or of one of its
+  /// ancestors changes. Computing it updates the cache, so it should not be
+  /// called concurrently on entities of the same world.
   /// \return World pose of entity
   public: virtual math::Pose3d GetWorldPose() const;
 
@@ -103,7 +115,9 @@ class IGNITION_PHYSICS_TPELIB_VISIBLE Entity
   /// \return Child entity
   public: virtual Entity &GetChildById(std::size_t _id) const;
 
-  /// \brief Get a child entity by name
+  /// \brief Get a child entity by name. Children are indexed by name so
+  /// the lookup takes constant time. If several children have the same
+  /// name, the one with the lowest id is returned.
   /// \param[in] _name Name of child entity
   /// \return Child entity
   public: virtual Entity &GetChildByName(const std::string &_name) const;
@@ -130,6 +144,13 @@ class IGNITION_PHYSICS_TPELIB_VISIBLE Entity
   /// \return Number of children
   public: virtual size_t GetChildCount() const;
 
+  /// \brief Call a function on each child entity in the order of their
+  /// ids. This walks the children once, unlike calling GetChildByIndex for
+  /// each index.
+  /// \param[in] _visitor Function called on each child
+  public: void VisitChildren(
+      const std::function<void(Entity &)> &_visitor) const;
+
   /// \brief Get bounding box of entity
   /// \param[in] _force True to force update bounding box
   /// \return Entity bounding box
@@ -160,10 +181,59 @@ class IGNITION_PHYSICS_TPELIB_VISIBLE Entity
 
   /// \internal
   /// \brief Mark that the children of the entity has changed, e.g. a child
-  /// entity is added or removed, or child entity properties changed.
+  /// entity is added or removed, or child entity properties changed. The
+  /// boxes of all children are refit in the next bounding box update. Use
+  /// ChildChanged instead when the child that changed is known.
   public: void ChildrenChanged();
 
-  /// \brief Get number of children
+  /// \internal
+  /// \brief Get the pool the entity was allocated from. Child entities are
+  /// allocated from the same pool.
+  /// \return Pool of the entity's world, or null if the entity was not
+  /// created in a world
+  public: const std::shared_ptr<EntityPool> &GetEntityPool() const;
+
+  /// \internal
+  /// \brief Allocate an id for a new entity in the tree of this entity. By
+  /// default the id is allocated by the parent entity, and by the process
+  /// wide counter if there is no parent.
+  /// \return New unique id
+  public: virtual std::size_t AllocateId();
+
+  /// \internal
+  /// \brief Mark the cached world pose of this entity and of all its
+  /// descendants as out of date. Called when the pose of the entity
+  /// changes, including by derived classes or worlds that update the pose
+  /// without calling SetPose.
+  public: void InvalidateWorldPose();
+
+  /// \internal
+  /// \brief Notify this entity that one of its child entities changed, e.g.
+  /// the child was added, the child's pose was set or the child's own
+  /// children changed. By default only the box of this child is refit in
+  /// the next bounding box update.
+  /// \param[in] _child Child entity that changed
+  public: virtual void ChildChanged(Entity &_child);
+
+  /// \brief Mark that the bounding box and collide bitmask of this entity
+  /// need to be updated and notify its parent
+  private: void MarkChanged();
+
+  /// \brief Add a child entity to the index of children by name. Called
+  /// when the child's parent is set or its name changes.
+  /// \param[in] _child Child entity
+  private: void AddChildName(const Entity &_child);
+
+  /// \brief Remove a child entity from the index of children by name
+  /// \param[in] _child Child entity
+  private: void RemoveChildName(const Entity &_child);
+
+  /// \brief Mark that the pose of the entity changed and notify its parent.
+  /// Called by SetPose and by derived classes that store their own pose.
+  protected: void PoseChanged();
+
+  /// \brief Get number of children. Entities inserted in the map must have
+  /// their parent set to this entity so that they are indexed by name.
   /// \return Map of child id's to child entities
   protected: std::map<std::size_t, std::shared_ptr<Entity>> &GetChildren()
       const;
@@ -172,15 +242,22 @@ class IGNITION_PHYSICS_TPELIB_VISIBLE Entity
   /// \param[in] _force True to force update children's bounding box
   private: virtual void UpdateBoundingBox(bool _force = false);
 
-  /// \brief An invalid vertex.
+  /// \brief An invalid entity, returned by getters when an entity is not
+  /// found. It is shared by all worlds, so it is safe to read from several
+  /// threads but must not be modified.
   public: static Entity kNullEntity;
 
-  /// \brief Get the id of next entity
+  /// \brief Get the id of next entity. This is thread safe.
   /// \return size_t id of next entity
   protected: static std::size_t GetNextId();
 
+  /// \brief Reserve a range of consecutive ids. This is thread safe.
+  /// \param[in] _count Number of ids to reserve
+  /// \return First id of the range
+  protected: static std::size_t ReserveIds(std::size_t _count);
+
   /// \brief Entity id counter
-  private: static std::size_t nextId;
+  private: static std::atomic<std::size_t> nextId;
 
   /// \brief Pointer to private data class
   private: EntityPrivate *dataPtr = nullptr;
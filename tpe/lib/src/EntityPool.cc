@@ -0,0 +1,152 @@
+/*
+ * Copyright (C) 2020 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+#include <algorithm>
+#include <mutex>
+#include <vector>
+
+#include "EntityPool.hh"
+
+/// \brief Alignment and size granularity of blocks
+static const std::size_t kBlockAlignment = alignof(std::max_align_t);
+
+/// \brief Largest block size served from chunks
+static const std::size_t kMaxBlockSize = 1024u;
+
+/// \brief Number of block sizes
+static const std::size_t kSizeClassCount = kMaxBlockSize / kBlockAlignment;
+
+/// \brief Size of each chunk
+static const std::size_t kChunkSize = 64u * 1024u;
+
+namespace ignition {
+namespace physics {
+namespace tpelib {
+
+/// \brief Private data class for EntityPool
+class EntityPoolPrivate
+{
+  /// \brief Mutex protecting the pool
+  public: mutable std::mutex mutex;
+
+  /// \brief Chunks of memory
+  public: std::vector<std::unique_ptr<std::max_align_t[]>> chunks;
+
+  /// \brief Next free byte in the last chunk
+  public: unsigned char *chunkPos = nullptr;
+
+  /// \brief End of the last chunk
+  public: unsigned char *chunkEnd = nullptr;
+
+  /// \brief Heads of the lists of free blocks of each size class. Each
+  /// free block stores a pointer to the next free block.
+  public: void *freeLists[kSizeClassCount] = {};
+
+  /// \brief Number of allocated blocks
+  public: std::size_t blockCount = 0u;
+};
+
+}
+}
+}
+
+using namespace ignition;
+using namespace physics;
+using namespace tpelib;
+
+//////////////////////////////////////////////////
+EntityPool::EntityPool()
+  : dataPtr(std::make_unique<EntityPoolPrivate>())
+{
+}
+
+//////////////////////////////////////////////////
+EntityPool::~EntityPool() = default;
+
+//////////////////////////////////////////////////
+void *EntityPool::Allocate(std::size_t _size)
+{
+  if (_size > kMaxBlockSize)
+    return ::operator new(_size);
+
+  const std::size_t sizeClass =
+      (std::max<std::size_t>(_size, 1u) - 1u) / kBlockAlignment;
+  const std::size_t blockSize = (sizeClass + 1u) * kBlockAlignment;
+
+  std::lock_guard<std::mutex> lock(this->dataPtr->mutex);
+  ++this->dataPtr->blockCount;
+
+  // reuse a free block
+  void *&freeList = this->dataPtr->freeLists[sizeClass];
+  if (freeList)
+  {
+    void *block = freeList;
+    freeList = *static_cast<void **>(block);
+    return block;
+  }
+
+  // start a new chunk when the last one is full. The rest of the last chunk
+  // is left unused.
+  if (static_cast<std::size_t>(
+      this->dataPtr->chunkEnd - this->dataPtr->chunkPos) < blockSize)
+  {
+    const std::size_t count = kChunkSize / sizeof(std::max_align_t);
+    this->dataPtr->chunks.emplace_back(new std::max_align_t[count]);
+    this->dataPtr->chunkPos = reinterpret_cast<unsigned char *>(
+        this->dataPtr->chunks.back().get());
+    this->dataPtr->chunkEnd = this->dataPtr->chunkPos + kChunkSize;
+  }
+
+  void *block = this->dataPtr->chunkPos;
+  this->dataPtr->chunkPos += blockSize;
+  return block;
+}
+
+//////////////////////////////////////////////////
+void EntityPool::Deallocate(void *_ptr, std::size_t _size)
+{
+  if (!_ptr)
+    return;
+
+  if (_size > kMaxBlockSize)
+  {
+    ::operator delete(_ptr);
+    return;
+  }
+
+  const std::size_t sizeClass =
+      (std::max<std::size_t>(_size, 1u) - 1u) / kBlockAlignment;
+
+  std::lock_guard<std::mutex> lock(this->dataPtr->mutex);
+  --this->dataPtr->blockCount;
+  void *&freeList = this->dataPtr->freeLists[sizeClass];
+  *static_cast<void **>(_ptr) = freeList;
+  freeList = _ptr;
+}
+
+//////////////////////////////////////////////////
+std::size_t EntityPool::ChunkCount() const
+{
+  std::lock_guard<std::mutex> lock(this->dataPtr->mutex);
+  return this->dataPtr->chunks.size();
+}
+
+//////////////////////////////////////////////////
+std::size_t EntityPool::BlockCount() const
+{
+  std::lock_guard<std::mutex> lock(this->dataPtr->mutex);
+  return this->dataPtr->blockCount;
+}
@@ -0,0 +1,187 @@
+/*
+ * Copyright (C) 2020 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+#ifndef IGNITION_PHYSICS_TPE_LIB_SRC_ENTITYPOOL_HH_
+#define IGNITION_PHYSICS_TPE_LIB_SRC_ENTITYPOOL_HH_
+
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <utility>
+
+#include <ignition/utilities/SuppressWarning.hh>
+
+#include "ignition/physics/tpelib/Export.hh"
+
+namespace ignition {
+namespace physics {
+namespace tpelib {
+
+// forward declaration
+class EntityPoolPrivate;
+
+/// \brief A memory pool for the small objects that make up the entities of
+/// a world: entities, their private data and their shapes. Memory is taken
+/// from large chunks and freed blocks are kept in free lists per size, so
+/// creating and removing entities rarely calls the system allocator. All
+/// chunks are released at once when the pool is destroyed. Objects
+/// allocated from the pool keep it alive through their allocator, so the
+/// pool is destroyed with the last of its world and entities.
+class IGNITION_PHYSICS_TPELIB_VISIBLE EntityPool
+{
+  /// \brief Constructor
+  public: EntityPool();
+
+  /// \brief Destructor. Releases all chunks.
+  public: ~EntityPool();
+
+  /// \brief Allocate memory aligned for any fundamental type. This is
+  /// thread safe.
+  /// \param[in] _size Number of bytes. Large blocks are allocated from the
+  /// system allocator.
+  /// \return Pointer to the memory
+  public: void *Allocate(std::size_t _size);
+
+  /// \brief Return memory to the pool. This is thread safe.
+  /// \param[in] _ptr Pointer returned by Allocate
+  /// \param[in] _size Number of bytes passed to Allocate
+  public: void Deallocate(void *_ptr, std::size_t _size);
+
+  /// \brief Get the number of chunks allocated by the pool
+  /// \return Number of chunks
+  public: std::size_t ChunkCount() const;
+
+  /// \brief Get the number of blocks currently allocated from the chunks
+  /// of the pool
+  /// \return Number of blocks
+  public: std::size_t BlockCount() const;
+
+  /// \brief Pointer to private data
+  IGN_UTILS_WARN_IGNORE__DLL_INTERFACE_MISSING
+  private: std::unique_ptr<EntityPoolPrivate> dataPtr;
+  IGN_UTILS_WARN_RESUME__DLL_INTERFACE_MISSING
+};
+
+/// \brief Standard allocator that allocates from an EntityPool
+template <typename T>
+class PoolAllocator
+{
+  /// \brief Type of the allocated objects
+  public: using value_type = T;
+
+  /// \brief Constructor
+  /// \param[in] _pool Pool to allocate from
+  public: explicit PoolAllocator(std::shared_ptr<EntityPool> _pool)
+    : pool(std::move(_pool))
+  {
+  }
+
+  /// \brief Converting constructor used when rebinding the allocator
+  /// \param[in] _other Allocator of another type
+  public: template <typename U>
+  PoolAllocator(const PoolAllocator<U> &_other) // NOLINT
+    : pool(_other.pool)
+  {
+  }
+
+  /// \brief Allocate memory for objects
+  /// \param[in] _n Number of objects
+  /// \return Pointer to the memory
+  public: T *allocate(std::size_t _n)
+  {
+    static_assert(alignof(T) <= alignof(std::max_align_t),
+        "Over-aligned types can not be allocated from an EntityPool");
+    return static_cast<T *>(this->pool->Allocate(_n * sizeof(T)));
+  }
+
+  /// \brief Free memory of objects
+  /// \param[in] _ptr Pointer returned by allocate
+  /// \param[in] _n Number of objects
+  public: void deallocate(T *_ptr, std::size_t _n)
+  {
+    this->pool->Deallocate(_ptr, _n * sizeof(T));
+  }
+
+  /// \brief Pool to allocate from
+  public: std::shared_ptr<EntityPool> pool;
+};
+
+/// \brief Allocators are equal if they allocate from the same pool
+template <typename T, typename U>
+bool operator==(const PoolAllocator<T> &_a, const PoolAllocator<U> &_b)
+{
+  return _a.pool == _b.pool;
+}
+
+/// \brief Allocators are equal if they allocate from the same pool
+template <typename T, typename U>
+bool operator!=(const PoolAllocator<T> &_a, const PoolAllocator<U> &_b)
+{
+  return _a.pool != _b.pool;
+}
+
+/// \brief Create a shared object in a pool, with its reference count in
+/// the same block
+/// \param[in] _pool Pool to allocate from, or null to use make_shared
+/// \param[in] _args Constructor arguments
+/// \return Shared pointer to the new object
+template <typename T, typename... Args>
+std::shared_ptr<T> allocateShared(const std::shared_ptr<EntityPool> &_pool,
+    Args &&... _args)
+{
+  if (!_pool)
+    return std::make_shared<T>(std::forward<Args>(_args)...);
+  return std::allocate_shared<T>(PoolAllocator<T>(_pool),
+      std::forward<Args>(_args)...);
+}
+
+/// \brief Create an object in a pool
+/// \param[in] _pool Pool to allocate from, or null to use new
+/// \param[in] _args Constructor arguments
+/// \return Pointer to the new object, to be destroyed with poolDelete
+template <typename T, typename... Args>
+T *poolNew(EntityPool *_pool, Args &&... _args)
+{
+  if (!_pool)
+    return new T(std::forward<Args>(_args)...);
+  static_assert(alignof(T) <= alignof(std::max_align_t),
+      "Over-aligned types can not be allocated from an EntityPool");
+  void *ptr = _pool->Allocate(sizeof(T));
+  return new (ptr) T(std::forward<Args>(_args)...);
+}
+
+/// \brief Destroy an object created with poolNew
+/// \param[in] _pool Pool the object was created in
+/// \param[in] _ptr Object to destroy, may be null
+template <typename T>
+void poolDelete(EntityPool *_pool, T *_ptr)
+{
+  if (!_pool)
+  {
+    delete _ptr;
+    return;
+  }
+  if (!_ptr)
+    return;
+  _ptr->~T();
+  _pool->Deallocate(_ptr, sizeof(T));
+}
+
+}
+}
+}
+
+#endif
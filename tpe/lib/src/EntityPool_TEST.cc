@@ -0,0 +1,111 @@
+/*
+ * Copyright (C) 2020 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <memory>
+#include <set>
+#include <vector>
+
+#include "EntityPool.hh"
+
+using namespace ignition;
+using namespace physics;
+using namespace tpelib;
+
+/////////////////////////////////////////////////
+TEST(EntityPool, AllocateDeallocate)
+{
+  EntityPool pool;
+  EXPECT_EQ(0u, pool.ChunkCount());
+  EXPECT_EQ(0u, pool.BlockCount());
+
+  // blocks are distinct and aligned
+  std::vector<void *> blocks;
+  std::set<void *> unique;
+  for (std::size_t i = 0u; i < 1000u; ++i)
+  {
+    void *block = pool.Allocate(24u + i % 200u);
+    EXPECT_EQ(0u,
+        reinterpret_cast<std::uintptr_t>(block) % alignof(std::max_align_t));
+    blocks.push_back(block);
+    unique.insert(block);
+  }
+  EXPECT_EQ(1000u, unique.size());
+  EXPECT_EQ(1000u, pool.BlockCount());
+  const std::size_t chunkCount = pool.ChunkCount();
+  EXPECT_LT(0u, chunkCount);
+  EXPECT_GT(10u, chunkCount);
+
+  // freed blocks are reused without new chunks
+  for (std::size_t i = 0u; i < blocks.size(); ++i)
+    pool.Deallocate(blocks[i], 24u + i % 200u);
+  EXPECT_EQ(0u, pool.BlockCount());
+  for (std::size_t i = 0u; i < blocks.size(); ++i)
+    blocks[i] = pool.Allocate(24u + i % 200u);
+  EXPECT_EQ(chunkCount, pool.ChunkCount());
+  for (std::size_t i = 0u; i < blocks.size(); ++i)
+    pool.Deallocate(blocks[i], 24u + i % 200u);
+
+  // large blocks are allocated from the heap
+  void *large = pool.Allocate(100000u);
+  EXPECT_NE(nullptr, large);
+  EXPECT_EQ(0u, pool.BlockCount());
+  pool.Deallocate(large, 100000u);
+}
+
+/////////////////////////////////////////////////
+TEST(EntityPool, AllocateShared)
+{
+  struct Counted
+  {
+    explicit Counted(int &_count) : count(_count) { ++this->count; }
+    ~Counted() { --this->count; }
+    int &count;
+    double data[4] = {};
+  };
+
+  int count = 0;
+  auto pool = std::make_shared<EntityPool>();
+  std::weak_ptr<EntityPool> weakPool = pool;
+
+  std::shared_ptr<Counted> shared = allocateShared<Counted>(pool, count);
+  EXPECT_EQ(1, count);
+  EXPECT_EQ(1u, pool->BlockCount());
+
+  Counted *raw = poolNew<Counted>(pool.get(), count);
+  EXPECT_EQ(2, count);
+  EXPECT_EQ(2u, pool->BlockCount());
+  poolDelete(pool.get(), raw);
+  EXPECT_EQ(1, count);
+  EXPECT_EQ(1u, pool->BlockCount());
+
+  // shared objects keep their pool alive
+  pool.reset();
+  EXPECT_FALSE(weakPool.expired());
+  shared.reset();
+  EXPECT_EQ(0, count);
+  EXPECT_TRUE(weakPool.expired());
+
+  // without a pool, objects are allocated from the heap
+  shared = allocateShared<Counted>(nullptr, count);
+  raw = poolNew<Counted>(nullptr, count);
+  EXPECT_EQ(2, count);
+  poolDelete<Counted>(nullptr, raw);
+  shared.reset();
+  EXPECT_EQ(0, count);
+}
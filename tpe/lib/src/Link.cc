@@ -15,7 +15,11 @@
  *
 */
 
+#include <memory>
+#include <utility>
+
 #include "Collision.hh"
+#include "EntityPool.hh"
 #include "Link.hh"
 
 using namespace ignition;
@@ -32,13 +36,20 @@ Link::Link(std::size_t _id) : Entity(_id)
 {
 }
 
+//////////////////////////////////////////////////
+Link::Link(std::size_t _id, std::shared_ptr<EntityPool> _pool)
+  : Entity(_id, std::move(_pool))
+{
+}
+
 //////////////////////////////////////////////////
 Entity &Link::AddCollision()
 {
-  std::size_t collisionId = Entity::GetNextId();
+  std::size_t collisionId = this->AllocateId();
   const auto[it, success] = this->GetChildren().insert(
-    {collisionId, std::make_shared<Collision>(collisionId)});
+    {collisionId, allocateShared<Collision>(this->GetEntityPool(),
+    collisionId, this->GetEntityPool())});
   it->second->SetParent(this);
-  this->ChildrenChanged();
+  this->ChildChanged(*it->second);
   return *it->second.get();
 }
@@ -36,6 +36,12 @@ class IGNITION_PHYSICS_TPELIB_VISIBLE Link : public Entity
   /// \param[in] _id Link id
   public: explicit Link(std::size_t _id);
 
+  /// \brief Constructor of a link allocated from a pool
+  /// \param[in] _id Link id
+  /// \param[in] _pool Pool to allocate the link's data from, null to use
+  /// the heap
+  public: Link(std::size_t _id, std::shared_ptr<EntityPool> _pool);
+
   /// \brief Destructor
   public: ~Link() = default;
 
@@ -17,9 +17,14 @@
 
 #include <gtest/gtest.h>
 
+#include <random>
+#include <vector>
+
 #include "Collision.hh"
 #include "Link.hh"
 #include "Model.hh"
+#include "Shape.hh"
+#include "Utils.hh"
 
 using namespace ignition;
 using namespace physics;
@@ -91,3 +96,86 @@ TEST(Link, Collision)
   EXPECT_EQ(Entity::kNullEntity.GetId(), nullEnt.GetId());
 }
 
+
+/////////////////////////////////////////////////
+TEST(Link, BoundingBox)
+{
+  Model model;
+  Link &link = static_cast<Link &>(model.AddLink());
+  std::vector<Collision *> collisions;
+  std::mt19937 rng(1234u);
+  std::uniform_real_distribution<double> dist(-5.0, 5.0);
+  auto randomPose = [&]()
+  {
+    return math::Pose3d(dist(rng), dist(rng), dist(rng),
+        dist(rng), dist(rng), dist(rng));
+  };
+  auto addCollision = [&]()
+  {
+    Collision &collision = static_cast<Collision &>(link.AddCollision());
+    BoxShape boxShape;
+    boxShape.SetSize(math::Vector3d(1.0 + dist(rng) * 0.1,
+        1.0 + dist(rng) * 0.1, 1.0 + dist(rng) * 0.1));
+    collision.SetShape(boxShape);
+    collision.SetPose(randomPose());
+    collisions.push_back(&collision);
+  };
+
+  // the bounding box is refit incrementally when collisions are added,
+  // moved and removed, and is the same as when all collisions are refit
+  auto expectBoxNear = [&]()
+  {
+    math::AxisAlignedBox expected;
+    for (Collision *collision : collisions)
+    {
+      expected.Merge(transformAxisAlignedBox(
+          collision->GetShape()->GetBoundingBox(),
+          collision->GetPose()));
+    }
+    math::AxisAlignedBox box = link.GetBoundingBox();
+    for (int i = 0; i < 3; ++i)
+    {
+      EXPECT_NEAR(expected.Min()[i], box.Min()[i], 1e-9);
+      EXPECT_NEAR(expected.Max()[i], box.Max()[i], 1e-9);
+    }
+    math::AxisAlignedBox modelBox = transformAxisAlignedBox(box,
+        link.GetPose());
+    EXPECT_EQ(modelBox, model.GetBoundingBox());
+  };
+
+  for (int i = 0; i < 40; ++i)
+    addCollision();
+  expectBoxNear();
+
+  for (int i = 0; i < 200; ++i)
+  {
+    std::size_t index = rng() % collisions.size();
+    switch (rng() % 4)
+    {
+      case 0:
+        collisions[index]->SetPose(randomPose());
+        break;
+      case 1:
+        // move a collision towards the origin of the link
+        collisions[index]->SetPose(math::Pose3d(
+            collisions[index]->GetPose().Pos() * 0.5,
+            collisions[index]->GetPose().Rot()));
+        break;
+      case 2:
+        link.RemoveChildById(collisions[index]->GetId());
+        collisions.erase(collisions.begin() + index);
+        if (collisions.empty())
+          addCollision();
+        break;
+      default:
+        addCollision();
+        break;
+    }
+    expectBoxNear();
+  }
+
+  // moving the link moves the model box without refitting the collisions
+  link.SetPose(math::Pose3d(1, 2, 3, 0, 0, 0));
+  expectBoxNear();
+  EXPECT_EQ(link.GetBoundingBox(), link.GetBoundingBox(true));
+}
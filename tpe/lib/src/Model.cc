@@ -15,13 +15,16 @@
  *
 */
 
+#include <memory>
 #include <string>
+#include <utility>
 
 #include <ignition/common/Profiler.hh>
 
 #include <ignition/math/Pose3.hh>
 #include <ignition/math/Vector3.hh>
 
+#include "EntityPool.hh"
 #include "Link.hh"
 #include "Model.hh"
 
@@ -30,27 +33,91 @@ using namespace physics;
 using namespace tpelib;
 
 //////////////////////////////////////////////////
-Model::Model() : Entity()
+Model::Model() : Entity(), ownStorage(std::make_unique<ModelStorage>())
 {
+  this->storage = this->ownStorage.get();
+  this->slot = this->storage->Add(this);
 }
 
 //////////////////////////////////////////////////
-Model::Model(std::size_t _id) : Entity(_id)
+Model::Model(std::size_t _id)
+  : Entity(_id), ownStorage(std::make_unique<ModelStorage>())
 {
+  this->storage = this->ownStorage.get();
+  this->slot = this->storage->Add(this);
+}
+
+//////////////////////////////////////////////////
+Model::Model(std::size_t _id, ModelStorage &_storage,
+    std::shared_ptr<EntityPool> _pool)
+  : Entity(_id, std::move(_pool)), storage(&_storage)
+{
+  this->slot = this->storage->Add(this);
+}
+
+//////////////////////////////////////////////////
+void Model::SetId(std::size_t _id)
+{
+  Entity::SetId(_id);
+  this->storage->ids[this->slot] = _id;
+}
+
+//////////////////////////////////////////////////
+void Model::SetPose(const math::Pose3d &_pose)
+{
+  this->storage->positions[this->slot] = _pose.Pos();
+  this->storage->orientations[this->slot] = _pose.Rot();
+  this->PoseChanged();
+}
+
+//////////////////////////////////////////////////
+math::Pose3d Model::GetPose() const
+{
+  return math::Pose3d(this->storage->positions[this->slot],
+      this->storage->orientations[this->slot]);
 }
 
 //////////////////////////////////////////////////
 Entity &Model::AddLink()
 {
-  std::size_t linkId = Entity::GetNextId();
+  std::size_t linkId = this->AllocateId();
   const auto[it, success]  = this->GetChildren().insert(
-      {linkId, std::make_shared<Link>(linkId)});
+      {linkId, allocateShared<Link>(this->GetEntityPool(), linkId,
+      this->GetEntityPool())});
 
   it->second->SetParent(this);
-  this->ChildrenChanged();
+  this->ChildChanged(*it->second);
   return *it->second.get();
 }
 
+//////////////////////////////////////////////////
+bool Model::RemoveChildById(std::size_t _id)
+{
+  if (!Entity::RemoveChildById(_id))
+    return false;
+  this->shapesChanged = true;
+  return true;
+}
+
+//////////////////////////////////////////////////
+void Model::ChildChanged(Entity &_child)
+{
+  this->shapesChanged = true;
+  Entity::ChildChanged(_child);
+}
+
+//////////////////////////////////////////////////
+bool Model::ShapesChanged() const
+{
+  return this->shapesChanged;
+}
+
+//////////////////////////////////////////////////
+void Model::ResetShapesChanged()
+{
+  this->shapesChanged = false;
+}
+
 //////////////////////////////////////////////////
 Entity &Model::GetCanonicalLink()
 {
@@ -62,27 +129,29 @@ Entity &Model::GetCanonicalLink()
 //////////////////////////////////////////////////
 void Model::SetLinearVelocity(const math::Vector3d _velocity)
 {
-  this->linearVelocity = _velocity;
+  this->storage->linearVelocities[this->slot] = _velocity;
+  this->Wake();
 }
 
 //////////////////////////////////////////////////
 math::Vector3d Model::GetLinearVelocity() const
 {
   IGN_PROFILE("tpelib::Model::GetLinearVelocity");
-  return this->linearVelocity;
+  return this->storage->linearVelocities[this->slot];
 }
 
 //////////////////////////////////////////////////
 void Model::SetAngularVelocity(const math::Vector3d _velocity)
 {
-  this->angularVelocity = _velocity;
+  this->storage->angularVelocities[this->slot] = _velocity;
+  this->Wake();
 }
 
 //////////////////////////////////////////////////
 math::Vector3d Model::GetAngularVelocity() const
 {
   IGN_PROFILE("tpelib::Model::GetAngularVelocity");
-  return this->angularVelocity;
+  return this->storage->angularVelocities[this->slot];
 }
 
 //////////////////////////////////////////////////
@@ -103,3 +172,89 @@ void Model::UpdatePose(
     currentPose.Rot().Integrate(_angularVelocity, _timeStep));
   this->SetPose(nextPose);
 }
+
+//////////////////////////////////////////////////
+bool Model::IsSleeping() const
+{
+  return this->sleeping;
+}
+
+//////////////////////////////////////////////////
+void Model::SetSleeping(bool _sleeping)
+{
+  this->sleeping = _sleeping;
+  if (!_sleeping)
+    this->storage->idleSteps[this->slot] = 0u;
+}
+
+//////////////////////////////////////////////////
+unsigned int Model::GetIdleSteps() const
+{
+  return this->storage->idleSteps[this->slot];
+}
+
+//////////////////////////////////////////////////
+void Model::SetIdleSteps(unsigned int _steps)
+{
+  this->storage->idleSteps[this->slot] = _steps;
+}
+
+//////////////////////////////////////////////////
+bool Model::IsChangeQueued() const
+{
+  return this->changeQueued;
+}
+
+//////////////////////////////////////////////////
+void Model::SetChangeQueued(bool _queued)
+{
+  this->changeQueued = _queued;
+}
+
+//////////////////////////////////////////////////
+std::size_t Model::GetStorageSlot() const
+{
+  return this->slot;
+}
+
+//////////////////////////////////////////////////
+void Model::SetStorageSlot(std::size_t _slot)
+{
+  this->slot = _slot;
+}
+
+//////////////////////////////////////////////////
+void Model::Detach()
+{
+  if (this->ownStorage)
+    return;
+
+  auto detached = std::make_unique<ModelStorage>();
+  const std::size_t newSlot = detached->Add(this);
+  detached->positions[newSlot] = this->storage->positions[this->slot];
+  detached->orientations[newSlot] = this->storage->orientations[this->slot];
+  detached->linearVelocities[newSlot] =
+      this->storage->linearVelocities[this->slot];
+  detached->angularVelocities[newSlot] =
+      this->storage->angularVelocities[this->slot];
+  detached->aabbMins[newSlot] = this->storage->aabbMins[this->slot];
+  detached->aabbMaxs[newSlot] = this->storage->aabbMaxs[this->slot];
+  detached->idleSteps[newSlot] = this->storage->idleSteps[this->slot];
+
+  this->ownStorage = std::move(detached);
+  this->storage = this->ownStorage.get();
+  this->slot = newSlot;
+}
+
+//////////////////////////////////////////////////
+void Model::Wake()
+{
+  this->storage->idleSteps[this->slot] = 0u;
+  if (!this->sleeping)
+    return;
+
+  // the world wakes up its sleeping models when they change
+  if (this->GetParent())
+    this->GetParent()->ChildChanged(*this);
+  this->sleeping = false;
+}
@@ -18,11 +18,14 @@
 #ifndef IGNITION_PHYSICS_TPE_LIB_SRC_MODEL_HH_
 #define IGNITION_PHYSICS_TPE_LIB_SRC_MODEL_HH_
 
+#include <memory>
+
 #include <ignition/utilities/SuppressWarning.hh>
 
 #include "ignition/physics/tpelib/Export.hh"
 
 #include "Entity.hh"
+#include "ModelStorage.hh"
 
 namespace ignition {
 namespace physics {
@@ -30,7 +33,9 @@ namespace tpelib {
 
 // class Link;
 
-/// \brief Model class
+/// \brief Model class. The pose, velocities and idle steps of a model are
+/// stored in a slot of a ModelStorage, which is owned by the model's world.
+/// A model created outside a world owns a storage with a single slot.
 class IGNITION_PHYSICS_TPELIB_VISIBLE Model : public Entity
 {
   /// \brief Constructor
@@ -40,9 +45,33 @@ class IGNITION_PHYSICS_TPELIB_VISIBLE Model : public Entity
   /// \param[in] _id Model id
   public: explicit Model(std::size_t _id);
 
+  /// \internal
+  /// \brief Constructor of a model stored in the storage of a world
+  /// \param[in] _id Model id
+  /// \param[in] _storage Storage to add the model to
+  /// \param[in] _pool Pool to allocate the model's data from, null to use
+  /// the heap
+  public: Model(std::size_t _id, ModelStorage &_storage,
+      std::shared_ptr<EntityPool> _pool = nullptr);
+
+  /// \brief Copy constructor is deleted since a model refers to a slot
+  public: Model(const Model &_other) = delete;
+
   /// \brief Destructor
   public: ~Model() = default;
 
+  /// \brief Assignment operator is deleted since a model refers to a slot
+  public: Model &operator=(const Model &_other) = delete;
+
+  // Documentation inherited
+  public: void SetId(std::size_t _id) override;
+
+  // Documentation inherited
+  public: void SetPose(const math::Pose3d &_pose) override;
+
+  // Documentation inherited
+  public: math::Pose3d GetPose() const override;
+
   /// \brief Add a link
   /// \return Newly created Link
   public: Entity &AddLink();
@@ -67,7 +96,67 @@ class IGNITION_PHYSICS_TPELIB_VISIBLE Model : public Entity
   /// \return angular velocity
   public: math::Vector3d GetAngularVelocity() const;
 
-  /// \brief Update the pose of the entity
+  /// \brief Get whether the model is sleeping. A sleeping model is not
+  /// integrated or updated in collision detection by its world until it is
+  /// woken up by setting its pose or velocity, or by a contact with a model
+  /// that is awake.
+  /// \return True if the model is sleeping
+  public: bool IsSleeping() const;
+
+  /// \internal
+  /// \brief Set whether the model is sleeping. Used by World.
+  /// \param[in] _sleeping True to put the model to sleep
+  public: void SetSleeping(bool _sleeping);
+
+  /// \internal
+  /// \brief Get the number of consecutive steps in which the model has not
+  /// moved. Used by World to put the model to sleep.
+  /// \return Number of idle steps
+  public: unsigned int GetIdleSteps() const;
+
+  /// \internal
+  /// \brief Set the number of consecutive steps in which the model has not
+  /// moved
+  /// \param[in] _steps Number of idle steps
+  public: void SetIdleSteps(unsigned int _steps);
+
+  // Documentation inherited
+  public: bool RemoveChildById(std::size_t _id) override;
+
+  /// \internal
+  /// \brief Notify the model that one of its links changed. The shapes of
+  /// the model are marked as changed.
+  /// \param[in] _child Link that changed
+  public: void ChildChanged(Entity &_child) override;
+
+  /// \internal
+  /// \brief Get whether the links or collisions of the model changed since
+  /// the flag was last reset, e.g. a link moved or a shape was set. Moving
+  /// the model itself does not change its shapes relative to the model.
+  /// \return True if the shapes of the model may have changed
+  public: bool ShapesChanged() const;
+
+  /// \internal
+  /// \brief Reset the flag returned by ShapesChanged. Used by World once
+  /// its collision detector has the shapes of the model.
+  public: void ResetShapesChanged();
+
+  /// \internal
+  /// \brief Get whether the model is queued in the models of its world that
+  /// changed since the last step
+  /// \return True if the model is queued
+  public: bool IsChangeQueued() const;
+
+  /// \internal
+  /// \brief Set whether the model is queued in the models of its world that
+  /// changed since the last step. Used by World to queue each model once.
+  /// \param[in] _queued True if the model is queued
+  public: void SetChangeQueued(bool _queued);
+
+  /// \brief Update the pose of the entity. Called by World::Step for each
+  /// model that is awake, possibly from several threads at once, so
+  /// overrides must only change this model. The model is treated as moved
+  /// if its pose is dirty afterwards, e.g. after calling SetPose.
   /// \param[in] _timeStep current world timestep
   /// \param[in] _linearVelocity linear velocity
   /// \param[in] _angularVelocity angular velocity
@@ -76,13 +165,46 @@ class IGNITION_PHYSICS_TPELIB_VISIBLE Model : public Entity
     const math::Vector3d _linearVelocity,
     const math::Vector3d _angularVelocity);
 
-  IGN_UTILS_WARN_IGNORE__DLL_INTERFACE_MISSING
-  /// \brief linear velocity of model
-  protected: math::Vector3d linearVelocity;
+  /// \internal
+  /// \brief Get the slot of the model in its storage
+  /// \return Slot index
+  public: std::size_t GetStorageSlot() const;
 
-  /// \brief angular velocity of model
-  protected: math::Vector3d angularVelocity;
+  /// \internal
+  /// \brief Set the slot of the model in its storage. Used by ModelStorage
+  /// when slots are moved.
+  /// \param[in] _slot Slot index
+  public: void SetStorageSlot(std::size_t _slot);
+
+  /// \internal
+  /// \brief Move the state of the model from its current storage to a
+  /// storage owned by the model. Used by World before the model is removed.
+  /// The slot in the previous storage is left for the caller to remove.
+  public: void Detach();
+
+  /// \brief Wake up the model if it is sleeping and reset its idle steps
+  private: void Wake();
+
+  /// \brief Storage holding the state of the model
+  protected: ModelStorage *storage{nullptr};
+
+  /// \brief Slot of the model in the storage
+  protected: std::size_t slot{0u};
+
+  IGN_UTILS_WARN_IGNORE__DLL_INTERFACE_MISSING
+  /// \brief Storage owned by a model that is not in a world
+  protected: std::unique_ptr<ModelStorage> ownStorage;
   IGN_UTILS_WARN_RESUME__DLL_INTERFACE_MISSING
+
+  /// \brief True if the model is sleeping
+  protected: bool sleeping{false};
+
+  /// \brief True if the model is queued in the changed models of its world
+  protected: bool changeQueued{false};
+
+  /// \brief True if the links or collisions of the model changed since the
+  /// collision detector of its world last collected its shapes
+  protected: bool shapesChanged{true};
 };
 
 }
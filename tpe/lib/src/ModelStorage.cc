@@ -0,0 +1,73 @@
+/*
+ * Copyright (C) 2020 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+#include <ignition/math/Helpers.hh>
+
+#include "Model.hh"
+#include "ModelStorage.hh"
+
+using namespace ignition;
+using namespace physics;
+using namespace tpelib;
+
+//////////////////////////////////////////////////
+std::size_t ModelStorage::Add(Model *_model)
+{
+  this->models.push_back(_model);
+  this->ids.push_back(_model->GetId());
+  this->positions.push_back(math::Vector3d::Zero);
+  this->orientations.push_back(math::Quaterniond::Identity);
+  this->linearVelocities.push_back(math::Vector3d::Zero);
+  this->angularVelocities.push_back(math::Vector3d::Zero);
+  this->aabbMins.emplace_back(math::MAX_D, math::MAX_D, math::MAX_D);
+  this->aabbMaxs.emplace_back(math::LOW_D, math::LOW_D, math::LOW_D);
+  this->idleSteps.push_back(0u);
+  return this->models.size() - 1u;
+}
+
+//////////////////////////////////////////////////
+void ModelStorage::Remove(std::size_t _slot)
+{
+  const std::size_t last = this->models.size() - 1u;
+  if (_slot != last)
+  {
+    this->models[_slot] = this->models[last];
+    this->ids[_slot] = this->ids[last];
+    this->positions[_slot] = this->positions[last];
+    this->orientations[_slot] = this->orientations[last];
+    this->linearVelocities[_slot] = this->linearVelocities[last];
+    this->angularVelocities[_slot] = this->angularVelocities[last];
+    this->aabbMins[_slot] = this->aabbMins[last];
+    this->aabbMaxs[_slot] = this->aabbMaxs[last];
+    this->idleSteps[_slot] = this->idleSteps[last];
+    this->models[_slot]->SetStorageSlot(_slot);
+  }
+  this->models.pop_back();
+  this->ids.pop_back();
+  this->positions.pop_back();
+  this->orientations.pop_back();
+  this->linearVelocities.pop_back();
+  this->angularVelocities.pop_back();
+  this->aabbMins.pop_back();
+  this->aabbMaxs.pop_back();
+  this->idleSteps.pop_back();
+}
+
+//////////////////////////////////////////////////
+std::size_t ModelStorage::Size() const
+{
+  return this->models.size();
+}
@@ -0,0 +1,92 @@
+/*
+ * Copyright (C) 2020 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+#ifndef IGNITION_PHYSICS_TPE_LIB_SRC_MODELSTORAGE_HH_
+#define IGNITION_PHYSICS_TPE_LIB_SRC_MODELSTORAGE_HH_
+
+#include <vector>
+
+#include <ignition/math/Quaternion.hh>
+#include <ignition/math/Vector3.hh>
+#include <ignition/utilities/SuppressWarning.hh>
+
+#include "ignition/physics/tpelib/Export.hh"
+
+namespace ignition {
+namespace physics {
+namespace tpelib {
+
+// forward declaration
+class Model;
+
+/// \brief Contiguous storage of the state of models as a structure of
+/// arrays. Each model is a handle to one slot of the arrays. A World owns
+/// the storage of all its models so that integrating their poses and
+/// updating their boxes walks over contiguous memory. Slots are kept
+/// contiguous by moving the last slot into the slot of a removed model.
+class IGNITION_PHYSICS_TPELIB_VISIBLE ModelStorage
+{
+  /// \brief Add a slot for a model with zero pose, velocities and box
+  /// \param[in] _model Model that refers to the slot
+  /// \return Slot index
+  public: std::size_t Add(Model *_model);
+
+  /// \brief Remove a slot. The last slot is moved in its place and the
+  /// model that refers to it is updated.
+  /// \param[in] _slot Slot index
+  public: void Remove(std::size_t _slot);
+
+  /// \brief Get the number of slots
+  /// \return Number of slots
+  public: std::size_t Size() const;
+
+  IGN_UTILS_WARN_IGNORE__DLL_INTERFACE_MISSING
+  /// \brief Model of each slot
+  public: std::vector<Model *> models;
+
+  /// \brief Id of the model of each slot
+  public: std::vector<std::size_t> ids;
+
+  /// \brief Position of each model relative to its parent
+  public: std::vector<math::Vector3d> positions;
+
+  /// \brief Orientation of each model relative to its parent
+  public: std::vector<math::Quaterniond> orientations;
+
+  /// \brief Linear velocity of each model
+  public: std::vector<math::Vector3d> linearVelocities;
+
+  /// \brief Angular velocity of each model
+  public: std::vector<math::Vector3d> angularVelocities;
+
+  /// \brief Minimum corner of the world AABB of each model. The world AABBs
+  /// are updated by World::Step for the models that changed and are used by
+  /// its collision detector.
+  public: std::vector<math::Vector3d> aabbMins;
+
+  /// \brief Maximum corner of the world AABB of each model
+  public: std::vector<math::Vector3d> aabbMaxs;
+
+  /// \brief Number of consecutive steps in which each model has not moved
+  public: std::vector<unsigned int> idleSteps;
+  IGN_UTILS_WARN_RESUME__DLL_INTERFACE_MISSING
+};
+
+}
+}
+}
+
+#endif
@@ -0,0 +1,91 @@
+/*
+ * Copyright (C) 2020 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+#include <gtest/gtest.h>
+
+#include "Model.hh"
+#include "ModelStorage.hh"
+
+using namespace ignition;
+using namespace physics;
+using namespace tpelib;
+
+/////////////////////////////////////////////////
+TEST(ModelStorage, AddRemove)
+{
+  ModelStorage storage;
+  EXPECT_EQ(0u, storage.Size());
+
+  Model model1(1u, storage);
+  Model model2(2u, storage);
+  Model model3(3u, storage);
+  EXPECT_EQ(3u, storage.Size());
+  EXPECT_EQ(0u, model1.GetStorageSlot());
+  EXPECT_EQ(1u, model2.GetStorageSlot());
+  EXPECT_EQ(2u, model3.GetStorageSlot());
+  EXPECT_EQ(2u, storage.ids[1]);
+  EXPECT_EQ(&model2, storage.models[1]);
+
+  // new slots have zero state
+  EXPECT_EQ(math::Pose3d::Zero, model2.GetPose());
+  EXPECT_EQ(math::Vector3d::Zero, model2.GetLinearVelocity());
+  EXPECT_EQ(math::Vector3d::Zero, model2.GetAngularVelocity());
+  EXPECT_EQ(0u, model2.GetIdleSteps());
+
+  // the state of the models is stored in the arrays
+  model1.SetPose(math::Pose3d(1, 2, 3, 0, 0, 0));
+  model3.SetPose(math::Pose3d(4, 5, 6, 0, 0, 0.5));
+  model3.SetLinearVelocity(math::Vector3d(1, 0, 0));
+  model3.SetAngularVelocity(math::Vector3d(0, 0, 1));
+  model3.SetIdleSteps(4u);
+  EXPECT_EQ(math::Vector3d(1, 2, 3), storage.positions[0]);
+  EXPECT_EQ(math::Vector3d(4, 5, 6), storage.positions[2]);
+  EXPECT_EQ(math::Quaterniond(0, 0, 0.5), storage.orientations[2]);
+  EXPECT_EQ(math::Vector3d(1, 0, 0), storage.linearVelocities[2]);
+  EXPECT_EQ(math::Vector3d(0, 0, 1), storage.angularVelocities[2]);
+  EXPECT_EQ(4u, storage.idleSteps[2]);
+
+  model2.SetId(5u);
+  EXPECT_EQ(5u, storage.ids[1]);
+
+  // the last slot moves into the slot of a removed model
+  std::size_t slot = model1.GetStorageSlot();
+  model1.Detach();
+  storage.Remove(slot);
+  EXPECT_EQ(2u, storage.Size());
+  EXPECT_EQ(0u, model3.GetStorageSlot());
+  EXPECT_EQ(1u, model2.GetStorageSlot());
+  EXPECT_EQ(&model3, storage.models[0]);
+  EXPECT_EQ(3u, storage.ids[0]);
+  EXPECT_EQ(math::Pose3d(4, 5, 6, 0, 0, 0.5), model3.GetPose());
+  EXPECT_EQ(math::Vector3d(1, 0, 0), model3.GetLinearVelocity());
+  EXPECT_EQ(math::Vector3d(0, 0, 1), model3.GetAngularVelocity());
+  EXPECT_EQ(4u, model3.GetIdleSteps());
+
+  // a detached model keeps its state in its own storage
+  EXPECT_EQ(0u, model1.GetStorageSlot());
+  EXPECT_EQ(math::Pose3d(1, 2, 3, 0, 0, 0), model1.GetPose());
+  model1.SetPose(math::Pose3d(7, 8, 9, 0, 0, 0));
+  EXPECT_EQ(math::Pose3d(7, 8, 9, 0, 0, 0), model1.GetPose());
+  EXPECT_EQ(math::Vector3d(4, 5, 6), storage.positions[0]);
+
+  // removing the last slot moves nothing
+  slot = model2.GetStorageSlot();
+  model2.Detach();
+  storage.Remove(slot);
+  EXPECT_EQ(1u, storage.Size());
+  EXPECT_EQ(0u, model3.GetStorageSlot());
+}
@@ -17,6 +17,8 @@
 
 #include <gtest/gtest.h>
 
+#include <vector>
+
 #include "Collision.hh"
 #include "Link.hh"
 #include "Model.hh"
@@ -103,6 +105,24 @@ TEST(Model, Link)
   Entity ent2ByIdx = model.GetChildByIndex(1u);
   EXPECT_EQ(linkEnt2.GetId(), ent2ByIdx.GetId());
 
+  // children are visited in the order of their ids
+  std::vector<std::size_t> visited;
+  model.VisitChildren([&](Entity &_child)
+  {
+    visited.push_back(_child.GetId());
+  });
+  EXPECT_EQ(std::vector<std::size_t>({linkId, linkEnt2.GetId()}), visited);
+
+  // changes to the links change the shapes of the model, moving the model
+  // does not
+  EXPECT_TRUE(model.ShapesChanged());
+  model.ResetShapesChanged();
+  model.SetPose(math::Pose3d(1, 0, 0, 0, 0, 0));
+  EXPECT_FALSE(model.ShapesChanged());
+  linkEnt2.SetPose(math::Pose3d(0, 1, 0, 0, 0, 0));
+  EXPECT_TRUE(model.ShapesChanged());
+  model.ResetShapesChanged();
+
   Link *link2 = static_cast<Link *>(&linkEnt2);
   EXPECT_NE(nullptr, link2);
   EXPECT_EQ(linkEnt2.GetId(), link2->GetId());
@@ -110,6 +130,7 @@ TEST(Model, Link)
   // test remove child by id
   model.RemoveChildById(linkId);
   EXPECT_EQ(1u, model.GetChildCount());
+  EXPECT_TRUE(model.ShapesChanged());
 
   Entity nullEnt = model.GetChildById(linkId);
   EXPECT_EQ(Entity::kNullEntity.GetId(), nullEnt.GetId());
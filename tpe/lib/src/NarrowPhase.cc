@@ -0,0 +1,872 @@
+/*
+ * Copyright (C) 2020 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <utility>
+
+#include "NarrowPhase.hh"
+#include "Utils.hh"
+
+namespace ignition {
+namespace physics {
+namespace tpelib {
+
+/// \brief Tolerance used to detect degenerate directions and distances
+static const double kEpsilon = 1e-9;
+
+/// \brief Tolerance used to check if a point is inside a box
+static const double kInsideTolerance = 1e-6;
+
+/// \brief Distance at which the polytope expansion stops. The penetration
+/// depth of shapes with curved surfaces is found up to this tolerance.
+static const double kPolytopeTolerance = 1e-9;
+
+/// \brief Maximum number of iterations of GJK and of the polytope expansion
+static const unsigned int kMaxIterations = 64u;
+
+/// \brief Maximum number of vertices of the polytope
+static const std::size_t kMaxPolytopeVertices = kMaxIterations + 4u;
+
+/// \brief Maximum number of faces of the polytope
+static const std::size_t kMaxPolytopeFaces = 4u * kMaxPolytopeVertices;
+
+/// \brief Face axes are preferred over edge axes in the box-box test unless
+/// the overlap along the edge axis is smaller by this factor. This keeps the
+/// normal stable for boxes resting on each other.
+static const double kEdgeAxisBias = 0.95;
+
+/// \brief Point of the minkowski difference of two shapes and the points on
+/// each shape it was computed from
+struct SupportPoint
+{
+  /// \brief Point of the minkowski difference
+  public: math::Vector3d v;
+
+  /// \brief Point on the first shape
+  public: math::Vector3d p1;
+
+  /// \brief Point on the second shape
+  public: math::Vector3d p2;
+};
+
+//////////////////////////////////////////////////
+/// \brief Get the axes of a shape's frame in world frame
+/// \param[in] _pose Pose of the shape
+/// \param[out] _axes X, y and z axes
+static void shapeAxes(const math::Pose3d &_pose, math::Vector3d _axes[3])
+{
+  _axes[0] = _pose.Rot().RotateVector(math::Vector3d::UnitX);
+  _axes[1] = _pose.Rot().RotateVector(math::Vector3d::UnitY);
+  _axes[2] = _pose.Rot().RotateVector(math::Vector3d::UnitZ);
+}
+
+//////////////////////////////////////////////////
+/// \brief Fill a contact given a point on the surface of each shape that is
+/// deepest inside the other shape. The points are expressed in the frame of
+/// a shape whose pose is given.
+/// \param[in] _pose Pose of the frame the points are expressed in
+/// \param[in] _surface1 Point on the surface of the first shape
+/// \param[in] _surface2 Point on the surface of the second shape
+/// \param[in] _normal Normal in the same frame
+/// \param[in] _depth Penetration depth
+/// \param[out] _contact Contact to be filled
+static void fillContact(const math::Pose3d &_pose,
+    const math::Vector3d &_surface1, const math::Vector3d &_surface2,
+    const math::Vector3d &_normal, double _depth, ShapeContact &_contact)
+{
+  _contact.point = _pose.Pos() +
+      _pose.Rot().RotateVector((_surface1 + _surface2) * 0.5);
+  _contact.normal = _pose.Rot().RotateVector(_normal);
+  _contact.depth = _depth;
+}
+
+//////////////////////////////////////////////////
+/// \brief Compute the contact between two spheres
+static bool sphereSphere(const ShapeGeometry &_sphere1,
+    const ShapeGeometry &_sphere2, ShapeContact &_contact)
+{
+  math::Vector3d diff = _sphere2.pose.Pos() - _sphere1.pose.Pos();
+  double radiusSum = _sphere1.radius + _sphere2.radius;
+  double dist2 = diff.SquaredLength();
+  if (dist2 > radiusSum * radiusSum)
+    return false;
+
+  double dist = std::sqrt(dist2);
+  math::Vector3d normal = dist > kEpsilon ? diff / dist : math::Vector3d::UnitZ;
+  math::Vector3d surface1 = _sphere1.pose.Pos() + normal * _sphere1.radius;
+  math::Vector3d surface2 = _sphere2.pose.Pos() - normal * _sphere2.radius;
+  _contact.point = (surface1 + surface2) * 0.5;
+  _contact.normal = normal;
+  _contact.depth = radiusSum - dist;
+  return true;
+}
+
+//////////////////////////////////////////////////
+/// \brief Compute the contact between a box and a sphere
+static bool boxSphere(const ShapeGeometry &_box,
+    const ShapeGeometry &_sphere, ShapeContact &_contact)
+{
+  // center of the sphere in box frame
+  math::Vector3d center = _box.pose.Rot().RotateVectorReverse(
+      _sphere.pose.Pos() - _box.pose.Pos());
+  const math::Vector3d &halfSize = _box.halfSize;
+
+  math::Vector3d closest;
+  for (unsigned int i = 0u; i < 3u; ++i)
+    closest[i] = std::clamp(center[i], -halfSize[i], halfSize[i]);
+
+  math::Vector3d diff = center - closest;
+  double dist2 = diff.SquaredLength();
+  double radius = _sphere.radius;
+  if (dist2 > radius * radius)
+    return false;
+
+  if (dist2 > kEpsilon * kEpsilon)
+  {
+    double dist = std::sqrt(dist2);
+    math::Vector3d normal = diff / dist;
+    fillContact(_box.pose, closest, center - normal * radius, normal,
+        radius - dist, _contact);
+    return true;
+  }
+
+  // the center of the sphere is inside the box, push it out through the
+  // closest face
+  unsigned int axis = 0u;
+  double faceDist = std::numeric_limits<double>::max();
+  for (unsigned int i = 0u; i < 3u; ++i)
+  {
+    double d = halfSize[i] - std::fabs(center[i]);
+    if (d < faceDist)
+    {
+      faceDist = d;
+      axis = i;
+    }
+  }
+  math::Vector3d normal;
+  normal[axis] = center[axis] >= 0.0 ? 1.0 : -1.0;
+  math::Vector3d surface = center;
+  surface[axis] = normal[axis] * halfSize[axis];
+  fillContact(_box.pose, surface, center - normal * radius, normal,
+      radius + faceDist, _contact);
+  return true;
+}
+
+//////////////////////////////////////////////////
+/// \brief Compute the contact between a cylinder and a sphere
+static bool cylinderSphere(const ShapeGeometry &_cylinder,
+    const ShapeGeometry &_sphere, ShapeContact &_contact)
+{
+  // center of the sphere in cylinder frame
+  math::Vector3d center = _cylinder.pose.Rot().RotateVectorReverse(
+      _sphere.pose.Pos() - _cylinder.pose.Pos());
+  math::Vector3d radial(center.X(), center.Y(), 0.0);
+  double radialDist = radial.Length();
+
+  math::Vector3d closest = radial;
+  if (radialDist > _cylinder.radius)
+    closest = radial * (_cylinder.radius / radialDist);
+  closest.Z() = std::clamp(center.Z(), -_cylinder.halfLength,
+      _cylinder.halfLength);
+
+  math::Vector3d diff = center - closest;
+  double dist2 = diff.SquaredLength();
+  double radius = _sphere.radius;
+  if (dist2 > radius * radius)
+    return false;
+
+  if (dist2 > kEpsilon * kEpsilon)
+  {
+    double dist = std::sqrt(dist2);
+    math::Vector3d normal = diff / dist;
+    fillContact(_cylinder.pose, closest, center - normal * radius, normal,
+        radius - dist, _contact);
+    return true;
+  }
+
+  // the center of the sphere is inside the cylinder, push it out through
+  // the closest of the side or the caps
+  double sideDist = _cylinder.radius - radialDist;
+  double capDist = _cylinder.halfLength - std::fabs(center.Z());
+  math::Vector3d normal;
+  math::Vector3d surface = center;
+  double faceDist;
+  if (sideDist < capDist)
+  {
+    normal = radialDist > kEpsilon ? radial / radialDist :
+        math::Vector3d::UnitX;
+    surface.X() = normal.X() * _cylinder.radius;
+    surface.Y() = normal.Y() * _cylinder.radius;
+    faceDist = sideDist;
+  }
+  else
+  {
+    normal.Z() = center.Z() >= 0.0 ? 1.0 : -1.0;
+    surface.Z() = normal.Z() * _cylinder.halfLength;
+    faceDist = capDist;
+  }
+  fillContact(_cylinder.pose, surface, center - normal * radius, normal,
+      radius + faceDist, _contact);
+  return true;
+}
+
+//////////////////////////////////////////////////
+/// \brief Get the closest points between two lines
+/// \param[in] _p1 Point on the first line
+/// \param[in] _d1 Direction of the first line
+/// \param[in] _p2 Point on the second line
+/// \param[in] _d2 Direction of the second line
+/// \return Point half way between the closest points
+static math::Vector3d lineLineMidpoint(const math::Vector3d &_p1,
+    const math::Vector3d &_d1, const math::Vector3d &_p2,
+    const math::Vector3d &_d2)
+{
+  math::Vector3d r = _p1 - _p2;
+  double a = _d1.Dot(_d1);
+  double b = _d1.Dot(_d2);
+  double c = _d2.Dot(_d2);
+  double d = _d1.Dot(r);
+  double e = _d2.Dot(r);
+  double denom = a * c - b * b;
+  double s = 0.0;
+  double t = 0.0;
+  if (denom > kEpsilon)
+  {
+    s = (b * e - c * d) / denom;
+    t = (a * e - b * d) / denom;
+  }
+  return (_p1 + _d1 * s + _p2 + _d2 * t) * 0.5;
+}
+
+//////////////////////////////////////////////////
+/// \brief Compute the contact between two oriented boxes using the
+/// separating axis test
+static bool boxBox(const ShapeGeometry &_box1, const ShapeGeometry &_box2,
+    ShapeContact &_contact)
+{
+  math::Vector3d axes1[3];
+  math::Vector3d axes2[3];
+  shapeAxes(_box1.pose, axes1);
+  shapeAxes(_box2.pose, axes2);
+  const math::Vector3d &half1 = _box1.halfSize;
+  const math::Vector3d &half2 = _box2.halfSize;
+  math::Vector3d t = _box2.pose.Pos() - _box1.pose.Pos();
+
+  double minOverlap = std::numeric_limits<double>::max();
+  math::Vector3d normal;
+  int edge1 = -1;
+  int edge2 = -1;
+
+  // Project both boxes on an axis and keep the axis with the smallest
+  // overlap. Returns false if the axis separates the boxes.
+  auto testAxis = [&](math::Vector3d _axis, bool _isEdge, int _i, int _j)
+  {
+    double length = _axis.Length();
+    if (length < kEpsilon)
+      return true;
+    _axis = _axis / length;
+
+    double r1 = 0.0;
+    double r2 = 0.0;
+    for (unsigned int k = 0u; k < 3u; ++k)
+    {
+      r1 += half1[k] * std::fabs(axes1[k].Dot(_axis));
+      r2 += half2[k] * std::fabs(axes2[k].Dot(_axis));
+    }
+    double dist = t.Dot(_axis);
+    double overlap = r1 + r2 - std::fabs(dist);
+    if (overlap < 0.0)
+      return false;
+
+    if (_isEdge ? overlap < kEdgeAxisBias * minOverlap : overlap < minOverlap)
+    {
+      minOverlap = overlap;
+      normal = dist < 0.0 ? -_axis : _axis;
+      edge1 = _i;
+      edge2 = _j;
+    }
+    return true;
+  };
+
+  for (int i = 0; i < 3; ++i)
+  {
+    if (!testAxis(axes1[i], false, -1, -1))
+      return false;
+  }
+  for (int i = 0; i < 3; ++i)
+  {
+    if (!testAxis(axes2[i], false, -1, -1))
+      return false;
+  }
+  for (int i = 0; i < 3; ++i)
+  {
+    for (int j = 0; j < 3; ++j)
+    {
+      if (!testAxis(axes1[i].Cross(axes2[j]), true, i, j))
+        return false;
+    }
+  }
+
+  _contact.normal = normal;
+  _contact.depth = minOverlap;
+
+  // The contact point is the average of the corners of each box that are
+  // inside the other box, moved half way to the other box's surface.
+  math::Vector3d sum;
+  unsigned int count = 0u;
+  auto addCorners = [&](const ShapeGeometry &_box,
+      const math::Vector3d _axes[3], const ShapeGeometry &_other,
+      const math::Vector3d &_offset)
+  {
+    for (unsigned int c = 0u; c < 8u; ++c)
+    {
+      math::Vector3d corner = _box.pose.Pos();
+      for (unsigned int k = 0u; k < 3u; ++k)
+      {
+        double sign = (c >> k) & 1u ? 1.0 : -1.0;
+        corner += _axes[k] * (sign * _box.halfSize[k]);
+      }
+      math::Vector3d local = _other.pose.Rot().RotateVectorReverse(
+          corner - _other.pose.Pos());
+      if (std::fabs(local.X()) <= _other.halfSize.X() + kInsideTolerance &&
+          std::fabs(local.Y()) <= _other.halfSize.Y() + kInsideTolerance &&
+          std::fabs(local.Z()) <= _other.halfSize.Z() + kInsideTolerance)
+      {
+        sum += corner + _offset;
+        ++count;
+      }
+    }
+  };
+  addCorners(_box1, axes1, _box2, -normal * (minOverlap * 0.5));
+  addCorners(_box2, axes2, _box1, normal * (minOverlap * 0.5));
+  if (count > 0u)
+  {
+    _contact.point = sum / static_cast<double>(count);
+    return true;
+  }
+
+  // No corner is inside the other box. Use the support feature of each box,
+  // i.e. the edges for an edge-edge contact or the face centers otherwise.
+  math::Vector3d support1 = _box1.pose.Pos();
+  math::Vector3d support2 = _box2.pose.Pos();
+  for (int k = 0; k < 3; ++k)
+  {
+    if (k != edge1)
+    {
+      double d = axes1[k].Dot(normal);
+      if (std::fabs(d) > kEpsilon)
+        support1 += axes1[k] * (d > 0.0 ? half1[k] : -half1[k]);
+    }
+    if (k != edge2)
+    {
+      double d = axes2[k].Dot(normal);
+      if (std::fabs(d) > kEpsilon)
+        support2 += axes2[k] * (d > 0.0 ? -half2[k] : half2[k]);
+    }
+  }
+  if (edge1 >= 0)
+  {
+    _contact.point = lineLineMidpoint(support1, axes1[edge1], support2,
+        axes2[edge2]);
+  }
+  else
+  {
+    _contact.point = (support1 + support2) * 0.5;
+  }
+  return true;
+}
+
+//////////////////////////////////////////////////
+/// \brief Get the point of a shape that is furthest along a direction
+/// \param[in] _geometry Shape geometry
+/// \param[in] _dir Direction in world frame
+/// \return Support point in world frame
+static math::Vector3d support(const ShapeGeometry &_geometry,
+    const math::Vector3d &_dir)
+{
+  math::Vector3d dir = _geometry.pose.Rot().RotateVectorReverse(_dir);
+  math::Vector3d p;
+  if (_geometry.type == ShapeType::SPHERE)
+  {
+    double length = dir.Length();
+    if (length > kEpsilon)
+      p = dir * (_geometry.radius / length);
+  }
+  else if (_geometry.type == ShapeType::CYLINDER)
+  {
+    double length = std::sqrt(dir.X() * dir.X() + dir.Y() * dir.Y());
+    if (length > kEpsilon)
+    {
+      p.X() = dir.X() * _geometry.radius / length;
+      p.Y() = dir.Y() * _geometry.radius / length;
+    }
+    p.Z() = dir.Z() >= 0.0 ? _geometry.halfLength : -_geometry.halfLength;
+  }
+  else
+  {
+    for (unsigned int i = 0u; i < 3u; ++i)
+      p[i] = dir[i] >= 0.0 ? _geometry.halfSize[i] : -_geometry.halfSize[i];
+  }
+  return _geometry.pose.Pos() + _geometry.pose.Rot().RotateVector(p);
+}
+
+//////////////////////////////////////////////////
+/// \brief Get the point of the minkowski difference of two shapes that is
+/// furthest along a direction
+static SupportPoint support(const ShapeGeometry &_geometry1,
+    const ShapeGeometry &_geometry2, const math::Vector3d &_dir)
+{
+  SupportPoint s;
+  s.p1 = support(_geometry1, _dir);
+  s.p2 = support(_geometry2, -_dir);
+  s.v = s.p1 - s.p2;
+  return s;
+}
+
+//////////////////////////////////////////////////
+/// \brief Update a triangle simplex a, b, c with the newest point a, and
+/// get the next search direction
+/// \return Number of points in the updated simplex
+static unsigned int updateTriangle(SupportPoint &_a, SupportPoint &_b,
+    SupportPoint &_c, SupportPoint &_d, math::Vector3d &_dir)
+{
+  math::Vector3d ab = _b.v - _a.v;
+  math::Vector3d ac = _c.v - _a.v;
+  math::Vector3d n = ab.Cross(ac);
+  math::Vector3d ao = -_a.v;
+
+  // the origin is closest to edge ab
+  if (ab.Cross(n).Dot(ao) > 0.0)
+  {
+    _c = _a;
+    _dir = ab.Cross(ao).Cross(ab);
+    return 2u;
+  }
+
+  // the origin is closest to edge ac
+  if (n.Cross(ac).Dot(ao) > 0.0)
+  {
+    _b = _a;
+    _dir = ac.Cross(ao).Cross(ac);
+    return 2u;
+  }
+
+  // the origin is above or below the triangle
+  if (n.Dot(ao) > 0.0)
+  {
+    _d = _c;
+    _c = _b;
+    _b = _a;
+    _dir = n;
+  }
+  else
+  {
+    _d = _b;
+    _b = _a;
+    _dir = -n;
+  }
+  return 3u;
+}
+
+//////////////////////////////////////////////////
+/// \brief Update a tetrahedron simplex a, b, c, d with the newest point a,
+/// and get the next search direction
+/// \return True if the tetrahedron contains the origin
+static bool updateTetrahedron(SupportPoint &_a, SupportPoint &_b,
+    SupportPoint &_c, SupportPoint &_d, math::Vector3d &_dir)
+{
+  math::Vector3d abc = (_b.v - _a.v).Cross(_c.v - _a.v);
+  math::Vector3d acd = (_c.v - _a.v).Cross(_d.v - _a.v);
+  math::Vector3d adb = (_d.v - _a.v).Cross(_b.v - _a.v);
+  math::Vector3d ao = -_a.v;
+
+  // keep the face the origin is in front of
+  if (abc.Dot(ao) > 0.0)
+  {
+    _d = _c;
+    _c = _b;
+    _b = _a;
+    _dir = abc;
+    return false;
+  }
+  if (acd.Dot(ao) > 0.0)
+  {
+    _b = _a;
+    _dir = acd;
+    return false;
+  }
+  if (adb.Dot(ao) > 0.0)
+  {
+    _c = _d;
+    _d = _b;
+    _b = _a;
+    _dir = adb;
+    return false;
+  }
+  return true;
+}
+
+//////////////////////////////////////////////////
+/// \brief Check if two convex shapes intersect using the GJK algorithm
+/// \param[in] _geometry1 Geometry of the first shape
+/// \param[in] _geometry2 Geometry of the second shape
+/// \param[out] _simplex Tetrahedron of the minkowski difference of the
+/// shapes that contains the origin
+/// \return True if the shapes intersect
+static bool gjk(const ShapeGeometry &_geometry1,
+    const ShapeGeometry &_geometry2, SupportPoint _simplex[4])
+{
+  math::Vector3d dir = _geometry1.pose.Pos() - _geometry2.pose.Pos();
+  if (dir.SquaredLength() < kEpsilon * kEpsilon)
+    dir = math::Vector3d::UnitX;
+
+  SupportPoint a;
+  SupportPoint b;
+  SupportPoint c = support(_geometry1, _geometry2, dir);
+  SupportPoint d;
+  if (c.v.SquaredLength() < kEpsilon * kEpsilon)
+    return false;
+
+  dir = -c.v;
+  b = support(_geometry1, _geometry2, dir);
+  if (b.v.Dot(dir) < 0.0)
+    return false;
+
+  math::Vector3d bc = c.v - b.v;
+  dir = bc.Cross(-b.v).Cross(bc);
+  if (dir.SquaredLength() < kEpsilon * kEpsilon)
+  {
+    // the origin is on the segment, search along any perpendicular direction
+    dir = bc.Cross(math::Vector3d::UnitX);
+    if (dir.SquaredLength() < kEpsilon * kEpsilon)
+      dir = bc.Cross(math::Vector3d::UnitZ);
+  }
+
+  unsigned int count = 2u;
+  for (unsigned int i = 0u; i < kMaxIterations; ++i)
+  {
+    double length = dir.Length();
+    if (length < kEpsilon)
+      return false;
+    dir = dir / length;
+
+    a = support(_geometry1, _geometry2, dir);
+    if (a.v.Dot(dir) < 0.0)
+      return false;
+
+    if (++count == 3u)
+    {
+      count = updateTriangle(a, b, c, d, dir);
+    }
+    else if (updateTetrahedron(a, b, c, d, dir))
+    {
+      _simplex[0] = a;
+      _simplex[1] = b;
+      _simplex[2] = c;
+      _simplex[3] = d;
+      return true;
+    }
+  }
+  return false;
+}
+
+/// \brief Triangle face of the polytope expanded by EPA
+struct PolytopeFace
+{
+  /// \brief Indices of the vertices of the face
+  public: std::size_t v[3];
+
+  /// \brief Unit normal pointing out of the polytope
+  public: math::Vector3d normal;
+
+  /// \brief Distance from the origin to the plane of the face
+  public: double dist = 0.0;
+};
+
+//////////////////////////////////////////////////
+/// \brief Make a face of the polytope. The vertices are ordered so that the
+/// normal points away from a point inside the polytope.
+/// \return False if the face is degenerate
+static bool makeFace(const SupportPoint *_vertices, std::size_t _a,
+    std::size_t _b, std::size_t _c, const math::Vector3d &_interior,
+    PolytopeFace &_face)
+{
+  const math::Vector3d &a = _vertices[_a].v;
+  math::Vector3d n = (_vertices[_b].v - a).Cross(_vertices[_c].v - a);
+  double length = n.Length();
+  if (length < kEpsilon * kEpsilon)
+    return false;
+  n = n / length;
+
+  _face.v[0] = _a;
+  if (n.Dot(a - _interior) < 0.0)
+  {
+    n = -n;
+    _face.v[1] = _c;
+    _face.v[2] = _b;
+  }
+  else
+  {
+    _face.v[1] = _b;
+    _face.v[2] = _c;
+  }
+  _face.normal = n;
+  _face.dist = n.Dot(a);
+  return true;
+}
+
+//////////////////////////////////////////////////
+/// \brief Compute the contact between two convex shapes using GJK to find
+/// if they intersect and EPA to find the penetration depth
+static bool convexContact(const ShapeGeometry &_geometry1,
+    const ShapeGeometry &_geometry2, ShapeContact &_contact)
+{
+  SupportPoint vertices[kMaxPolytopeVertices];
+  if (!gjk(_geometry1, _geometry2, vertices))
+    return false;
+
+  // expand the polytope of the minkowski difference from the GJK simplex
+  // until its face closest to the origin is on the surface
+  math::Vector3d interior = (vertices[0].v + vertices[1].v + vertices[2].v +
+      vertices[3].v) * 0.25;
+  std::size_t vertexCount = 4u;
+  PolytopeFace faces[kMaxPolytopeFaces];
+  std::size_t faceCount = 0u;
+  const std::size_t tetrahedron[4][3] = {{0, 1, 2}, {0, 2, 3}, {0, 3, 1},
+      {1, 3, 2}};
+  for (const auto &f : tetrahedron)
+  {
+    if (!makeFace(vertices, f[0], f[1], f[2], interior, faces[faceCount++]))
+      return false;
+  }
+
+  std::pair<std::size_t, std::size_t> edges[kMaxPolytopeFaces];
+  std::size_t closest = 0u;
+  while (true)
+  {
+    closest = 0u;
+    for (std::size_t i = 1u; i < faceCount; ++i)
+    {
+      if (faces[i].dist < faces[closest].dist)
+        closest = i;
+    }
+
+    const PolytopeFace &face = faces[closest];
+    SupportPoint p = support(_geometry1, _geometry2, face.normal);
+    if (p.v.Dot(face.normal) - face.dist < kPolytopeTolerance ||
+        vertexCount == kMaxPolytopeVertices)
+    {
+      break;
+    }
+
+    // Remove the faces that can be seen from the new point and keep the
+    // edges on the border of the hole, i.e. the edges of only one removed
+    // face. Adjacent faces list their shared edge in opposite directions.
+    std::size_t edgeCount = 0u;
+    for (std::size_t i = 0u; i < faceCount;)
+    {
+      const PolytopeFace &f = faces[i];
+      if (f.normal.Dot(p.v - vertices[f.v[0]].v) <= 0.0)
+      {
+        ++i;
+        continue;
+      }
+
+      for (unsigned int j = 0u; j < 3u; ++j)
+      {
+        std::pair<std::size_t, std::size_t> edge(f.v[j], f.v[(j + 1u) % 3u]);
+        bool shared = false;
+        for (std::size_t k = 0u; k < edgeCount; ++k)
+        {
+          if (edges[k].first == edge.second && edges[k].second == edge.first)
+          {
+            edges[k] = edges[--edgeCount];
+            shared = true;
+            break;
+          }
+        }
+        if (!shared && edgeCount < kMaxPolytopeFaces)
+          edges[edgeCount++] = edge;
+      }
+      faces[i] = faces[--faceCount];
+    }
+
+    // fill the hole with faces connecting the border to the new point
+    std::size_t pIndex = vertexCount++;
+    vertices[pIndex] = p;
+    for (std::size_t k = 0u; k < edgeCount && faceCount < kMaxPolytopeFaces;
+        ++k)
+    {
+      if (makeFace(vertices, edges[k].first, edges[k].second, pIndex,
+          interior, faces[faceCount]))
+      {
+        ++faceCount;
+      }
+    }
+    if (faceCount == 0u)
+      return false;
+  }
+
+  const PolytopeFace &face = faces[closest];
+  _contact.normal = face.normal;
+  _contact.depth = std::max(face.dist, 0.0);
+
+  // barycentric coordinates of the origin's projection on the face give the
+  // corresponding points on each shape
+  const SupportPoint &a = vertices[face.v[0]];
+  const SupportPoint &b = vertices[face.v[1]];
+  const SupportPoint &c = vertices[face.v[2]];
+  math::Vector3d ab = b.v - a.v;
+  math::Vector3d ac = c.v - a.v;
+  math::Vector3d aq = face.normal * face.dist - a.v;
+  double d00 = ab.Dot(ab);
+  double d01 = ab.Dot(ac);
+  double d11 = ac.Dot(ac);
+  double d20 = aq.Dot(ab);
+  double d21 = aq.Dot(ac);
+  double denom = d00 * d11 - d01 * d01;
+  double u = 1.0 / 3.0;
+  double v = 1.0 / 3.0;
+  if (std::fabs(denom) > kEpsilon * kEpsilon)
+  {
+    u = (d11 * d20 - d01 * d21) / denom;
+    v = (d00 * d21 - d01 * d20) / denom;
+  }
+  double w = 1.0 - u - v;
+  math::Vector3d p1 = a.p1 * w + b.p1 * u + c.p1 * v;
+  math::Vector3d p2 = a.p2 * w + b.p2 * u + c.p2 * v;
+  _contact.point = (p1 + p2) * 0.5;
+  return true;
+}
+
+//////////////////////////////////////////////////
+bool shapeGeometry(const Shape &_shape, const math::Pose3d &_pose,
+    ShapeGeometry &_geometry)
+{
+  math::AxisAlignedBox box = _shape.GetBoundingBox();
+  if (box == math::AxisAlignedBox())
+    return false;
+
+  _geometry.pose = _pose;
+  _geometry.type = _shape.GetType();
+  switch (_geometry.type)
+  {
+    case ShapeType::BOX:
+      _geometry.halfSize =
+          static_cast<const BoxShape &>(_shape).GetSize() * 0.5;
+      break;
+    case ShapeType::CYLINDER:
+    {
+      auto &cylinder = static_cast<const CylinderShape &>(_shape);
+      _geometry.radius = cylinder.GetRadius();
+      _geometry.halfLength = cylinder.GetLength() * 0.5;
+      break;
+    }
+    case ShapeType::SPHERE:
+      _geometry.radius = static_cast<const SphereShape &>(_shape).GetRadius();
+      break;
+    case ShapeType::MESH:
+      // approximate meshes by their bounding box, which may not be centered
+      // at the origin of the mesh
+      _geometry.type = ShapeType::BOX;
+      _geometry.halfSize = box.Size() * 0.5;
+      _geometry.pose = _pose * math::Pose3d(box.Center(),
+          math::Quaterniond::Identity);
+      break;
+    default:
+      return false;
+  }
+
+  _geometry.aabb = transformAxisAlignedBox(box, _pose);
+  return true;
+}
+
+//////////////////////////////////////////////////
+ShapeGeometry transformShapeGeometry(const ShapeGeometry &_geometry,
+    const math::Pose3d &_pose)
+{
+  ShapeGeometry result = _geometry;
+  result.pose = _pose * _geometry.pose;
+
+  // half extents of the shape along the axes of its own frame
+  math::Vector3d extents;
+  switch (_geometry.type)
+  {
+    case ShapeType::BOX:
+      extents = _geometry.halfSize;
+      break;
+    case ShapeType::CYLINDER:
+      extents.Set(_geometry.radius, _geometry.radius, _geometry.halfLength);
+      break;
+    case ShapeType::SPHERE:
+      extents.Set(_geometry.radius, _geometry.radius, _geometry.radius);
+      break;
+    default:
+      result.aabb = transformAxisAlignedBox(_geometry.aabb, _pose);
+      return result;
+  }
+
+  // the box is centered at the shape's origin so its extents in the new
+  // frame are the sum of the extents projected on each of the shape's axes
+  math::Vector3d axes[3];
+  shapeAxes(result.pose, axes);
+  math::Vector3d halfExtents = axes[0].Abs() * extents.X() +
+      axes[1].Abs() * extents.Y() + axes[2].Abs() * extents.Z();
+  result.aabb = math::AxisAlignedBox(result.pose.Pos() - halfExtents,
+      result.pose.Pos() + halfExtents);
+  return result;
+}
+
+//////////////////////////////////////////////////
+bool collideShapes(const ShapeGeometry &_geometry1,
+    const ShapeGeometry &_geometry2, ShapeContact &_contact)
+{
+  auto supported = [](ShapeType _type)
+  {
+    return _type == ShapeType::BOX || _type == ShapeType::CYLINDER ||
+        _type == ShapeType::SPHERE;
+  };
+  if (!supported(_geometry1.type) || !supported(_geometry2.type))
+    return false;
+
+  // order the shapes by type so that each pair of types is handled by one
+  // function, and flip the normal back if needed
+  bool swapped = _geometry1.type > _geometry2.type;
+  const ShapeGeometry &g1 = swapped ? _geometry2 : _geometry1;
+  const ShapeGeometry &g2 = swapped ? _geometry1 : _geometry2;
+
+  bool result;
+  if (g1.type == ShapeType::SPHERE)
+    result = sphereSphere(g1, g2, _contact);
+  else if (g1.type == ShapeType::BOX && g2.type == ShapeType::SPHERE)
+    result = boxSphere(g1, g2, _contact);
+  else if (g1.type == ShapeType::CYLINDER && g2.type == ShapeType::SPHERE)
+    result = cylinderSphere(g1, g2, _contact);
+  else if (g1.type == ShapeType::BOX && g2.type == ShapeType::BOX)
+    result = boxBox(g1, g2, _contact);
+  else
+    result = convexContact(g1, g2, _contact);
+
+  if (result && swapped)
+    _contact.normal = -_contact.normal;
+  return result;
+}
+}
+}
+}
@@ -0,0 +1,116 @@
+/*
+ * Copyright (C) 2020 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#ifndef IGNITION_PHYSICS_TPE_LIB_SRC_NARROWPHASE_HH_
+#define IGNITION_PHYSICS_TPE_LIB_SRC_NARROWPHASE_HH_
+
+#include <ignition/math/AxisAlignedBox.hh>
+#include <ignition/math/Pose3.hh>
+#include <ignition/math/Vector3.hh>
+#include <ignition/utilities/SuppressWarning.hh>
+
+#include "ignition/physics/tpelib/Export.hh"
+
+#include "Shape.hh"
+
+namespace ignition {
+namespace physics {
+namespace tpelib {
+
+/// \brief Geometry of a shape placed in world frame, or in the frame of the
+/// entity it belongs to. It stores a copy of the shape dimensions so contacts
+/// can be computed without accessing the shape, e.g. from multiple threads.
+class IGNITION_PHYSICS_TPELIB_VISIBLE ShapeGeometry
+{
+  /// \brief Type of shape. Meshes are approximated by their bounding box and
+  /// are stored as boxes.
+  public: ShapeType type = ShapeType::EMPTY;
+
+  IGN_UTILS_WARN_IGNORE__DLL_INTERFACE_MISSING
+  /// \brief Pose of the center of the shape
+  public: math::Pose3d pose;
+
+  /// \brief Half of the size of a box
+  public: math::Vector3d halfSize;
+
+  /// \brief Axis aligned bounding box of the shape in the same frame as
+  /// the pose
+  public: math::AxisAlignedBox aabb;
+  IGN_UTILS_WARN_RESUME__DLL_INTERFACE_MISSING
+
+  /// \brief Radius of a sphere or cylinder
+  public: double radius = 0.0;
+
+  /// \brief Half of the length of a cylinder along its z axis
+  public: double halfLength = 0.0;
+};
+
+/// \brief Contact between two shapes
+class IGNITION_PHYSICS_TPELIB_VISIBLE ShapeContact
+{
+  IGN_UTILS_WARN_IGNORE__DLL_INTERFACE_MISSING
+  /// \brief Point of contact in world frame, half way between the surfaces
+  /// of the two shapes
+  public: math::Vector3d point;
+
+  /// \brief Unit normal in world frame pointing from the first shape to the
+  /// second shape. Moving the second shape along the normal by the depth
+  /// separates the shapes.
+  public: math::Vector3d normal;
+  IGN_UTILS_WARN_RESUME__DLL_INTERFACE_MISSING
+
+  /// \brief Penetration depth, 0 if the shapes are touching
+  public: double depth = 0.0;
+};
+
+  /// \brief Get the geometry of a shape placed in world frame
+  /// \param[in] _shape Shape
+  /// \param[in] _pose Pose of the shape's frame in world frame
+  /// \param[out] _geometry Geometry to be filled
+  /// \return True if the shape type is supported and has a valid size,
+  /// false otherwise
+  IGNITION_PHYSICS_TPELIB_VISIBLE
+  bool shapeGeometry(const Shape &_shape, const math::Pose3d &_pose,
+      ShapeGeometry &_geometry);
+
+  /// \brief Move the geometry of a shape to another frame
+  /// \param[in] _geometry Geometry of the shape
+  /// \param[in] _pose Pose of the frame the geometry is expressed in,
+  /// relative to the new frame
+  /// \return Geometry of the shape in the new frame
+  IGNITION_PHYSICS_TPELIB_VISIBLE
+  ShapeGeometry transformShapeGeometry(const ShapeGeometry &_geometry,
+      const math::Pose3d &_pose);
+
+  /// \brief Compute the contact between two shapes. Sphere-sphere,
+  /// sphere-box, sphere-cylinder and box-box pairs are tested analytically;
+  /// box-box uses the separating axis test on the 15 candidate axes of the
+  /// two oriented boxes. Pairs involving a cylinder and a box or another
+  /// cylinder are tested with GJK and the expanding polytope algorithm on
+  /// the shapes' support functions.
+  /// \param[in] _geometry1 Geometry of the first shape
+  /// \param[in] _geometry2 Geometry of the second shape
+  /// \param[out] _contact Contact to be filled if the shapes intersect
+  /// \return True if the shapes intersect or touch, false otherwise
+  IGNITION_PHYSICS_TPELIB_VISIBLE
+  bool collideShapes(const ShapeGeometry &_geometry1,
+      const ShapeGeometry &_geometry2, ShapeContact &_contact);
+}
+}
+}
+
+#endif
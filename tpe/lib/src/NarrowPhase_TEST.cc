@@ -0,0 +1,316 @@
+/*
+ * Copyright (C) 2020 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+
+#include "NarrowPhase.hh"
+#include "Shape.hh"
+
+using namespace ignition;
+using namespace physics;
+using namespace tpelib;
+
+/////////////////////////////////////////////////
+/// \brief Create the geometry of a box
+ShapeGeometry boxGeometry(const math::Vector3d &_size,
+    const math::Pose3d &_pose)
+{
+  BoxShape shape;
+  shape.SetSize(_size);
+  ShapeGeometry geometry;
+  EXPECT_TRUE(shapeGeometry(shape, _pose, geometry));
+  return geometry;
+}
+
+/////////////////////////////////////////////////
+/// \brief Create the geometry of a sphere
+ShapeGeometry sphereGeometry(double _radius, const math::Pose3d &_pose)
+{
+  SphereShape shape;
+  shape.SetRadius(_radius);
+  ShapeGeometry geometry;
+  EXPECT_TRUE(shapeGeometry(shape, _pose, geometry));
+  return geometry;
+}
+
+/////////////////////////////////////////////////
+/// \brief Create the geometry of a cylinder
+ShapeGeometry cylinderGeometry(double _radius, double _length,
+    const math::Pose3d &_pose)
+{
+  CylinderShape shape;
+  shape.SetRadius(_radius);
+  shape.SetLength(_length);
+  ShapeGeometry geometry;
+  EXPECT_TRUE(shapeGeometry(shape, _pose, geometry));
+  return geometry;
+}
+
+/////////////////////////////////////////////////
+TEST(NarrowPhase, ShapeGeometry)
+{
+  ShapeGeometry geometry;
+  Shape empty;
+  EXPECT_FALSE(shapeGeometry(empty, math::Pose3d::Zero, geometry));
+
+  geometry = boxGeometry(math::Vector3d(2, 4, 6),
+      math::Pose3d(1, 2, 3, 0, 0, 0));
+  EXPECT_EQ(ShapeType::BOX, geometry.type);
+  EXPECT_EQ(math::Vector3d(1, 2, 3), geometry.halfSize);
+  EXPECT_EQ(math::AxisAlignedBox(math::Vector3d(0, 0, 0),
+      math::Vector3d(2, 4, 6)), geometry.aabb);
+
+  geometry = cylinderGeometry(1, 4, math::Pose3d::Zero);
+  EXPECT_EQ(ShapeType::CYLINDER, geometry.type);
+  EXPECT_DOUBLE_EQ(1.0, geometry.radius);
+  EXPECT_DOUBLE_EQ(2.0, geometry.halfLength);
+
+  geometry = sphereGeometry(3, math::Pose3d::Zero);
+  EXPECT_EQ(ShapeType::SPHERE, geometry.type);
+  EXPECT_DOUBLE_EQ(3.0, geometry.radius);
+}
+
+/////////////////////////////////////////////////
+TEST(NarrowPhase, TransformShapeGeometry)
+{
+  // the transformed geometry matches the geometry of the shape placed
+  // directly at the composed pose
+  math::Pose3d pose(1, 2, 3, 0.1, 0.2, 0.3);
+  math::Pose3d transform(-4, 5, 6, 0.5, -0.4, 1.2);
+  ShapeGeometry geometries[3][2] =
+  {
+    {boxGeometry(math::Vector3d(2, 4, 6), pose),
+     boxGeometry(math::Vector3d(2, 4, 6), transform * pose)},
+    {cylinderGeometry(1, 4, pose), cylinderGeometry(1, 4, transform * pose)},
+    {sphereGeometry(3, pose), sphereGeometry(3, transform * pose)}
+  };
+
+  for (const auto &g : geometries)
+  {
+    ShapeGeometry geometry = transformShapeGeometry(g[0], transform);
+    EXPECT_EQ(g[1].type, geometry.type);
+    EXPECT_EQ(g[1].pose, geometry.pose);
+    EXPECT_EQ(g[1].halfSize, geometry.halfSize);
+    EXPECT_DOUBLE_EQ(g[1].radius, geometry.radius);
+    EXPECT_DOUBLE_EQ(g[1].halfLength, geometry.halfLength);
+    EXPECT_EQ(g[1].aabb.Min(), geometry.aabb.Min());
+    EXPECT_EQ(g[1].aabb.Max(), geometry.aabb.Max());
+  }
+}
+
+/////////////////////////////////////////////////
+TEST(NarrowPhase, SphereSphere)
+{
+  ShapeGeometry sphere1 = sphereGeometry(1, math::Pose3d::Zero);
+  ShapeGeometry sphere2 = sphereGeometry(1, math::Pose3d(1.5, 0, 0, 0, 0, 0));
+
+  ShapeContact contact;
+  ASSERT_TRUE(collideShapes(sphere1, sphere2, contact));
+  EXPECT_EQ(math::Vector3d(0.75, 0, 0), contact.point);
+  EXPECT_EQ(math::Vector3d::UnitX, contact.normal);
+  EXPECT_NEAR(0.5, contact.depth, 1e-6);
+
+  // the normal points from the first to the second shape
+  ASSERT_TRUE(collideShapes(sphere2, sphere1, contact));
+  EXPECT_EQ(-math::Vector3d::UnitX, contact.normal);
+
+  // the AABBs overlap but the spheres do not
+  sphere2 = sphereGeometry(1, math::Pose3d(1.5, 1.5, 0, 0, 0, 0));
+  EXPECT_TRUE(sphere1.aabb.Intersects(sphere2.aabb));
+  EXPECT_FALSE(collideShapes(sphere1, sphere2, contact));
+}
+
+/////////////////////////////////////////////////
+TEST(NarrowPhase, BoxSphere)
+{
+  ShapeGeometry box = boxGeometry(math::Vector3d(2, 2, 2),
+      math::Pose3d::Zero);
+  ShapeGeometry sphere = sphereGeometry(1, math::Pose3d(1.5, 0, 0, 0, 0, 0));
+
+  ShapeContact contact;
+  ASSERT_TRUE(collideShapes(box, sphere, contact));
+  EXPECT_EQ(math::Vector3d(0.75, 0, 0), contact.point);
+  EXPECT_EQ(math::Vector3d::UnitX, contact.normal);
+  EXPECT_NEAR(0.5, contact.depth, 1e-6);
+
+  ASSERT_TRUE(collideShapes(sphere, box, contact));
+  EXPECT_EQ(-math::Vector3d::UnitX, contact.normal);
+
+  // sphere center inside the box
+  sphere = sphereGeometry(1, math::Pose3d(0, 0, 0.8, 0, 0, 0));
+  ASSERT_TRUE(collideShapes(box, sphere, contact));
+  EXPECT_EQ(math::Vector3d::UnitZ, contact.normal);
+  EXPECT_NEAR(1.2, contact.depth, 1e-6);
+
+  // rotated box whose corner points at the sphere
+  box = boxGeometry(math::Vector3d(2, 2, 2),
+      math::Pose3d(0, 0, 0, 0, 0, IGN_PI * 0.25));
+  sphere = sphereGeometry(1, math::Pose3d(2.2, 0, 0, 0, 0, 0));
+  ASSERT_TRUE(collideShapes(box, sphere, contact));
+  EXPECT_EQ(math::Vector3d::UnitX, contact.normal);
+  EXPECT_NEAR(1.0 - (2.2 - std::sqrt(2.0)), contact.depth, 1e-6);
+
+  // the AABBs overlap but the shapes do not
+  sphere = sphereGeometry(1, math::Pose3d(1.5, 1.5, 0, 0, 0, 0));
+  EXPECT_TRUE(box.aabb.Intersects(sphere.aabb));
+  EXPECT_FALSE(collideShapes(box, sphere, contact));
+}
+
+/////////////////////////////////////////////////
+TEST(NarrowPhase, BoxBox)
+{
+  ShapeGeometry box1 = boxGeometry(math::Vector3d(4, 4, 4),
+      math::Pose3d::Zero);
+  ShapeGeometry box2 = boxGeometry(math::Vector3d(4, 4, 4),
+      math::Pose3d(3.5, 0, 0, 0, 0, 0));
+
+  ShapeContact contact;
+  ASSERT_TRUE(collideShapes(box1, box2, contact));
+  EXPECT_EQ(math::Vector3d(1.75, 0, 0), contact.point);
+  EXPECT_EQ(math::Vector3d::UnitX, contact.normal);
+  EXPECT_NEAR(0.5, contact.depth, 1e-6);
+
+  ASSERT_TRUE(collideShapes(box2, box1, contact));
+  EXPECT_EQ(math::Vector3d(1.75, 0, 0), contact.point);
+  EXPECT_EQ(-math::Vector3d::UnitX, contact.normal);
+
+  // touching boxes
+  box2 = boxGeometry(math::Vector3d(4, 4, 4), math::Pose3d(0, 0, 4, 0, 0, 0));
+  ASSERT_TRUE(collideShapes(box1, box2, contact));
+  EXPECT_EQ(math::Vector3d::UnitZ, contact.normal);
+  EXPECT_NEAR(0.0, contact.depth, 1e-6);
+
+  // rotated box with an edge inside the other box
+  box2 = boxGeometry(math::Vector3d(2, 2, 2),
+      math::Pose3d(3.2, 0, 0, 0, 0, IGN_PI * 0.25));
+  ASSERT_TRUE(collideShapes(box1, box2, contact));
+  double depth = 2.0 - (3.2 - std::sqrt(2.0));
+  EXPECT_EQ(math::Vector3d::UnitX, contact.normal);
+  EXPECT_NEAR(depth, contact.depth, 1e-6);
+  EXPECT_EQ(math::Vector3d(2.0 - depth * 0.5, 0, 0), contact.point);
+
+  // edge-edge contact between two boxes rotated about different axes
+  box1 = boxGeometry(math::Vector3d(2, 2, 2),
+      math::Pose3d(0, 0, 0, IGN_PI * 0.25, 0, 0));
+  box2 = boxGeometry(math::Vector3d(2, 2, 2),
+      math::Pose3d(0, 0, 2.7, 0, IGN_PI * 0.25, 0));
+  ASSERT_TRUE(collideShapes(box1, box2, contact));
+  EXPECT_EQ(math::Vector3d::UnitZ, contact.normal);
+  EXPECT_NEAR(2.0 * std::sqrt(2.0) - 2.7, contact.depth, 1e-6);
+  EXPECT_EQ(math::Vector3d(0, 0, 1.35), contact.point);
+
+  // the AABBs overlap but the rotated boxes do not
+  box1 = boxGeometry(math::Vector3d(2, 2, 2),
+      math::Pose3d(0, 0, 0, 0, 0, IGN_PI * 0.25));
+  box2 = boxGeometry(math::Vector3d(2, 2, 2), math::Pose3d(2, 2, 0, 0, 0, 0));
+  EXPECT_TRUE(box1.aabb.Intersects(box2.aabb));
+  EXPECT_FALSE(collideShapes(box1, box2, contact));
+}
+
+/////////////////////////////////////////////////
+TEST(NarrowPhase, CylinderSphere)
+{
+  ShapeGeometry cylinder = cylinderGeometry(1, 2, math::Pose3d::Zero);
+  ShapeGeometry sphere = sphereGeometry(1, math::Pose3d(0, 0, 1.5, 0, 0, 0));
+
+  ShapeContact contact;
+  ASSERT_TRUE(collideShapes(cylinder, sphere, contact));
+  EXPECT_EQ(math::Vector3d(0, 0, 0.75), contact.point);
+  EXPECT_EQ(math::Vector3d::UnitZ, contact.normal);
+  EXPECT_NEAR(0.5, contact.depth, 1e-6);
+
+  sphere = sphereGeometry(1, math::Pose3d(0, -1.5, 0, 0, 0, 0));
+  ASSERT_TRUE(collideShapes(sphere, cylinder, contact));
+  EXPECT_EQ(math::Vector3d::UnitY, contact.normal);
+  EXPECT_NEAR(0.5, contact.depth, 1e-6);
+
+  // sphere near the rim of the cylinder
+  sphere = sphereGeometry(1, math::Pose3d(1.6, 0, 1.6, 0, 0, 0));
+  ASSERT_TRUE(collideShapes(cylinder, sphere, contact));
+  EXPECT_EQ(math::Vector3d(1, 0, 1).Normalized(), contact.normal);
+  EXPECT_NEAR(1.0 - 0.6 * std::sqrt(2.0), contact.depth, 1e-6);
+
+  // the AABBs overlap but the shapes do not
+  sphere = sphereGeometry(1, math::Pose3d(1.8, 0, 1.8, 0, 0, 0));
+  EXPECT_TRUE(cylinder.aabb.Intersects(sphere.aabb));
+  EXPECT_FALSE(collideShapes(cylinder, sphere, contact));
+}
+
+/////////////////////////////////////////////////
+TEST(NarrowPhase, BoxCylinder)
+{
+  ShapeGeometry cylinder = cylinderGeometry(1, 2, math::Pose3d::Zero);
+  ShapeGeometry box = boxGeometry(math::Vector3d(2, 2, 2),
+      math::Pose3d(1.5, 0, 0, 0, 0, 0));
+
+  ShapeContact contact;
+  ASSERT_TRUE(collideShapes(cylinder, box, contact));
+  EXPECT_EQ(math::Vector3d::UnitX, contact.normal);
+  EXPECT_NEAR(0.5, contact.depth, 1e-3);
+  EXPECT_NEAR(0.75, contact.point.X(), 1e-3);
+
+  ASSERT_TRUE(collideShapes(box, cylinder, contact));
+  EXPECT_EQ(-math::Vector3d::UnitX, contact.normal);
+  EXPECT_NEAR(0.5, contact.depth, 1e-3);
+
+  // box on top of the cylinder
+  box = boxGeometry(math::Vector3d(2, 2, 2),
+      math::Pose3d(0.2, 0, 1.8, 0, 0, 0));
+  ASSERT_TRUE(collideShapes(cylinder, box, contact));
+  EXPECT_EQ(math::Vector3d::UnitZ, contact.normal);
+  EXPECT_NEAR(0.2, contact.depth, 1e-3);
+
+  // rotated box whose edge is inside the cylinder
+  box = boxGeometry(math::Vector3d(2, 2, 2),
+      math::Pose3d(2.2, 0, 0, 0, 0, IGN_PI * 0.25));
+  ASSERT_TRUE(collideShapes(cylinder, box, contact));
+  EXPECT_EQ(math::Vector3d::UnitX, contact.normal);
+  EXPECT_NEAR(1.0 - (2.2 - std::sqrt(2.0)), contact.depth, 1e-3);
+
+  // the AABBs overlap but the shapes do not
+  box = boxGeometry(math::Vector3d(2, 2, 2),
+      math::Pose3d(1.9, 1.9, 0, 0, 0, 0));
+  EXPECT_TRUE(cylinder.aabb.Intersects(box.aabb));
+  EXPECT_FALSE(collideShapes(cylinder, box, contact));
+}
+
+/////////////////////////////////////////////////
+TEST(NarrowPhase, CylinderCylinder)
+{
+  ShapeGeometry cylinder1 = cylinderGeometry(1, 2, math::Pose3d::Zero);
+  ShapeGeometry cylinder2 = cylinderGeometry(1, 2,
+      math::Pose3d(1.5, 0, 0, 0, 0, 0));
+
+  ShapeContact contact;
+  ASSERT_TRUE(collideShapes(cylinder1, cylinder2, contact));
+  EXPECT_EQ(math::Vector3d::UnitX, contact.normal);
+  EXPECT_NEAR(0.5, contact.depth, 1e-3);
+  EXPECT_NEAR(0.75, contact.point.X(), 1e-3);
+
+  // stacked cylinders
+  cylinder2 = cylinderGeometry(1, 2, math::Pose3d(0.5, 0, 1.9, 0, 0, 0));
+  ASSERT_TRUE(collideShapes(cylinder1, cylinder2, contact));
+  EXPECT_EQ(math::Vector3d::UnitZ, contact.normal);
+  EXPECT_NEAR(0.1, contact.depth, 1e-3);
+
+  // the AABBs overlap but the shapes do not
+  cylinder2 = cylinderGeometry(1, 2, math::Pose3d(1.5, 1.5, 0, 0, 0, 0));
+  EXPECT_TRUE(cylinder1.aabb.Intersects(cylinder2.aabb));
+  EXPECT_FALSE(collideShapes(cylinder1, cylinder2, contact));
+}
@@ -28,7 +28,7 @@ Shape::Shape()
 }
 
 //////////////////////////////////////////////////
-math::AxisAlignedBox Shape::GetBoundingBox()
+math::AxisAlignedBox Shape::GetBoundingBox() const
 {
   if (this->dirty)
   {
@@ -39,7 +39,7 @@ math::AxisAlignedBox Shape::GetBoundingBox()
 }
 
 //////////////////////////////////////////////////
-void Shape::UpdateBoundingBox()
+void Shape::UpdateBoundingBox() const
 {
   // No op. To be overriden by derived classes
 }
@@ -85,13 +85,13 @@ void BoxShape::SetSize(const math::Vector3d &_size)
 }
 
 //////////////////////////////////////////////////
-math::Vector3d BoxShape::GetSize()
+math::Vector3d BoxShape::GetSize() const
 {
   return this->size;
 }
 
 //////////////////////////////////////////////////
-void BoxShape::UpdateBoundingBox()
+void BoxShape::UpdateBoundingBox() const
 {
   math::Vector3d halfSize = this->size * 0.5;
   this->bbox = math::AxisAlignedBox(-halfSize, halfSize);
@@ -146,7 +146,7 @@ void CylinderShape::SetLength(double _length)
 }
 
 //////////////////////////////////////////////////
-void CylinderShape::UpdateBoundingBox()
+void CylinderShape::UpdateBoundingBox() const
 {
   math::Vector3d halfSize(this->radius, this->radius, this->length*0.5);
   this->bbox = math::AxisAlignedBox(-halfSize, halfSize);
@@ -187,7 +187,7 @@ void SphereShape::SetRadius(double _radius)
 }
 
 //////////////////////////////////////////////////
-void SphereShape::UpdateBoundingBox()
+void SphereShape::UpdateBoundingBox() const
 {
   math::Vector3d halfSize(this->radius, this->radius, this->radius);
   this->bbox = math::AxisAlignedBox(-halfSize, halfSize);
@@ -240,7 +240,7 @@ void MeshShape::SetMesh(const common::Mesh &_mesh)
 }
 
 //////////////////////////////////////////////////
-void MeshShape::UpdateBoundingBox()
+void MeshShape::UpdateBoundingBox() const
 {
   this->bbox = math::AxisAlignedBox(
       this->scale * this->meshAABB.Min(), this->scale * this->meshAABB.Max());
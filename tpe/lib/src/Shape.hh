@@ -65,25 +65,26 @@ class IGNITION_PHYSICS_TPELIB_VISIBLE Shape
   /// \brief Destructor
   public: ~Shape() = default;
 
-  /// \brief Get bounding box of shape
+  /// \brief Get bounding box of shape. The box is cached and only computed
+  /// again after the shape changes.
   /// \return Shape's bounding box
-  public: virtual math::AxisAlignedBox GetBoundingBox();
+  public: virtual math::AxisAlignedBox GetBoundingBox() const;
 
   /// \brief Get type of shape
   /// \return Type of shape
   public: virtual ShapeType GetType() const;
 
   /// \brief Update the shape's bounding box
-  protected: virtual void UpdateBoundingBox();
+  protected: virtual void UpdateBoundingBox() const;
 
   /// \brief Bounding Box
-  protected: math::AxisAlignedBox bbox;
+  protected: mutable math::AxisAlignedBox bbox;
 
   /// \brief Type of shape
   protected: ShapeType type;
 
   /// \brief Flag to indicate if dimensions changed
-  protected: bool dirty = true;
+  protected: mutable bool dirty = true;
 };
 
 /// \brief Box geometry
@@ -109,10 +110,10 @@ class IGNITION_PHYSICS_TPELIB_VISIBLE BoxShape : public Shape
 
   /// \brief Get size of box
   /// \return Size of box
-  public: math::Vector3d GetSize();
+  public: math::Vector3d GetSize() const;
 
   // Documentation inherited
-  protected: virtual void UpdateBoundingBox() override;
+  protected: virtual void UpdateBoundingBox() const override;
 
   IGN_UTILS_WARN_IGNORE__DLL_INTERFACE_MISSING
   /// \brief Size of box
@@ -154,7 +155,7 @@ class IGNITION_PHYSICS_TPELIB_VISIBLE CylinderShape : public Shape
   public: void SetLength(double _length);
 
   // Documentation inherited
-  protected: virtual void UpdateBoundingBox() override;
+  protected: virtual void UpdateBoundingBox() const override;
 
   /// \brief Cylinder radius
   private: double radius = 0.0;
@@ -189,7 +190,7 @@ class IGNITION_PHYSICS_TPELIB_VISIBLE SphereShape : public Shape
   public: void SetRadius(double _radius);
 
   // Documentation inherited
-  protected: virtual void UpdateBoundingBox() override;
+  protected: virtual void UpdateBoundingBox() const override;
 
   /// \brief Sphere radius
   private: double radius = 0.0;
@@ -225,7 +226,7 @@ class IGNITION_PHYSICS_TPELIB_VISIBLE MeshShape : public Shape
   public: void SetScale(math::Vector3d _scale);
 
   // Documentation inherited
-  protected: virtual void UpdateBoundingBox() override;
+  protected: virtual void UpdateBoundingBox() const override;
 
   IGN_UTILS_WARN_IGNORE__DLL_INTERFACE_MISSING
   /// \brief Mesh scale
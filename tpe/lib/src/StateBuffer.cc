@@ -0,0 +1,87 @@
+/*
+ * Copyright (C) 2020 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include "StateBuffer.hh"
+
+using namespace ignition;
+using namespace physics;
+using namespace tpelib;
+
+//////////////////////////////////////////////////
+StateWriter::StateWriter(std::vector<uint8_t> &_buffer)
+  : buffer(_buffer)
+{
+}
+
+//////////////////////////////////////////////////
+void StateWriter::Write(const math::Vector3d &_value)
+{
+  const double values[3] = {_value.X(), _value.Y(), _value.Z()};
+  this->Write(values);
+}
+
+//////////////////////////////////////////////////
+void StateWriter::Write(const math::Quaterniond &_value)
+{
+  const double values[4] = {_value.W(), _value.X(), _value.Y(), _value.Z()};
+  this->Write(values);
+}
+
+//////////////////////////////////////////////////
+void StateWriter::Write(const math::Pose3d &_value)
+{
+  this->Write(_value.Pos());
+  this->Write(_value.Rot());
+}
+
+//////////////////////////////////////////////////
+StateReader::StateReader(const std::vector<uint8_t> &_buffer)
+  : data(_buffer.data()), end(_buffer.data() + _buffer.size())
+{
+}
+
+//////////////////////////////////////////////////
+bool StateReader::Read(math::Vector3d &_value)
+{
+  double values[3];
+  if (!this->Read(values))
+    return false;
+  _value.Set(values[0], values[1], values[2]);
+  return true;
+}
+
+//////////////////////////////////////////////////
+bool StateReader::Read(math::Quaterniond &_value)
+{
+  double values[4];
+  if (!this->Read(values))
+    return false;
+  _value.Set(values[0], values[1], values[2], values[3]);
+  return true;
+}
+
+//////////////////////////////////////////////////
+bool StateReader::Read(math::Pose3d &_value)
+{
+  return this->Read(_value.Pos()) && this->Read(_value.Rot());
+}
+
+//////////////////////////////////////////////////
+bool StateReader::AtEnd() const
+{
+  return this->data == this->end;
+}
@@ -0,0 +1,128 @@
+/*
+ * Copyright (C) 2020 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#ifndef IGNITION_PHYSICS_TPE_LIB_SRC_STATEBUFFER_HH_
+#define IGNITION_PHYSICS_TPE_LIB_SRC_STATEBUFFER_HH_
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include <vector>
+
+#include <ignition/math/Pose3.hh>
+#include <ignition/math/Quaternion.hh>
+#include <ignition/math/Vector3.hh>
+
+#include "ignition/physics/tpelib/Export.hh"
+
+namespace ignition {
+namespace physics {
+namespace tpelib {
+
+/// \brief Appends values to a contiguous binary buffer of simulation state.
+/// Values are written in the byte order of the machine, so a buffer can only
+/// be read back on the same kind of machine.
+class IGNITION_PHYSICS_TPELIB_VISIBLE StateWriter
+{
+  /// \brief Constructor
+  /// \param[in] _buffer Buffer to append to
+  public: explicit StateWriter(std::vector<uint8_t> &_buffer);
+
+  /// \brief Append a trivially copyable value
+  /// \param[in] _value Value to append
+  public: template <typename T>
+  void Write(const T &_value)
+  {
+    static_assert(std::is_trivially_copyable<T>::value,
+        "StateWriter can only write trivially copyable values");
+    const std::size_t offset = this->buffer.size();
+    this->buffer.resize(offset + sizeof(T));
+    std::memcpy(this->buffer.data() + offset, &_value, sizeof(T));
+  }
+
+  /// \brief Append a vector
+  /// \param[in] _value Vector to append
+  public: void Write(const math::Vector3d &_value);
+
+  /// \brief Append a quaternion
+  /// \param[in] _value Quaternion to append
+  public: void Write(const math::Quaterniond &_value);
+
+  /// \brief Append a pose
+  /// \param[in] _value Pose to append
+  public: void Write(const math::Pose3d &_value);
+
+  /// \brief Buffer to append to
+  private: std::vector<uint8_t> &buffer;
+};
+
+/// \brief Reads values written by StateWriter from a binary buffer. Reads
+/// past the end of the buffer fail and leave the value unchanged.
+class IGNITION_PHYSICS_TPELIB_VISIBLE StateReader
+{
+  /// \brief Constructor
+  /// \param[in] _buffer Buffer to read from. It must outlive the reader.
+  public: explicit StateReader(const std::vector<uint8_t> &_buffer);
+
+  /// \brief Read a trivially copyable value
+  /// \param[out] _value Value read
+  /// \return True if the value was read, false if the end of the buffer
+  /// was reached
+  public: template <typename T>
+  bool Read(T &_value)
+  {
+    static_assert(std::is_trivially_copyable<T>::value,
+        "StateReader can only read trivially copyable values");
+    if (this->end - this->data < static_cast<std::ptrdiff_t>(sizeof(T)))
+      return false;
+    std::memcpy(&_value, this->data, sizeof(T));
+    this->data += sizeof(T);
+    return true;
+  }
+
+  /// \brief Read a vector
+  /// \param[out] _value Vector read
+  /// \return True if the value was read
+  public: bool Read(math::Vector3d &_value);
+
+  /// \brief Read a quaternion
+  /// \param[out] _value Quaternion read
+  /// \return True if the value was read
+  public: bool Read(math::Quaterniond &_value);
+
+  /// \brief Read a pose
+  /// \param[out] _value Pose read
+  /// \return True if the value was read
+  public: bool Read(math::Pose3d &_value);
+
+  /// \brief Get whether all the buffer was read
+  /// \return True if there is nothing left to read
+  public: bool AtEnd() const;
+
+  /// \brief Next byte to read
+  private: const uint8_t *data;
+
+  /// \brief End of the buffer
+  private: const uint8_t *end;
+};
+
+}
+}
+}
+
+#endif
@@ -0,0 +1,70 @@
+/*
+ * Copyright (C) 2020 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <vector>
+
+#include "StateBuffer.hh"
+
+using namespace ignition;
+using namespace physics;
+using namespace tpelib;
+
+/////////////////////////////////////////////////
+TEST(StateBuffer, WriteRead)
+{
+  std::vector<uint8_t> buffer;
+  StateWriter writer(buffer);
+  writer.Write(uint32_t(7u));
+  writer.Write(2.5);
+  writer.Write(true);
+  writer.Write(math::Vector3d(1, 2, 3));
+  writer.Write(math::Pose3d(4, 5, 6, 0.1, 0.2, 0.3));
+  EXPECT_EQ(4u + 8u + 1u + 3u * 8u + 7u * 8u, buffer.size());
+
+  StateReader reader(buffer);
+  uint32_t u = 0u;
+  double d = 0.0;
+  bool b = false;
+  math::Vector3d v;
+  math::Pose3d p;
+  EXPECT_TRUE(reader.Read(u));
+  EXPECT_TRUE(reader.Read(d));
+  EXPECT_TRUE(reader.Read(b));
+  EXPECT_TRUE(reader.Read(v));
+  EXPECT_FALSE(reader.AtEnd());
+  EXPECT_TRUE(reader.Read(p));
+  EXPECT_TRUE(reader.AtEnd());
+  EXPECT_EQ(7u, u);
+  EXPECT_DOUBLE_EQ(2.5, d);
+  EXPECT_TRUE(b);
+  EXPECT_EQ(math::Vector3d(1, 2, 3), v);
+  EXPECT_EQ(math::Pose3d(4, 5, 6, 0.1, 0.2, 0.3), p);
+
+  // reading past the end fails and leaves the value unchanged
+  EXPECT_FALSE(reader.Read(u));
+  EXPECT_EQ(7u, u);
+  EXPECT_FALSE(reader.Read(v));
+  EXPECT_EQ(math::Vector3d(1, 2, 3), v);
+
+  // values are appended to the contents of the buffer
+  StateWriter writer2(buffer);
+  writer2.Write(uint8_t(1u));
+  EXPECT_EQ(4u + 8u + 1u + 3u * 8u + 7u * 8u + 1u, buffer.size());
+}
@@ -0,0 +1,880 @@
+/*
+ * Copyright (C) 2020 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <set>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <ignition/common/Console.hh>
+
+#include "AABBTree.hh"
+#include "SweepAndPrune.hh"
+
+namespace ignition {
+namespace physics {
+namespace tpelib {
+
+/// \brief Nodes whose fat box is longer than this many times the median
+/// length along the sorting axis are stored in the tree
+static const double kOversizedScale = 8.0;
+
+/// \brief A node in the sweep and prune broadphase
+struct SweepAndPruneBox
+{
+  /// \brief User node id
+  public: std::size_t id = 0u;
+
+  /// \brief Minimum corner of the tight box
+  public: double min[3] = {0.0, 0.0, 0.0};
+
+  /// \brief Maximum corner of the tight box
+  public: double max[3] = {0.0, 0.0, 0.0};
+
+  /// \brief Minimum corner of the fat box
+  public: double fatMin[3] = {0.0, 0.0, 0.0};
+
+  /// \brief Maximum corner of the fat box
+  public: double fatMax[3] = {0.0, 0.0, 0.0};
+
+  /// \brief Position of the box in the sorted order, or kPending if the box
+  /// has not been merged into the sorted order yet or is stored in the tree
+  public: std::size_t rank = 0u;
+
+  /// \brief True if the node was removed but its box is still kept in the
+  /// sorted order until the next compaction
+  public: bool removed = false;
+
+  /// \brief True if the node is stored in the tree instead of the sorted
+  /// order
+  public: bool oversized = false;
+};
+
+/// \brief Rank of boxes waiting to be merged into the sorted order
+static const std::size_t kPending = static_cast<std::size_t>(-1);
+
+/// \brief Check whether two boxes given by their corners overlap. Touching
+/// boxes are considered overlapping.
+/// \param[in] _min1 Minimum corner of first box
+/// \param[in] _max1 Maximum corner of first box
+/// \param[in] _min2 Minimum corner of second box
+/// \param[in] _max2 Maximum corner of second box
+/// \return True if the boxes overlap
+static inline bool BoxesOverlap(const double *_min1, const double *_max1,
+    const double *_min2, const double *_max2)
+{
+  return _max1[0] >= _min2[0] && _min1[0] <= _max2[0] &&
+         _max1[1] >= _min2[1] && _min1[1] <= _max2[1] &&
+         _max1[2] >= _min2[2] && _min1[2] <= _max2[2];
+}
+
+/// \brief Private data class for SweepAndPrune
+class SweepAndPrunePrivate
+{
+  /// \brief Set the tight box of a node
+  /// \param[in] _box Node to set
+  /// \param[in] _aabb New box
+  public: void SetTightBox(SweepAndPruneBox &_box,
+      const math::AxisAlignedBox &_aabb);
+
+  /// \brief Set the fat box of a node from its tight box
+  /// \param[in] _box Node to set
+  /// \param[in] _displacement Displacement of the tight box since the last
+  /// update
+  public: void SetFatBox(SweepAndPruneBox &_box,
+      const double *_displacement);
+
+  /// \brief Check whether the fat box of a node is too long along the
+  /// sorting axis to be kept in the sorted order
+  /// \param[in] _box Node to check
+  /// \return True if the node belongs in the tree
+  public: bool Oversized(const SweepAndPruneBox &_box) const;
+
+  /// \brief Store a node in the tree if it is oversized, otherwise add it
+  /// to the pending nodes that are merged into the sorted order
+  /// \param[in] _i Index of the node in boxes
+  public: void Insert(std::size_t _i);
+
+  /// \brief Move a node to a new slot at the end of boxes and leave a
+  /// removed box in its old slot, so the node can leave the sorted order
+  /// without shifting the other boxes
+  /// \param[in] _i Index of the node in boxes
+  /// \return New index of the node in boxes
+  public: std::size_t Relocate(std::size_t _i);
+
+  /// \brief Move a node to its position in the sorted order by swapping it
+  /// with its neighbors, i.e. one step of insertion sort
+  /// \param[in] _rank Current position of the node in the sorted order
+  public: void Sort(std::size_t _rank);
+
+  /// \brief Choose the axis along which the centers of the fat boxes have
+  /// the largest variance, tune the length above which nodes are stored in
+  /// the tree and sort the other boxes along the axis. Must be called
+  /// without removed or pending boxes.
+  public: void ChooseAxis();
+
+  /// \brief Drop removed boxes and merge pending boxes into the sorted order
+  /// in a single pass over the nodes
+  public: void Flush();
+
+  /// \brief Flush if removed or pending boxes outnumber the sorted ones
+  public: void FlushIfNeeded();
+
+  /// \brief Get the position in the sorted order of the first node whose fat
+  /// box may overlap with a box, given the minimum of the box
+  /// \param[in] _min Minimum of the box along the sorting axis
+  /// \return Position of the first candidate node
+  public: std::size_t FirstCandidate(double _min) const;
+
+  /// \brief Find the nodes in the sorted order and in the pending nodes
+  /// whose tight boxes overlap with a box
+  /// \param[in] _min Minimum corner of the box
+  /// \param[in] _max Maximum corner of the box
+  /// \param[in] _skip Index in boxes of a node to skip
+  /// \param[out] _ids Ids of the nodes are appended to this vector
+  public: void SortedQuery(const double *_min, const double *_max,
+      std::size_t _skip, std::vector<std::size_t> &_ids) const;
+
+  /// \brief Get the fat box of a node
+  /// \param[in] _box Node
+  /// \return Fat box, which is taken from the tree for oversized nodes
+  public: math::AxisAlignedBox FatBox(const SweepAndPruneBox &_box) const;
+
+  /// \brief Nodes stored contiguously in no particular order
+  public: std::vector<SweepAndPruneBox> boxes;
+
+  /// \brief A map of user node id to the index of its node in boxes
+  public: std::unordered_map<std::size_t, std::size_t> index;
+
+  /// \brief Indices of nodes in boxes sorted by the minimum of their fat box
+  /// along the sorting axis. May contain removed boxes.
+  public: std::vector<std::size_t> order;
+
+  /// \brief Indices of added nodes in boxes that are not in the sorted order
+  /// yet. May contain removed boxes.
+  public: std::vector<std::size_t> pending;
+
+  /// \brief Number of removed boxes that are still in boxes
+  public: std::size_t removedCount = 0u;
+
+  /// \brief New index of each box in boxes, used when compacting
+  public: std::vector<std::size_t> remap;
+
+  /// \brief Tree of nodes that are too long along the sorting axis, such as
+  /// ground planes, so they do not widen the sweep of every query
+  public: AABBTree tree;
+
+  /// \brief Buffer of ids used by queries of the tree
+  public: std::vector<std::size_t> ids;
+
+  /// \brief Buffer of pairs of nodes in the tree used by the pair queries
+  public: std::vector<std::pair<std::size_t, std::size_t>> treePairs;
+
+  /// \brief Axis along which boxes are sorted
+  public: int axis = 0;
+
+  /// \brief Number of nodes when the axis was last chosen
+  public: std::size_t axisNodeCount = 0u;
+
+  /// \brief Length of fat boxes along the sorting axis above which nodes are
+  /// stored in the tree
+  public: double lengthLimit = std::numeric_limits<double>::infinity();
+
+  /// \brief Upper bound of the length of the fat boxes in the sorted order
+  /// along the sorting axis, used to find where to start the sweep for a
+  /// query box. Bounded by lengthLimit.
+  public: double maxLength = 0.0;
+
+  /// \brief Margin used to enlarge the tight boxes
+  public: double margin = 0.0;
+
+  /// \brief Scale applied to displacement when enlarging the tight boxes
+  public: double displacementScale = 0.0;
+};
+}
+}
+}
+
+using namespace ignition;
+using namespace physics;
+using namespace tpelib;
+
+//////////////////////////////////////////////////
+void SweepAndPrunePrivate::SetTightBox(SweepAndPruneBox &_box,
+    const math::AxisAlignedBox &_aabb)
+{
+  _box.min[0] = _aabb.Min().X();
+  _box.min[1] = _aabb.Min().Y();
+  _box.min[2] = _aabb.Min().Z();
+  _box.max[0] = _aabb.Max().X();
+  _box.max[1] = _aabb.Max().Y();
+  _box.max[2] = _aabb.Max().Z();
+}
+
+//////////////////////////////////////////////////
+void SweepAndPrunePrivate::SetFatBox(SweepAndPruneBox &_box,
+    const double *_displacement)
+{
+  fattenBox(_box.min, _box.max, this->margin, this->displacementScale,
+      _displacement, _box.fatMin, _box.fatMax);
+}
+
+//////////////////////////////////////////////////
+bool SweepAndPrunePrivate::Oversized(const SweepAndPruneBox &_box) const
+{
+  return _box.fatMax[this->axis] - _box.fatMin[this->axis] >
+      this->lengthLimit;
+}
+
+//////////////////////////////////////////////////
+void SweepAndPrunePrivate::Insert(std::size_t _i)
+{
+  SweepAndPruneBox &box = this->boxes[_i];
+  box.rank = kPending;
+  box.oversized = this->Oversized(box);
+  if (box.oversized)
+  {
+    this->tree.AddNode(box.id, math::AxisAlignedBox(
+        math::Vector3d(box.min[0], box.min[1], box.min[2]),
+        math::Vector3d(box.max[0], box.max[1], box.max[2])));
+    return;
+  }
+
+  this->maxLength = std::max(this->maxLength,
+      box.fatMax[this->axis] - box.fatMin[this->axis]);
+  this->pending.push_back(_i);
+}
+
+//////////////////////////////////////////////////
+std::size_t SweepAndPrunePrivate::Relocate(std::size_t _i)
+{
+  const SweepAndPruneBox box = this->boxes[_i];
+  this->boxes[_i].removed = true;
+  ++this->removedCount;
+
+  const std::size_t i = this->boxes.size();
+  this->boxes.push_back(box);
+  this->index[box.id] = i;
+  return i;
+}
+
+//////////////////////////////////////////////////
+void SweepAndPrunePrivate::Sort(std::size_t _rank)
+{
+  const std::size_t i = this->order[_rank];
+  const double value = this->boxes[i].fatMin[this->axis];
+  std::size_t r = _rank;
+  while (r > 0u && this->boxes[this->order[r - 1u]].fatMin[this->axis] > value)
+  {
+    this->order[r] = this->order[r - 1u];
+    this->boxes[this->order[r]].rank = r;
+    --r;
+  }
+  while (r + 1u < this->order.size() &&
+      this->boxes[this->order[r + 1u]].fatMin[this->axis] < value)
+  {
+    this->order[r] = this->order[r + 1u];
+    this->boxes[this->order[r]].rank = r;
+    ++r;
+  }
+  this->order[r] = i;
+  this->boxes[i].rank = r;
+}
+
+//////////////////////////////////////////////////
+void SweepAndPrunePrivate::ChooseAxis()
+{
+  this->axisNodeCount = this->boxes.size();
+
+  double sum[3] = {0.0, 0.0, 0.0};
+  double sumSquared[3] = {0.0, 0.0, 0.0};
+  for (const auto &box : this->boxes)
+  {
+    for (int i = 0; i < 3; ++i)
+    {
+      double center = 0.5 * (box.fatMin[i] + box.fatMax[i]);
+      sum[i] += center;
+      sumSquared[i] += center * center;
+    }
+  }
+
+  // variance times the number of nodes, which does not change the best axis
+  int best = this->axis;
+  double bestVariance = -1.0;
+  double count = static_cast<double>(this->boxes.size());
+  for (int i = 0; i < 3; ++i)
+  {
+    double variance = sumSquared[i] - sum[i] * sum[i] / count;
+    if (variance > bestVariance)
+    {
+      best = i;
+      bestVariance = variance;
+    }
+  }
+  this->axis = best;
+
+  // the median is not affected by a few long nodes such as ground planes
+  std::vector<double> lengths;
+  lengths.reserve(this->boxes.size());
+  for (const auto &box : this->boxes)
+    lengths.push_back(box.fatMax[best] - box.fatMin[best]);
+  this->lengthLimit = std::numeric_limits<double>::infinity();
+  if (!lengths.empty())
+  {
+    auto median = lengths.begin() + lengths.size() / 2u;
+    std::nth_element(lengths.begin(), median, lengths.end());
+    if (*median > 0.0 && std::isfinite(*median))
+      this->lengthLimit = kOversizedScale * *median;
+  }
+
+  // move nodes between the tree and the sorted order and sort the boxes
+  // along the axis
+  this->order.clear();
+  this->maxLength = 0.0;
+  for (std::size_t i = 0u; i < this->boxes.size(); ++i)
+  {
+    SweepAndPruneBox &box = this->boxes[i];
+    const bool oversized = this->Oversized(box);
+    if (box.oversized && !oversized)
+    {
+      this->tree.RemoveNode(box.id);
+    }
+    else if (!box.oversized && oversized)
+    {
+      this->tree.AddNode(box.id, math::AxisAlignedBox(
+          math::Vector3d(box.min[0], box.min[1], box.min[2]),
+          math::Vector3d(box.max[0], box.max[1], box.max[2])));
+    }
+    box.oversized = oversized;
+    box.rank = kPending;
+    if (oversized)
+      continue;
+
+    this->maxLength = std::max(this->maxLength,
+        box.fatMax[best] - box.fatMin[best]);
+    this->order.push_back(i);
+  }
+
+  std::sort(this->order.begin(), this->order.end(),
+      [this](std::size_t _a, std::size_t _b)
+      {
+        return this->boxes[_a].fatMin[this->axis] <
+            this->boxes[_b].fatMin[this->axis];
+      });
+  for (std::size_t r = 0u; r < this->order.size(); ++r)
+    this->boxes[this->order[r]].rank = r;
+}
+
+//////////////////////////////////////////////////
+void SweepAndPrunePrivate::Flush()
+{
+  if (this->pending.empty() && this->removedCount == 0u)
+    return;
+
+  // compact the boxes, keeping the sorted order of the remaining ones
+  if (this->removedCount > 0u)
+  {
+    this->remap.assign(this->boxes.size(), kPending);
+    std::size_t count = 0u;
+    for (std::size_t i = 0u; i < this->boxes.size(); ++i)
+    {
+      if (this->boxes[i].removed)
+        continue;
+      if (count != i)
+      {
+        this->boxes[count] = this->boxes[i];
+        this->index[this->boxes[count].id] = count;
+      }
+      this->remap[i] = count++;
+    }
+    this->boxes.resize(count);
+
+    auto compact = [this](std::vector<std::size_t> &_indices)
+    {
+      std::size_t n = 0u;
+      for (std::size_t i : _indices)
+      {
+        if (this->remap[i] != kPending)
+          _indices[n++] = this->remap[i];
+      }
+      _indices.resize(n);
+    };
+    compact(this->order);
+    compact(this->pending);
+    this->removedCount = 0u;
+  }
+
+  // sort the pending boxes and merge them with the sorted ones
+  auto less = [this](std::size_t _a, std::size_t _b)
+  {
+    return this->boxes[_a].fatMin[this->axis] <
+        this->boxes[_b].fatMin[this->axis];
+  };
+  if (!this->pending.empty())
+  {
+    std::sort(this->pending.begin(), this->pending.end(), less);
+    const std::size_t sorted = this->order.size();
+    this->order.insert(this->order.end(), this->pending.begin(),
+        this->pending.end());
+    std::inplace_merge(this->order.begin(), this->order.begin() + sorted,
+        this->order.end(), less);
+    this->pending.clear();
+  }
+  for (std::size_t r = 0u; r < this->order.size(); ++r)
+    this->boxes[this->order[r]].rank = r;
+
+  if (this->boxes.empty())
+  {
+    this->maxLength = 0.0;
+    this->axisNodeCount = 0u;
+    this->lengthLimit = std::numeric_limits<double>::infinity();
+  }
+  // choose the axis again each time the number of nodes doubles
+  else if (this->boxes.size() >= 2u * this->axisNodeCount)
+  {
+    this->ChooseAxis();
+  }
+}
+
+//////////////////////////////////////////////////
+void SweepAndPrunePrivate::FlushIfNeeded()
+{
+  // merging early keeps the scans of pending boxes and the skipped removed
+  // boxes bounded by the number of sorted boxes
+  if (this->pending.size() > this->order.size() ||
+      this->removedCount > this->index.size())
+  {
+    this->Flush();
+  }
+}
+
+//////////////////////////////////////////////////
+std::size_t SweepAndPrunePrivate::FirstCandidate(double _min) const
+{
+  // a fat box that ends after _min starts after _min - maxLength
+  auto it = std::lower_bound(this->order.begin(), this->order.end(),
+      _min - this->maxLength, [this](std::size_t _i, double _value)
+      {
+        return this->boxes[_i].fatMin[this->axis] < _value;
+      });
+  return static_cast<std::size_t>(it - this->order.begin());
+}
+
+//////////////////////////////////////////////////
+void SweepAndPrunePrivate::SortedQuery(const double *_min,
+    const double *_max, std::size_t _skip,
+    std::vector<std::size_t> &_ids) const
+{
+  // sweep the fat boxes and check the tight boxes
+  for (std::size_t r = this->FirstCandidate(_min[this->axis]);
+      r < this->order.size() &&
+      this->boxes[this->order[r]].fatMin[this->axis] <= _max[this->axis];
+      ++r)
+  {
+    const SweepAndPruneBox &other = this->boxes[this->order[r]];
+    if (!other.removed && this->order[r] != _skip &&
+        BoxesOverlap(other.min, other.max, _min, _max))
+    {
+      _ids.push_back(other.id);
+    }
+  }
+
+  // check the boxes that are not merged into the sorted order yet
+  for (std::size_t i : this->pending)
+  {
+    const SweepAndPruneBox &other = this->boxes[i];
+    if (!other.removed && i != _skip &&
+        BoxesOverlap(other.min, other.max, _min, _max))
+    {
+      _ids.push_back(other.id);
+    }
+  }
+}
+
+//////////////////////////////////////////////////
+math::AxisAlignedBox SweepAndPrunePrivate::FatBox(
+    const SweepAndPruneBox &_box) const
+{
+  if (_box.oversized)
+    return this->tree.FatAABB(_box.id);
+
+  return math::AxisAlignedBox(
+      math::Vector3d(_box.fatMin[0], _box.fatMin[1], _box.fatMin[2]),
+      math::Vector3d(_box.fatMax[0], _box.fatMax[1], _box.fatMax[2]));
+}
+
+//////////////////////////////////////////////////
+SweepAndPrune::SweepAndPrune()
+  : dataPtr(new SweepAndPrunePrivate)
+{
+}
+
+//////////////////////////////////////////////////
+SweepAndPrune::~SweepAndPrune()
+{
+}
+
+//////////////////////////////////////////////////
+void SweepAndPrune::SetMargin(double _margin)
+{
+  this->dataPtr->margin = std::max(0.0, _margin);
+  this->dataPtr->tree.SetMargin(this->dataPtr->margin);
+}
+
+//////////////////////////////////////////////////
+double SweepAndPrune::Margin() const
+{
+  return this->dataPtr->margin;
+}
+
+//////////////////////////////////////////////////
+void SweepAndPrune::SetDisplacementScale(double _scale)
+{
+  this->dataPtr->displacementScale = std::max(0.0, _scale);
+  this->dataPtr->tree.SetDisplacementScale(
+      this->dataPtr->displacementScale);
+}
+
+//////////////////////////////////////////////////
+double SweepAndPrune::DisplacementScale() const
+{
+  return this->dataPtr->displacementScale;
+}
+
+//////////////////////////////////////////////////
+void SweepAndPrune::AddNode(std::size_t _id,
+    const math::AxisAlignedBox &_aabb)
+{
+  if (this->dataPtr->index.find(_id) != this->dataPtr->index.end())
+  {
+    ignerr << "Unable to add node '" << _id << "'. "
+           << "Node already exists." << std::endl;
+    return;
+  }
+
+  std::size_t i = this->dataPtr->boxes.size();
+  this->dataPtr->index[_id] = i;
+  this->dataPtr->boxes.emplace_back();
+  SweepAndPruneBox &box = this->dataPtr->boxes.back();
+  box.id = _id;
+  this->dataPtr->SetTightBox(box, _aabb);
+
+  const double noDisplacement[3] = {0.0, 0.0, 0.0};
+  this->dataPtr->SetFatBox(box, noDisplacement);
+
+  // the box is merged into the sorted order with other added boxes
+  this->dataPtr->Insert(i);
+  this->dataPtr->FlushIfNeeded();
+}
+
+//////////////////////////////////////////////////
+bool SweepAndPrune::RemoveNode(std::size_t _id)
+{
+  auto it = this->dataPtr->index.find(_id);
+  if (it == this->dataPtr->index.end())
+  {
+    ignerr << "Unable to remove node '" << _id << "'. "
+           << "Node not found." << std::endl;
+    return false;
+  }
+
+  // the box stays in the sorted order until the next compaction, which
+  // removes all removed boxes in a single pass
+  SweepAndPruneBox &box = this->dataPtr->boxes[it->second];
+  if (box.oversized)
+    this->dataPtr->tree.RemoveNode(_id);
+  box.removed = true;
+  this->dataPtr->index.erase(it);
+  ++this->dataPtr->removedCount;
+  this->dataPtr->FlushIfNeeded();
+  return true;
+}
+
+//////////////////////////////////////////////////
+bool SweepAndPrune::UpdateNode(std::size_t _id,
+    const math::AxisAlignedBox &_aabb)
+{
+  auto it = this->dataPtr->index.find(_id);
+  if (it == this->dataPtr->index.end())
+  {
+    ignerr << "Unable to update node '" << _id << "'. "
+           << "Node not found." << std::endl;
+    return false;
+  }
+
+  std::size_t i = it->second;
+  SweepAndPruneBox &box = this->dataPtr->boxes[i];
+  double displacement[3];
+  for (int j = 0; j < 3; ++j)
+  {
+    displacement[j] = 0.5 * ((_aabb.Min()[j] + _aabb.Max()[j]) -
+        (box.min[j] + box.max[j]));
+  }
+  this->dataPtr->SetTightBox(box, _aabb);
+
+  if (box.oversized)
+  {
+    // move the node to the sorted order if it became short enough
+    this->dataPtr->SetFatBox(box, displacement);
+    if (this->dataPtr->Oversized(box))
+      return this->dataPtr->tree.UpdateNode(_id, _aabb);
+
+    this->dataPtr->tree.RemoveNode(_id);
+    this->dataPtr->Insert(i);
+    this->dataPtr->FlushIfNeeded();
+    return true;
+  }
+
+  // the order only changes if the tight box moved out of the fat box
+  if (fatBoxValid(box.min, box.max, box.fatMin, box.fatMax,
+      this->dataPtr->margin, this->dataPtr->displacementScale, displacement))
+    return true;
+
+  // a node that became too long leaves a removed box in the sorted order,
+  // which keeps the old fat box so the order stays sorted
+  SweepAndPruneBox fatBox = box;
+  this->dataPtr->SetFatBox(fatBox, displacement);
+  if (this->dataPtr->Oversized(fatBox))
+  {
+    i = this->dataPtr->Relocate(i);
+    SweepAndPruneBox &moved = this->dataPtr->boxes[i];
+    std::copy(fatBox.fatMin, fatBox.fatMin + 3, moved.fatMin);
+    std::copy(fatBox.fatMax, fatBox.fatMax + 3, moved.fatMax);
+    this->dataPtr->Insert(i);
+    this->dataPtr->FlushIfNeeded();
+    return true;
+  }
+
+  std::copy(fatBox.fatMin, fatBox.fatMin + 3, box.fatMin);
+  std::copy(fatBox.fatMax, fatBox.fatMax + 3, box.fatMax);
+  this->dataPtr->maxLength = std::max(this->dataPtr->maxLength,
+      box.fatMax[this->dataPtr->axis] - box.fatMin[this->dataPtr->axis]);
+  if (box.rank != kPending)
+    this->dataPtr->Sort(box.rank);
+  return true;
+}
+
+//////////////////////////////////////////////////
+unsigned int SweepAndPrune::NodeCount() const
+{
+  return static_cast<unsigned int>(this->dataPtr->index.size());
+}
+
+//////////////////////////////////////////////////
+std::set<std::size_t> SweepAndPrune::Collisions(std::size_t _id) const
+{
+  std::set<std::size_t> result;
+  auto it = this->dataPtr->index.find(_id);
+  if (it == this->dataPtr->index.end())
+  {
+    ignerr << "Unable to compute collisions for node '" << _id << "'. "
+           << "Node not found." << std::endl;
+    return result;
+  }
+
+  const SweepAndPruneBox &box = this->dataPtr->boxes[it->second];
+  std::vector<std::size_t> ids;
+  if (box.oversized)
+  {
+    result = this->dataPtr->tree.Collisions(_id);
+  }
+  else
+  {
+    // the tree query clears the ids first
+    this->dataPtr->tree.Collisions(math::AxisAlignedBox(
+        math::Vector3d(box.min[0], box.min[1], box.min[2]),
+        math::Vector3d(box.max[0], box.max[1], box.max[2])), ids);
+  }
+  this->dataPtr->SortedQuery(box.min, box.max, it->second, ids);
+  result.insert(ids.begin(), ids.end());
+  return result;
+}
+
+//////////////////////////////////////////////////
+void SweepAndPrune::Collisions(const math::AxisAlignedBox &_box,
+    std::vector<std::size_t> &_ids) const
+{
+  // the tree query clears the ids first
+  this->dataPtr->tree.Collisions(_box, _ids);
+
+  const double min[3] = {_box.Min().X(), _box.Min().Y(), _box.Min().Z()};
+  const double max[3] = {_box.Max().X(), _box.Max().Y(), _box.Max().Z()};
+  this->dataPtr->SortedQuery(min, max, kPending, _ids);
+}
+
+//////////////////////////////////////////////////
+void SweepAndPrune::Collisions(
+    std::vector<std::pair<std::size_t, std::size_t>> &_pairs) const
+{
+  _pairs.clear();
+
+  // merge added nodes and drop removed ones before sweeping
+  this->dataPtr->Flush();
+
+  // each box is tested against the boxes that start before it ends along
+  // the sorting axis
+  const auto &boxes = this->dataPtr->boxes;
+  const auto &order = this->dataPtr->order;
+  const int axis = this->dataPtr->axis;
+  for (std::size_t r = 0u; r < order.size(); ++r)
+  {
+    const SweepAndPruneBox &a = boxes[order[r]];
+    for (std::size_t s = r + 1u;
+        s < order.size() && boxes[order[s]].fatMin[axis] <= a.fatMax[axis];
+        ++s)
+    {
+      const SweepAndPruneBox &b = boxes[order[s]];
+      if (BoxesOverlap(a.fatMin, a.fatMax, b.fatMin, b.fatMax))
+        _pairs.push_back(std::minmax(a.id, b.id));
+    }
+  }
+
+  const AABBTree &tree = this->dataPtr->tree;
+  if (tree.NodeCount() > 0u)
+  {
+    // pairs of nodes in the tree
+    tree.Collisions(this->dataPtr->treePairs);
+    _pairs.insert(_pairs.end(), this->dataPtr->treePairs.begin(),
+        this->dataPtr->treePairs.end());
+
+    // pairs of sorted nodes and nodes in the tree
+    auto &ids = this->dataPtr->ids;
+    for (std::size_t i : order)
+    {
+      const SweepAndPruneBox &box = boxes[i];
+      tree.Collisions(math::AxisAlignedBox(
+          math::Vector3d(box.fatMin[0], box.fatMin[1], box.fatMin[2]),
+          math::Vector3d(box.fatMax[0], box.fatMax[1], box.fatMax[2])), ids);
+      for (std::size_t id : ids)
+        _pairs.push_back(std::minmax(box.id, id));
+    }
+  }
+
+  std::sort(_pairs.begin(), _pairs.end());
+}
+
+//////////////////////////////////////////////////
+void SweepAndPrune::Collisions(const Broadphase &_other,
+    std::vector<std::pair<std::size_t, std::size_t>> &_pairs) const
+{
+  _pairs.clear();
+
+  // merge added nodes and drop removed ones before sweeping
+  this->dataPtr->Flush();
+
+  const auto &boxes = this->dataPtr->boxes;
+  const SweepAndPrune *otherSap = dynamic_cast<const SweepAndPrune *>(&_other);
+  if (!otherSap)
+  {
+    // query the other broadphase with the fat box of each node
+    auto &ids = this->dataPtr->ids;
+    for (const auto &box : boxes)
+    {
+      _other.Collisions(this->dataPtr->FatBox(box), ids);
+      for (std::size_t id : ids)
+        _pairs.emplace_back(box.id, id);
+    }
+    std::sort(_pairs.begin(), _pairs.end());
+    return;
+  }
+
+  // sweep each box along the sorted boxes of the other broadphase and query
+  // the tree of the other broadphase
+  otherSap->dataPtr->Flush();
+  const SweepAndPrunePrivate &other = *otherSap->dataPtr;
+  const int axis = other.axis;
+  auto &ids = this->dataPtr->ids;
+  for (const auto &box : boxes)
+  {
+    const math::AxisAlignedBox fatBox = this->dataPtr->FatBox(box);
+    const double fatMin[3] = {
+        fatBox.Min().X(), fatBox.Min().Y(), fatBox.Min().Z()};
+    const double fatMax[3] = {
+        fatBox.Max().X(), fatBox.Max().Y(), fatBox.Max().Z()};
+    for (std::size_t r = other.FirstCandidate(fatMin[axis]);
+        r < other.order.size() &&
+        other.boxes[other.order[r]].fatMin[axis] <= fatMax[axis]; ++r)
+    {
+      const SweepAndPruneBox &b = other.boxes[other.order[r]];
+      if (BoxesOverlap(fatMin, fatMax, b.fatMin, b.fatMax))
+        _pairs.emplace_back(box.id, b.id);
+    }
+
+    if (other.tree.NodeCount() > 0u)
+    {
+      other.tree.Collisions(fatBox, ids);
+      for (std::size_t id : ids)
+        _pairs.emplace_back(box.id, id);
+    }
+  }
+
+  std::sort(_pairs.begin(), _pairs.end());
+}
+
+//////////////////////////////////////////////////
+math::AxisAlignedBox SweepAndPrune::AABB(std::size_t _id) const
+{
+  auto it = this->dataPtr->index.find(_id);
+  if (it == this->dataPtr->index.end())
+  {
+    ignerr << "Unable to get AABB for node '" << _id << "'. "
+           << "Node not found." << std::endl;
+    return math::AxisAlignedBox();
+  }
+
+  const SweepAndPruneBox &box = this->dataPtr->boxes[it->second];
+  return math::AxisAlignedBox(
+      math::Vector3d(box.min[0], box.min[1], box.min[2]),
+      math::Vector3d(box.max[0], box.max[1], box.max[2]));
+}
+
+//////////////////////////////////////////////////
+math::AxisAlignedBox SweepAndPrune::FatAABB(std::size_t _id) const
+{
+  auto it = this->dataPtr->index.find(_id);
+  if (it == this->dataPtr->index.end())
+  {
+    ignerr << "Unable to get fat AABB for node '" << _id << "'. "
+           << "Node not found." << std::endl;
+    return math::AxisAlignedBox();
+  }
+
+  return this->dataPtr->FatBox(this->dataPtr->boxes[it->second]);
+}
+
+//////////////////////////////////////////////////
+bool SweepAndPrune::HasNode(std::size_t _id) const
+{
+  return this->dataPtr->index.find(_id) != this->dataPtr->index.end();
+}
+
+//////////////////////////////////////////////////
+bool SweepAndPrune::Oversized(std::size_t _id) const
+{
+  auto it = this->dataPtr->index.find(_id);
+  return it != this->dataPtr->index.end() &&
+      this->dataPtr->boxes[it->second].oversized;
+}
+
+//////////////////////////////////////////////////
+int SweepAndPrune::Axis() const
+{
+  return this->dataPtr->axis;
+}
@@ -0,0 +1,140 @@
+/*
+ * Copyright (C) 2020 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#ifndef IGNITION_PHYSICS_TPE_LIB_SRC_SWEEPANDPRUNE_HH_
+#define IGNITION_PHYSICS_TPE_LIB_SRC_SWEEPANDPRUNE_HH_
+
+#include <memory>
+#include <set>
+#include <utility>
+#include <vector>
+
+#include <ignition/math/AxisAlignedBox.hh>
+#include <ignition/utilities/SuppressWarning.hh>
+
+#include "ignition/physics/tpelib/Export.hh"
+
+#include "Broadphase.hh"
+
+namespace ignition {
+namespace physics {
+namespace tpelib {
+
+// forward declaration
+class SweepAndPrunePrivate;
+
+/// \brief Broadphase that keeps the fat boxes of nodes sorted by their
+/// minimum along one axis. Pairs are found by sweeping along the sorted
+/// boxes and checking the other two axes. Boxes are kept sorted with
+/// insertion sort as they move, which needs few swaps when nodes move by
+/// small amounts in each update. Added nodes are kept aside and removed
+/// nodes are only marked, so moving many nodes in or out does not shift the
+/// sorted boxes each time. They are merged into the sorted order in one pass
+/// when all pairs are queried, which is why those queries are not safe to
+/// call concurrently. The axis is the one along which the nodes are spread
+/// the most and is chosen again as the number of nodes grows. Nodes much
+/// longer than the others along the axis, such as ground planes, are kept
+/// in a tree instead, so they do not widen the sweep for every query.
+class IGNITION_PHYSICS_TPELIB_VISIBLE SweepAndPrune : public Broadphase
+{
+  /// \brief Constructor
+  public: SweepAndPrune();
+
+  /// \brief Destructor
+  public: ~SweepAndPrune() override;
+
+  // Documentation inherited
+  public: void AddNode(std::size_t _id,
+      const math::AxisAlignedBox &_aabb) override;
+
+  // Documentation inherited
+  public: bool RemoveNode(std::size_t _id) override;
+
+  // Documentation inherited
+  public: bool UpdateNode(std::size_t _id,
+      const math::AxisAlignedBox &_aabb) override;
+
+  // Documentation inherited
+  public: void SetMargin(double _margin) override;
+
+  // Documentation inherited
+  public: double Margin() const override;
+
+  // Documentation inherited
+  public: void SetDisplacementScale(double _scale) override;
+
+  // Documentation inherited
+  public: double DisplacementScale() const override;
+
+  // Documentation inherited
+  public: unsigned int NodeCount() const override;
+
+  // Documentation inherited
+  public: std::set<std::size_t> Collisions(std::size_t _id) const override;
+
+  // Documentation inherited
+  public: void Collisions(const math::AxisAlignedBox &_box,
+      std::vector<std::size_t> &_ids) const override;
+
+  // Documentation inherited
+  public: void Collisions(
+      std::vector<std::pair<std::size_t, std::size_t>> &_pairs)
+      const override;
+
+  /// \brief Get all pairs of nodes in this broadphase and nodes in another
+  /// broadphase that may collide / intersect with each other. Sorted boxes
+  /// of two sweep and prune broadphases are swept against each other,
+  /// otherwise the other broadphase is queried with the fat AABB of each
+  /// node in this broadphase.
+  /// \param[in] _other Other broadphase to check against
+  /// \param[out] _pairs Vector to be filled with pairs of node ids. The first
+  /// id of each pair is the id of the node in this broadphase and the second
+  /// is the id of the node in the other broadphase. Pairs are sorted. The
+  /// vector is cleared first so the same buffer can be reused across calls.
+  public: void Collisions(const Broadphase &_other,
+      std::vector<std::pair<std::size_t, std::size_t>> &_pairs)
+      const override;
+
+  // Documentation inherited
+  public: math::AxisAlignedBox AABB(std::size_t _id) const override;
+
+  // Documentation inherited
+  public: math::AxisAlignedBox FatAABB(std::size_t _id) const override;
+
+  // Documentation inherited
+  public: bool HasNode(std::size_t _id) const override;
+
+  /// \brief Get the axis along which the boxes are sorted
+  /// \return 0, 1 or 2 for the x, y or z axis
+  public: int Axis() const;
+
+  /// \brief Get whether a node is stored in the tree instead of the sorted
+  /// boxes because it is much longer than the other nodes along the axis
+  /// \param[in] _id Node id
+  /// \return True if the node is stored in the tree
+  public: bool Oversized(std::size_t _id) const;
+
+  /// \brief Pointer to the private data
+  IGN_UTILS_WARN_IGNORE__DLL_INTERFACE_MISSING
+  private: std::unique_ptr<SweepAndPrunePrivate> dataPtr;
+  IGN_UTILS_WARN_RESUME__DLL_INTERFACE_MISSING
+};
+}
+}
+}
+
+#endif
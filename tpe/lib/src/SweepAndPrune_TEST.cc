@@ -0,0 +1,329 @@
+/*
+ * Copyright (C) 2020 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <iterator>
+#include <map>
+#include <random>
+#include <set>
+#include <utility>
+#include <vector>
+
+#include "AABBTree.hh"
+#include "SweepAndPrune.hh"
+
+using namespace ignition;
+using namespace physics;
+using namespace tpelib;
+
+/////////////////////////////////////////////////
+TEST(SweepAndPrune, SweepAndPrune)
+{
+  SweepAndPrune sap;
+  EXPECT_EQ(0u, sap.NodeCount());
+
+  math::AxisAlignedBox a(-math::Vector3d::One, math::Vector3d::One);
+  sap.AddNode(1u, a);
+  math::AxisAlignedBox b(math::Vector3d(-3, -3, -3),
+     math::Vector3d(-2, -2, -2));
+  sap.AddNode(2u, b);
+  // c overlaps with a and b
+  math::AxisAlignedBox c(math::Vector3d(-2.5, -2.5, -2.5),
+      math::Vector3d(0.5, 0.5, 0.5));
+  sap.AddNode(3u, c);
+  // d overlaps with a only
+  math::AxisAlignedBox d(math::Vector3d(0.55, 0.55, 0.55),
+      math::Vector3d(0.75, 0.75, 0.75));
+  sap.AddNode(4u, d);
+  EXPECT_EQ(4u, sap.NodeCount());
+  EXPECT_TRUE(sap.HasNode(4u));
+  EXPECT_EQ(d, sap.AABB(4u));
+
+  // adding an existing node fails
+  sap.AddNode(4u, a);
+  EXPECT_EQ(4u, sap.NodeCount());
+  EXPECT_EQ(d, sap.AABB(4u));
+
+  EXPECT_EQ(std::set<std::size_t>({3u, 4u}), sap.Collisions(1u));
+  EXPECT_EQ(std::set<std::size_t>({3u}), sap.Collisions(2u));
+  EXPECT_EQ(std::set<std::size_t>({1u, 2u}), sap.Collisions(3u));
+  EXPECT_EQ(std::set<std::size_t>({1u}), sap.Collisions(4u));
+
+  std::vector<std::pair<std::size_t, std::size_t>> pairs;
+  sap.Collisions(pairs);
+  std::vector<std::pair<std::size_t, std::size_t>> expected =
+      {{1u, 3u}, {1u, 4u}, {2u, 3u}};
+  EXPECT_EQ(expected, pairs);
+
+  // remove nodes
+  EXPECT_FALSE(sap.RemoveNode(555u));
+  EXPECT_TRUE(sap.RemoveNode(2u));
+  EXPECT_EQ(3u, sap.NodeCount());
+  EXPECT_FALSE(sap.HasNode(2u));
+  EXPECT_EQ(std::set<std::size_t>({1u}), sap.Collisions(3u));
+  EXPECT_TRUE(sap.Collisions(2u).empty());
+
+  // move c away
+  EXPECT_TRUE(sap.UpdateNode(3u, math::AxisAlignedBox(
+      math::Vector3d(-40, -40, -40), math::Vector3d(-10, -10, -10))));
+  EXPECT_FALSE(sap.UpdateNode(2u, a));
+  EXPECT_EQ(std::set<std::size_t>({4u}), sap.Collisions(1u));
+  EXPECT_TRUE(sap.Collisions(3u).empty());
+  sap.Collisions(pairs);
+  expected = {{1u, 4u}};
+  EXPECT_EQ(expected, pairs);
+
+  EXPECT_EQ(math::AxisAlignedBox(), sap.AABB(2u));
+  EXPECT_EQ(math::AxisAlignedBox(), sap.FatAABB(2u));
+}
+
+/////////////////////////////////////////////////
+TEST(SweepAndPrune, Axis)
+{
+  // nodes spread along the y axis are sorted along it
+  std::mt19937 rng(2345);
+  std::uniform_real_distribution<double> spreadDist(-100.0, 100.0);
+  std::uniform_real_distribution<double> posDist(-2.0, 2.0);
+
+  SweepAndPrune sap;
+  for (std::size_t i = 0u; i < 100u; ++i)
+  {
+    math::Vector3d center(posDist(rng), spreadDist(rng), posDist(rng));
+    math::Vector3d halfSize(0.5, 0.5, 0.5);
+    sap.AddNode(i, math::AxisAlignedBox(center - halfSize, center + halfSize));
+  }
+  EXPECT_EQ(1, sap.Axis());
+
+  // pairs are the same as those found by a tree
+  AABBTree tree;
+  for (std::size_t i = 0u; i < 100u; ++i)
+    tree.AddNode(i, sap.AABB(i));
+  std::vector<std::pair<std::size_t, std::size_t>> pairs;
+  std::vector<std::pair<std::size_t, std::size_t>> treePairs;
+  sap.Collisions(pairs);
+  tree.Collisions(treePairs);
+  EXPECT_FALSE(pairs.empty());
+  EXPECT_EQ(treePairs, pairs);
+}
+
+/////////////////////////////////////////////////
+TEST(SweepAndPrune, MoveNodes)
+{
+  // nodes moved out and in between queries, e.g. between the static and
+  // dynamic broadphases of the collision detector, are found by all queries
+  std::mt19937 rng(3456);
+  std::uniform_real_distribution<double> posDist(-20.0, 20.0);
+
+  SweepAndPrune sap;
+  std::map<std::size_t, math::AxisAlignedBox> boxes;
+  math::Vector3d halfSize(1.0, 1.0, 1.0);
+  for (std::size_t i = 0u; i < 300u; ++i)
+  {
+    math::Vector3d center(posDist(rng), posDist(rng), posDist(rng));
+    boxes[i] = math::AxisAlignedBox(center - halfSize, center + halfSize);
+    sap.AddNode(i, boxes[i]);
+  }
+  std::vector<std::pair<std::size_t, std::size_t>> pairs;
+  sap.Collisions(pairs);
+
+  for (std::size_t step = 0u; step < 5u; ++step)
+  {
+    // remove some nodes and add others back with new boxes
+    for (std::size_t i = step; i < 300u; i += 7u)
+    {
+      EXPECT_TRUE(sap.RemoveNode(i));
+      EXPECT_FALSE(sap.HasNode(i));
+      boxes.erase(i);
+    }
+    for (std::size_t i = step + 3u; i < 300u; i += 7u)
+    {
+      if (boxes.find(i) != boxes.end())
+        continue;
+      math::Vector3d center(posDist(rng), posDist(rng), posDist(rng));
+      boxes[i] = math::AxisAlignedBox(center - halfSize, center + halfSize);
+      sap.AddNode(i, boxes[i]);
+      EXPECT_TRUE(sap.HasNode(i));
+      EXPECT_EQ(boxes[i], sap.AABB(i));
+    }
+    EXPECT_EQ(boxes.size(), sap.NodeCount());
+
+    // queries before the pending changes are merged
+    for (const auto &b : boxes)
+    {
+      std::set<std::size_t> expected;
+      for (const auto &other : boxes)
+      {
+        if (other.first != b.first && other.second.Intersects(b.second))
+          expected.insert(other.first);
+      }
+      EXPECT_EQ(expected, sap.Collisions(b.first));
+    }
+
+    // pairs after merging them
+    std::vector<std::pair<std::size_t, std::size_t>> expectedPairs;
+    for (auto it = boxes.begin(); it != boxes.end(); ++it)
+    {
+      for (auto jt = std::next(it); jt != boxes.end(); ++jt)
+      {
+        if (it->second.Intersects(jt->second))
+          expectedPairs.emplace_back(it->first, jt->first);
+      }
+    }
+    sap.Collisions(pairs);
+    EXPECT_EQ(expectedPairs, pairs);
+  }
+}
+
+/////////////////////////////////////////////////
+TEST(SweepAndPrune, Ground)
+{
+  // a ground box much longer than the other nodes is kept out of the sweep
+  // so it does not widen the range of sorted boxes checked by each query
+  std::mt19937 rng(4567);
+  std::uniform_real_distribution<double> posDist(-50.0, 50.0);
+  std::uniform_real_distribution<double> heightDist(0.0, 2.0);
+
+  SweepAndPrune sap;
+  SweepAndPrune staticSap;
+  std::map<std::size_t, math::AxisAlignedBox> boxes;
+  std::map<std::size_t, math::AxisAlignedBox> staticBoxes;
+  const std::size_t groundId = 1000u;
+  staticBoxes[groundId] = math::AxisAlignedBox(
+      math::Vector3d(-500.0, -500.0, -1.0), math::Vector3d(500.0, 500.0, 0.5));
+  staticSap.AddNode(groundId, staticBoxes[groundId]);
+  math::Vector3d halfSize(0.5, 0.5, 0.5);
+  for (std::size_t i = 0u; i < 500u; ++i)
+  {
+    math::Vector3d center(posDist(rng), posDist(rng), heightDist(rng));
+    math::AxisAlignedBox box(center - halfSize, center + halfSize);
+    if (i % 5u == 0u)
+    {
+      staticBoxes[i] = box;
+      staticSap.AddNode(i, box);
+    }
+    else
+    {
+      boxes[i] = box;
+      sap.AddNode(i, box);
+    }
+  }
+  // a wall that is only long when the dynamic boxes are sorted along x
+  boxes[groundId + 1u] = math::AxisAlignedBox(
+      math::Vector3d(-500.0, 10.0, 0.0), math::Vector3d(500.0, 11.0, 3.0));
+  sap.AddNode(groundId + 1u, boxes[groundId + 1u]);
+
+  std::vector<std::pair<std::size_t, std::size_t>> pairs;
+  std::vector<std::pair<std::size_t, std::size_t>> expectedPairs;
+  auto check = [&]()
+  {
+    staticSap.Collisions(pairs);
+    sap.Collisions(pairs);
+
+    // single nodes
+    for (const auto &b : staticBoxes)
+    {
+      std::set<std::size_t> expected;
+      for (const auto &other : staticBoxes)
+      {
+        if (other.first != b.first && other.second.Intersects(b.second))
+          expected.insert(other.first);
+      }
+      EXPECT_EQ(expected, staticSap.Collisions(b.first));
+      EXPECT_EQ(b.second, staticSap.AABB(b.first));
+    }
+
+    // pairs within the dynamic nodes
+    expectedPairs.clear();
+    for (auto it = boxes.begin(); it != boxes.end(); ++it)
+    {
+      for (auto jt = std::next(it); jt != boxes.end(); ++jt)
+      {
+        if (it->second.Intersects(jt->second))
+          expectedPairs.emplace_back(it->first, jt->first);
+      }
+    }
+    sap.Collisions(pairs);
+    EXPECT_EQ(expectedPairs, pairs);
+
+    // pairs between dynamic and static nodes, as checked by the collision
+    // detector
+    expectedPairs.clear();
+    for (const auto &b : boxes)
+    {
+      for (const auto &s : staticBoxes)
+      {
+        if (b.second.Intersects(s.second))
+          expectedPairs.emplace_back(b.first, s.first);
+      }
+    }
+    sap.Collisions(staticSap, pairs);
+    EXPECT_EQ(expectedPairs, pairs);
+
+    // box queries
+    math::AxisAlignedBox query(
+        math::Vector3d(-5.0, -5.0, -5.0), math::Vector3d(5.0, 5.0, 5.0));
+    std::vector<std::size_t> ids;
+    std::vector<std::size_t> expectedIds;
+    for (const auto &s : staticBoxes)
+    {
+      if (s.second.Intersects(query))
+        expectedIds.push_back(s.first);
+    }
+    staticSap.Collisions(query, ids);
+    std::sort(ids.begin(), ids.end());
+    EXPECT_EQ(expectedIds, ids);
+  };
+
+  check();
+  EXPECT_TRUE(staticSap.Oversized(groundId));
+  EXPECT_FALSE(staticSap.Oversized(0u));
+  EXPECT_TRUE(sap.Oversized(groundId + 1u) || sap.Axis() != 0);
+  EXPECT_FALSE(sap.Oversized(1u));
+
+  // shrink the ground so it is an ordinary node and grow a small box so it
+  // is kept in the tree instead
+  staticBoxes[groundId] = math::AxisAlignedBox(
+      math::Vector3d(-1.0, -1.0, -1.0), math::Vector3d(1.0, 1.0, 0.5));
+  staticSap.UpdateNode(groundId, staticBoxes[groundId]);
+  staticBoxes[5u] = math::AxisAlignedBox(
+      math::Vector3d(-500.0, -500.0, -1.0), math::Vector3d(500.0, 500.0, 0.0));
+  staticSap.UpdateNode(5u, staticBoxes[5u]);
+  check();
+  EXPECT_FALSE(staticSap.Oversized(groundId));
+  EXPECT_TRUE(staticSap.Oversized(5u));
+
+  // move the dynamic nodes, including the wall
+  for (auto &b : boxes)
+  {
+    math::Vector3d offset(0.3, -0.2, 0.1);
+    b.second = math::AxisAlignedBox(
+        b.second.Min() + offset, b.second.Max() + offset);
+    sap.UpdateNode(b.first, b.second);
+  }
+  check();
+
+  // remove the long nodes
+  EXPECT_TRUE(staticSap.RemoveNode(5u));
+  staticBoxes.erase(5u);
+  EXPECT_TRUE(sap.RemoveNode(groundId + 1u));
+  boxes.erase(groundId + 1u);
+  check();
+  EXPECT_EQ(staticBoxes.size(), staticSap.NodeCount());
+  EXPECT_EQ(boxes.size(), sap.NodeCount());
+}
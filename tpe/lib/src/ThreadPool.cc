@@ -0,0 +1,290 @@
+/*
+ * Copyright (C) 2020 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "ThreadPool.hh"
+
+namespace ignition {
+namespace physics {
+namespace tpelib {
+
+/// \brief A range of indices split into chunks to be run by the pool
+struct ThreadPoolJob
+{
+  /// \brief Function to call for each chunk
+  public: const ThreadPool::ChunkFunction *func = nullptr;
+
+  /// \brief Number of indices in the range
+  public: std::size_t count = 0u;
+
+  /// \brief Number of chunks
+  public: std::size_t chunkCount = 0u;
+
+  /// \brief Index of the next chunk to run
+  public: std::atomic<std::size_t> nextChunk{0u};
+
+  /// \brief Number of chunks that are done
+  public: std::atomic<std::size_t> doneChunks{0u};
+};
+
+/// \brief Private data class for ThreadPool
+class ThreadPoolPrivate
+{
+  /// \brief Start worker threads
+  public: void Start();
+
+  /// \brief Stop and join worker threads
+  public: void Stop();
+
+  /// \brief Worker thread loop
+  public: void Work();
+
+  /// \brief Run a job on the worker threads and the calling thread, and
+  /// wait for all its chunks to be done
+  /// \param[in] _count Number of indices in the range
+  /// \param[in] _chunkCount Number of chunks
+  /// \param[in] _func Function to call for each chunk
+  public: void RunJob(std::size_t _count, std::size_t _chunkCount,
+      const ThreadPool::ChunkFunction &_func);
+
+  /// \brief Run chunks of a job until there are none left
+  /// \param[in] _job Job to run
+  public: void RunChunks(ThreadPoolJob &_job);
+
+  /// \brief Number of threads, including the calling thread
+  public: unsigned int threadCount = 1u;
+
+  /// \brief Worker threads
+  public: std::vector<std::thread> workers;
+
+  /// \brief Mutex protecting the job and stop flag
+  public: std::mutex mutex;
+
+  /// \brief Notifies workers that a new job is available
+  public: std::condition_variable jobCondition;
+
+  /// \brief Notifies the calling thread that all chunks of a job are done
+  public: std::condition_variable doneCondition;
+
+  /// \brief Current job. Workers keep a reference to the job they are
+  /// running so a worker that is late to pick up a job never touches the
+  /// next one.
+  public: std::shared_ptr<ThreadPoolJob> job;
+
+  /// \brief Incremented every time a new job is available
+  public: std::uint64_t generation = 0u;
+
+  /// \brief True to stop the worker threads
+  public: bool stop = false;
+};
+
+}
+}
+}
+
+using namespace ignition;
+using namespace physics;
+using namespace tpelib;
+
+//////////////////////////////////////////////////
+void ThreadPoolPrivate::Start()
+{
+  this->stop = false;
+  for (unsigned int i = 1u; i < this->threadCount; ++i)
+    this->workers.emplace_back(&ThreadPoolPrivate::Work, this);
+}
+
+//////////////////////////////////////////////////
+void ThreadPoolPrivate::Stop()
+{
+  {
+    std::lock_guard<std::mutex> lock(this->mutex);
+    this->stop = true;
+  }
+  this->jobCondition.notify_all();
+  for (auto &worker : this->workers)
+    worker.join();
+  this->workers.clear();
+}
+
+//////////////////////////////////////////////////
+void ThreadPoolPrivate::Work()
+{
+  std::uint64_t lastGeneration;
+  {
+    std::lock_guard<std::mutex> lock(this->mutex);
+    lastGeneration = this->generation;
+  }
+
+  while (true)
+  {
+    std::shared_ptr<ThreadPoolJob> currentJob;
+    {
+      std::unique_lock<std::mutex> lock(this->mutex);
+      this->jobCondition.wait(lock, [&]
+      {
+        return this->stop || this->generation != lastGeneration;
+      });
+      if (this->stop)
+        return;
+      lastGeneration = this->generation;
+      currentJob = this->job;
+    }
+
+    if (currentJob)
+      this->RunChunks(*currentJob);
+  }
+}
+
+//////////////////////////////////////////////////
+void ThreadPoolPrivate::RunChunks(ThreadPoolJob &_job)
+{
+  while (true)
+  {
+    std::size_t chunk = _job.nextChunk.fetch_add(1u);
+    if (chunk >= _job.chunkCount)
+      return;
+
+    std::size_t begin = chunk * _job.count / _job.chunkCount;
+    std::size_t end = (chunk + 1u) * _job.count / _job.chunkCount;
+    (*_job.func)(chunk, begin, end);
+
+    if (_job.doneChunks.fetch_add(1u) + 1u == _job.chunkCount)
+    {
+      std::lock_guard<std::mutex> lock(this->mutex);
+      this->doneCondition.notify_all();
+    }
+  }
+}
+
+//////////////////////////////////////////////////
+void ThreadPoolPrivate::RunJob(std::size_t _count, std::size_t _chunkCount,
+    const ThreadPool::ChunkFunction &_func)
+{
+  auto newJob = std::make_shared<ThreadPoolJob>();
+  newJob->func = &_func;
+  newJob->count = _count;
+  newJob->chunkCount = _chunkCount;
+  {
+    std::lock_guard<std::mutex> lock(this->mutex);
+    this->job = newJob;
+    ++this->generation;
+  }
+  this->jobCondition.notify_all();
+
+  // the calling thread takes part in the work
+  this->RunChunks(*newJob);
+
+  std::unique_lock<std::mutex> lock(this->mutex);
+  this->doneCondition.wait(lock, [&]
+  {
+    return newJob->doneChunks.load() == _chunkCount;
+  });
+  this->job.reset();
+}
+
+//////////////////////////////////////////////////
+ThreadPool::ThreadPool(unsigned int _threadCount)
+  : dataPtr(new ThreadPoolPrivate)
+{
+  this->SetThreadCount(_threadCount);
+}
+
+//////////////////////////////////////////////////
+ThreadPool::~ThreadPool()
+{
+  this->dataPtr->Stop();
+}
+
+//////////////////////////////////////////////////
+void ThreadPool::SetThreadCount(unsigned int _threadCount)
+{
+  if (_threadCount == 0u)
+    _threadCount = std::max(1u, std::thread::hardware_concurrency());
+
+  if (_threadCount == this->dataPtr->threadCount &&
+      this->dataPtr->workers.size() + 1u == _threadCount)
+    return;
+
+  this->dataPtr->Stop();
+  this->dataPtr->threadCount = _threadCount;
+  this->dataPtr->Start();
+}
+
+//////////////////////////////////////////////////
+unsigned int ThreadPool::ThreadCount() const
+{
+  return this->dataPtr->threadCount;
+}
+
+//////////////////////////////////////////////////
+std::size_t ThreadPool::ChunkCount(std::size_t _count,
+    std::size_t _minChunkSize) const
+{
+  if (_count == 0u)
+    return 0u;
+
+  std::size_t maxChunks = _count / std::max<std::size_t>(_minChunkSize, 1u);
+  return std::clamp<std::size_t>(maxChunks, 1u, this->dataPtr->threadCount);
+}
+
+//////////////////////////////////////////////////
+void ThreadPool::ParallelFor(std::size_t _count, const ChunkFunction &_func,
+    std::size_t _minChunkSize)
+{
+  std::size_t chunkCount = this->ChunkCount(_count, _minChunkSize);
+  if (chunkCount == 0u)
+    return;
+
+  // run small ranges on the calling thread
+  if (chunkCount == 1u)
+  {
+    _func(0u, 0u, _count);
+    return;
+  }
+
+  this->dataPtr->RunJob(_count, chunkCount, _func);
+}
+
+//////////////////////////////////////////////////
+void ThreadPool::ParallelForEach(std::size_t _count,
+    const IndexFunction &_func)
+{
+  if (_count == 0u)
+    return;
+
+  if (_count == 1u || this->dataPtr->threadCount == 1u)
+  {
+    for (std::size_t i = 0u; i < _count; ++i)
+      _func(i);
+    return;
+  }
+
+  // one chunk per index
+  ChunkFunction chunkFunc = [&](std::size_t, std::size_t _begin, std::size_t)
+  {
+    _func(_begin);
+  };
+  this->dataPtr->RunJob(_count, _count, chunkFunc);
+}
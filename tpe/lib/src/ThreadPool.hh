@@ -0,0 +1,108 @@
+/*
+ * Copyright (C) 2020 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#ifndef IGNITION_PHYSICS_TPE_LIB_SRC_THREADPOOL_HH_
+#define IGNITION_PHYSICS_TPE_LIB_SRC_THREADPOOL_HH_
+
+#include <cstddef>
+#include <functional>
+#include <memory>
+
+#include <ignition/utilities/SuppressWarning.hh>
+
+#include "ignition/physics/tpelib/Export.hh"
+
+namespace ignition {
+namespace physics {
+namespace tpelib {
+
+// forward declaration
+class ThreadPoolPrivate;
+
+/// \brief A pool of worker threads that runs a function over contiguous
+/// ranges of indices in parallel. The calling thread also takes part in the
+/// work, so a pool with a thread count of N uses N - 1 worker threads.
+class IGNITION_PHYSICS_TPELIB_VISIBLE ThreadPool
+{
+  /// \brief Function called for each chunk of a range.
+  /// The arguments are the chunk index, and the beginning (inclusive) and
+  /// end (exclusive) of the range of indices in the chunk.
+  public: using ChunkFunction =
+      std::function<void(std::size_t, std::size_t, std::size_t)>;
+
+  /// \brief Function called for each index of a range by ParallelForEach
+  public: using IndexFunction = std::function<void(std::size_t)>;
+
+  /// \brief Constructor
+  /// \param[in] _threadCount Number of threads, including the calling thread
+  public: explicit ThreadPool(unsigned int _threadCount = 1u);
+
+  /// \brief Destructor. Stops and joins all worker threads.
+  public: ~ThreadPool();
+
+  /// \brief Set the number of threads, including the calling thread. Worker
+  /// threads are restarted if the count changes.
+  /// \param[in] _threadCount Number of threads. 0 uses the number of
+  /// hardware threads.
+  public: void SetThreadCount(unsigned int _threadCount);
+
+  /// \brief Get the number of threads, including the calling thread
+  /// \return Number of threads
+  public: unsigned int ThreadCount() const;
+
+  /// \brief Get the number of chunks a range is split into by ParallelFor
+  /// \param[in] _count Number of indices in the range
+  /// \param[in] _minChunkSize Minimum number of indices in each chunk. Small
+  /// ranges are split into fewer chunks than there are threads so that the
+  /// work done in each chunk outweighs the cost of waking a thread.
+  /// \return Number of chunks, 0 if the range is empty
+  public: std::size_t ChunkCount(std::size_t _count,
+      std::size_t _minChunkSize = 1u) const;
+
+  /// \brief Split the range [0, _count) into ChunkCount(_count,
+  /// _minChunkSize) contiguous chunks of nearly equal size and call a
+  /// function for each chunk. The chunk boundaries only depend on the
+  /// arguments and the thread count, and chunk i always covers lower indices
+  /// than chunk i + 1, so results written per chunk can be merged in a
+  /// deterministic order. This function blocks until all chunks are done.
+  /// \param[in] _count Number of indices in the range
+  /// \param[in] _func Function to call for each chunk
+  /// \param[in] _minChunkSize Minimum number of indices in each chunk
+  public: void ParallelFor(std::size_t _count, const ChunkFunction &_func,
+      std::size_t _minChunkSize = 1u);
+
+  /// \brief Call a function for each index in the range [0, _count) in
+  /// parallel. Unlike ParallelFor, each index is a separate task that is
+  /// taken by the next idle thread, so tasks of uneven cost, such as
+  /// stepping worlds of different sizes, are balanced across threads. This
+  /// function blocks until all tasks are done.
+  /// \param[in] _count Number of indices in the range
+  /// \param[in] _func Function to call for each index
+  public: void ParallelForEach(std::size_t _count,
+      const IndexFunction &_func);
+
+  /// \brief Pointer to private data
+  IGN_UTILS_WARN_IGNORE__DLL_INTERFACE_MISSING
+  private: std::unique_ptr<ThreadPoolPrivate> dataPtr;
+  IGN_UTILS_WARN_RESUME__DLL_INTERFACE_MISSING
+};
+
+}
+}
+}
+
+#endif
@@ -0,0 +1,133 @@
+/*
+ * Copyright (C) 2020 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <vector>
+
+#include "ThreadPool.hh"
+
+using namespace ignition;
+using namespace physics;
+using namespace tpelib;
+
+/////////////////////////////////////////////////
+TEST(ThreadPool, ThreadCount)
+{
+  ThreadPool pool;
+  EXPECT_EQ(1u, pool.ThreadCount());
+
+  pool.SetThreadCount(4u);
+  EXPECT_EQ(4u, pool.ThreadCount());
+  EXPECT_EQ(0u, pool.ChunkCount(0u));
+  EXPECT_EQ(3u, pool.ChunkCount(3u));
+  EXPECT_EQ(4u, pool.ChunkCount(100u));
+  EXPECT_EQ(1u, pool.ChunkCount(3u, 10u));
+  EXPECT_EQ(2u, pool.ChunkCount(25u, 10u));
+  EXPECT_EQ(4u, pool.ChunkCount(100u, 10u));
+  EXPECT_EQ(0u, pool.ChunkCount(0u, 10u));
+
+  // use hardware threads
+  pool.SetThreadCount(0u);
+  EXPECT_LE(1u, pool.ThreadCount());
+
+  ThreadPool pool2(3u);
+  EXPECT_EQ(3u, pool2.ThreadCount());
+}
+
+/////////////////////////////////////////////////
+TEST(ThreadPool, ParallelFor)
+{
+  for (unsigned int threadCount : {1u, 2u, 3u, 8u})
+  {
+    ThreadPool pool(threadCount);
+
+    // empty range
+    bool called = false;
+    pool.ParallelFor(0u, [&](std::size_t, std::size_t, std::size_t)
+    {
+      called = true;
+    });
+    EXPECT_FALSE(called);
+
+    // run many times to make sure jobs do not interfere with each other
+    for (std::size_t count : {1u, 5u, 1000u, 1001u, 3u, 50000u})
+    {
+      std::vector<int> values(count, 0);
+      std::size_t chunkCount = pool.ChunkCount(count);
+      std::vector<std::size_t> chunkBegin(chunkCount);
+      std::vector<std::size_t> chunkEnd(chunkCount);
+      std::atomic<std::size_t> calls{0u};
+      pool.ParallelFor(count,
+          [&](std::size_t _chunk, std::size_t _begin, std::size_t _end)
+      {
+        ASSERT_LT(_chunk, chunkCount);
+        chunkBegin[_chunk] = _begin;
+        chunkEnd[_chunk] = _end;
+        for (std::size_t i = _begin; i < _end; ++i)
+          values[i] += static_cast<int>(i);
+        ++calls;
+      });
+      EXPECT_EQ(chunkCount, calls.load());
+
+      // every index is visited once
+      for (std::size_t i = 0u; i < count; ++i)
+        EXPECT_EQ(static_cast<int>(i), values[i]);
+
+      // chunks are contiguous and ordered
+      EXPECT_EQ(0u, chunkBegin.front());
+      EXPECT_EQ(count, chunkEnd.back());
+      for (std::size_t c = 1u; c < chunkCount; ++c)
+        EXPECT_EQ(chunkEnd[c - 1u], chunkBegin[c]);
+    }
+  }
+}
+
+/////////////////////////////////////////////////
+TEST(ThreadPool, ParallelForEach)
+{
+  for (unsigned int threadCount : {1u, 2u, 3u, 8u})
+  {
+    ThreadPool pool(threadCount);
+
+    // empty range
+    bool called = false;
+    pool.ParallelForEach(0u, [&](std::size_t)
+    {
+      called = true;
+    });
+    EXPECT_FALSE(called);
+
+    for (std::size_t count : {1u, 2u, 7u, 100u, 1001u})
+    {
+      std::vector<std::atomic<int>> values(count);
+      std::atomic<std::size_t> calls{0u};
+      pool.ParallelForEach(count, [&](std::size_t _index)
+      {
+        ASSERT_LT(_index, count);
+        ++values[_index];
+        ++calls;
+      });
+      EXPECT_EQ(count, calls.load());
+
+      // every index is visited once
+      for (std::size_t i = 0u; i < count; ++i)
+        EXPECT_EQ(1, values[i].load());
+    }
+  }
+}
@@ -0,0 +1,837 @@
+/*
+ * Copyright (C) 2020 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <set>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <ignition/common/Console.hh>
+
+#include "AABBTree.hh"
+#include "UniformGrid.hh"
+
+namespace ignition {
+namespace physics {
+namespace tpelib {
+
+/// \brief Nodes whose fat box spans more cells than this along any axis are
+/// stored in the tree
+static const int kMaxCellsPerAxis = 4;
+
+/// \brief Ratio of the tuned cell size to the median node size
+static const double kCellSizeScale = 2.0;
+
+/// \brief Cell size used when all nodes are points
+static const double kDefaultCellSize = 1.0;
+
+/// \brief Largest absolute cell coordinate. Cell coordinates are clamped to
+/// this range so that three of them fit in a 64 bit cell key.
+static const int kMaxCellCoord = (1 << 20) - 1;
+
+/// \brief A node in the uniform grid broadphase
+struct UniformGridBox
+{
+  /// \brief User node id
+  public: std::size_t id = 0u;
+
+  /// \brief Minimum corner of the tight box
+  public: double min[3] = {0.0, 0.0, 0.0};
+
+  /// \brief Maximum corner of the tight box
+  public: double max[3] = {0.0, 0.0, 0.0};
+
+  /// \brief Minimum corner of the fat box
+  public: double fatMin[3] = {0.0, 0.0, 0.0};
+
+  /// \brief Maximum corner of the fat box
+  public: double fatMax[3] = {0.0, 0.0, 0.0};
+
+  /// \brief Coordinates of the first cell covered by the fat box
+  public: int cellMin[3] = {0, 0, 0};
+
+  /// \brief Coordinates of the last cell covered by the fat box
+  public: int cellMax[3] = {0, 0, 0};
+
+  /// \brief True if the node is stored in the tree instead of the grid
+  public: bool oversized = false;
+};
+
+/// \brief A cell of the uniform grid
+struct UniformGridCell
+{
+  /// \brief Coordinates of the cell
+  public: int coord[3] = {0, 0, 0};
+
+  /// \brief Indices of the nodes whose fat boxes cover the cell
+  public: std::vector<std::size_t> boxes;
+};
+
+/// \brief Hash function for cell keys, which mixes the bits of the packed
+/// coordinates so that neighboring cells land in different buckets
+struct UniformGridCellHash
+{
+  /// \brief Hash a cell key
+  /// \param[in] _key Cell key
+  /// \return Hash value
+  public: std::size_t operator()(std::uint64_t _key) const
+  {
+    _key ^= _key >> 33;
+    _key *= 0xff51afd7ed558ccdULL;
+    _key ^= _key >> 33;
+    return static_cast<std::size_t>(_key);
+  }
+};
+
+/// \brief Check whether two boxes given by their corners overlap. Touching
+/// boxes are considered overlapping.
+/// \param[in] _min1 Minimum corner of first box
+/// \param[in] _max1 Maximum corner of first box
+/// \param[in] _min2 Minimum corner of second box
+/// \param[in] _max2 Maximum corner of second box
+/// \return True if the boxes overlap
+static inline bool BoxesOverlap(const double *_min1, const double *_max1,
+    const double *_min2, const double *_max2)
+{
+  return _max1[0] >= _min2[0] && _min1[0] <= _max2[0] &&
+         _max1[1] >= _min2[1] && _min1[1] <= _max2[1] &&
+         _max1[2] >= _min2[2] && _min1[2] <= _max2[2];
+}
+
+/// \brief Private data class for UniformGrid
+class UniformGridPrivate
+{
+  /// \brief Set the tight box of a node
+  /// \param[in] _box Node to set
+  /// \param[in] _aabb New box
+  public: void SetTightBox(UniformGridBox &_box,
+      const math::AxisAlignedBox &_aabb);
+
+  /// \brief Set the fat box of a node from its tight box
+  /// \param[in] _box Node to set
+  /// \param[in] _displacement Displacement of the tight box since the last
+  /// update
+  public: void SetFatBox(UniformGridBox &_box,
+      const double *_displacement);
+
+  /// \brief Get the coordinate of the cell that contains a value
+  /// \param[in] _value Value along one axis
+  /// \return Cell coordinate along that axis
+  public: int CellCoord(double _value) const;
+
+  /// \brief Get the key of a cell in the cell map
+  /// \param[in] _coord Cell coordinates
+  /// \return Cell key
+  public: static std::uint64_t CellKey(const int *_coord);
+
+  /// \brief Compute the range of cells covered by a box
+  /// \param[in] _min Minimum corner of the box
+  /// \param[in] _max Maximum corner of the box
+  /// \param[out] _cellMin Coordinates of the first cell
+  /// \param[out] _cellMax Coordinates of the last cell
+  /// \return True if the box spans too many cells to be stored in the grid
+  public: bool CellRange(const double *_min, const double *_max,
+      int *_cellMin, int *_cellMax) const;
+
+  /// \brief Store a node in the grid, or in the tree if it is too large
+  /// \param[in] _i Index of the node in boxes
+  public: void Insert(std::size_t _i);
+
+  /// \brief Remove a node from the grid or from the tree
+  /// \param[in] _i Index of the node in boxes
+  public: void Extract(std::size_t _i);
+
+  /// \brief Add a node to the cells covered by its fat box
+  /// \param[in] _i Index of the node in boxes
+  public: void AddToCells(std::size_t _i);
+
+  /// \brief Remove or replace a node in the cells covered by its fat box
+  /// \param[in] _i Index of the node in boxes
+  /// \param[in] _replacement Index to store instead of the node, or
+  /// kNullIndex to remove it
+  public: void RemoveFromCells(std::size_t _i, std::size_t _replacement);
+
+  /// \brief Tune the cell size to the median size of the nodes and move all
+  /// nodes to the cells of the new grid if the cell size changed
+  /// \return True if the nodes were moved to a new grid
+  public: bool Tune();
+
+  /// \brief Move all nodes to the cells of a grid with a new cell size
+  /// \param[in] _cellSize New cell size
+  public: void Rebuild(double _cellSize);
+
+  /// \brief Find nodes in the grid whose tight boxes overlap a box
+  /// \param[in] _min Minimum corner of the box
+  /// \param[in] _max Maximum corner of the box
+  /// \param[in] _skip Index of a node to leave out of the result
+  /// \param[out] _ids Vector that ids of overlapping nodes are appended to
+  public: void GridQuery(const double *_min, const double *_max,
+      std::size_t _skip, std::vector<std::size_t> &_ids) const;
+
+  /// \brief Index used to indicate no node
+  public: static const std::size_t kNullIndex = static_cast<std::size_t>(-1);
+
+  /// \brief Nodes stored contiguously in no particular order, including the
+  /// nodes stored in the tree
+  public: std::vector<UniformGridBox> boxes;
+
+  /// \brief A map of user node id to the index of its node in boxes
+  public: std::unordered_map<std::size_t, std::size_t> index;
+
+  /// \brief Cells that are covered by at least one node
+  public: std::unordered_map<std::uint64_t, UniformGridCell,
+      UniformGridCellHash> cells;
+
+  /// \brief Tree that stores nodes that span too many cells
+  public: AABBTree tree;
+
+  /// \brief Current cell size
+  public: double cellSize = 0.0;
+
+  /// \brief Inverse of the current cell size
+  public: double invCellSize = 0.0;
+
+  /// \brief Cell size set by the user, 0 to tune it automatically
+  public: double userCellSize = 0.0;
+
+  /// \brief Number of nodes when the cell size was last tuned
+  public: std::size_t tuneNodeCount = 0u;
+
+  /// \brief Margin used to enlarge the tight boxes
+  public: double margin = 0.0;
+
+  /// \brief Scale applied to displacement when enlarging the tight boxes
+  public: double displacementScale = 0.0;
+
+  /// \brief Buffer of node ids used by the pair queries
+  public: mutable std::vector<std::size_t> ids;
+
+  /// \brief Buffer of pairs of nodes in the tree used by the pair queries
+  public: mutable std::vector<std::pair<std::size_t, std::size_t>> treePairs;
+};
+}
+}
+}
+
+using namespace ignition;
+using namespace physics;
+using namespace tpelib;
+
+//////////////////////////////////////////////////
+void UniformGridPrivate::SetTightBox(UniformGridBox &_box,
+    const math::AxisAlignedBox &_aabb)
+{
+  _box.min[0] = _aabb.Min().X();
+  _box.min[1] = _aabb.Min().Y();
+  _box.min[2] = _aabb.Min().Z();
+  _box.max[0] = _aabb.Max().X();
+  _box.max[1] = _aabb.Max().Y();
+  _box.max[2] = _aabb.Max().Z();
+}
+
+//////////////////////////////////////////////////
+void UniformGridPrivate::SetFatBox(UniformGridBox &_box,
+    const double *_displacement)
+{
+  fattenBox(_box.min, _box.max, this->margin, this->displacementScale,
+      _displacement, _box.fatMin, _box.fatMax);
+}
+
+//////////////////////////////////////////////////
+int UniformGridPrivate::CellCoord(double _value) const
+{
+  double coord = std::floor(_value * this->invCellSize);
+  coord = std::min(std::max(coord, static_cast<double>(-kMaxCellCoord)),
+      static_cast<double>(kMaxCellCoord));
+  return static_cast<int>(coord);
+}
+
+//////////////////////////////////////////////////
+std::uint64_t UniformGridPrivate::CellKey(const int *_coord)
+{
+  // offset the coordinates so that each fits in 21 bits
+  const std::uint64_t x = static_cast<std::uint64_t>(_coord[0] + (1 << 20));
+  const std::uint64_t y = static_cast<std::uint64_t>(_coord[1] + (1 << 20));
+  const std::uint64_t z = static_cast<std::uint64_t>(_coord[2] + (1 << 20));
+  return x | (y << 21) | (z << 42);
+}
+
+//////////////////////////////////////////////////
+bool UniformGridPrivate::CellRange(const double *_min, const double *_max,
+    int *_cellMin, int *_cellMax) const
+{
+  bool tooLarge = false;
+  for (int i = 0; i < 3; ++i)
+  {
+    _cellMin[i] = this->CellCoord(_min[i]);
+    _cellMax[i] = this->CellCoord(_max[i]);
+    if (_cellMax[i] - _cellMin[i] + 1 > kMaxCellsPerAxis)
+      tooLarge = true;
+  }
+  return tooLarge;
+}
+
+//////////////////////////////////////////////////
+void UniformGridPrivate::Insert(std::size_t _i)
+{
+  UniformGridBox &box = this->boxes[_i];
+  box.oversized = this->CellRange(box.fatMin, box.fatMax, box.cellMin,
+      box.cellMax);
+  if (box.oversized)
+  {
+    this->tree.AddNode(box.id, math::AxisAlignedBox(
+        math::Vector3d(box.min[0], box.min[1], box.min[2]),
+        math::Vector3d(box.max[0], box.max[1], box.max[2])));
+  }
+  else
+  {
+    this->AddToCells(_i);
+  }
+}
+
+//////////////////////////////////////////////////
+void UniformGridPrivate::Extract(std::size_t _i)
+{
+  if (this->boxes[_i].oversized)
+    this->tree.RemoveNode(this->boxes[_i].id);
+  else
+    this->RemoveFromCells(_i, kNullIndex);
+}
+
+//////////////////////////////////////////////////
+void UniformGridPrivate::AddToCells(std::size_t _i)
+{
+  const UniformGridBox &box = this->boxes[_i];
+  int c[3];
+  for (c[0] = box.cellMin[0]; c[0] <= box.cellMax[0]; ++c[0])
+  {
+    for (c[1] = box.cellMin[1]; c[1] <= box.cellMax[1]; ++c[1])
+    {
+      for (c[2] = box.cellMin[2]; c[2] <= box.cellMax[2]; ++c[2])
+      {
+        UniformGridCell &cell = this->cells[CellKey(c)];
+        if (cell.boxes.empty())
+          std::copy(c, c + 3, cell.coord);
+        cell.boxes.push_back(_i);
+      }
+    }
+  }
+}
+
+//////////////////////////////////////////////////
+void UniformGridPrivate::RemoveFromCells(std::size_t _i,
+    std::size_t _replacement)
+{
+  const UniformGridBox &box = this->boxes[_i];
+  int c[3];
+  for (c[0] = box.cellMin[0]; c[0] <= box.cellMax[0]; ++c[0])
+  {
+    for (c[1] = box.cellMin[1]; c[1] <= box.cellMax[1]; ++c[1])
+    {
+      for (c[2] = box.cellMin[2]; c[2] <= box.cellMax[2]; ++c[2])
+      {
+        auto cellIt = this->cells.find(CellKey(c));
+        if (cellIt == this->cells.end())
+          continue;
+
+        auto &cellBoxes = cellIt->second.boxes;
+        auto it = std::find(cellBoxes.begin(), cellBoxes.end(), _i);
+        if (it == cellBoxes.end())
+          continue;
+
+        if (_replacement != kNullIndex)
+        {
+          *it = _replacement;
+          continue;
+        }
+
+        *it = cellBoxes.back();
+        cellBoxes.pop_back();
+        if (cellBoxes.empty())
+          this->cells.erase(cellIt);
+      }
+    }
+  }
+}
+
+//////////////////////////////////////////////////
+bool UniformGridPrivate::Tune()
+{
+  this->tuneNodeCount = this->boxes.size();
+
+  // the median is not affected by a few large nodes such as ground planes
+  std::vector<double> sizes;
+  sizes.reserve(this->boxes.size());
+  for (const auto &box : this->boxes)
+  {
+    double size = 0.0;
+    for (int i = 0; i < 3; ++i)
+      size = std::max(size, box.max[i] - box.min[i]);
+    sizes.push_back(size + 2.0 * this->margin);
+  }
+
+  double cellSizeValue = kDefaultCellSize;
+  if (!sizes.empty())
+  {
+    auto median = sizes.begin() + sizes.size() / 2u;
+    std::nth_element(sizes.begin(), median, sizes.end());
+    if (*median > 0.0 && std::isfinite(*median))
+      cellSizeValue = kCellSizeScale * *median;
+  }
+
+  if (std::abs(cellSizeValue - this->cellSize) <= 1e-9 * cellSizeValue)
+    return false;
+
+  this->Rebuild(cellSizeValue);
+  return true;
+}
+
+//////////////////////////////////////////////////
+void UniformGridPrivate::Rebuild(double _cellSize)
+{
+  for (std::size_t i = 0u; i < this->boxes.size(); ++i)
+  {
+    if (this->boxes[i].oversized)
+      this->tree.RemoveNode(this->boxes[i].id);
+  }
+  this->cells.clear();
+
+  this->cellSize = _cellSize;
+  this->invCellSize = 1.0 / _cellSize;
+  const double noDisplacement[3] = {0.0, 0.0, 0.0};
+  for (std::size_t i = 0u; i < this->boxes.size(); ++i)
+  {
+    this->SetFatBox(this->boxes[i], noDisplacement);
+    this->Insert(i);
+  }
+}
+
+//////////////////////////////////////////////////
+void UniformGridPrivate::GridQuery(const double *_min, const double *_max,
+    std::size_t _skip, std::vector<std::size_t> &_ids) const
+{
+  if (this->cells.empty())
+    return;
+
+  int cellMin[3];
+  int cellMax[3];
+  this->CellRange(_min, _max, cellMin, cellMax);
+
+  // check every node if the box covers more cells than there are in use
+  double cellCount = 1.0;
+  for (int i = 0; i < 3; ++i)
+    cellCount *= static_cast<double>(cellMax[i] - cellMin[i] + 1);
+  if (cellCount > static_cast<double>(this->cells.size()))
+  {
+    for (std::size_t i = 0u; i < this->boxes.size(); ++i)
+    {
+      const UniformGridBox &box = this->boxes[i];
+      if (i != _skip && !box.oversized &&
+          BoxesOverlap(box.min, box.max, _min, _max))
+        _ids.push_back(box.id);
+    }
+    return;
+  }
+
+  int c[3];
+  for (c[0] = cellMin[0]; c[0] <= cellMax[0]; ++c[0])
+  {
+    for (c[1] = cellMin[1]; c[1] <= cellMax[1]; ++c[1])
+    {
+      for (c[2] = cellMin[2]; c[2] <= cellMax[2]; ++c[2])
+      {
+        auto cellIt = this->cells.find(CellKey(c));
+        if (cellIt == this->cells.end())
+          continue;
+
+        for (std::size_t i : cellIt->second.boxes)
+        {
+          const UniformGridBox &box = this->boxes[i];
+          if (i == _skip || !BoxesOverlap(box.min, box.max, _min, _max))
+            continue;
+
+          // a node that covers several of the cells is only reported in the
+          // cell that contains the minimum corner of the overlap
+          if (this->CellCoord(std::max(box.fatMin[0], _min[0])) == c[0] &&
+              this->CellCoord(std::max(box.fatMin[1], _min[1])) == c[1] &&
+              this->CellCoord(std::max(box.fatMin[2], _min[2])) == c[2])
+            _ids.push_back(box.id);
+        }
+      }
+    }
+  }
+}
+
+//////////////////////////////////////////////////
+UniformGrid::UniformGrid()
+  : dataPtr(new UniformGridPrivate)
+{
+}
+
+//////////////////////////////////////////////////
+UniformGrid::~UniformGrid()
+{
+}
+
+//////////////////////////////////////////////////
+void UniformGrid::SetMargin(double _margin)
+{
+  this->dataPtr->margin = std::max(0.0, _margin);
+  this->dataPtr->tree.SetMargin(this->dataPtr->margin);
+}
+
+//////////////////////////////////////////////////
+double UniformGrid::Margin() const
+{
+  return this->dataPtr->margin;
+}
+
+//////////////////////////////////////////////////
+void UniformGrid::SetDisplacementScale(double _scale)
+{
+  this->dataPtr->displacementScale = std::max(0.0, _scale);
+  this->dataPtr->tree.SetDisplacementScale(
+      this->dataPtr->displacementScale);
+}
+
+//////////////////////////////////////////////////
+double UniformGrid::DisplacementScale() const
+{
+  return this->dataPtr->displacementScale;
+}
+
+//////////////////////////////////////////////////
+void UniformGrid::SetCellSize(double _size)
+{
+  this->dataPtr->userCellSize = std::max(0.0, _size);
+  if (this->dataPtr->userCellSize > 0.0)
+    this->dataPtr->Rebuild(this->dataPtr->userCellSize);
+  else if (!this->dataPtr->boxes.empty())
+    this->dataPtr->Tune();
+}
+
+//////////////////////////////////////////////////
+double UniformGrid::CellSize() const
+{
+  return this->dataPtr->cellSize;
+}
+
+//////////////////////////////////////////////////
+void UniformGrid::AddNode(std::size_t _id,
+    const math::AxisAlignedBox &_aabb)
+{
+  if (this->dataPtr->index.find(_id) != this->dataPtr->index.end())
+  {
+    ignerr << "Unable to add node '" << _id << "'. "
+           << "Node already exists." << std::endl;
+    return;
+  }
+
+  std::size_t i = this->dataPtr->boxes.size();
+  this->dataPtr->index[_id] = i;
+  this->dataPtr->boxes.emplace_back();
+  UniformGridBox &box = this->dataPtr->boxes.back();
+  box.id = _id;
+  this->dataPtr->SetTightBox(box, _aabb);
+
+  const double noDisplacement[3] = {0.0, 0.0, 0.0};
+  this->dataPtr->SetFatBox(box, noDisplacement);
+
+  // tune the cell size again each time the number of nodes doubles. Moving
+  // the nodes to a new grid also inserts the new node.
+  if (this->dataPtr->userCellSize <= 0.0 &&
+      this->dataPtr->boxes.size() >= 2u * this->dataPtr->tuneNodeCount &&
+      this->dataPtr->Tune())
+  {
+    return;
+  }
+
+  this->dataPtr->Insert(i);
+}
+
+//////////////////////////////////////////////////
+bool UniformGrid::RemoveNode(std::size_t _id)
+{
+  auto it = this->dataPtr->index.find(_id);
+  if (it == this->dataPtr->index.end())
+  {
+    ignerr << "Unable to remove node '" << _id << "'. "
+           << "Node not found." << std::endl;
+    return false;
+  }
+
+  auto &boxes = this->dataPtr->boxes;
+  std::size_t i = it->second;
+  this->dataPtr->index.erase(it);
+  this->dataPtr->Extract(i);
+
+  // move the last node into the freed slot to keep the nodes contiguous
+  std::size_t last = boxes.size() - 1u;
+  if (i != last)
+  {
+    if (!boxes[last].oversized)
+      this->dataPtr->RemoveFromCells(last, i);
+    boxes[i] = boxes[last];
+    this->dataPtr->index[boxes[i].id] = i;
+  }
+  boxes.pop_back();
+
+  if (boxes.empty())
+    this->dataPtr->tuneNodeCount = 0u;
+  return true;
+}
+
+//////////////////////////////////////////////////
+bool UniformGrid::UpdateNode(std::size_t _id,
+    const math::AxisAlignedBox &_aabb)
+{
+  auto it = this->dataPtr->index.find(_id);
+  if (it == this->dataPtr->index.end())
+  {
+    ignerr << "Unable to update node '" << _id << "'. "
+           << "Node not found." << std::endl;
+    return false;
+  }
+
+  std::size_t i = it->second;
+  UniformGridBox &box = this->dataPtr->boxes[i];
+  double displacement[3];
+  for (int j = 0; j < 3; ++j)
+  {
+    displacement[j] = 0.5 * ((_aabb.Min()[j] + _aabb.Max()[j]) -
+        (box.min[j] + box.max[j]));
+  }
+  this->dataPtr->SetTightBox(box, _aabb);
+
+  if (box.oversized)
+  {
+    // move the node to the grid if it became small enough
+    this->dataPtr->SetFatBox(box, displacement);
+    int cellMin[3];
+    int cellMax[3];
+    if (this->dataPtr->CellRange(box.fatMin, box.fatMax, cellMin, cellMax))
+      return this->dataPtr->tree.UpdateNode(_id, _aabb);
+
+    this->dataPtr->tree.RemoveNode(_id);
+    this->dataPtr->Insert(i);
+    return true;
+  }
+
+  // the cells only change if the tight box moved out of the fat box
+  if (fatBoxValid(box.min, box.max, box.fatMin, box.fatMax,
+      this->dataPtr->margin, this->dataPtr->displacementScale, displacement))
+    return true;
+
+  this->dataPtr->SetFatBox(box, displacement);
+  int cellMin[3];
+  int cellMax[3];
+  bool tooLarge = this->dataPtr->CellRange(box.fatMin, box.fatMax, cellMin,
+      cellMax);
+  if (!tooLarge &&
+      std::equal(cellMin, cellMin + 3, box.cellMin) &&
+      std::equal(cellMax, cellMax + 3, box.cellMax))
+    return true;
+
+  this->dataPtr->RemoveFromCells(i, UniformGridPrivate::kNullIndex);
+  this->dataPtr->Insert(i);
+  return true;
+}
+
+//////////////////////////////////////////////////
+unsigned int UniformGrid::NodeCount() const
+{
+  return static_cast<unsigned int>(this->dataPtr->boxes.size());
+}
+
+//////////////////////////////////////////////////
+std::set<std::size_t> UniformGrid::Collisions(std::size_t _id) const
+{
+  std::set<std::size_t> result;
+  auto it = this->dataPtr->index.find(_id);
+  if (it == this->dataPtr->index.end())
+  {
+    ignerr << "Unable to compute collisions for node '" << _id << "'. "
+           << "Node not found." << std::endl;
+    return result;
+  }
+
+  const UniformGridBox &box = this->dataPtr->boxes[it->second];
+  std::vector<std::size_t> ids;
+  if (box.oversized)
+  {
+    result = this->dataPtr->tree.Collisions(_id);
+  }
+  else
+  {
+    this->dataPtr->tree.Collisions(math::AxisAlignedBox(
+        math::Vector3d(box.min[0], box.min[1], box.min[2]),
+        math::Vector3d(box.max[0], box.max[1], box.max[2])), ids);
+  }
+  this->dataPtr->GridQuery(box.min, box.max, it->second, ids);
+  result.insert(ids.begin(), ids.end());
+  return result;
+}
+
+//////////////////////////////////////////////////
+void UniformGrid::Collisions(const math::AxisAlignedBox &_box,
+    std::vector<std::size_t> &_ids) const
+{
+  // the tree query clears the ids first
+  this->dataPtr->tree.Collisions(_box, _ids);
+
+  const double min[3] = {_box.Min().X(), _box.Min().Y(), _box.Min().Z()};
+  const double max[3] = {_box.Max().X(), _box.Max().Y(), _box.Max().Z()};
+  this->dataPtr->GridQuery(min, max, UniformGridPrivate::kNullIndex, _ids);
+}
+
+//////////////////////////////////////////////////
+void UniformGrid::Collisions(
+    std::vector<std::pair<std::size_t, std::size_t>> &_pairs) const
+{
+  _pairs.clear();
+
+  // Test the nodes that share each cell. A pair of nodes that share several
+  // cells is only reported in the cell that contains the minimum corner of
+  // the overlap of their fat boxes.
+  const auto &boxes = this->dataPtr->boxes;
+  for (const auto &cellIt : this->dataPtr->cells)
+  {
+    const UniformGridCell &cell = cellIt.second;
+    for (std::size_t a = 0u; a < cell.boxes.size(); ++a)
+    {
+      const UniformGridBox &boxA = boxes[cell.boxes[a]];
+      for (std::size_t b = a + 1u; b < cell.boxes.size(); ++b)
+      {
+        const UniformGridBox &boxB = boxes[cell.boxes[b]];
+        if (!BoxesOverlap(boxA.fatMin, boxA.fatMax, boxB.fatMin, boxB.fatMax))
+          continue;
+
+        bool owner = true;
+        for (int i = 0; i < 3 && owner; ++i)
+        {
+          owner = this->dataPtr->CellCoord(
+              std::max(boxA.fatMin[i], boxB.fatMin[i])) == cell.coord[i];
+        }
+        if (owner)
+          _pairs.push_back(std::minmax(boxA.id, boxB.id));
+      }
+    }
+  }
+
+  const AABBTree &tree = this->dataPtr->tree;
+  if (tree.NodeCount() > 0u)
+  {
+    // pairs of nodes in the tree
+    tree.Collisions(this->dataPtr->treePairs);
+    _pairs.insert(_pairs.end(), this->dataPtr->treePairs.begin(),
+        this->dataPtr->treePairs.end());
+
+    // pairs of nodes in the grid and nodes in the tree
+    auto &ids = this->dataPtr->ids;
+    for (const auto &box : boxes)
+    {
+      if (box.oversized)
+        continue;
+
+      tree.Collisions(math::AxisAlignedBox(
+          math::Vector3d(box.fatMin[0], box.fatMin[1], box.fatMin[2]),
+          math::Vector3d(box.fatMax[0], box.fatMax[1], box.fatMax[2])), ids);
+      for (std::size_t id : ids)
+        _pairs.push_back(std::minmax(box.id, id));
+    }
+  }
+
+  std::sort(_pairs.begin(), _pairs.end());
+}
+
+//////////////////////////////////////////////////
+void UniformGrid::Collisions(const Broadphase &_other,
+    std::vector<std::pair<std::size_t, std::size_t>> &_pairs) const
+{
+  _pairs.clear();
+
+  // query the other broadphase with the fat box of each node
+  auto &ids = this->dataPtr->ids;
+  for (const auto &box : this->dataPtr->boxes)
+  {
+    math::AxisAlignedBox fatBox = box.oversized ?
+        this->dataPtr->tree.FatAABB(box.id) :
+        math::AxisAlignedBox(
+            math::Vector3d(box.fatMin[0], box.fatMin[1], box.fatMin[2]),
+            math::Vector3d(box.fatMax[0], box.fatMax[1], box.fatMax[2]));
+    _other.Collisions(fatBox, ids);
+    for (std::size_t id : ids)
+      _pairs.emplace_back(box.id, id);
+  }
+
+  std::sort(_pairs.begin(), _pairs.end());
+}
+
+//////////////////////////////////////////////////
+math::AxisAlignedBox UniformGrid::AABB(std::size_t _id) const
+{
+  auto it = this->dataPtr->index.find(_id);
+  if (it == this->dataPtr->index.end())
+  {
+    ignerr << "Unable to get AABB for node '" << _id << "'. "
+           << "Node not found." << std::endl;
+    return math::AxisAlignedBox();
+  }
+
+  const UniformGridBox &box = this->dataPtr->boxes[it->second];
+  return math::AxisAlignedBox(
+      math::Vector3d(box.min[0], box.min[1], box.min[2]),
+      math::Vector3d(box.max[0], box.max[1], box.max[2]));
+}
+
+//////////////////////////////////////////////////
+math::AxisAlignedBox UniformGrid::FatAABB(std::size_t _id) const
+{
+  auto it = this->dataPtr->index.find(_id);
+  if (it == this->dataPtr->index.end())
+  {
+    ignerr << "Unable to get fat AABB for node '" << _id << "'. "
+           << "Node not found." << std::endl;
+    return math::AxisAlignedBox();
+  }
+
+  const UniformGridBox &box = this->dataPtr->boxes[it->second];
+  if (box.oversized)
+    return this->dataPtr->tree.FatAABB(_id);
+
+  return math::AxisAlignedBox(
+      math::Vector3d(box.fatMin[0], box.fatMin[1], box.fatMin[2]),
+      math::Vector3d(box.fatMax[0], box.fatMax[1], box.fatMax[2]));
+}
+
+//////////////////////////////////////////////////
+bool UniformGrid::HasNode(std::size_t _id) const
+{
+  return this->dataPtr->index.find(_id) != this->dataPtr->index.end();
+}
+
+//////////////////////////////////////////////////
+bool UniformGrid::Oversized(std::size_t _id) const
+{
+  auto it = this->dataPtr->index.find(_id);
+  if (it == this->dataPtr->index.end())
+    return false;
+  return this->dataPtr->boxes[it->second].oversized;
+}
@@ -0,0 +1,147 @@
+/*
+ * Copyright (C) 2020 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#ifndef IGNITION_PHYSICS_TPE_LIB_SRC_UNIFORMGRID_HH_
+#define IGNITION_PHYSICS_TPE_LIB_SRC_UNIFORMGRID_HH_
+
+#include <memory>
+#include <set>
+#include <utility>
+#include <vector>
+
+#include <ignition/math/AxisAlignedBox.hh>
+#include <ignition/utilities/SuppressWarning.hh>
+
+#include "ignition/physics/tpelib/Export.hh"
+
+#include "Broadphase.hh"
+
+namespace ignition {
+namespace physics {
+namespace tpelib {
+
+// forward declaration
+class UniformGridPrivate;
+
+/// \brief Broadphase that hashes the fat boxes of nodes into the cells of a
+/// uniform grid. Nodes are only tested against nodes that share a cell, so
+/// adding, updating and querying a node takes constant time when nodes have
+/// similar sizes. The cell size is tuned to the typical node size unless it
+/// is set explicitly. Nodes that span too many cells, such as ground planes,
+/// are stored in an AABBTree instead.
+class IGNITION_PHYSICS_TPELIB_VISIBLE UniformGrid : public Broadphase
+{
+  /// \brief Constructor
+  public: UniformGrid();
+
+  /// \brief Destructor
+  public: ~UniformGrid() override;
+
+  // Documentation inherited
+  public: void AddNode(std::size_t _id,
+      const math::AxisAlignedBox &_aabb) override;
+
+  // Documentation inherited
+  public: bool RemoveNode(std::size_t _id) override;
+
+  // Documentation inherited
+  public: bool UpdateNode(std::size_t _id,
+      const math::AxisAlignedBox &_aabb) override;
+
+  // Documentation inherited
+  public: void SetMargin(double _margin) override;
+
+  // Documentation inherited
+  public: double Margin() const override;
+
+  // Documentation inherited
+  public: void SetDisplacementScale(double _scale) override;
+
+  // Documentation inherited
+  public: double DisplacementScale() const override;
+
+  // Documentation inherited
+  public: unsigned int NodeCount() const override;
+
+  // Documentation inherited
+  public: std::set<std::size_t> Collisions(std::size_t _id) const override;
+
+  // Documentation inherited
+  public: void Collisions(const math::AxisAlignedBox &_box,
+      std::vector<std::size_t> &_ids) const override;
+
+  /// \brief Get all pairs of nodes that may collide / intersect with each
+  /// other. Pairs of nodes in the grid are found using their fat AABBs.
+  /// Nodes stored in the tree are checked against the fat AABBs of the nodes
+  /// in the grid using their tight AABBs, so fewer candidates are reported
+  /// for them. Pairs are sorted and store the smaller node id first.
+  /// \param[out] _pairs Vector to be filled with pairs of node ids. It is
+  /// cleared first so the same buffer can be reused across calls.
+  public: void Collisions(
+      std::vector<std::pair<std::size_t, std::size_t>> &_pairs)
+      const override;
+
+  /// \brief Get all pairs of nodes in this broadphase and nodes in another
+  /// broadphase that may collide / intersect with each other. The other
+  /// broadphase is queried with the fat AABB of each node in this
+  /// broadphase.
+  /// \param[in] _other Other broadphase to check against
+  /// \param[out] _pairs Vector to be filled with pairs of node ids. The first
+  /// id of each pair is the id of the node in this broadphase and the second
+  /// is the id of the node in the other broadphase. Pairs are sorted. The
+  /// vector is cleared first so the same buffer can be reused across calls.
+  public: void Collisions(const Broadphase &_other,
+      std::vector<std::pair<std::size_t, std::size_t>> &_pairs)
+      const override;
+
+  // Documentation inherited
+  public: math::AxisAlignedBox AABB(std::size_t _id) const override;
+
+  // Documentation inherited
+  public: math::AxisAlignedBox FatAABB(std::size_t _id) const override;
+
+  // Documentation inherited
+  public: bool HasNode(std::size_t _id) const override;
+
+  /// \brief Set the size of the grid cells. All nodes are moved to the
+  /// cells of the new grid.
+  /// \param[in] _size Cell size. A value of 0, which is the default, tunes
+  /// the cell size to the median size of the nodes each time the number of
+  /// nodes doubles.
+  public: void SetCellSize(double _size);
+
+  /// \brief Get the size of the grid cells
+  /// \return Cell size, which is 0 if it has not been set and there are no
+  /// nodes to tune it to.
+  public: double CellSize() const;
+
+  /// \brief Get whether a node is stored in the tree instead of the grid
+  /// because it spans too many cells
+  /// \param[in] _id Node id
+  /// \return True if the node is stored in the tree
+  public: bool Oversized(std::size_t _id) const;
+
+  /// \brief Pointer to the private data
+  IGN_UTILS_WARN_IGNORE__DLL_INTERFACE_MISSING
+  private: std::unique_ptr<UniformGridPrivate> dataPtr;
+  IGN_UTILS_WARN_RESUME__DLL_INTERFACE_MISSING
+};
+}
+}
+}
+
+#endif
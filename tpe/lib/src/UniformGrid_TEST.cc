@@ -0,0 +1,155 @@
+/*
+ * Copyright (C) 2020 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <gtest/gtest.h>
+
+#include <set>
+#include <utility>
+#include <vector>
+
+#include "UniformGrid.hh"
+
+using namespace ignition;
+using namespace physics;
+using namespace tpelib;
+
+/////////////////////////////////////////////////
+TEST(UniformGrid, UniformGrid)
+{
+  UniformGrid grid;
+  EXPECT_EQ(0u, grid.NodeCount());
+  EXPECT_DOUBLE_EQ(0.0, grid.CellSize());
+
+  math::AxisAlignedBox a(-math::Vector3d::One, math::Vector3d::One);
+  grid.AddNode(1u, a);
+  // the cell size is tuned to the first node
+  EXPECT_DOUBLE_EQ(4.0, grid.CellSize());
+  math::AxisAlignedBox b(math::Vector3d(-3, -3, -3),
+     math::Vector3d(-2, -2, -2));
+  grid.AddNode(2u, b);
+  // c overlaps with a and b
+  math::AxisAlignedBox c(math::Vector3d(-2.5, -2.5, -2.5),
+      math::Vector3d(0.5, 0.5, 0.5));
+  grid.AddNode(3u, c);
+  // d overlaps with a only
+  math::AxisAlignedBox d(math::Vector3d(0.55, 0.55, 0.55),
+      math::Vector3d(0.75, 0.75, 0.75));
+  grid.AddNode(4u, d);
+  EXPECT_EQ(4u, grid.NodeCount());
+  EXPECT_TRUE(grid.HasNode(4u));
+  EXPECT_EQ(d, grid.AABB(4u));
+
+  // adding an existing node fails
+  grid.AddNode(4u, a);
+  EXPECT_EQ(4u, grid.NodeCount());
+  EXPECT_EQ(d, grid.AABB(4u));
+
+  EXPECT_EQ(std::set<std::size_t>({3u, 4u}), grid.Collisions(1u));
+  EXPECT_EQ(std::set<std::size_t>({3u}), grid.Collisions(2u));
+  EXPECT_EQ(std::set<std::size_t>({1u, 2u}), grid.Collisions(3u));
+  EXPECT_EQ(std::set<std::size_t>({1u}), grid.Collisions(4u));
+
+  std::vector<std::pair<std::size_t, std::size_t>> pairs;
+  grid.Collisions(pairs);
+  std::vector<std::pair<std::size_t, std::size_t>> expected =
+      {{1u, 3u}, {1u, 4u}, {2u, 3u}};
+  EXPECT_EQ(expected, pairs);
+
+  // remove nodes
+  EXPECT_FALSE(grid.RemoveNode(555u));
+  EXPECT_TRUE(grid.RemoveNode(2u));
+  EXPECT_EQ(3u, grid.NodeCount());
+  EXPECT_FALSE(grid.HasNode(2u));
+  EXPECT_EQ(std::set<std::size_t>({1u}), grid.Collisions(3u));
+  EXPECT_TRUE(grid.Collisions(2u).empty());
+
+  // move c away
+  EXPECT_TRUE(grid.UpdateNode(3u, math::AxisAlignedBox(
+      math::Vector3d(-40, -40, -40), math::Vector3d(-39, -39, -39))));
+  EXPECT_FALSE(grid.UpdateNode(2u, a));
+  EXPECT_EQ(std::set<std::size_t>({4u}), grid.Collisions(1u));
+  EXPECT_TRUE(grid.Collisions(3u).empty());
+  grid.Collisions(pairs);
+  expected = {{1u, 4u}};
+  EXPECT_EQ(expected, pairs);
+
+  EXPECT_EQ(math::AxisAlignedBox(), grid.AABB(2u));
+  EXPECT_EQ(math::AxisAlignedBox(), grid.FatAABB(2u));
+}
+
+/////////////////////////////////////////////////
+TEST(UniformGrid, CellSize)
+{
+  UniformGrid grid;
+
+  // the cell size is tuned to the median node size, so a ground plane
+  // does not change it and is stored in the tree
+  for (std::size_t i = 0u; i < 10u; ++i)
+  {
+    math::Vector3d center(3.0 * i, 0, 0.5);
+    grid.AddNode(i, math::AxisAlignedBox(center - 0.5 * math::Vector3d::One,
+        center + 0.5 * math::Vector3d::One));
+  }
+  math::AxisAlignedBox ground(math::Vector3d(-1000, -1000, -0.1),
+      math::Vector3d(1000, 1000, 0));
+  grid.AddNode(100u, ground);
+  EXPECT_DOUBLE_EQ(2.0, grid.CellSize());
+  EXPECT_TRUE(grid.Oversized(100u));
+  EXPECT_FALSE(grid.Oversized(0u));
+  EXPECT_FALSE(grid.Oversized(555u));
+
+  EXPECT_EQ(std::set<std::size_t>({0u, 1u, 2u, 3u, 4u, 5u, 6u, 7u, 8u, 9u}),
+      grid.Collisions(100u));
+  EXPECT_EQ(std::set<std::size_t>({100u}), grid.Collisions(3u));
+  std::vector<std::pair<std::size_t, std::size_t>> pairs;
+  grid.Collisions(pairs);
+  EXPECT_EQ(10u, pairs.size());
+  for (const auto &p : pairs)
+    EXPECT_EQ(100u, p.second);
+
+  std::vector<std::size_t> ids;
+  grid.Collisions(math::AxisAlignedBox(math::Vector3d(2.6, -1, 0.2),
+      math::Vector3d(3.4, 1, 2)), ids);
+  EXPECT_EQ(std::vector<std::size_t>({1u}), ids);
+
+  // a node that grows too large is moved to the tree and back
+  grid.UpdateNode(5u, math::AxisAlignedBox(math::Vector3d(11, -0.5, 0),
+      math::Vector3d(19, 0.5, 1)));
+  EXPECT_TRUE(grid.Oversized(5u));
+  EXPECT_EQ(std::set<std::size_t>({4u, 6u, 100u}), grid.Collisions(5u));
+  grid.UpdateNode(5u, math::AxisAlignedBox(math::Vector3d(14.5, -0.5, 0),
+      math::Vector3d(15.5, 0.5, 1)));
+  EXPECT_FALSE(grid.Oversized(5u));
+  EXPECT_EQ(std::set<std::size_t>({100u}), grid.Collisions(5u));
+
+  // a cell size set explicitly moves nodes between the grid and the tree
+  grid.SetCellSize(1000.0);
+  EXPECT_DOUBLE_EQ(1000.0, grid.CellSize());
+  EXPECT_FALSE(grid.Oversized(100u));
+  grid.Collisions(pairs);
+  EXPECT_EQ(10u, pairs.size());
+  grid.SetCellSize(0.1);
+  EXPECT_DOUBLE_EQ(0.1, grid.CellSize());
+  EXPECT_TRUE(grid.Oversized(0u));
+  grid.Collisions(pairs);
+  EXPECT_EQ(10u, pairs.size());
+
+  // going back to automatic tuning
+  grid.SetCellSize(0.0);
+  EXPECT_DOUBLE_EQ(2.0, grid.CellSize());
+  EXPECT_FALSE(grid.Oversized(0u));
+}
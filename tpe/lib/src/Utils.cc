@@ -15,12 +15,49 @@
  *
 */
 
+#include <cmath>
+
+#if defined(__AVX__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
 #include "Utils.hh"
 
 namespace ignition {
 namespace physics {
 namespace tpelib {
 
+//////////////////////////////////////////////////
+/// \brief Compute the rotation matrix of a quaternion, scaled so that
+/// quaternions that are not normalized rotate the same way as
+/// math::Quaterniond does
+/// \param[in] _q Quaternion
+/// \param[out] _r Rotation matrix in row major order
+static void rotationMatrix(const math::Quaterniond &_q, double _r[9])
+{
+  const double n = _q.W() * _q.W() + _q.X() * _q.X() + _q.Y() * _q.Y() +
+      _q.Z() * _q.Z();
+  const double s = n > 0.0 ? 2.0 / n : 0.0;
+  const double xx = s * _q.X() * _q.X();
+  const double yy = s * _q.Y() * _q.Y();
+  const double zz = s * _q.Z() * _q.Z();
+  const double xy = s * _q.X() * _q.Y();
+  const double xz = s * _q.X() * _q.Z();
+  const double yz = s * _q.Y() * _q.Z();
+  const double wx = s * _q.W() * _q.X();
+  const double wy = s * _q.W() * _q.Y();
+  const double wz = s * _q.W() * _q.Z();
+  _r[0] = 1.0 - (yy + zz);
+  _r[1] = xy - wz;
+  _r[2] = xz + wy;
+  _r[3] = xy + wz;
+  _r[4] = 1.0 - (xx + zz);
+  _r[5] = yz - wx;
+  _r[6] = xz - wy;
+  _r[7] = yz + wx;
+  _r[8] = 1.0 - (xx + yy);
+}
+
 //////////////////////////////////////////////////
 math::AxisAlignedBox transformAxisAlignedBox(
     const math::AxisAlignedBox &_box, const math::Pose3d &_pose)
@@ -28,73 +65,167 @@ math::AxisAlignedBox transformAxisAlignedBox(
   if (_box == math::AxisAlignedBox())
     return _box;
 
-  // Transform the original axis aligned box by applying the pose
-  // transformation to all 8 corners. This results in a rotated box, which
-  // we need to fit a new axis aligned box to. We can achieve this by creating
-  // an empty axis aligned box and merging it with each corner of the rotated
-  // box. The result is a larger axis aligned box that surrounds the rotated box
-
-  // old min and max of original axis aligned box
-  math::Vector3d oldMin = _box.Min();
-  math::Vector3d oldMax = _box.Max();
-
-  // empty min max of new axis aligned box
-  // we will merge the empty min and max values with each of the
-  //  transformed corners
-  math::Vector3d newMin(math::MAX_D, math::MAX_D, math::MAX_D);
-  math::Vector3d newMax(math::LOW_D, math::LOW_D, math::LOW_D);
-
-  // min min min
-  // transform corner
-  math::Vector3d corner = oldMin;
-  auto v = _pose.Rot() * corner + _pose.Pos();
-  // merge min/max with transformed corner
-  newMin.Min(v);
-  newMax.Max(v);
-
-  // min min max
-  corner.Z() = oldMax.Z();
-  v = _pose.Rot() * corner + _pose.Pos();
-  newMin.Min(v);
-  newMax.Max(v);
-
-  // min max max
-  corner.Y() = oldMax.Y();
-  v = _pose.Rot() * corner + _pose.Pos();
-  newMin.Min(v);
-  newMax.Max(v);
-
-  // min max min
-  corner.Z() = oldMin.Z();
-  v = _pose.Rot() * corner + _pose.Pos();
-  newMin.Min(v);
-  newMax.Max(v);
-
-  // max max min
-  corner.X() = oldMax.X();
-  v = _pose.Rot() * corner + _pose.Pos();
-  newMin.Min(v);
-  newMax.Max(v);
-
-  // max max max
-  corner.Z() = oldMax.Z();
-  v = _pose.Rot() * corner + _pose.Pos();
-  newMin.Min(v);
-  newMax.Max(v);
-
-  // max min max
-  corner.Y() = oldMin.Y();
-  v = _pose.Rot() * corner + _pose.Pos();
-  newMin.Min(v);
-  newMax.Max(v);
-
-  // max min min
-  corner.Z() = oldMin.Z();
-  v = _pose.Rot() * corner + _pose.Pos();
-  newMin.Min(v);
-  newMax.Max(v);
-
-  return math::AxisAlignedBox(newMin, newMax);
+  // same as one box of transformAxisAlignedBoxes, without filling a batch:
+  // the center is rotated and translated and the extent is multiplied by
+  // the absolute rotation matrix
+  double r[9];
+  rotationMatrix(_pose.Rot(), r);
+  const math::Vector3d c = 0.5 * (_box.Min() + _box.Max());
+  const math::Vector3d e = 0.5 * (_box.Max() - _box.Min());
+  math::Vector3d nc;
+  math::Vector3d ne;
+  for (unsigned int a = 0u; a < 3u; ++a)
+  {
+    double value = _pose.Pos()[a];
+    double extent = 0.0;
+    for (unsigned int b = 0u; b < 3u; ++b)
+    {
+      value += r[a * 3u + b] * c[b];
+      extent += std::fabs(r[a * 3u + b]) * e[b];
+    }
+    nc[a] = value;
+    ne[a] = extent;
+  }
+  return math::AxisAlignedBox(nc - ne, nc + ne);
+}
+
+//////////////////////////////////////////////////
+const std::size_t AxisAlignedBoxBatch::kCapacity;
+
+//////////////////////////////////////////////////
+std::size_t AxisAlignedBoxBatch::Add(const math::AxisAlignedBox &_box,
+    const math::Pose3d &_pose)
+{
+  if (this->count >= kCapacity)
+    return kCapacity;
+
+  const std::size_t i = this->count++;
+  const math::Vector3d &min = _box.Min();
+  const math::Vector3d &max = _box.Max();
+  for (unsigned int a = 0u; a < 3u; ++a)
+  {
+    this->center[a][i] = 0.5 * (min[a] + max[a]);
+    this->extent[a][i] = 0.5 * (max[a] - min[a]);
+    this->translation[a][i] = _pose.Pos()[a];
+  }
+
+  double r[9];
+  rotationMatrix(_pose.Rot(), r);
+  for (unsigned int a = 0u; a < 9u; ++a)
+    this->rotation[a][i] = r[a];
+  return i;
+}
+
+//////////////////////////////////////////////////
+math::AxisAlignedBox AxisAlignedBoxBatch::Box(std::size_t _index) const
+{
+  math::Vector3d c(this->center[0][_index], this->center[1][_index],
+      this->center[2][_index]);
+  math::Vector3d e(this->extent[0][_index], this->extent[1][_index],
+      this->extent[2][_index]);
+  return math::AxisAlignedBox(c - e, c + e);
+}
+
+//////////////////////////////////////////////////
+std::size_t AxisAlignedBoxBatch::Size() const
+{
+  return this->count;
+}
+
+//////////////////////////////////////////////////
+bool AxisAlignedBoxBatch::Full() const
+{
+  return this->count >= kCapacity;
+}
+
+//////////////////////////////////////////////////
+void AxisAlignedBoxBatch::Clear()
+{
+  this->count = 0u;
+}
+
+//////////////////////////////////////////////////
+void transformAxisAlignedBoxes(AxisAlignedBoxBatch &_batch)
+{
+  auto &c = _batch.center;
+  auto &e = _batch.extent;
+  const auto &r = _batch.rotation;
+  const auto &t = _batch.translation;
+  std::size_t i = 0u;
+
+#if defined(__AVX__)
+  // 4 boxes at a time. The absolute value clears the sign bit.
+  const __m256d sign = _mm256_set1_pd(-0.0);
+  for (; i + 4u <= _batch.count; i += 4u)
+  {
+    __m256d ci[3];
+    __m256d ei[3];
+    for (unsigned int a = 0u; a < 3u; ++a)
+    {
+      ci[a] = _mm256_load_pd(&c[a][i]);
+      ei[a] = _mm256_load_pd(&e[a][i]);
+    }
+    for (unsigned int a = 0u; a < 3u; ++a)
+    {
+      __m256d nc = _mm256_load_pd(&t[a][i]);
+      __m256d ne = _mm256_setzero_pd();
+      for (unsigned int b = 0u; b < 3u; ++b)
+      {
+        const __m256d rab = _mm256_load_pd(&r[a * 3u + b][i]);
+        nc = _mm256_add_pd(nc, _mm256_mul_pd(rab, ci[b]));
+        ne = _mm256_add_pd(ne,
+            _mm256_mul_pd(_mm256_andnot_pd(sign, rab), ei[b]));
+      }
+      _mm256_store_pd(&c[a][i], nc);
+      _mm256_store_pd(&e[a][i], ne);
+    }
+  }
+#elif defined(__SSE2__)
+  // 2 boxes at a time. The absolute value clears the sign bit.
+  const __m128d sign = _mm_set1_pd(-0.0);
+  for (; i + 2u <= _batch.count; i += 2u)
+  {
+    __m128d ci[3];
+    __m128d ei[3];
+    for (unsigned int a = 0u; a < 3u; ++a)
+    {
+      ci[a] = _mm_load_pd(&c[a][i]);
+      ei[a] = _mm_load_pd(&e[a][i]);
+    }
+    for (unsigned int a = 0u; a < 3u; ++a)
+    {
+      __m128d nc = _mm_load_pd(&t[a][i]);
+      __m128d ne = _mm_setzero_pd();
+      for (unsigned int b = 0u; b < 3u; ++b)
+      {
+        const __m128d rab = _mm_load_pd(&r[a * 3u + b][i]);
+        nc = _mm_add_pd(nc, _mm_mul_pd(rab, ci[b]));
+        ne = _mm_add_pd(ne, _mm_mul_pd(_mm_andnot_pd(sign, rab), ei[b]));
+      }
+      _mm_store_pd(&c[a][i], nc);
+      _mm_store_pd(&e[a][i], ne);
+    }
+  }
+#endif
+
+  // remaining boxes, or all of them without SIMD support
+  for (; i < _batch.count; ++i)
+  {
+    const double ci[3] = {c[0][i], c[1][i], c[2][i]};
+    const double ei[3] = {e[0][i], e[1][i], e[2][i]};
+    for (unsigned int a = 0u; a < 3u; ++a)
+    {
+      double nc = t[a][i];
+      double ne = 0.0;
+      for (unsigned int b = 0u; b < 3u; ++b)
+      {
+        nc += r[a * 3u + b][i] * ci[b];
+        ne += std::fabs(r[a * 3u + b][i]) * ei[b];
+      }
+      c[a][i] = nc;
+      e[a][i] = ne;
+    }
+  }
 }
 
 }
@@ -15,6 +15,8 @@
  *
 */
 
+#include <cstddef>
+
 #include <ignition/math/AxisAlignedBox.hh>
 #include <ignition/math/Pose3.hh>
 
@@ -32,6 +34,65 @@ namespace tpelib {
   IGNITION_PHYSICS_TPELIB_VISIBLE
   math::AxisAlignedBox transformAxisAlignedBox(
       const math::AxisAlignedBox &_box, const math::Pose3d &_pose);
+
+  /// \brief A batch of axis aligned boxes and the poses that transform them.
+  /// The boxes are stored by their centers and half extents and the poses by
+  /// their rotation matrices and translations, each as a structure of arrays
+  /// so that transformAxisAlignedBoxes can process several boxes at once with
+  /// SIMD instructions.
+  class IGNITION_PHYSICS_TPELIB_VISIBLE AxisAlignedBoxBatch
+  {
+    /// \brief Maximum number of boxes in a batch
+    public: static const std::size_t kCapacity = 32u;
+
+    /// \brief Add a box to the batch
+    /// \param[in] _box Axis aligned box, which must not be empty
+    /// \param[in] _pose Transform to be applied to the box
+    /// \return Index of the box in the batch, or kCapacity if the batch is
+    /// full
+    public: std::size_t Add(const math::AxisAlignedBox &_box,
+        const math::Pose3d &_pose);
+
+    /// \brief Get a box in the batch
+    /// \param[in] _index Index of the box
+    /// \return Axis aligned box with the current center and extent
+    public: math::AxisAlignedBox Box(std::size_t _index) const;
+
+    /// \brief Get the number of boxes in the batch
+    /// \return Number of boxes
+    public: std::size_t Size() const;
+
+    /// \brief Get whether the batch is full
+    /// \return True if no more boxes can be added
+    public: bool Full() const;
+
+    /// \brief Remove all boxes from the batch
+    public: void Clear();
+
+    /// \brief Centers of the boxes, one array per axis
+    public: alignas(32) double center[3][kCapacity];
+
+    /// \brief Half extents of the boxes, one array per axis
+    public: alignas(32) double extent[3][kCapacity];
+
+    /// \brief Rotation matrices in row major order, one array per element
+    public: alignas(32) double rotation[9][kCapacity];
+
+    /// \brief Translations, one array per axis
+    public: alignas(32) double translation[3][kCapacity];
+
+    /// \brief Number of boxes in the batch
+    public: std::size_t count = 0u;
+  };
+
+  /// \brief Transform all boxes in a batch by their poses, in place. The new
+  /// box of each entry has center R * c + t and half extent |R| * e, where
+  /// |R| is the rotation matrix with the absolute value of each element.
+  /// This yields the same box as transforming the 8 corners of the box, but
+  /// needs no comparisons and is vectorized with AVX or SSE2 when available.
+  /// \param[in,out] _batch Batch of boxes to be transformed
+  IGNITION_PHYSICS_TPELIB_VISIBLE
+  void transformAxisAlignedBoxes(AxisAlignedBoxBatch &_batch);
 }
 }
 }
@@ -17,6 +17,9 @@
 
 #include <gtest/gtest.h>
 
+#include <random>
+#include <vector>
+
 #include "Utils.hh"
 
 using namespace ignition;
@@ -53,3 +56,69 @@ TEST(Utils, TransformAxisAlignedBox)
   EXPECT_EQ(math::AxisAlignedBox(math::Vector3d(-1, 0, 1),
       math::Vector3d(5, 4, 3)), box2TransformedRot);
 }
+
+/////////////////////////////////////////////////
+/// \brief Transform a box by transforming its 8 corners
+/// \param[in] _box Box to be transformed
+/// \param[in] _pose Transform to be applied
+/// \return Box that surrounds the transformed corners
+math::AxisAlignedBox transformCorners(const math::AxisAlignedBox &_box,
+    const math::Pose3d &_pose)
+{
+  math::AxisAlignedBox result;
+  for (unsigned int i = 0u; i < 8u; ++i)
+  {
+    math::Vector3d corner(
+        (i & 1u) ? _box.Max().X() : _box.Min().X(),
+        (i & 2u) ? _box.Max().Y() : _box.Min().Y(),
+        (i & 4u) ? _box.Max().Z() : _box.Min().Z());
+    math::Vector3d v = _pose.Rot() * corner + _pose.Pos();
+    result.Merge(math::AxisAlignedBox(v, v));
+  }
+  return result;
+}
+
+/////////////////////////////////////////////////
+TEST(Utils, TransformAxisAlignedBoxes)
+{
+  std::mt19937 rng(42);
+  std::uniform_real_distribution<double> dist(-5.0, 5.0);
+
+  // batch sizes that do not fill whole SIMD registers test the scalar path
+  AxisAlignedBoxBatch batch;
+  EXPECT_EQ(0u, batch.Size());
+  for (std::size_t count : {1u, 3u, 5u, 8u, 13u, 32u})
+  {
+    batch.Clear();
+    std::vector<math::AxisAlignedBox> boxes;
+    std::vector<math::Pose3d> poses;
+    for (std::size_t i = 0u; i < count; ++i)
+    {
+      math::Vector3d a(dist(rng), dist(rng), dist(rng));
+      math::Vector3d b(dist(rng), dist(rng), dist(rng));
+      boxes.push_back(math::AxisAlignedBox(a, b));
+      poses.push_back(math::Pose3d(dist(rng), dist(rng), dist(rng),
+          dist(rng), dist(rng), dist(rng)));
+      EXPECT_EQ(i, batch.Add(boxes.back(), poses.back()));
+    }
+    EXPECT_EQ(count, batch.Size());
+    EXPECT_EQ(count == AxisAlignedBoxBatch::kCapacity, batch.Full());
+
+    transformAxisAlignedBoxes(batch);
+    for (std::size_t i = 0u; i < count; ++i)
+    {
+      math::AxisAlignedBox expected = transformCorners(boxes[i], poses[i]);
+      EXPECT_EQ(expected, batch.Box(i));
+      EXPECT_EQ(expected, transformAxisAlignedBox(boxes[i], poses[i]));
+    }
+  }
+
+  // boxes can not be added to a full batch
+  EXPECT_TRUE(batch.Full());
+  EXPECT_EQ(AxisAlignedBoxBatch::kCapacity, batch.Add(
+      math::AxisAlignedBox(-1, -1, -1, 1, 1, 1), math::Pose3d::Zero));
+  EXPECT_EQ(AxisAlignedBoxBatch::kCapacity, batch.Size());
+  batch.Clear();
+  EXPECT_EQ(0u, batch.Size());
+  EXPECT_FALSE(batch.Full());
+}
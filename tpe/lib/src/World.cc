@@ -15,22 +15,143 @@
  *
 */
 
+#include <algorithm>
 #include <string>
 #include <memory>
+#include <unordered_map>
+#include <vector>
 
 #include <ignition/common/Profiler.hh>
 
 #include <ignition/math/Pose3.hh>
+#include <ignition/common/Console.hh>
+
+#include "Collision.hh"
+#include "EntityPool.hh"
+#include "Link.hh"
+#include "StateBuffer.hh"
 #include "World.hh"
 #include "Model.hh"
+#include "Utils.hh"
 
 using namespace ignition;
 using namespace physics;
 using namespace tpelib;
 
+/// \brief Minimum number of models updated by a thread in each step
+static const std::size_t kMinModelsPerChunk = 64u;
+
+/// \brief Number of ids a world reserves at a time for its entities
+static const std::size_t kIdBlockSize = 1024u;
+
+/// \brief Version of the format of saved world states
+static const uint32_t kStateVersion = 1u;
+
+/// \brief Get whether two poses are exactly equal. The tolerances of the
+/// math comparison operators would skip small changes.
+/// \param[in] _p1 First pose
+/// \param[in] _p2 Second pose
+/// \return True if all components are equal
+static bool samePose(const math::Pose3d &_p1, const math::Pose3d &_p2)
+{
+  return _p1.Pos().X() == _p2.Pos().X() && _p1.Pos().Y() == _p2.Pos().Y() &&
+      _p1.Pos().Z() == _p2.Pos().Z() && _p1.Rot().W() == _p2.Rot().W() &&
+      _p1.Rot().X() == _p2.Rot().X() && _p1.Rot().Y() == _p2.Rot().Y() &&
+      _p1.Rot().Z() == _p2.Rot().Z();
+}
+
+/// \brief Write the ids and poses of the descendants of an entity
+/// \param[in] _writer Writer to append to
+/// \param[in] _entity Entity
+static void writeDescendants(StateWriter &_writer, const Entity &_entity)
+{
+  _writer.Write(_entity.GetChildCount());
+  for (std::size_t i = 0u; i < _entity.GetChildCount(); ++i)
+  {
+    Entity &child = _entity.GetChildByIndex(static_cast<unsigned int>(i));
+    _writer.Write(child.GetId());
+    _writer.Write(child.GetPose());
+    writeDescendants(_writer, child);
+  }
+}
+
+/// \brief Read the ids and poses of the descendants of an entity written by
+/// writeDescendants
+/// \param[in] _reader Reader positioned at the descendants
+/// \param[in] _entity Entity
+/// \param[in] _apply True to set the poses that changed, false to only check
+/// that the entity has the same descendants
+/// \return True if the descendants match those of the entity
+static bool readDescendants(StateReader &_reader, Entity &_entity,
+    bool _apply)
+{
+  std::size_t count = 0u;
+  if (!_reader.Read(count) || count != _entity.GetChildCount())
+    return false;
+
+  for (std::size_t i = 0u; i < count; ++i)
+  {
+    Entity &child = _entity.GetChildByIndex(static_cast<unsigned int>(i));
+    std::size_t id = kNullEntityId;
+    math::Pose3d pose;
+    if (!_reader.Read(id) || id != child.GetId() || !_reader.Read(pose))
+      return false;
+    if (_apply && !samePose(pose, child.GetPose()))
+      child.SetPose(pose);
+    if (!readDescendants(_reader, child, _apply))
+      return false;
+  }
+  return true;
+}
+
+/// \brief Write a contact
+/// \param[in] _writer Writer to append to
+/// \param[in] _contact Contact
+static void writeContact(StateWriter &_writer, const Contact &_contact)
+{
+  _writer.Write(_contact.id);
+  _writer.Write(_contact.entity1);
+  _writer.Write(_contact.entity2);
+  _writer.Write(_contact.collision1);
+  _writer.Write(_contact.collision2);
+  _writer.Write(_contact.point);
+  _writer.Write(_contact.normal);
+  _writer.Write(_contact.depth);
+}
+
+/// \brief Read a contact written by writeContact
+/// \param[in] _reader Reader positioned at the contact
+/// \param[out] _contact Contact read
+/// \return True if the contact was read
+static bool readContact(StateReader &_reader, Contact &_contact)
+{
+  return _reader.Read(_contact.id) && _reader.Read(_contact.entity1) &&
+      _reader.Read(_contact.entity2) && _reader.Read(_contact.collision1) &&
+      _reader.Read(_contact.collision2) && _reader.Read(_contact.point) &&
+      _reader.Read(_contact.normal) && _reader.Read(_contact.depth);
+}
+
+/// \brief Collect all descendants of an entity
+/// \param[in] _entity Entity
+/// \param[out] _descendants Descendants to append to
+static void collectDescendants(const Entity &_entity,
+    std::vector<const Entity *> &_descendants)
+{
+  for (std::size_t i = 0u; i < _entity.GetChildCount(); ++i)
+  {
+    const Entity &child =
+        _entity.GetChildByIndex(static_cast<unsigned int>(i));
+    _descendants.push_back(&child);
+    collectDescendants(child, _descendants);
+  }
+}
+
 /////////////////////////////////////////////////
-World::World() : Entity()
+World::World()
+  : Entity(Entity::GetNextId(), std::make_shared<EntityPool>()),
+    threadPool(std::make_shared<ThreadPool>())
 {
+  this->collisionDetector.SetThreadPool(this->threadPool);
 }
 
 /////////////////////////////////////////////////
@@ -57,29 +178,183 @@ double World::GetTimeStep() const
   return this->timeStep;
 }
 
+/////////////////////////////////////////////////
+void World::SetBroadphaseType(BroadphaseType _type)
+{
+  this->collisionDetector.SetBroadphaseType(_type);
+}
+
+/////////////////////////////////////////////////
+BroadphaseType World::GetBroadphaseType() const
+{
+  return this->collisionDetector.GetBroadphaseType();
+}
+
+/////////////////////////////////////////////////
+void World::SetCollisionMargin(double _margin)
+{
+  this->collisionDetector.SetAABBMargin(_margin);
+}
+
+/////////////////////////////////////////////////
+double World::GetCollisionMargin() const
+{
+  return this->collisionDetector.GetAABBMargin();
+}
+
+/////////////////////////////////////////////////
+void World::SetCollisionDisplacementScale(double _scale)
+{
+  this->collisionDetector.SetAABBDisplacementScale(_scale);
+}
+
+/////////////////////////////////////////////////
+double World::GetCollisionDisplacementScale() const
+{
+  return this->collisionDetector.GetAABBDisplacementScale();
+}
+
+/////////////////////////////////////////////////
+void World::SetThreadCount(unsigned int _threadCount)
+{
+  this->threadPool->SetThreadCount(_threadCount);
+}
+
+/////////////////////////////////////////////////
+unsigned int World::GetThreadCount() const
+{
+  return this->threadPool->ThreadCount();
+}
+
+/////////////////////////////////////////////////
+void World::SetSleepSteps(unsigned int _steps)
+{
+  this->sleepSteps = _steps;
+  if (_steps > 0u)
+    return;
+
+  for (auto &it : this->GetChildren())
+  {
+    Model *model = static_cast<Model *>(it.second.get());
+    if (model->IsSleeping())
+    {
+      model->SetSleeping(false);
+      this->modelsDirty = true;
+    }
+  }
+}
+
+/////////////////////////////////////////////////
+unsigned int World::GetSleepSteps() const
+{
+  return this->sleepSteps;
+}
+
 /////////////////////////////////////////////////
 void World::Step()
 {
   IGN_PROFILE("tpelib::World::Step");
   // apply updates to each model
   auto &children = this->GetChildren();
-  for (auto it = children.begin(); it != children.end(); ++it)
+  if (this->modelsDirty)
+  {
+    this->models.clear();
+    for (auto it = children.begin(); it != children.end(); ++it)
+    {
+      Model *model = static_cast<Model *>(it->second.get());
+      if (!model->IsSleeping())
+        this->models.push_back(model->GetStorageSlot());
+    }
+    this->modelsDirty = false;
+  }
+
+  // Models are updated in parallel in contiguous chunks through
+  // Model::UpdatePose, which writes to the arrays of the model storage. A
+  // model moved if its pose is dirty afterwards. Each chunk records the
+  // models that moved and the chunks are merged in order, so the list of
+  // changed models is the same for any number of threads.
+  auto &storage = this->modelStorage;
+  this->chunkMovedModels.resize(
+      this->threadPool->ChunkCount(this->models.size(), kMinModelsPerChunk));
+  this->updatingPoses = true;
+  this->threadPool->ParallelFor(this->models.size(),
+      [&](std::size_t _chunk, std::size_t _begin, std::size_t _end)
+  {
+    auto &moved = this->chunkMovedModels[_chunk];
+    moved.clear();
+    for (std::size_t i = _begin; i < _end; ++i)
+    {
+      const std::size_t slot = this->models[i];
+      const math::Vector3d &linearVelocity = storage.linearVelocities[slot];
+      const math::Vector3d &angularVelocity = storage.angularVelocities[slot];
+      Model *model = storage.models[slot];
+      const bool wasDirty = model->PoseDirty();
+      model->UpdatePose(this->timeStep, linearVelocity, angularVelocity);
+
+      // a pose set since the last step is not a move in this step unless
+      // the model also has a velocity
+      const bool stepped = model->PoseDirty() && (!wasDirty ||
+          linearVelocity != math::Vector3d::Zero ||
+          angularVelocity != math::Vector3d::Zero);
+      if (!stepped)
+      {
+        if (storage.idleSteps[slot] < this->sleepSteps)
+          ++storage.idleSteps[slot];
+        continue;
+      }
+
+      storage.idleSteps[slot] = 0u;
+      if (!model->IsChangeQueued())
+      {
+        model->SetChangeQueued(true);
+        moved.push_back(storage.ids[slot]);
+      }
+    }
+  }, kMinModelsPerChunk);
+  this->updatingPoses = false;
+
+  for (const auto &moved : this->chunkMovedModels)
   {
-    auto model = std::dynamic_pointer_cast<Model>(it->second);
-    model->UpdatePose(
-      this->timeStep,
-      model->GetLinearVelocity(),
-      model->GetAngularVelocity());
+    this->changedModels.insert(this->changedModels.end(), moved.begin(),
+        moved.end());
   }
 
+  this->UpdateWorldBoxes();
+
   // check colliisions
-  // the last bool arg tells the collision checker to return one single contact
+  // the bool arg tells the collision checker to return one single contact
   // point for each pair of collisions
-  this->contacts = std::move(
-      this->collisionDetector.CheckCollisions(children, true));
+  // Only models that changed since the last step are updated in the
+  // collision detector, which owns the contacts and reuses their buffers
+  // across steps. The world AABBs of the changed models were computed above,
+  // so the collision detector takes them from the model storage.
+  this->collisionDetector.CheckCollisions(children, this->changedModels,
+      this->removedModels, true,
+      [&storage](const Entity &_model)
+      {
+        const std::size_t slot =
+            static_cast<const Model &>(_model).GetStorageSlot();
+        return math::AxisAlignedBox(storage.aabbMins[slot],
+            storage.aabbMaxs[slot]);
+      });
 
-  for (auto it = children.begin(); it != children.end(); ++it)
+  // models that changed in this step are still queued, which wakes up the
+  // sleeping models they touch
+  if (this->sleepSteps > 0u)
+    this->UpdateSleeping();
+
+  for (std::size_t id : this->changedModels)
+  {
+    auto it = children.find(id);
+    if (it == children.end())
+      continue;
     it->second->ResetPoseDirty();
+    Model *model = static_cast<Model *>(it->second.get());
+    model->SetChangeQueued(false);
+    model->ResetShapesChanged();
+  }
+  this->changedModels.clear();
+  this->removedModels.clear();
 
   // increment world time by step size
   this->time += this->timeStep;
@@ -88,14 +363,433 @@ void World::Step()
 /////////////////////////////////////////////////
 Entity &World::AddModel()
 {
-  std::size_t modelId = Entity::GetNextId();
+  std::size_t modelId = this->AllocateId();
   const auto[it, success] = this->GetChildren().insert(
-    {modelId, std::make_shared<Model>(modelId)});
+    {modelId, allocateShared<Model>(this->GetEntityPool(), modelId,
+    this->modelStorage, this->GetEntityPool())});
+  it->second->SetParent(this);
+  Entity::ChildChanged(*it->second);
+  this->QueueChanged(static_cast<Model &>(*it->second));
+  this->modelsDirty = true;
   return *it->second.get();
 }
 
 /////////////////////////////////////////////////
 std::vector<Contact> World::GetContacts() const
 {
-  return this->contacts;
+  return this->collisionDetector.GetContacts();
+}
+
+/////////////////////////////////////////////////
+std::size_t World::GetContactCount() const
+{
+  return this->collisionDetector.GetContacts().size();
+}
+
+/////////////////////////////////////////////////
+void World::VisitContacts(
+    const std::function<void(const Contact &)> &_visitor) const
+{
+  for (const auto &c : this->collisionDetector.GetContacts())
+    _visitor(c);
+}
+
+/////////////////////////////////////////////////
+std::vector<ContactEvent> World::GetContactEvents() const
+{
+  return this->collisionDetector.GetContactEvents();
+}
+
+/////////////////////////////////////////////////
+std::size_t World::AllocateId()
+{
+  if (this->nextChildId == this->endChildId)
+  {
+    this->nextChildId = Entity::ReserveIds(kIdBlockSize);
+    this->endChildId = this->nextChildId + kIdBlockSize;
+  }
+  return this->nextChildId++;
+}
+
+/////////////////////////////////////////////////
+const ModelStorage &World::GetModelStorage() const
+{
+  return this->modelStorage;
+}
+
+/////////////////////////////////////////////////
+void World::SaveState(std::vector<uint8_t> &_buffer) const
+{
+  IGN_PROFILE("tpelib::World::SaveState");
+
+  _buffer.clear();
+  StateWriter writer(_buffer);
+  writer.Write(kStateVersion);
+  writer.Write(this->time);
+
+  const auto &contacts = this->collisionDetector.GetContacts();
+  writer.Write(contacts.size());
+  for (const auto &contact : contacts)
+    writeContact(writer, contact);
+
+  const auto &storage = this->modelStorage;
+  auto &children = this->GetChildren();
+  writer.Write(children.size());
+  for (const auto &it : children)
+  {
+    const Model *model = static_cast<const Model *>(it.second.get());
+    const std::size_t slot = model->GetStorageSlot();
+    writer.Write(it.first);
+    writer.Write(model->GetPose());
+    writer.Write(storage.linearVelocities[slot]);
+    writer.Write(storage.angularVelocities[slot]);
+    writer.Write(storage.idleSteps[slot]);
+    writer.Write(model->IsSleeping());
+    writeDescendants(writer, *model);
+  }
+
+  this->collisionDetector.SaveState(writer);
+}
+
+/////////////////////////////////////////////////
+bool World::RestoreState(const std::vector<uint8_t> &_buffer)
+{
+  IGN_PROFILE("tpelib::World::RestoreState");
+
+  StateReader reader(_buffer);
+  uint32_t version = 0u;
+  double savedTime = 0.0;
+  std::size_t contactCount = 0u;
+  if (!reader.Read(version) || version != kStateVersion ||
+      !reader.Read(savedTime) || !reader.Read(contactCount))
+  {
+    ignerr << "Failed to restore world state: invalid buffer" << std::endl;
+    return false;
+  }
+
+  std::vector<Contact> savedContacts;
+  for (std::size_t i = 0u; i < contactCount; ++i)
+  {
+    Contact contact;
+    if (!readContact(reader, contact))
+    {
+      ignerr << "Failed to restore world state: invalid buffer" << std::endl;
+      return false;
+    }
+    savedContacts.push_back(contact);
+  }
+
+  // The models are read twice, first to check that they match the models of
+  // the world and then to set their state, so that the world is unchanged
+  // if the buffer does not match.
+  auto &storage = this->modelStorage;
+  auto &children = this->GetChildren();
+  auto readModels = [&](StateReader &_reader, bool _apply)
+  {
+    std::size_t count = 0u;
+    if (!_reader.Read(count) || count != children.size())
+      return false;
+
+    for (auto &it : children)
+    {
+      Model *model = static_cast<Model *>(it.second.get());
+      std::size_t id = kNullEntityId;
+      math::Pose3d pose;
+      math::Vector3d linearVelocity;
+      math::Vector3d angularVelocity;
+      unsigned int idleSteps = 0u;
+      bool sleeping = false;
+      if (!_reader.Read(id) || id != it.first || !_reader.Read(pose) ||
+          !_reader.Read(linearVelocity) || !_reader.Read(angularVelocity) ||
+          !_reader.Read(idleSteps) || !_reader.Read(sleeping) ||
+          !readDescendants(_reader, *model, _apply))
+      {
+        return false;
+      }
+      if (!_apply)
+        continue;
+
+      // setting a pose marks the model as changed and wakes it up, so the
+      // velocities and sleeping state are set after it
+      if (!samePose(pose, model->GetPose()))
+        model->SetPose(pose);
+      const std::size_t slot = model->GetStorageSlot();
+      storage.linearVelocities[slot] = linearVelocity;
+      storage.angularVelocities[slot] = angularVelocity;
+      storage.idleSteps[slot] = idleSteps;
+      model->SetSleeping(sleeping);
+    }
+    return true;
+  };
+
+  StateReader modelReader = reader;
+  if (!readModels(reader, false))
+  {
+    ignerr << "Failed to restore world state: the models of the world do "
+           << "not match the saved models" << std::endl;
+    return false;
+  }
+  if (!this->collisionDetector.RestoreState(reader,
+      std::move(savedContacts)))
+  {
+    ignerr << "Failed to restore world state: invalid buffer" << std::endl;
+    return false;
+  }
+  readModels(modelReader, true);
+
+  this->time = savedTime;
+  this->modelsDirty = true;
+  return true;
+}
+
+/////////////////////////////////////////////////
+std::shared_ptr<World> World::Clone() const
+{
+  IGN_PROFILE("tpelib::World::Clone");
+
+  auto clone = std::make_shared<World>();
+  clone->SetName(this->GetNameRef());
+  clone->SetPose(this->GetPose());
+  clone->time = this->time;
+  clone->timeStep = this->timeStep;
+  clone->sleepSteps = this->sleepSteps;
+  clone->SetThreadCount(this->GetThreadCount());
+  clone->SetBroadphaseType(this->GetBroadphaseType());
+  clone->SetCollisionMargin(this->GetCollisionMargin());
+  clone->SetCollisionDisplacementScale(
+      this->GetCollisionDisplacementScale());
+
+  // Entities are copied in the order of their ids, so parents are copied
+  // before their children and the ids of the copies are in the same order
+  // as the original ids. Contacts and contact pairs, which are sorted by
+  // id, stay sorted once their ids are mapped.
+  std::vector<const Entity *> entities;
+  auto &children = this->GetChildren();
+  for (const auto &it : children)
+  {
+    entities.push_back(it.second.get());
+    collectDescendants(*it.second, entities);
+  }
+  std::sort(entities.begin(), entities.end(),
+      [](const Entity *_e1, const Entity *_e2)
+      {
+        return _e1->GetId() < _e2->GetId();
+      });
+
+  std::unordered_map<std::size_t, Entity *> copies;
+  copies.reserve(entities.size() + 1u);
+  copies[this->GetId()] = clone.get();
+  for (const Entity *entity : entities)
+  {
+    Entity *parentCopy = copies[entity->GetParent()->GetId()];
+    Entity *copy = nullptr;
+    if (const auto *collision = dynamic_cast<const Collision *>(entity))
+    {
+      auto &collisionCopy = static_cast<Collision &>(
+          static_cast<Link *>(parentCopy)->AddCollision());
+      collisionCopy.ShareShape(*collision);
+      collisionCopy.SetCollideBitmask(collision->GetCollideBitmask());
+      copy = &collisionCopy;
+    }
+    else if (dynamic_cast<const Link *>(entity))
+    {
+      copy = &static_cast<Model *>(parentCopy)->AddLink();
+    }
+    else
+    {
+      copy = &clone->AddModel();
+    }
+    copy->SetName(entity->GetNameRef());
+    copy->SetPose(entity->GetPose());
+    copies[entity->GetId()] = copy;
+  }
+
+  // setting the velocities wakes up the models, so the sleeping state is
+  // set after them
+  for (const auto &it : children)
+  {
+    const Model *model = static_cast<const Model *>(it.second.get());
+    Model *modelCopy = static_cast<Model *>(copies[it.first]);
+    modelCopy->SetLinearVelocity(model->GetLinearVelocity());
+    modelCopy->SetAngularVelocity(model->GetAngularVelocity());
+    modelCopy->SetIdleSteps(model->GetIdleSteps());
+    modelCopy->SetSleeping(model->IsSleeping());
+  }
+
+  auto mapId = [&copies](std::size_t _id)
+  {
+    auto it = copies.find(_id);
+    return it == copies.end() ? _id : it->second->GetId();
+  };
+  std::vector<Contact> contacts = this->collisionDetector.GetContacts();
+  for (auto &contact : contacts)
+  {
+    contact.entity1 = mapId(contact.entity1);
+    contact.entity2 = mapId(contact.entity2);
+    contact.collision1 = mapId(contact.collision1);
+    contact.collision2 = mapId(contact.collision2);
+  }
+  clone->collisionDetector.CopyContactState(this->collisionDetector, mapId,
+      std::move(contacts));
+
+  return clone;
+}
+
+/////////////////////////////////////////////////
+bool World::RemoveChildById(std::size_t _id)
+{
+  auto &children = this->GetChildren();
+  auto it = children.find(_id);
+  if (it == children.end())
+    return false;
+
+  // the model keeps its state in case it is still referenced, and its slot
+  // is reused by the last model in the storage
+  Model *model = static_cast<Model *>(it->second.get());
+  const std::size_t slot = model->GetStorageSlot();
+  model->Detach();
+  this->modelStorage.Remove(slot);
+
+  if (!Entity::RemoveChildById(_id))
+    return false;
+
+  this->removedModels.push_back(_id);
+  this->modelsDirty = true;
+  return true;
+}
+
+/////////////////////////////////////////////////
+bool World::RemoveChildByName(const std::string &_name)
+{
+  Entity &child = this->GetChildByName(_name);
+  if (child.GetId() == kNullEntityId)
+    return false;
+
+  return this->RemoveChildById(child.GetId());
+}
+
+/////////////////////////////////////////////////
+void World::ChildChanged(Entity &_child)
+{
+  // changes made while updating poses are collected by World::Step
+  if (this->updatingPoses)
+    return;
+
+  Entity::ChildChanged(_child);
+
+  // any change to a model wakes it up
+  Model &model = static_cast<Model &>(_child);
+  this->QueueChanged(model);
+  model.SetIdleSteps(0u);
+  if (model.IsSleeping())
+  {
+    model.SetSleeping(false);
+    if (!this->modelsDirty)
+      this->models.push_back(model.GetStorageSlot());
+  }
+}
+
+/////////////////////////////////////////////////
+void World::QueueChanged(Model &_model)
+{
+  if (_model.IsChangeQueued())
+    return;
+  _model.SetChangeQueued(true);
+  this->changedModels.push_back(_model.GetId());
+}
+
+/////////////////////////////////////////////////
+void World::UpdateSleeping()
+{
+  IGN_PROFILE("tpelib::World::UpdateSleeping");
+
+  // put models that have not moved for long enough to sleep
+  auto &storage = this->modelStorage;
+  auto sleepIt = std::remove_if(this->models.begin(), this->models.end(),
+      [&](std::size_t _slot)
+      {
+        if (storage.idleSteps[_slot] < this->sleepSteps)
+          return false;
+        storage.models[_slot]->SetSleeping(true);
+        return true;
+      });
+  this->models.erase(sleepIt, this->models.end());
+
+  // Wake up sleeping models that touch models that moved in this step, i.e.
+  // models that changed or have a velocity. Awake models that stand still
+  // do not wake the models they touch, so models that stop on different
+  // steps while touching each other still fall asleep.
+  auto moved = [&storage](const Model &_model)
+  {
+    const std::size_t slot = _model.GetStorageSlot();
+    return _model.IsChangeQueued() ||
+        storage.linearVelocities[slot] != math::Vector3d::Zero ||
+        storage.angularVelocities[slot] != math::Vector3d::Zero;
+  };
+  auto &children = this->GetChildren();
+  for (const auto &contact : this->collisionDetector.GetContacts())
+  {
+    auto it1 = children.find(contact.entity1);
+    auto it2 = children.find(contact.entity2);
+    if (it1 == children.end() || it2 == children.end())
+      continue;
+
+    Model *model1 = static_cast<Model *>(it1->second.get());
+    Model *model2 = static_cast<Model *>(it2->second.get());
+    if (model1->IsSleeping() == model2->IsSleeping())
+      continue;
+
+    Model *sleepingModel = model1->IsSleeping() ? model1 : model2;
+    Model *awakeModel = model1->IsSleeping() ? model2 : model1;
+    if (!moved(*awakeModel))
+      continue;
+
+    sleepingModel->SetSleeping(false);
+    this->models.push_back(sleepingModel->GetStorageSlot());
+  }
+}
+
+/////////////////////////////////////////////////
+void World::UpdateWorldBoxes()
+{
+  IGN_PROFILE("tpelib::World::UpdateWorldBoxes");
+
+  auto &storage = this->modelStorage;
+  auto &children = this->GetChildren();
+  AxisAlignedBoxBatch batch;
+  std::size_t batchSlots[AxisAlignedBoxBatch::kCapacity];
+  auto flushBatch = [&]()
+  {
+    transformAxisAlignedBoxes(batch);
+    for (std::size_t i = 0u; i < batch.Size(); ++i)
+    {
+      const math::AxisAlignedBox box = batch.Box(i);
+      storage.aabbMins[batchSlots[i]] = box.Min();
+      storage.aabbMaxs[batchSlots[i]] = box.Max();
+    }
+    batch.Clear();
+  };
+
+  for (std::size_t id : this->changedModels)
+  {
+    auto it = children.find(id);
+    if (it == children.end())
+      continue;
+
+    const std::size_t slot =
+        static_cast<Model *>(it->second.get())->GetStorageSlot();
+    math::AxisAlignedBox box = it->second->GetBoundingBox();
+    if (box == math::AxisAlignedBox())
+    {
+      storage.aabbMins[slot] = box.Min();
+      storage.aabbMaxs[slot] = box.Max();
+      continue;
+    }
+
+    batchSlots[batch.Add(box, math::Pose3d(storage.positions[slot],
+        storage.orientations[slot]))] = slot;
+    if (batch.Full())
+      flushBatch();
+  }
+  flushBatch();
 }
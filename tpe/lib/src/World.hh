@@ -18,6 +18,10 @@
 #ifndef IGNITION_PHYSICS_TPE_LIB_SRC_WORLD_HH_
 #define IGNITION_PHYSICS_TPE_LIB_SRC_WORLD_HH_
 
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
 #include <vector>
 #include <ignition/utilities/SuppressWarning.hh>
 
@@ -25,6 +29,8 @@
 
 #include "CollisionDetector.hh"
 #include "Entity.hh"
+#include "ModelStorage.hh"
+#include "ThreadPool.hh"
 
 namespace ignition {
 namespace physics {
@@ -57,6 +63,61 @@ class IGNITION_PHYSICS_TPELIB_VISIBLE World : public Entity
   /// \return double current timestep of the world
   public: double GetTimeStep() const;
 
+  /// \brief Set the type of broadphase used to find pairs of models whose
+  /// AABBs overlap in collision detection
+  /// \param[in] _type Broadphase type, defaults to BroadphaseType::AABB_TREE
+  public: void SetBroadphaseType(BroadphaseType _type);
+
+  /// \brief Get the type of broadphase used in collision detection
+  /// \return Broadphase type
+  public: BroadphaseType GetBroadphaseType() const;
+
+  /// \brief Set the margin used to enlarge the AABBs of models in collision
+  /// detection. Models that move less than this margin do not need to be
+  /// reinserted into the broadphase.
+  /// \param[in] _margin Margin in meters, 0 to disable
+  public: void SetCollisionMargin(double _margin);
+
+  /// \brief Get the margin used to enlarge the AABBs of models
+  /// \return Margin in meters
+  public: double GetCollisionMargin() const;
+
+  /// \brief Set the scale applied to the displacement of a model in one
+  /// step to further enlarge its AABB in the direction of its velocity.
+  /// \param[in] _scale Displacement scale, 0 to disable
+  public: void SetCollisionDisplacementScale(double _scale);
+
+  /// \brief Get the scale applied to the displacement of a model
+  /// \return Displacement scale
+  public: double GetCollisionDisplacementScale() const;
+
+  /// \brief Set the number of threads used to update the poses of models and
+  /// to find contacts in each step. Models and pairs of models are split into
+  /// contiguous chunks, one per thread, so the results do not depend on the
+  /// number of threads.
+  /// \param[in] _threadCount Number of threads. 1 updates models on the
+  /// calling thread only and 0 uses the number of hardware threads.
+  public: void SetThreadCount(unsigned int _threadCount);
+
+  /// \brief Get the number of threads used in each step
+  /// \return Number of threads
+  public: unsigned int GetThreadCount() const;
+
+  /// \brief Set the number of consecutive steps after which a model that has
+  /// not moved is put to sleep. A model has not moved in a step if it has
+  /// zero velocity and its pose was not set. Sleeping models are skipped when
+  /// updating poses and stay unchanged in collision detection. They are woken
+  /// up when their pose or velocity is set, or when they touch a model that
+  /// is awake.
+  /// \param[in] _steps Number of steps, 0 to disable sleeping and wake up
+  /// all sleeping models
+  public: void SetSleepSteps(unsigned int _steps);
+
+  /// \brief Get the number of steps after which a model that has not moved
+  /// is put to sleep
+  /// \return Number of steps, 0 if sleeping is disabled
+  public: unsigned int GetSleepSteps() const;
+
   /// \brief Step forward at a constant timestep
   public: void Step();
 
@@ -68,6 +129,91 @@ class IGNITION_PHYSICS_TPELIB_VISIBLE World : public Entity
   /// \return Contacts from last step
   public: std::vector<Contact> GetContacts() const;
 
+  /// \brief Get the number of contacts from last step
+  /// \return Number of contacts
+  public: std::size_t GetContactCount() const;
+
+  /// \brief Call a function on each contact from last step without copying
+  /// the contacts. The contacts are stored in a buffer owned by the
+  /// collision detector of the world that is reused in each step.
+  /// \param[in] _visitor Function called on each contact in order
+  public: void VisitContacts(
+      const std::function<void(const Contact &)> &_visitor) const;
+
+  /// \brief Get the changes in contacts in the last step compared to the
+  /// step before it, i.e. the pairs of models that started touching, are
+  /// still touching or stopped touching. Each event has the id of the
+  /// contacts of its pair of models.
+  /// \return Contact events from last step
+  public: std::vector<ContactEvent> GetContactEvents() const;
+
+  /// \brief Get the storage of the state of the models in this world. The
+  /// world AABBs in the storage are those of the last step.
+  /// \return Model storage
+  public: const ModelStorage &GetModelStorage() const;
+
+  /// \brief Save the state of the world into a compact binary buffer: the
+  /// time, the contacts of the last step, the poses of all entities and the
+  /// velocities and sleeping state of the models. Shapes and other
+  /// properties are not saved.
+  /// \param[out] _buffer Buffer to write to. Its previous contents are
+  /// replaced but its capacity is reused.
+  public: void SaveState(std::vector<uint8_t> &_buffer) const;
+
+  /// \brief Restore a state saved by SaveState in place, without creating
+  /// or destroying entities. The world must have the same entities as when
+  /// the state was saved. Models whose state changed are updated in the
+  /// collision detector in the next step, and contact ids and events
+  /// continue from the saved step.
+  /// \param[in] _buffer Buffer written by SaveState
+  /// \return True if the state was restored, false if the buffer does not
+  /// match the entities of the world, in which case the world is unchanged
+  public: bool RestoreState(const std::vector<uint8_t> &_buffer);
+
+  /// \brief Create a copy of this world that can be stepped independently
+  /// of it, e.g. on another thread, to try different changes from the same
+  /// state. The copy has new entity ids, allocated in the same order as the
+  /// ids of this world, with the same names, poses, velocities, sleeping
+  /// state, time and contacts. The collision shapes are shared with this
+  /// world until a shape is set on one of the collisions. The contact ids
+  /// and events of the copy continue from the last step of this world, and
+  /// its collision detector is built in its first step.
+  /// \return Copy of the world
+  public: std::shared_ptr<World> Clone() const;
+
+  // Documentation inherited
+  public: bool RemoveChildById(std::size_t _id) override;
+
+  // Documentation inherited
+  public: bool RemoveChildByName(const std::string &_name) override;
+
+  /// \internal
+  /// \brief Allocate an id for a new entity in this world. Ids are taken
+  /// from blocks of consecutive ids reserved from the process wide counter,
+  /// so entities can be created in different worlds from different threads
+  /// without contention, while ids stay unique across worlds.
+  /// \return New unique id
+  public: std::size_t AllocateId() override;
+
+  /// \internal
+  /// \brief Record that a model changed so that it is updated in the next
+  /// collision check, and wake it up if it is sleeping.
+  /// \param[in] _child Model that changed
+  public: void ChildChanged(Entity &_child) override;
+
+  /// \brief Add a model to the models that changed since the last step,
+  /// unless it is already in them
+  /// \param[in] _model Model that changed
+  private: void QueueChanged(Model &_model);
+
+  /// \brief Put models that have not moved for long enough to sleep, and
+  /// wake up sleeping models that touch models that moved in this step
+  private: void UpdateSleeping();
+
+  /// \brief Update the world AABBs in the model storage of the models that
+  /// changed since the last step
+  private: void UpdateWorldBoxes();
+
   /// \brief World time
   protected: double time{0.0};
 
@@ -77,9 +223,47 @@ class IGNITION_PHYSICS_TPELIB_VISIBLE World : public Entity
   /// \brief Collision detector
   protected: CollisionDetector collisionDetector;
 
+  /// \brief Thread pool used to update the poses of models and to find
+  /// contacts
+  protected: std::shared_ptr<ThreadPool> threadPool;
+
+  /// \brief Next id in the block of ids reserved by this world
+  protected: std::size_t nextChildId{0u};
+
+  /// \brief End of the block of ids reserved by this world
+  protected: std::size_t endChildId{0u};
+
+  /// \brief Storage of the state of the models in this world
+  protected: ModelStorage modelStorage;
+
+  /// \brief True if the models vector needs to be rebuilt
+  protected: bool modelsDirty{true};
+
+  /// \brief True while the poses of models are being updated in parallel.
+  /// Changes to models are then collected per chunk instead of in
+  /// changedModels.
+  protected: bool updatingPoses{false};
+
+  /// \brief Number of steps after which a model that has not moved is put
+  /// to sleep, 0 to disable sleeping
+  protected: unsigned int sleepSteps{10u};
+
   IGN_UTILS_WARN_IGNORE__DLL_INTERFACE_MISSING
-  /// \brief list of contacts
-  protected: std::vector<Contact> contacts;
+  /// \brief Ids of models that were added or changed since the last step,
+  /// each model at most once
+  protected: std::vector<std::size_t> changedModels;
+
+  /// \brief Ids of models that were removed since the last step
+  protected: std::vector<std::size_t> removedModels;
+
+  /// \brief Storage slots of the models that are awake, used to split the
+  /// models into contiguous chunks when updating their poses. Models are in
+  /// the order of their ids when the vector is rebuilt, followed by models in
+  /// the order they were woken up.
+  protected: std::vector<std::size_t> models;
+
+  /// \brief Ids of models that moved in each chunk during the pose update
+  protected: std::vector<std::vector<std::size_t>> chunkMovedModels;
   IGN_UTILS_WARN_RESUME__DLL_INTERFACE_MISSING
 };
 
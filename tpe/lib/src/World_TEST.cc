@@ -17,13 +17,44 @@
 
 #include <gtest/gtest.h>
 
-#include "World.hh"
+#include <algorithm>
+#include <memory>
+#include <random>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Collision.hh"
+#include "EntityPool.hh"
+#include "Link.hh"
 #include "Model.hh"
+#include "Shape.hh"
+#include "World.hh"
 
 using namespace ignition;
 using namespace physics;
 using namespace tpelib;
 
+/////////////////////////////////////////////////
+/// \brief Add a model with a single link and a box collision to a world
+/// \param[in] _world World to add the model to
+/// \param[in] _size Size of the box
+/// \param[in] _pose Pose of the model
+/// \return The new model
+static Model *addBoxModel(World &_world, const math::Vector3d &_size,
+    const math::Pose3d &_pose)
+{
+  BoxShape boxShape;
+  boxShape.SetSize(_size);
+  Model *model = static_cast<Model *>(&_world.AddModel());
+  Link *link = static_cast<Link *>(&model->AddLink());
+  Collision *collision = static_cast<Collision *>(&link->AddCollision());
+  collision->SetShape(boxShape);
+  model->SetPose(_pose);
+  return model;
+}
+
 /////////////////////////////////////////////////
 TEST(World, BasicAPI)
 {
@@ -43,6 +74,22 @@ TEST(World, BasicAPI)
   world.Step();
   EXPECT_NEAR(world.GetTime()-1.1, 0.0, 1e-6);
 
+  EXPECT_EQ(BroadphaseType::AABB_TREE, world.GetBroadphaseType());
+  world.SetBroadphaseType(BroadphaseType::SWEEP_AND_PRUNE);
+  EXPECT_EQ(BroadphaseType::SWEEP_AND_PRUNE, world.GetBroadphaseType());
+
+  EXPECT_DOUBLE_EQ(0.0, world.GetCollisionMargin());
+  world.SetCollisionMargin(0.05);
+  EXPECT_DOUBLE_EQ(0.05, world.GetCollisionMargin());
+
+  EXPECT_DOUBLE_EQ(0.0, world.GetCollisionDisplacementScale());
+  world.SetCollisionDisplacementScale(1.0);
+  EXPECT_DOUBLE_EQ(1.0, world.GetCollisionDisplacementScale());
+
+  EXPECT_EQ(1u, world.GetThreadCount());
+  world.SetThreadCount(4u);
+  EXPECT_EQ(4u, world.GetThreadCount());
+
   World world2;
   EXPECT_NE(world.GetId(), world2.GetId());
 }
@@ -91,3 +138,723 @@ TEST(World, Model)
   Entity nullEnt = world.GetChildById(modelId);
   EXPECT_EQ(Entity::kNullEntity.GetId(), nullEnt.GetId());
 }
+
+/////////////////////////////////////////////////
+TEST(World, UpdatePose)
+{
+  World world;
+  world.SetTimeStep(0.1);
+  const math::Vector3d boxSize(1, 1, 1);
+  Model *model = addBoxModel(world, boxSize, math::Pose3d::Zero);
+  Model *other = addBoxModel(world, boxSize, math::Pose3d(5, 0, 0, 0, 0, 0));
+  world.Step();
+  EXPECT_FALSE(model->PoseDirty());
+  EXPECT_FALSE(model->IsChangeQueued());
+
+  // updating the pose of a model reports the change to its world
+  const math::Vector3d velocity(1, 0, 0);
+  model->UpdatePose(0.1, velocity, math::Vector3d::Zero);
+  EXPECT_TRUE(model->PoseDirty());
+  EXPECT_TRUE(model->IsChangeQueued());
+  EXPECT_EQ(math::Pose3d(0.1, 0, 0, 0, 0, 0), model->GetPose());
+  Entity &link = model->GetCanonicalLink();
+  EXPECT_EQ(math::Pose3d(0.1, 0, 0, 0, 0, 0), link.GetWorldPose());
+  world.Step();
+  EXPECT_FALSE(model->PoseDirty());
+  EXPECT_FALSE(model->IsChangeQueued());
+
+  // a model without velocity does not change
+  model->UpdatePose(0.1, math::Vector3d::Zero, math::Vector3d::Zero);
+  EXPECT_FALSE(model->PoseDirty());
+  EXPECT_FALSE(model->IsChangeQueued());
+
+  // stepping updates the poses through UpdatePose, so moved models are
+  // found in contact
+  model->SetLinearVelocity(math::Vector3d(10, 0, 0));
+  world.Step();
+  EXPECT_EQ(math::Pose3d(1.1, 0, 0, 0, 0, 0), model->GetPose());
+  EXPECT_EQ(math::Pose3d(1.1, 0, 0, 0, 0, 0), link.GetWorldPose());
+  EXPECT_FALSE(model->PoseDirty());
+  EXPECT_TRUE(world.GetContacts().empty());
+  for (unsigned int i = 0u; i < 3u; ++i)
+    world.Step();
+  EXPECT_EQ(math::Pose3d(4.1, 0, 0, 0, 0, 0), model->GetPose());
+  ASSERT_EQ(1u, world.GetContactCount());
+  EXPECT_EQ(std::min(model->GetId(), other->GetId()),
+      world.GetContacts()[0].entity1);
+}
+
+/////////////////////////////////////////////////
+TEST(World, Contacts)
+{
+  World world;
+  world.SetTimeStep(0.1);
+
+  // add two box models
+  const math::Vector3d boxSize(2, 2, 2);
+  Model *model1 = addBoxModel(world, boxSize, math::Pose3d(0, 0, 0, 0, 0, 0));
+  Model *model2 = addBoxModel(world, boxSize, math::Pose3d(1, 0, 0, 0, 0, 0));
+  EXPECT_TRUE(model1->PoseDirty());
+  EXPECT_TRUE(model2->PoseDirty());
+
+  // each model is queued once for the next step however many times it
+  // changed
+  EXPECT_TRUE(model1->IsChangeQueued());
+  EXPECT_TRUE(model2->IsChangeQueued());
+
+  world.Step();
+  EXPECT_EQ(1u, world.GetContacts().size());
+  EXPECT_FALSE(model1->PoseDirty());
+  EXPECT_FALSE(model2->PoseDirty());
+  EXPECT_FALSE(model1->IsChangeQueued());
+  EXPECT_FALSE(model2->IsChangeQueued());
+  std::vector<ContactEvent> events = world.GetContactEvents();
+  ASSERT_EQ(1u, events.size());
+  EXPECT_EQ(ContactEventType::BEGIN, events[0].type);
+  std::size_t contactId = events[0].id;
+
+  // contacts between models at rest are still reported
+  for (unsigned int i = 0u; i < 3u; ++i)
+  {
+    world.Step();
+    ASSERT_EQ(1u, world.GetContacts().size());
+    EXPECT_EQ(contactId, world.GetContacts()[0].id);
+    EXPECT_EQ(1u, world.GetContactCount());
+    std::size_t visited = 0u;
+    world.VisitContacts([&](const Contact &_contact)
+    {
+      EXPECT_EQ(contactId, _contact.id);
+      EXPECT_EQ(world.GetContacts()[0].point, _contact.point);
+      ++visited;
+    });
+    EXPECT_EQ(1u, visited);
+    events = world.GetContactEvents();
+    ASSERT_EQ(1u, events.size());
+    EXPECT_EQ(ContactEventType::PERSIST, events[0].type);
+    EXPECT_EQ(contactId, events[0].id);
+  }
+
+  // move a model away
+  model2->SetPose(math::Pose3d(5, 0, 0, 0, 0, 0));
+  EXPECT_TRUE(model2->PoseDirty());
+  EXPECT_FALSE(model1->PoseDirty());
+  EXPECT_TRUE(model2->IsChangeQueued());
+  EXPECT_FALSE(model1->IsChangeQueued());
+  world.Step();
+  EXPECT_TRUE(world.GetContacts().empty());
+  EXPECT_EQ(0u, world.GetContactCount());
+  events = world.GetContactEvents();
+  ASSERT_EQ(1u, events.size());
+  EXPECT_EQ(ContactEventType::END, events[0].type);
+  EXPECT_EQ(contactId, events[0].id);
+
+  // move it back with a velocity
+  model2->SetLinearVelocity(math::Vector3d(-20, 0, 0));
+  world.Step();
+  EXPECT_TRUE(world.GetContacts().empty());
+  world.Step();
+  ASSERT_EQ(1u, world.GetContacts().size());
+  EXPECT_EQ(math::Vector3d(1, 0, 0), model2->GetPose().Pos());
+  model2->SetLinearVelocity(math::Vector3d::Zero);
+
+  // changing the shape of a model at rest updates its bounding box. Moving
+  // a model does not change its shapes.
+  model2->SetPose(math::Pose3d(1.5, 0, 0, 0, 0, 0));
+  EXPECT_FALSE(model2->ShapesChanged());
+  world.Step();
+  EXPECT_EQ(1u, world.GetContacts().size());
+  world.Step();
+  EXPECT_EQ(1u, world.GetContacts().size());
+  BoxShape smallBoxShape;
+  smallBoxShape.SetSize(math::Vector3d(0.5, 0.5, 0.5));
+  Link &link1 = static_cast<Link &>(model1->GetCanonicalLink());
+  static_cast<Collision &>(link1.GetChildByIndex(0u)).SetShape(
+      smallBoxShape);
+  EXPECT_TRUE(model1->ShapesChanged());
+  world.Step();
+  EXPECT_TRUE(world.GetContacts().empty());
+
+  // changing the pose of a link updates its model's bounding box
+  link1.SetPose(math::Pose3d(1, 0, 0, 0, 0, 0));
+  world.Step();
+  EXPECT_EQ(1u, world.GetContacts().size());
+
+  // remove a model
+  EXPECT_TRUE(world.RemoveChildById(model2->GetId()));
+  world.Step();
+  EXPECT_TRUE(world.GetContacts().empty());
+
+  // add a model and remove it by name
+  Model *model3 = addBoxModel(world, boxSize, math::Pose3d(1, 0, 0, 0, 0, 0));
+  model3->SetName("model_3");
+  world.Step();
+  EXPECT_EQ(1u, world.GetContacts().size());
+  EXPECT_FALSE(world.RemoveChildByName("no_such_model"));
+  EXPECT_TRUE(world.RemoveChildByName("model_3"));
+  world.Step();
+  EXPECT_TRUE(world.GetContacts().empty());
+}
+
+/////////////////////////////////////////////////
+TEST(World, ThreadCount)
+{
+  // worlds stepped with different numbers of threads produce the same
+  // results
+  std::vector<unsigned int> threadCounts = {1u, 2u, 3u, 8u};
+  std::vector<std::unique_ptr<World>> worlds;
+  std::vector<std::vector<Model *>> models(threadCounts.size());
+  const math::Vector3d boxSize(1, 1, 1);
+  for (std::size_t w = 0u; w < threadCounts.size(); ++w)
+  {
+    worlds.emplace_back(new World);
+    worlds[w]->SetThreadCount(threadCounts[w]);
+
+    std::mt19937 rng(1234);
+    std::uniform_real_distribution<double> posDist(-10.0, 10.0);
+    std::uniform_real_distribution<double> velDist(-1.0, 1.0);
+    for (unsigned int i = 0u; i < 500u; ++i)
+    {
+      Model *model = addBoxModel(*worlds[w], boxSize, math::Pose3d(
+          posDist(rng), posDist(rng), posDist(rng), 0, 0, 0));
+      // half of the models are static
+      if (i % 2u == 0u)
+      {
+        model->SetLinearVelocity(
+            math::Vector3d(velDist(rng), velDist(rng), velDist(rng)));
+        model->SetAngularVelocity(
+            math::Vector3d(velDist(rng), velDist(rng), velDist(rng)));
+      }
+      models[w].push_back(model);
+    }
+  }
+
+  for (unsigned int step = 0u; step < 20u; ++step)
+  {
+    for (auto &world : worlds)
+      world->Step();
+
+    const auto contacts = worlds[0]->GetContacts();
+    EXPECT_FALSE(contacts.empty());
+    for (std::size_t w = 1u; w < worlds.size(); ++w)
+    {
+      for (std::size_t i = 0u; i < models[0].size(); ++i)
+      {
+        EXPECT_EQ(models[0][i]->GetPose(), models[w][i]->GetPose());
+        EXPECT_FALSE(models[w][i]->PoseDirty());
+      }
+
+      // model ids differ between worlds so compare contacts by model index
+      const auto otherContacts = worlds[w]->GetContacts();
+      ASSERT_EQ(contacts.size(), otherContacts.size());
+      for (std::size_t c = 0u; c < contacts.size(); ++c)
+      {
+        EXPECT_EQ(contacts[c].entity1 - models[0][0]->GetId(),
+            otherContacts[c].entity1 - models[w][0]->GetId());
+        EXPECT_EQ(contacts[c].entity2 - models[0][0]->GetId(),
+            otherContacts[c].entity2 - models[w][0]->GetId());
+        EXPECT_EQ(contacts[c].point, otherContacts[c].point);
+      }
+    }
+  }
+}
+
+/////////////////////////////////////////////////
+TEST(World, Sleeping)
+{
+  World world;
+  world.SetTimeStep(0.1);
+  EXPECT_EQ(10u, world.GetSleepSteps());
+  world.SetSleepSteps(3u);
+  EXPECT_EQ(3u, world.GetSleepSteps());
+
+  const math::Vector3d boxSize(1, 1, 1);
+  Model *moving = addBoxModel(world, boxSize, math::Pose3d(-10, 0, 0, 0, 0, 0));
+  Model *parked = addBoxModel(world, boxSize, math::Pose3d(0, 0, 0, 0, 0, 0));
+  moving->SetLinearVelocity(math::Vector3d(1, 0, 0));
+
+  // models that do not move fall asleep after the number of sleep steps
+  for (unsigned int i = 0u; i < 2u; ++i)
+  {
+    world.Step();
+    EXPECT_FALSE(parked->IsSleeping());
+  }
+  world.Step();
+  EXPECT_TRUE(parked->IsSleeping());
+  EXPECT_FALSE(moving->IsSleeping());
+
+  // setting the pose wakes a model up
+  parked->SetPose(math::Pose3d(0, 0, 0, 0, 0, 0));
+  EXPECT_FALSE(parked->IsSleeping());
+  for (unsigned int i = 0u; i < 3u; ++i)
+    world.Step();
+  EXPECT_TRUE(parked->IsSleeping());
+
+  // setting the velocity wakes a model up, and a sleeping model does not move
+  parked->SetAngularVelocity(math::Vector3d::Zero);
+  EXPECT_FALSE(parked->IsSleeping());
+  for (unsigned int i = 0u; i < 3u; ++i)
+    world.Step();
+  EXPECT_TRUE(parked->IsSleeping());
+  EXPECT_EQ(math::Pose3d::Zero, parked->GetPose());
+
+  // a model that touches an awake model is woken up
+  while (world.GetContacts().empty())
+  {
+    ASSERT_LT(moving->GetPose().Pos().X(), 0.0);
+    EXPECT_TRUE(parked->IsSleeping());
+    world.Step();
+  }
+  EXPECT_FALSE(parked->IsSleeping());
+  EXPECT_EQ(1u, world.GetContactCount());
+
+  // both models fall asleep once they stop moving and still touch
+  moving->SetLinearVelocity(math::Vector3d::Zero);
+  for (unsigned int i = 0u; i < 3u; ++i)
+    world.Step();
+  EXPECT_TRUE(moving->IsSleeping());
+  for (unsigned int i = 0u; i < 3u; ++i)
+    world.Step();
+  EXPECT_TRUE(parked->IsSleeping());
+  EXPECT_EQ(1u, world.GetContactCount());
+
+  // disabling sleeping wakes up all models
+  world.SetSleepSteps(0u);
+  EXPECT_FALSE(moving->IsSleeping());
+  EXPECT_FALSE(parked->IsSleeping());
+  for (unsigned int i = 0u; i < 5u; ++i)
+    world.Step();
+  EXPECT_FALSE(parked->IsSleeping());
+}
+
+/////////////////////////////////////////////////
+TEST(World, SleepingInContact)
+{
+  // models that touch each other and stop on different steps fall asleep,
+  // also on a ground plane
+  World world;
+  world.SetTimeStep(0.1);
+  world.SetSleepSteps(3u);
+
+  Model *ground = addBoxModel(world, math::Vector3d(100, 100, 1),
+      math::Pose3d(0, 0, -0.5, 0, 0, 0));
+  const math::Vector3d boxSize(1, 1, 1);
+  Model *parked = addBoxModel(world, boxSize, math::Pose3d(0, 0, 0.5, 0, 0, 0));
+  Model *moving =
+      addBoxModel(world, boxSize, math::Pose3d(-3, 0, 0.5, 0, 0, 0));
+  moving->SetLinearVelocity(math::Vector3d(1, 0, 0));
+
+  // drive the moving model into the parked one and stop it one step after
+  // they touch
+  world.Step();
+  while (world.GetContactCount() < 3u)
+  {
+    ASSERT_LT(moving->GetPose().Pos().X(), 0.0);
+    world.Step();
+  }
+  world.Step();
+  moving->SetLinearVelocity(math::Vector3d::Zero);
+
+  for (unsigned int i = 0u; i < 10u; ++i)
+    world.Step();
+  EXPECT_TRUE(ground->IsSleeping());
+  EXPECT_TRUE(parked->IsSleeping());
+  EXPECT_TRUE(moving->IsSleeping());
+  EXPECT_EQ(3u, world.GetContactCount());
+
+  // a model that moves again wakes up the models it touches
+  moving->SetLinearVelocity(math::Vector3d(0, 0.1, 0));
+  world.Step();
+  EXPECT_FALSE(moving->IsSleeping());
+  EXPECT_FALSE(parked->IsSleeping());
+  EXPECT_FALSE(ground->IsSleeping());
+}
+
+/////////////////////////////////////////////////
+TEST(World, SleepingContacts)
+{
+  // contacts in worlds with and without sleeping are the same while models
+  // start and stop moving
+  std::vector<std::unique_ptr<World>> worlds;
+  std::vector<std::vector<Model *>> models(2u);
+  const math::Vector3d boxSize(1, 1, 1);
+  for (std::size_t w = 0u; w < 2u; ++w)
+  {
+    worlds.emplace_back(new World);
+    worlds[w]->SetSleepSteps(w == 0u ? 0u : 2u);
+
+    std::mt19937 rng(4321);
+    std::uniform_real_distribution<double> posDist(-5.0, 5.0);
+    for (unsigned int i = 0u; i < 200u; ++i)
+    {
+      Model *model = addBoxModel(*worlds[w], boxSize, math::Pose3d(
+          posDist(rng), posDist(rng), posDist(rng), 0, 0, 0));
+      models[w].push_back(model);
+    }
+  }
+
+  std::mt19937 rng(8765);
+  std::uniform_real_distribution<double> velDist(-1.0, 1.0);
+  bool slept = false;
+  for (unsigned int step = 0u; step < 40u; ++step)
+  {
+    // start and stop a few models
+    for (std::size_t i = 0u; i < models[0].size(); ++i)
+    {
+      if (rng() % 20u != 0u)
+        continue;
+      math::Vector3d vel = (rng() % 2u == 0u) ? math::Vector3d::Zero :
+          math::Vector3d(velDist(rng), velDist(rng), velDist(rng));
+      for (auto &m : models)
+        m[i]->SetLinearVelocity(vel);
+    }
+
+    for (auto &world : worlds)
+      world->Step();
+
+    for (std::size_t i = 0u; i < models[0].size(); ++i)
+    {
+      EXPECT_EQ(models[0][i]->GetPose(), models[1][i]->GetPose());
+      EXPECT_FALSE(models[0][i]->IsSleeping());
+      slept = slept || models[1][i]->IsSleeping();
+    }
+
+    std::vector<Contact> contacts0 = worlds[0]->GetContacts();
+    std::vector<Contact> contacts1 = worlds[1]->GetContacts();
+    ASSERT_EQ(contacts0.size(), contacts1.size());
+    // entity ids are unique across worlds
+    const std::size_t offset = models[1][0]->GetId() - models[0][0]->GetId();
+    for (std::size_t i = 0u; i < contacts0.size(); ++i)
+    {
+      EXPECT_EQ(contacts0[i].entity1 + offset, contacts1[i].entity1);
+      EXPECT_EQ(contacts0[i].entity2 + offset, contacts1[i].entity2);
+      EXPECT_EQ(contacts0[i].point, contacts1[i].point);
+    }
+  }
+  EXPECT_TRUE(slept);
+}
+
+/////////////////////////////////////////////////
+TEST(World, ModelStorage)
+{
+  World world;
+  world.SetTimeStep(0.1);
+
+  const math::Vector3d boxSize(2, 2, 2);
+
+  Model *model1 = addBoxModel(world, boxSize, math::Pose3d(0, 0, 0, 0, 0, 0));
+  Model *model2 = addBoxModel(world, boxSize, math::Pose3d(5, 0, 0, 0, 0, 0));
+  Model *model3 = addBoxModel(world, boxSize, math::Pose3d(10, 0, 0, 0, 0, 0));
+  model3->SetLinearVelocity(math::Vector3d(1, 0, 0));
+
+  const ModelStorage &storage = world.GetModelStorage();
+  ASSERT_EQ(3u, storage.Size());
+  EXPECT_EQ(model2, storage.models[model2->GetStorageSlot()]);
+
+  // poses are integrated and world AABBs are updated in the storage
+  world.Step();
+  EXPECT_EQ(math::Pose3d(10.1, 0, 0, 0, 0, 0), model3->GetPose());
+  std::size_t slot = model3->GetStorageSlot();
+  EXPECT_EQ(math::Vector3d(9.1, -1, -1), storage.aabbMins[slot]);
+  EXPECT_EQ(math::Vector3d(11.1, 1, 1), storage.aabbMaxs[slot]);
+  slot = model1->GetStorageSlot();
+  EXPECT_EQ(math::Vector3d(-1, -1, -1), storage.aabbMins[slot]);
+  EXPECT_EQ(math::Vector3d(1, 1, 1), storage.aabbMaxs[slot]);
+
+  // removing a model keeps the state of the other models
+  std::size_t id2 = model2->GetId();
+  EXPECT_TRUE(world.RemoveChildById(model1->GetId()));
+  EXPECT_EQ(2u, storage.Size());
+  EXPECT_EQ(math::Pose3d(5, 0, 0, 0, 0, 0), model2->GetPose());
+  EXPECT_EQ(math::Pose3d(10.1, 0, 0, 0, 0, 0), model3->GetPose());
+  EXPECT_EQ(math::Vector3d(1, 0, 0), model3->GetLinearVelocity());
+  EXPECT_EQ(model3, storage.models[model3->GetStorageSlot()]);
+  EXPECT_EQ(id2, storage.ids[model2->GetStorageSlot()]);
+
+  world.Step();
+  EXPECT_EQ(math::Pose3d(10.2, 0, 0, 0, 0, 0), model3->GetPose());
+  EXPECT_EQ(math::Pose3d(5, 0, 0, 0, 0, 0), model2->GetPose());
+}
+
+/////////////////////////////////////////////////
+TEST(World, Ids)
+{
+  // entities are created and stepped in separate worlds on separate threads
+  const std::size_t worldCount = 4u;
+  const std::size_t modelCount = 500u;
+  std::vector<std::unique_ptr<World>> worlds(worldCount);
+  std::vector<std::vector<std::size_t>> ids(worldCount);
+  std::vector<std::thread> threads;
+  for (std::size_t w = 0u; w < worldCount; ++w)
+  {
+    threads.emplace_back([&, w]()
+    {
+      BoxShape boxShape;
+      boxShape.SetSize(math::Vector3d(1, 1, 1));
+      worlds[w] = std::make_unique<World>();
+      for (std::size_t i = 0u; i < modelCount; ++i)
+      {
+        Entity &model = worlds[w]->AddModel();
+        model.SetPose(math::Pose3d(0.75 * i, 0, 0, 0, 0, 0));
+        Entity &link = static_cast<Model &>(model).AddLink();
+        Entity &collision = static_cast<Link &>(link).AddCollision();
+        static_cast<Collision &>(collision).SetShape(boxShape);
+        ids[w].push_back(model.GetId());
+        ids[w].push_back(link.GetId());
+        ids[w].push_back(collision.GetId());
+      }
+      worlds[w]->Step();
+    });
+  }
+  for (auto &thread : threads)
+    thread.join();
+
+  // ids are unique across worlds
+  std::set<std::size_t> allIds;
+  for (std::size_t w = 0u; w < worldCount; ++w)
+  {
+    allIds.insert(worlds[w]->GetId());
+    allIds.insert(ids[w].begin(), ids[w].end());
+    EXPECT_EQ(modelCount - 1u, worlds[w]->GetContactCount());
+  }
+  EXPECT_EQ(worldCount * (3u * modelCount + 1u), allIds.size());
+
+  // entities of a world are found by their ids
+  for (std::size_t i = 0u; i < ids[0].size(); i += 3u)
+    EXPECT_EQ(ids[0][i], worlds[0]->GetChildById(ids[0][i]).GetId());
+}
+
+/////////////////////////////////////////////////
+TEST(World, EntityPool)
+{
+  std::weak_ptr<EntityPool> weakPool;
+  {
+    World world;
+    std::shared_ptr<EntityPool> pool = world.GetEntityPool();
+    ASSERT_NE(nullptr, pool);
+    weakPool = pool;
+    const std::size_t worldBlocks = pool->BlockCount();
+
+    // models, links, collisions and shapes are allocated from the pool of
+    // their world
+    BoxShape boxShape;
+    boxShape.SetSize(math::Vector3d(1, 1, 1));
+    std::vector<std::size_t> ids;
+    for (std::size_t i = 0u; i < 1000u; ++i)
+    {
+      Model &model = static_cast<Model &>(world.AddModel());
+      Link &link = static_cast<Link &>(model.AddLink());
+      Collision &collision = static_cast<Collision &>(link.AddCollision());
+      collision.SetShape(boxShape);
+      EXPECT_EQ(pool, model.GetEntityPool());
+      EXPECT_EQ(pool, link.GetEntityPool());
+      EXPECT_EQ(pool, collision.GetEntityPool());
+      ids.push_back(model.GetId());
+    }
+    const std::size_t blocks = pool->BlockCount();
+    EXPECT_LE(worldBlocks + 7000u, blocks);
+    const std::size_t chunks = pool->ChunkCount();
+    world.Step();
+
+    // removed entities return their blocks, which are reused
+    for (std::size_t i = 0u; i < 500u; ++i)
+      EXPECT_TRUE(world.RemoveChildById(ids[i]));
+    EXPECT_GT(blocks, pool->BlockCount());
+    for (std::size_t i = 0u; i < 500u; ++i)
+    {
+      Model &model = static_cast<Model &>(world.AddModel());
+      Link &link = static_cast<Link &>(model.AddLink());
+      static_cast<Collision &>(link.AddCollision()).SetShape(boxShape);
+    }
+    EXPECT_EQ(blocks, pool->BlockCount());
+    EXPECT_EQ(chunks, pool->ChunkCount());
+
+    // entities outside a world are not pooled
+    Model model;
+    EXPECT_EQ(nullptr, model.GetEntityPool());
+    EXPECT_EQ(nullptr, model.AddLink().GetEntityPool());
+  }
+
+  // the pool is released with the world
+  EXPECT_TRUE(weakPool.expired());
+}
+
+/////////////////////////////////////////////////
+TEST(World, ChildNames)
+{
+  World world;
+  std::vector<Entity *> models;
+  for (std::size_t i = 0u; i < 100u; ++i)
+  {
+    Entity &model = world.AddModel();
+    model.SetName("model_" + std::to_string(i));
+    models.push_back(&model);
+  }
+  for (std::size_t i = 0u; i < 100u; ++i)
+  {
+    EXPECT_EQ(models[i]->GetId(),
+        world.GetChildByName("model_" + std::to_string(i)).GetId());
+  }
+
+  // renamed models are found by their new name only
+  models[10]->SetName("renamed");
+  EXPECT_EQ(models[10]->GetId(), world.GetChildByName("renamed").GetId());
+  EXPECT_EQ(kNullEntityId, world.GetChildByName("model_10").GetId());
+
+  // the model with the lowest id is found first among models with the same
+  // name
+  models[20]->SetName("renamed");
+  EXPECT_EQ(models[10]->GetId(), world.GetChildByName("renamed").GetId());
+  EXPECT_TRUE(world.RemoveChildByName("renamed"));
+  EXPECT_EQ(models[20]->GetId(), world.GetChildByName("renamed").GetId());
+  EXPECT_TRUE(world.RemoveChildById(models[20]->GetId()));
+  EXPECT_EQ(kNullEntityId, world.GetChildByName("renamed").GetId());
+  EXPECT_FALSE(world.RemoveChildByName("renamed"));
+
+  // children of links and models are indexed by their own parent
+  Model &model = static_cast<Model &>(*models[0]);
+  Entity &link = model.AddLink();
+  link.SetName("link");
+  EXPECT_EQ(link.GetId(), model.GetChildByName("link").GetId());
+  EXPECT_EQ(kNullEntityId, world.GetChildByName("link").GetId());
+  EXPECT_EQ(kNullEntityId, models[1]->GetChildByName("link").GetId());
+}
+
+/////////////////////////////////////////////////
+TEST(World, WorldPoses)
+{
+  World world;
+  world.SetSleepSteps(0u);
+  Model &model = static_cast<Model &>(world.AddModel());
+  Link &link = static_cast<Link &>(model.AddLink());
+  Entity &collision = link.AddCollision();
+  link.SetPose(math::Pose3d(0, 1, 0, 0, 0, 0));
+  collision.SetPose(math::Pose3d(0, 0, 1, 0, 0, 0));
+  EXPECT_EQ(math::Pose3d(0, 1, 1, 0, 0, 0), collision.GetWorldPose());
+
+  // setting the pose of an ancestor updates the world poses of its
+  // descendants
+  model.SetPose(math::Pose3d(1, 0, 0, 0, 0, IGN_PI_2));
+  EXPECT_EQ(model.GetPose(), model.GetWorldPose());
+  EXPECT_EQ(model.GetWorldPose() * link.GetPose(), link.GetWorldPose());
+  EXPECT_EQ(link.GetWorldPose() * collision.GetPose(),
+      collision.GetWorldPose());
+  world.SetPose(math::Pose3d(0, 0, 2, 0, 0, 0));
+  EXPECT_EQ(world.GetPose() * model.GetPose() * link.GetPose() *
+      collision.GetPose(), collision.GetWorldPose());
+  world.SetPose(math::Pose3d::Zero);
+
+  // models moved in a step update the world poses of their descendants
+  model.SetPose(math::Pose3d::Zero);
+  EXPECT_EQ(math::Pose3d(0, 1, 1, 0, 0, 0), collision.GetWorldPose());
+  model.SetLinearVelocity(math::Vector3d(1, 0, 0));
+  world.SetTimeStep(0.5);
+  world.Step();
+  EXPECT_EQ(math::Pose3d(0.5, 0, 0, 0, 0, 0), model.GetWorldPose());
+  EXPECT_EQ(math::Pose3d(0.5, 1, 1, 0, 0, 0), collision.GetWorldPose());
+
+  // setting the pose of a child does not change the pose of its parent
+  link.SetPose(math::Pose3d::Zero);
+  EXPECT_EQ(math::Pose3d(0.5, 0, 1, 0, 0, 0), collision.GetWorldPose());
+  EXPECT_EQ(math::Pose3d(0.5, 0, 0, 0, 0, 0), model.GetWorldPose());
+}
+
+/////////////////////////////////////////////////
+TEST(World, SaveRestoreState)
+{
+  World world;
+  world.SetTimeStep(0.1);
+  world.SetSleepSteps(3u);
+  BoxShape boxShape;
+  boxShape.SetSize(math::Vector3d(1, 1, 1));
+  std::vector<Model *> models;
+  for (int i = 0; i < 10; ++i)
+  {
+    Model &model = static_cast<Model &>(world.AddModel());
+    Link &link = static_cast<Link &>(model.AddLink());
+    link.SetPose(math::Pose3d(0, 0, 0.1 * i, 0, 0, 0));
+    static_cast<Collision &>(link.AddCollision()).SetShape(boxShape);
+    model.SetPose(math::Pose3d(0.9 * i, 0, 0, 0, 0, 0));
+    models.push_back(&model);
+  }
+  models[0]->SetLinearVelocity(math::Vector3d(1, 0, 0));
+  models[9]->SetAngularVelocity(math::Vector3d(0, 0, 1));
+  for (int i = 0; i < 5; ++i)
+    world.Step();
+
+  std::vector<uint8_t> state;
+  world.SaveState(state);
+  EXPECT_FALSE(state.empty());
+
+  // step on from the saved state and record the results
+  auto record = [&]()
+  {
+    std::vector<math::Pose3d> poses;
+    for (Model *model : models)
+    {
+      poses.push_back(model->GetWorldPose());
+      poses.push_back(model->GetCanonicalLink().GetWorldPose());
+    }
+    return poses;
+  };
+  auto sameContacts = [](const std::vector<Contact> &_c1,
+      const std::vector<Contact> &_c2)
+  {
+    if (_c1.size() != _c2.size())
+      return false;
+    for (std::size_t i = 0u; i < _c1.size(); ++i)
+    {
+      if (_c1[i].id != _c2[i].id || _c1[i].entity1 != _c2[i].entity1 ||
+          _c1[i].entity2 != _c2[i].entity2 || _c1[i].point != _c2[i].point)
+      {
+        return false;
+      }
+    }
+    return true;
+  };
+  const double savedTime = world.GetTime();
+  const std::vector<Contact> savedContacts = world.GetContacts();
+  const auto savedPoses = record();
+  std::vector<std::vector<math::Pose3d>> poses;
+  std::vector<std::vector<Contact>> contacts;
+  std::vector<std::size_t> eventCounts;
+  for (int i = 0; i < 10; ++i)
+  {
+    world.Step();
+    poses.push_back(record());
+    contacts.push_back(world.GetContacts());
+    eventCounts.push_back(world.GetContactEvents().size());
+  }
+
+  // change the world, restore the saved state and step again
+  models[3]->SetPose(math::Pose3d(100, 0, 0, 0, 0, 0));
+  models[3]->GetCanonicalLink().SetPose(math::Pose3d(0, 5, 0, 0, 0, 0));
+  models[5]->SetLinearVelocity(math::Vector3d(0, 1, 0));
+  world.Step();
+  EXPECT_TRUE(world.RestoreState(state));
+  EXPECT_DOUBLE_EQ(savedTime, world.GetTime());
+  EXPECT_TRUE(sameContacts(savedContacts, world.GetContacts()));
+  EXPECT_EQ(savedPoses, record());
+  for (int i = 0; i < 10; ++i)
+  {
+    world.Step();
+    EXPECT_EQ(poses[i], record());
+    EXPECT_TRUE(sameContacts(contacts[i], world.GetContacts()));
+    EXPECT_EQ(eventCounts[i], world.GetContactEvents().size());
+  }
+
+  // a state does not restore into a world with different models
+  world.AddModel();
+  EXPECT_FALSE(world.RestoreState(state));
+  EXPECT_EQ(11u, world.GetChildCount());
+  World otherWorld;
+  otherWorld.AddModel();
+  EXPECT_FALSE(otherWorld.RestoreState(state));
+
+  // truncated buffers are rejected
+  std::vector<uint8_t> newState;
+  world.SaveState(newState);
+  EXPECT_TRUE(world.RestoreState(newState));
+  newState.resize(newState.size() - 1u);
+  EXPECT_FALSE(world.RestoreState(newState));
+  EXPECT_FALSE(world.RestoreState(std::vector<uint8_t>()));
+}
@@ -23,6 +23,9 @@
 #include <map>
 #include <memory>
 #include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
 
 #include "lib/src/World.hh"
 #include "lib/src/Engine.hh"
@@ -66,50 +69,95 @@ class Base : public Implements3d<FeatureList<Feature>>
     return this->GenerateIdentity(0);
   }
 
+  /// \brief Get the index of an entity among the children of its container
+  /// \param[in] _id Id of the entity
+  /// \return Index of the entity, or -1 if it is not found
   public: inline std::size_t idToIndexInContainer(std::size_t _id) const
   {
-    std::size_t index = 0;
-    auto it = this->childIdToParentId.find(_id);
-    if (it != this->childIdToParentId.end())
-    {
-      for (const auto &pair : this->childIdToParentId)
-      {
-        if (pair.first == _id && pair.second == it->second)
-        {
-          return index;
-        }
-        else if (pair.second == it->second)
-        {
-          ++index;
-        }
-      }
-    }
+    auto it = this->childIdToIndex.find(_id);
+    if (it != this->childIdToIndex.end())
+      return it->second;
+
     // return invalid index if not found in id map
     return -1;
   }
 
+  /// \brief Get the id of a child of a container from its index
+  /// \param[in] _containerId Id of the container, -1 for worlds
+  /// \param[in] _index Index of the child in the container
+  /// \return Id of the child, or -1 if it is not found
   public: inline std::size_t indexInContainerToId(
     const std::size_t _containerId, const std::size_t _index) const
   {
-    std::size_t counter = 0;
-    auto it = this->childIdToParentId.begin();
+    auto it = this->containerToChildIds.find(_containerId);
+    if (it != this->containerToChildIds.end() && _index < it->second.size())
+      return it->second[_index];
 
-    while (counter <= _index && it != this->childIdToParentId.end())
-    {
-      if (it->second == _containerId && counter == _index)
-      {
-        return it->first;
-      }
-      else if (it->second == _containerId)
-      {
-        ++counter;
-      }
-      ++it;
-    }
     // return invalid id if entity not found
     return -1;
   }
 
+  /// \brief Record an entity as the last child of its container
+  /// \param[in] _id Id of the entity
+  /// \param[in] _containerId Id of the container, -1 for worlds
+  public: inline void AddToContainer(std::size_t _id,
+    std::size_t _containerId)
+  {
+    if (!this->childIdToParentId.insert({_id, _containerId}).second)
+      return;
+
+    auto &childIds = this->containerToChildIds[_containerId];
+    this->childIdToIndex[_id] = childIds.size();
+    childIds.push_back(_id);
+  }
+
+  /// \brief Remove an entity from its container in constant time. The last
+  /// child of the container takes the index of the removed entity, so the
+  /// indices of the other children do not change. The descendants of the
+  /// entity, e.g. the links and collisions of a model, are removed from
+  /// all maps.
+  /// \param[in] _id Id of the entity
+  public: inline void RemoveFromContainer(std::size_t _id)
+  {
+    auto parentIt = this->childIdToParentId.find(_id);
+    if (parentIt == this->childIdToParentId.end())
+      return;
+
+    auto indexIt = this->childIdToIndex.find(_id);
+    auto &childIds = this->containerToChildIds[parentIt->second];
+    const std::size_t index = indexIt->second;
+    const std::size_t lastId = childIds.back();
+    childIds[index] = lastId;
+    this->childIdToIndex[lastId] = index;
+    childIds.pop_back();
+
+    this->childIdToIndex.erase(indexIt);
+    this->childIdToParentId.erase(parentIt);
+    this->RemoveDescendants(_id);
+  }
+
+  /// \brief Remove the descendants of an entity from all maps. The whole
+  /// subtree is removed, so the indices of the descendants are not kept
+  /// up to date while removing them.
+  /// \param[in] _id Id of the entity
+  public: inline void RemoveDescendants(std::size_t _id)
+  {
+    auto childIt = this->containerToChildIds.find(_id);
+    if (childIt == this->containerToChildIds.end())
+      return;
+
+    const std::vector<std::size_t> childIds = std::move(childIt->second);
+    this->containerToChildIds.erase(childIt);
+    for (std::size_t childId : childIds)
+    {
+      this->RemoveDescendants(childId);
+      this->childIdToIndex.erase(childId);
+      this->childIdToParentId.erase(childId);
+      this->models.erase(childId);
+      this->links.erase(childId);
+      this->collisions.erase(childId);
+    }
+  }
 
   public: inline Identity AddWorld(std::shared_ptr<tpelib::World> _world)
   {
@@ -117,7 +165,7 @@ class Base : public Implements3d<FeatureList<Feature>>
     auto worldPtr = std::make_shared<WorldInfo>();
     worldPtr->world = _world;
     this->worlds.insert({worldId, worldPtr});
-    this->childIdToParentId.insert({worldId, -1});
+    this->AddToContainer(worldId, -1);
     return this->GenerateIdentity(worldId, worldPtr);
   }
 
@@ -128,7 +176,7 @@ class Base : public Implements3d<FeatureList<Feature>>
     size_t modelId = _model.GetId();
     this->models.insert({modelId, modelPtr});
     // keep track of model's corresponding world
-    this->childIdToParentId.insert({modelId, _worldId});
+    this->AddToContainer(modelId, _worldId);
 
     return this->GenerateIdentity(modelId, modelPtr);
   }
@@ -140,7 +188,7 @@ class Base : public Implements3d<FeatureList<Feature>>
     size_t linkId = _link.GetId();
     this->links.insert({linkId, linkPtr});
     // keep track of link's corresponding model
-    this->childIdToParentId.insert({linkId, _modelId});
+    this->AddToContainer(linkId, _modelId);
 
     return this->GenerateIdentity(linkId, linkPtr);
   }
@@ -153,16 +201,31 @@ class Base : public Implements3d<FeatureList<Feature>>
     size_t collisionId = _collision.GetId();
     this->collisions.insert({collisionId, collisionPtr});
     // keep track of collision's corresponding link
-    this->childIdToParentId.insert({collisionId, _linkId});
+    this->AddToContainer(collisionId, _linkId);
 
     return this->GenerateIdentity(collisionId, collisionPtr);
   }
 
   public: std::map<std::size_t, std::shared_ptr<WorldInfo>> worlds;
-  public: std::map<std::size_t, std::shared_ptr<ModelInfo>> models;
-  public: std::map<std::size_t, std::shared_ptr<LinkInfo>> links;
-  public: std::map<std::size_t, std::shared_ptr<CollisionInfo>> collisions;
-  public: std::map<std::size_t, std::size_t> childIdToParentId;
+  public: std::unordered_map<std::size_t, std::shared_ptr<ModelInfo>>
+      models;
+  public: std::unordered_map<std::size_t, std::shared_ptr<LinkInfo>>
+      links;
+  public: std::unordered_map<std::size_t, std::shared_ptr<CollisionInfo>>
+      collisions;
+  public: std::unordered_map<std::size_t, std::size_t> childIdToParentId;
+
+  /// \brief Ids of the children of each container in the order of their
+  /// indices. Worlds are the children of container -1.
+  public: std::unordered_map<std::size_t, std::vector<std::size_t>>
+      containerToChildIds;
+
+  /// \brief Index of each entity among the children of its container
+  public: std::unordered_map<std::size_t, std::size_t> childIdToIndex;
+
+  /// \brief Engine used to step worlds in parallel. The worlds are owned by
+  /// the maps above, not by the engine.
+  public: tpelib::Engine engine;
 };
 
 }
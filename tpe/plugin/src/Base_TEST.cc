@@ -18,6 +18,7 @@
 #include <gtest/gtest.h>
 
 #include <memory>
+#include <vector>
 
 #include <ignition/physics/Implements.hh>
 
@@ -178,6 +179,77 @@ TEST(BaseClass, AddEntities)
   EXPECT_EQ(cylinderId, base.indexInContainerToId(linkId2, 0u));
 }
 
+TEST(BaseClass, RemoveEntities)
+{
+  tpeplugin::Base base;
+  base.InitiateEngine(0);
+
+  auto world = std::make_shared<tpelib::World>();
+  std::size_t worldId = world->GetId();
+  base.AddWorld(world);
+
+  std::vector<std::size_t> modelIds;
+  for (unsigned int i = 0; i < 4u; ++i)
+  {
+    auto *model = static_cast<tpelib::Model *>(&world->AddModel());
+    base.AddModel(worldId, *model);
+    modelIds.push_back(model->GetId());
+    EXPECT_EQ(i, base.idToIndexInContainer(model->GetId()));
+  }
+
+  // the last model takes the index of the removed model
+  base.RemoveFromContainer(modelIds[1]);
+  EXPECT_EQ(static_cast<std::size_t>(-1),
+      base.idToIndexInContainer(modelIds[1]));
+  EXPECT_TRUE(base.childIdToParentId.find(modelIds[1]) ==
+      base.childIdToParentId.end());
+  EXPECT_EQ(0u, base.idToIndexInContainer(modelIds[0]));
+  EXPECT_EQ(1u, base.idToIndexInContainer(modelIds[3]));
+  EXPECT_EQ(2u, base.idToIndexInContainer(modelIds[2]));
+  EXPECT_EQ(modelIds[3], base.indexInContainerToId(worldId, 1u));
+  EXPECT_EQ(static_cast<std::size_t>(-1),
+      base.indexInContainerToId(worldId, 3u));
+
+  // removing the last model does not move any other model
+  base.RemoveFromContainer(modelIds[2]);
+  EXPECT_EQ(0u, base.idToIndexInContainer(modelIds[0]));
+  EXPECT_EQ(1u, base.idToIndexInContainer(modelIds[3]));
+
+  // removing an entity twice has no effect
+  base.RemoveFromContainer(modelIds[2]);
+  EXPECT_EQ(modelIds[0], base.indexInContainerToId(worldId, 0u));
+  EXPECT_EQ(modelIds[3], base.indexInContainerToId(worldId, 1u));
+
+  // new models are added at the end
+  auto *model = static_cast<tpelib::Model *>(&world->AddModel());
+  base.AddModel(worldId, *model);
+  EXPECT_EQ(2u, base.idToIndexInContainer(model->GetId()));
+  EXPECT_EQ(0u, base.idToIndexInContainer(worldId));
+
+  // the links and collisions of a removed model are removed too
+  auto *link = static_cast<tpelib::Link *>(&model->AddLink());
+  base.AddLink(model->GetId(), *link);
+  auto *collision = static_cast<tpelib::Collision *>(&link->AddCollision());
+  base.AddCollision(link->GetId(), *collision);
+  EXPECT_EQ(link->GetId(), base.indexInContainerToId(model->GetId(), 0u));
+  EXPECT_EQ(collision->GetId(), base.indexInContainerToId(link->GetId(), 0u));
+
+  base.RemoveFromContainer(model->GetId());
+  for (std::size_t id : {model->GetId(), link->GetId(), collision->GetId()})
+  {
+    EXPECT_TRUE(base.childIdToParentId.find(id) ==
+        base.childIdToParentId.end());
+    EXPECT_TRUE(base.childIdToIndex.find(id) == base.childIdToIndex.end());
+    EXPECT_TRUE(base.containerToChildIds.find(id) ==
+        base.containerToChildIds.end());
+  }
+  EXPECT_TRUE(base.links.find(link->GetId()) == base.links.end());
+  EXPECT_TRUE(base.collisions.find(collision->GetId()) ==
+      base.collisions.end());
+  EXPECT_EQ(modelIds[0], base.indexInContainerToId(worldId, 0u));
+  EXPECT_EQ(modelIds[3], base.indexInContainerToId(worldId, 1u));
+}
+
 int main(int argc, char *argv[])
 {
   ::testing::InitGoogleTest(&argc, argv);
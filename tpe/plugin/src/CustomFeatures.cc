@@ -15,7 +15,12 @@
  *
 */
 
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
 #include <ignition/common/Console.hh>
+#include <ignition/common/Profiler.hh>
 
 #include "CustomFeatures.hh"
 
@@ -38,3 +43,57 @@ std::shared_ptr<tpelib::World> CustomFeatures::GetTpeLibWorld(
   }
   return it->second->world;
 }
+
+/////////////////////////////////////////////////
+void CustomFeatures::SetWorldStepThreadCount(const Identity &,
+  unsigned int _threadCount)
+{
+  this->engine.SetThreadCount(_threadCount);
+}
+
+/////////////////////////////////////////////////
+void CustomFeatures::StepWorlds(const Identity &,
+  const std::vector<std::size_t> &_worldIds)
+{
+  IGN_PROFILE("CustomFeatures::StepWorlds");
+
+  // each world is stepped once even if it is listed more than once
+  std::vector<std::size_t> ids = _worldIds;
+  std::sort(ids.begin(), ids.end());
+  ids.erase(std::unique(ids.begin(), ids.end()), ids.end());
+
+  std::vector<tpelib::World *> stepWorlds;
+  stepWorlds.reserve(ids.size());
+  for (std::size_t id : ids)
+  {
+    auto it = this->worlds.find(id);
+    if (it == this->worlds.end())
+    {
+      ignerr << "World with id ["
+        << id
+        << "] not found."
+        << std::endl;
+      continue;
+    }
+    stepWorlds.push_back(it->second->world.get());
+  }
+  this->engine.StepWorlds(stepWorlds);
+}
+
+/////////////////////////////////////////////////
+void CustomFeatures::SaveWorldState(const Identity &_worldID,
+  std::vector<uint8_t> &_buffer) const
+{
+  IGN_PROFILE("CustomFeatures::SaveWorldState");
+  auto worldInfo = this->ReferenceInterface<WorldInfo>(_worldID);
+  worldInfo->world->SaveState(_buffer);
+}
+
+/////////////////////////////////////////////////
+bool CustomFeatures::RestoreWorldState(const Identity &_worldID,
+  const std::vector<uint8_t> &_buffer)
+{
+  IGN_PROFILE("CustomFeatures::RestoreWorldState");
+  auto worldInfo = this->ReferenceInterface<WorldInfo>(_worldID);
+  return worldInfo->world->RestoreState(_buffer);
+}
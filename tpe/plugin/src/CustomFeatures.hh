@@ -18,7 +18,9 @@
 #ifndef IGNITION_PHYSICS_TPE_PLUGIN_SRC_CUSTOMFEATURES_HH
 #define IGNITION_PHYSICS_TPE_PLUGIN_SRC_CUSTOMFEATURES_HH
 
+#include <cstdint>
 #include <memory>
+#include <vector>
 
 #include <ignition/physics/Implements.hh>
 
@@ -30,7 +32,9 @@ namespace physics {
 namespace tpeplugin {
 
 using CustomFeatureList = FeatureList<
-  RetrieveWorld
+  RetrieveWorld,
+  ParallelWorldStep,
+  SaveWorldState
 >;
 
 class CustomFeatures :
@@ -39,6 +43,22 @@ class CustomFeatures :
 {
   public: std::shared_ptr<tpelib::World> GetTpeLibWorld(
     const Identity &_worldID) override;
+
+  // Documentation inherited
+  public: void SetWorldStepThreadCount(const Identity &_engineID,
+    unsigned int _threadCount) override;
+
+  // Documentation inherited
+  public: void StepWorlds(const Identity &_engineID,
+    const std::vector<std::size_t> &_worldIds) override;
+
+  // Documentation inherited
+  public: void SaveWorldState(const Identity &_worldID,
+    std::vector<uint8_t> &_buffer) const override;
+
+  // Documentation inherited
+  public: bool RestoreWorldState(const Identity &_worldID,
+    const std::vector<uint8_t> &_buffer) override;
 };
 
 }
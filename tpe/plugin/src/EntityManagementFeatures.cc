@@ -127,16 +127,10 @@ Identity EntityManagementFeatures::GetModel(
   if (worldInfo != nullptr)
   {
     tpelib::Entity &modelEnt = worldInfo->world->GetChildByName(_modelName);
-    for (auto it = this->models.begin(); it != this->models.end(); ++it)
+    auto it = this->models.find(modelEnt.GetId());
+    if (it != this->models.end() && it->second != nullptr)
     {
-      if (it->second != nullptr)
-      {
-        std::string name = it->second->model->GetName();
-        if (it->first == modelEnt.GetId() && name == modelEnt.GetName())
-        {
-          return this->GenerateIdentity(it->first, it->second);
-        }
-      }
+      return this->GenerateIdentity(it->first, it->second);
     }
   }
   return this->GenerateInvalidId();
@@ -200,16 +194,10 @@ Identity EntityManagementFeatures::GetLink(
   if (modelInfo != nullptr)
   {
     tpelib::Entity &linkEnt = modelInfo->model->GetChildByName(_linkName);
-    for (auto it = this->links.begin(); it != this->links.end(); ++it)
+    auto it = this->links.find(linkEnt.GetId());
+    if (it != this->links.end() && it->second != nullptr)
     {
-      if (it->second != nullptr)
-      {
-        std::string name = it->second->link->GetName();
-        if (it->first == linkEnt.GetId() && name == linkEnt.GetName())
-        {
-          return this->GenerateIdentity(it->first, it->second);
-        }
-      }
+      return this->GenerateIdentity(it->first, it->second);
     }
   }
   return this->GenerateInvalidId();
@@ -273,18 +261,10 @@ Identity EntityManagementFeatures::GetShape(
   if (linkInfo != nullptr)
   {
     tpelib::Entity &shapeEnt = linkInfo->link->GetChildByName(_shapeName);
-    for (auto it = this->collisions.begin();
-         it != this->collisions.end();
-         ++it)
+    auto it = this->collisions.find(shapeEnt.GetId());
+    if (it != this->collisions.end() && it->second != nullptr)
     {
-      if (it->second != nullptr)
-      {
-        std::string name = it->second->collision->GetName();
-        if (it->first == shapeEnt.GetId() && name == shapeEnt.GetName())
-        {
-          return this->GenerateIdentity(it->first, it->second);
-        }
-      }
+      return this->GenerateIdentity(it->first, it->second);
     }
   }
   return this->GenerateInvalidId();
@@ -332,7 +312,7 @@ bool EntityManagementFeatures::RemoveModelByIndex(
     if (this->models.find(modelId) != this->models.end())
     {
       this->models.erase(modelId);
-      this->childIdToParentId.erase(modelId);
+      this->RemoveFromContainer(modelId);
       return worldInfo->world->RemoveChildById(modelId);
     }
   }
@@ -349,7 +329,7 @@ bool EntityManagementFeatures::RemoveModelByName(
     std::size_t modelId =
       worldInfo->world->GetChildByName(_modelName).GetId();
     this->models.erase(modelId);
-    this->childIdToParentId.erase(modelId);
+    this->RemoveFromContainer(modelId);
     return worldInfo->world->RemoveChildById(modelId);
   }
   return false;
@@ -365,7 +345,7 @@ bool EntityManagementFeatures::RemoveModel(const Identity &_modelID)
     if (worldIt != this->worlds.end() && worldIt->second != nullptr)
     {
       this->models.erase(_modelID.id);
-      this->childIdToParentId.erase(_modelID.id);
+      this->RemoveFromContainer(_modelID.id);
       return worldIt->second->world->RemoveChildById(_modelID.id);
     }
   }
@@ -21,6 +21,7 @@
 #include <sdf/Cylinder.hh>
 #include <sdf/Sphere.hh>
 #include <sdf/Geometry.hh>
+#include <sdf/Physics.hh>
 #include <sdf/World.hh>
 #include <ignition/common/Console.hh>
 
@@ -53,6 +54,48 @@ static math::Pose3d ResolveSdfPose(const ::sdf::SemanticPose &_semPose)
   }
   return pose;
 }
+
+/////////////////////////////////////////////////
+/// \brief Read the broadphase type from the custom <tpe:broadphase> element
+/// of the default physics profile of a world, e.g.
+///
+///   <physics name="default" type="tpe">
+///     <tpe:broadphase>uniform_grid</tpe:broadphase>
+///   </physics>
+///
+/// The tpe namespace needs to be declared in the <sdf> element with
+/// xmlns:tpe="...". Valid values are aabb_tree, sweep_and_prune and
+/// uniform_grid.
+/// \param[in] _sdfWorld SDF world
+/// \param[out] _type Broadphase type
+/// \return True if a valid broadphase type was found
+static bool ReadSdfBroadphaseType(const ::sdf::World &_sdfWorld,
+    tpelib::BroadphaseType &_type)
+{
+  const ::sdf::Physics *physics = _sdfWorld.PhysicsDefault();
+  if (!physics || !physics->Element() ||
+      !physics->Element()->HasElement("tpe:broadphase"))
+  {
+    return false;
+  }
+
+  const std::string type =
+      physics->Element()->Get<std::string>("tpe:broadphase");
+  if (type == "aabb_tree")
+    _type = tpelib::BroadphaseType::AABB_TREE;
+  else if (type == "sweep_and_prune")
+    _type = tpelib::BroadphaseType::SWEEP_AND_PRUNE;
+  else if (type == "uniform_grid")
+    _type = tpelib::BroadphaseType::UNIFORM_GRID;
+  else
+  {
+    ignerr << "Unknown broadphase type [" << type << "] in world ["
+           << _sdfWorld.Name() << "]. Valid types are aabb_tree, "
+           << "sweep_and_prune and uniform_grid.\n";
+    return false;
+  }
+  return true;
+}
 }  // namespace
 
 /////////////////////////////////////////////////
@@ -62,6 +105,14 @@ Identity SDFFeatures::ConstructSdfWorld(
 {
   const Identity worldID = this->ConstructEmptyWorld(_engine, _sdfWorld.Name());
 
+  // select the broadphase before models are added
+  tpelib::BroadphaseType broadphaseType;
+  if (ReadSdfBroadphaseType(_sdfWorld, broadphaseType))
+  {
+    auto worldInfo = this->ReferenceInterface<WorldInfo>(worldID);
+    worldInfo->world->SetBroadphaseType(broadphaseType);
+  }
+
   // construct models
   for (std::size_t i = 0; i < _sdfWorld.ModelCount(); ++i)
   {
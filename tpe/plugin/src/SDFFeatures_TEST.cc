@@ -17,7 +17,9 @@
 
 #include <gtest/gtest.h>
 
+#include <cstdint>
 #include <tuple>
+#include <vector>
 
 #include <sdf/Root.hh>
 #include <sdf/World.hh>
@@ -40,6 +42,8 @@
 
 struct TestFeatureList : ignition::physics::FeatureList<
     ignition::physics::tpeplugin::RetrieveWorld,
+    ignition::physics::tpeplugin::ParallelWorldStep,
+    ignition::physics::tpeplugin::SaveWorldState,
     ignition::physics::sdf::ConstructSdfLink,
     ignition::physics::sdf::ConstructSdfModel,
     ignition::physics::sdf::ConstructSdfWorld
@@ -353,6 +357,85 @@ TEST(SDFFeatures_TEST, CheckTpeData)
   }
 }
 
+// Test that the broadphase type is read from the world's physics profile
+TEST(SDFFeatures_TEST, BroadphaseType)
+{
+  World world = LoadWorld(TEST_WORLD_DIR"/grid_broadphase.sdf");
+  auto tpeWorld = world.GetTpeLibWorld();
+  ASSERT_NE(nullptr, tpeWorld);
+  EXPECT_EQ(ignition::physics::tpelib::BroadphaseType::UNIFORM_GRID,
+      tpeWorld->GetBroadphaseType());
+  EXPECT_EQ(2u, tpeWorld->GetChildCount());
+
+  // worlds without a broadphase type use the default
+  World defaultWorld = LoadWorld(TEST_WORLD_DIR"/test.world");
+  auto defaultTpeWorld = defaultWorld.GetTpeLibWorld();
+  ASSERT_NE(nullptr, defaultTpeWorld);
+  EXPECT_EQ(ignition::physics::tpelib::BroadphaseType::AABB_TREE,
+      defaultTpeWorld->GetBroadphaseType());
+}
+
+// Test stepping several worlds of an engine in parallel
+TEST(SDFFeatures_TEST, StepWorlds)
+{
+  auto engine = LoadEngine();
+  ASSERT_NE(nullptr, engine);
+  engine->SetWorldStepThreadCount(4u);
+
+  sdf::Root root;
+  const sdf::Errors &errors = root.Load(TEST_WORLD_DIR"/test.world");
+  EXPECT_EQ(0u, errors.size());
+  const sdf::World *sdfWorld = root.WorldByIndex(0);
+  ASSERT_NE(nullptr, sdfWorld);
+
+  std::vector<WorldPtr> worlds;
+  for (std::size_t i = 0u; i < 4u; ++i)
+  {
+    worlds.push_back(engine->ConstructWorld(*sdfWorld));
+    ASSERT_NE(nullptr, worlds.back());
+  }
+
+  // a world listed twice is stepped once
+  engine->StepWorlds({worlds[0]->EntityID(), worlds[2]->EntityID(),
+      worlds[3]->EntityID(), worlds[0]->EntityID()});
+  for (std::size_t i = 0u; i < worlds.size(); ++i)
+  {
+    auto tpeWorld = worlds[i]->GetTpeLibWorld();
+    ASSERT_NE(nullptr, tpeWorld);
+    const double steps = i == 1u ? 0.0 : 1.0;
+    EXPECT_DOUBLE_EQ(steps * tpeWorld->GetTimeStep(), tpeWorld->GetTime());
+  }
+}
+
+// Test saving and restoring the state of a world
+TEST(SDFFeatures_TEST, SaveWorldState)
+{
+  World world = LoadWorld(TEST_WORLD_DIR"/test.world");
+  auto tpeWorld = world.GetTpeLibWorld();
+  ASSERT_NE(nullptr, tpeWorld);
+  tpeWorld->Step();
+
+  std::vector<uint8_t> state;
+  world.SaveState(state);
+  EXPECT_FALSE(state.empty());
+  const double time = tpeWorld->GetTime();
+
+  ignition::physics::tpelib::Entity &modelEnt =
+      tpeWorld->GetChildByIndex(0u);
+  const ignition::math::Pose3d pose = modelEnt.GetPose();
+  modelEnt.SetPose(ignition::math::Pose3d(
+      pose.Pos() + ignition::math::Vector3d(1, 2, 3), pose.Rot()));
+  tpeWorld->Step();
+
+  EXPECT_TRUE(world.RestoreState(state));
+  EXPECT_DOUBLE_EQ(time, tpeWorld->GetTime());
+  EXPECT_EQ(pose, modelEnt.GetPose());
+
+  // a state does not restore into a different world
+  World otherWorld = LoadWorld(TEST_WORLD_DIR"/shapes.world");
+  EXPECT_FALSE(otherWorld.RestoreState(state));
+}
+
 int main(int argc, char *argv[])
 {
   ::testing::InitGoogleTest(&argc, argv);
@@ -33,7 +33,7 @@ Identity ShapeFeatures::CastToBoxShape(const Identity &_shapeID) const
   if (it != this->collisions.end() && it->second != nullptr)
   {
     auto *shape = it->second->collision->GetShape();
-    if (shape != nullptr && dynamic_cast<tpelib::BoxShape*>(shape))
+    if (shape != nullptr && dynamic_cast<const tpelib::BoxShape*>(shape))
       return this->GenerateIdentity(_shapeID, it->second);
   }
   return this->GenerateInvalidId();
@@ -50,7 +50,7 @@ LinearVector3d ShapeFeatures::GetBoxShapeSize(
     auto *shape = it->second->collision->GetShape();
     if (shape != nullptr)
     {
-      tpelib::BoxShape *box = static_cast<tpelib::BoxShape*>(shape);
+      auto *box = static_cast<const tpelib::BoxShape*>(shape);
       return math::eigen3::convert(box->GetSize());
     }
   }
@@ -89,7 +89,7 @@ Identity ShapeFeatures::CastToCylinderShape(const Identity &_shapeID) const
   if (it != this->collisions.end() && it->second != nullptr)
   {
     auto *shape = it->second->collision->GetShape();
-    if (shape != nullptr && dynamic_cast<tpelib::CylinderShape*>(shape))
+    if (shape != nullptr && dynamic_cast<const tpelib::CylinderShape*>(shape))
       return this->GenerateIdentity(_shapeID, it->second);
   }
   return this->GenerateInvalidId();
@@ -106,7 +106,7 @@ double ShapeFeatures::GetCylinderShapeRadius(
     auto *shape = it->second->collision->GetShape();
     if (shape != nullptr)
     {
-      auto *cylinder = static_cast<tpelib::CylinderShape*>(shape);
+      auto *cylinder = static_cast<const tpelib::CylinderShape*>(shape);
       return cylinder->GetRadius();
     }
   }
@@ -125,7 +125,7 @@ double ShapeFeatures::GetCylinderShapeHeight(
     auto *shape = it->second->collision->GetShape();
     if (shape != nullptr)
     {
-      auto *cylinder = static_cast<tpelib::CylinderShape*>(shape);
+      auto *cylinder = static_cast<const tpelib::CylinderShape*>(shape);
       return cylinder->GetLength();
     }
   }
@@ -167,7 +167,7 @@ Identity ShapeFeatures::CastToSphereShape(
   if (it != this->collisions.end() && it->second != nullptr)
   {
     auto *shape = it->second->collision->GetShape();
-    if (shape != nullptr && dynamic_cast<tpelib::SphereShape*>(shape))
+    if (shape != nullptr && dynamic_cast<const tpelib::SphereShape*>(shape))
       return this->GenerateIdentity(_shapeID, it->second);
   }
   return this->GenerateInvalidId();
@@ -182,7 +182,7 @@ double ShapeFeatures::GetSphereShapeRadius(const Identity &_sphereID) const
     auto *shape = it->second->collision->GetShape();
     if (shape != nullptr)
     {
-      auto *sphere = static_cast<tpelib::SphereShape*>(shape);
+      auto *sphere = static_cast<const tpelib::SphereShape*>(shape);
       return sphere->GetRadius();
     }
   }
@@ -222,7 +222,7 @@ Identity ShapeFeatures::CastToMeshShape(
   if (it != this->collisions.end() && it->second != nullptr)
   {
     auto *shape = it->second->collision->GetShape();
-    if (shape != nullptr && dynamic_cast<tpelib::MeshShape*>(shape))
+    if (shape != nullptr && dynamic_cast<const tpelib::MeshShape*>(shape))
       return this->GenerateIdentity(_shapeID, it->second);
   }
   return this->GenerateInvalidId();
@@ -238,7 +238,7 @@ LinearVector3d ShapeFeatures::GetMeshShapeSize(
     auto *shape = it->second->collision->GetShape();
     if (shape != nullptr)
     {
-      auto *mesh = static_cast<tpelib::MeshShape*>(shape);
+      auto *mesh = static_cast<const tpelib::MeshShape*>(shape);
       return math::eigen3::convert(mesh->GetBoundingBox().Size());
     }
   }
@@ -256,7 +256,7 @@ LinearVector3d ShapeFeatures::GetMeshShapeScale(
     auto *shape = it->second->collision->GetShape();
     if (shape != nullptr)
     {
-      auto *mesh = static_cast<tpelib::MeshShape*>(shape);
+      auto *mesh = static_cast<const tpelib::MeshShape*>(shape);
       return math::eigen3::convert(mesh->GetScale());
     }
   }
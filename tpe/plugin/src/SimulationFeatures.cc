@@ -65,24 +65,36 @@ SimulationFeatures::GetContactsFromLastStep(const Identity &_worldID) const
 {
   IGN_PROFILE("SimulationFeatures::GetContactFromLastStep");
   std::vector<SimulationFeatures::ContactInternal> outContacts;
-  auto const world = this->ReferenceInterface<WorldInfo>(_worldID)->world;
-  const auto contacts = world->GetContacts();
+  const auto &world = this->ReferenceInterface<WorldInfo>(_worldID)->world;
+  outContacts.reserve(world->GetContactCount());
 
-  for (const auto &c : contacts)
+  // visit the contacts in the world's buffer instead of copying them
+  world->VisitContacts([&](const tpelib::Contact &_c)
   {
     CompositeData extraData;
 
-    // Contact expects identity to be associated with shapes not models
-    // but tpe computes collisions between models
-    // Workaround is to return the first shape of a model
-    auto s1 = this->GetModelCollision(c.entity1);
-    auto s2 = this->GetModelCollision(c.entity2);
+    // Add normal and depth to extraData. tpe does not compute contact forces.
+    // The normal of the force acting on the first body points from the
+    // second body to the first one.
+    auto &extraContactData = extraData.Get<ExtraContactData>();
+    extraContactData.force = Eigen::Vector3d::Zero();
+    extraContactData.normal = math::eigen3::convert(-_c.normal);
+    extraContactData.depth = _c.depth;
+
+    // Contacts are associated with the collisions whose shapes intersect.
+    // Contacts between models without supported collision shapes are found
+    // from the models' bounding boxes, in which case the first shape of each
+    // model is returned.
+    std::size_t s1 = _c.collision1 != tpelib::kNullEntityId ?
+        _c.collision1 : this->GetModelCollision(_c.entity1).GetId();
+    std::size_t s2 = _c.collision2 != tpelib::kNullEntityId ?
+        _c.collision2 : this->GetModelCollision(_c.entity2).GetId();
 
     outContacts.push_back(
-        {this->GenerateIdentity(s1.GetId(), this->collisions.at(s1.GetId())),
-         this->GenerateIdentity(s2.GetId(), this->collisions.at(s2.GetId())),
-         math::eigen3::convert(c.point), extraData});
-  }
+        {this->GenerateIdentity(s1, this->collisions.at(s1)),
+         this->GenerateIdentity(s2, this->collisions.at(s2)),
+         math::eigen3::convert(_c.point), extraData});
+  });
 
   return outContacts;
 }
@@ -17,6 +17,8 @@
 
 #include <gtest/gtest.h>
 
+#include <cmath>
+
 #include <ignition/common/Console.hh>
 #include <ignition/math/Vector3.hh>
 #include <ignition/math/eigen3/Conversions.hh>
@@ -53,6 +55,8 @@ struct TestFeatureList : ignition::physics::FeatureList<
 using TestWorldPtr = ignition::physics::World3dPtr<TestFeatureList>;
 using TestShapePtr = ignition::physics::Shape3dPtr<TestFeatureList>;
 using ContactPoint = ignition::physics::World3d<TestFeatureList>::ContactPoint;
+using ExtraContactData =
+    ignition::physics::World3d<TestFeatureList>::ExtraContactData;
 
 std::unordered_set<TestWorldPtr> LoadWorlds(
     const std::string &_library,
@@ -323,17 +327,34 @@ TEST_P(SimulationFeatures_TEST, RetrieveContacts)
           (m1->GetName() == "box" && m2->GetName() == "sphere"))
       {
         contactBoxSphere++;
-        Eigen::Vector3d expectedContactPos = Eigen::Vector3d(0, 1.5, 0.5);
+        // the center of the sphere is inside the box so the sphere is pushed
+        // out through the top face of the box, and the contact point is half
+        // way between the top face and the bottom of the sphere
+        Eigen::Vector3d expectedContactPos = Eigen::Vector3d(0, 1.5, 0.25);
         EXPECT_TRUE(ignition::physics::test::Equal(expectedContactPos,
             contactPoint.point, 1e-6));
+
+        const auto *extraContactData = contact.Query<ExtraContactData>();
+        ASSERT_NE(nullptr, extraContactData);
+        EXPECT_NEAR(1.5, extraContactData->depth, 1e-6);
+        EXPECT_NEAR(0.0, extraContactData->normal[0], 1e-6);
+        EXPECT_NEAR(0.0, extraContactData->normal[1], 1e-6);
+        EXPECT_NEAR(1.0, std::abs(extraContactData->normal[2]), 1e-6);
       }
       else if ((m1->GetName() == "box" && m2->GetName() == "cylinder") ||
           (m1->GetName() == "cylinder" && m2->GetName() == "box"))
       {
         contactBoxCylinder++;
-        Eigen::Vector3d expectedContactPos = Eigen::Vector3d(0, -1.5, 0.5);
-        EXPECT_TRUE(ignition::physics::test::Equal(expectedContactPos,
-            contactPoint.point, 1e-6));
+        // the contact point is below the cylinder and inside the box
+        Eigen::Vector3d cylinderPos = Eigen::Vector3d(0, -1.5, 0.5);
+        EXPECT_GE(0.5, (contactPoint.point - cylinderPos).head<2>().norm());
+        EXPECT_LE(0.0, contactPoint.point.z());
+        EXPECT_GE(1.0, contactPoint.point.z());
+
+        const auto *extraContactData = contact.Query<ExtraContactData>();
+        ASSERT_NE(nullptr, extraContactData);
+        EXPECT_NEAR(1.05, extraContactData->depth, 1e-3);
+        EXPECT_NEAR(1.0, std::abs(extraContactData->normal[2]), 1e-3);
       }
       else
       {
@@ -373,9 +394,8 @@ TEST_P(SimulationFeatures_TEST, RetrieveContacts)
       else
         FAIL() << "There should only be contacts between box and cylinder";
 
-      Eigen::Vector3d expectedContactPos = Eigen::Vector3d(0, -1.5, 0.5);
-      EXPECT_TRUE(ignition::physics::test::Equal(expectedContactPos,
-          contactPoint.point, 1e-6));
+      Eigen::Vector3d cylinderPos = Eigen::Vector3d(0, -1.5, 0.5);
+      EXPECT_GE(0.5, (contactPoint.point - cylinderPos).head<2>().norm());
     }
     EXPECT_EQ(1u, contactBoxCylinder);
 
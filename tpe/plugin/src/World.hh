@@ -18,7 +18,10 @@
 #ifndef IGNITION_PHYSICS_TPE_PLUGIN_SRC_WORLD_HH_
 #define IGNITION_PHYSICS_TPE_PLUGIN_SRC_WORLD_HH_
 
+#include <cstddef>
+#include <cstdint>
 #include <memory>
+#include <vector>
 
 #include <ignition/physics/FeatureList.hh>
 
@@ -55,6 +58,105 @@ std::shared_ptr<tpelib::World> RetrieveWorld::World<PolicyT, FeaturesT>
       ->GetTpeLibWorld(this->identity);
 }
 
+/////////////////////////////////////////////////
+/// \brief Step several worlds of an engine in parallel
+class ParallelWorldStep : public virtual Feature
+{
+  public: template <typename PolicyT, typename FeaturesT>
+  class Engine : public virtual Feature::Engine<PolicyT, FeaturesT>
+  {
+    /// \brief Set the number of threads used to step worlds in parallel
+    /// \param[in] _threadCount Number of threads. 1 steps worlds on the
+    /// calling thread only and 0 uses the number of hardware threads.
+    public: void SetWorldStepThreadCount(unsigned int _threadCount);
+
+    /// \brief Step a set of worlds once with their current time steps, in
+    /// parallel. Threads take the next world that has not been started, so
+    /// worlds of different sizes keep all threads busy. This returns once
+    /// all worlds are stepped.
+    /// \param[in] _worldIds Entity ids of the worlds to step
+    public: void StepWorlds(const std::vector<std::size_t> &_worldIds);
+  };
+
+  public: template <typename PolicyT>
+  class Implementation : public virtual Feature::Implementation<PolicyT>
+  {
+    public: virtual void SetWorldStepThreadCount(
+        const Identity &_engineID, unsigned int _threadCount) = 0;
+
+    public: virtual void StepWorlds(const Identity &_engineID,
+        const std::vector<std::size_t> &_worldIds) = 0;
+  };
+};
+
+/////////////////////////////////////////////////
+template <typename PolicyT, typename FeaturesT>
+void ParallelWorldStep::Engine<PolicyT, FeaturesT>::SetWorldStepThreadCount(
+    unsigned int _threadCount)
+{
+  this->template Interface<ParallelWorldStep>()
+      ->SetWorldStepThreadCount(this->identity, _threadCount);
+}
+
+/////////////////////////////////////////////////
+template <typename PolicyT, typename FeaturesT>
+void ParallelWorldStep::Engine<PolicyT, FeaturesT>::StepWorlds(
+    const std::vector<std::size_t> &_worldIds)
+{
+  this->template Interface<ParallelWorldStep>()
+      ->StepWorlds(this->identity, _worldIds);
+}
+
+/////////////////////////////////////////////////
+/// \brief Save the state of a world into a compact binary buffer and
+/// restore it later, e.g. to run several rollouts from the same state
+/// without constructing the world again
+class SaveWorldState : public virtual Feature
+{
+  public: template <typename PolicyT, typename FeaturesT>
+  class World : public virtual Feature::World<PolicyT, FeaturesT>
+  {
+    /// \brief Save the time, contacts, poses and velocities of the world
+    /// \param[out] _buffer Buffer to write to. Its capacity is reused.
+    public: void SaveState(std::vector<uint8_t> &_buffer) const;
+
+    /// \brief Restore a state saved from this world in place. No entities
+    /// are created or destroyed.
+    /// \param[in] _buffer Buffer written by SaveState
+    /// \return True if the state was restored, false if the buffer does not
+    /// match the entities of the world
+    public: bool RestoreState(const std::vector<uint8_t> &_buffer);
+  };
+
+  public: template <typename PolicyT>
+  class Implementation : public virtual Feature::Implementation<PolicyT>
+  {
+    public: virtual void SaveWorldState(const Identity &_worldID,
+        std::vector<uint8_t> &_buffer) const = 0;
+
+    public: virtual bool RestoreWorldState(const Identity &_worldID,
+        const std::vector<uint8_t> &_buffer) = 0;
+  };
+};
+
+/////////////////////////////////////////////////
+template <typename PolicyT, typename FeaturesT>
+void SaveWorldState::World<PolicyT, FeaturesT>::SaveState(
+    std::vector<uint8_t> &_buffer) const
+{
+  this->template Interface<SaveWorldState>()
+      ->SaveWorldState(this->identity, _buffer);
+}
+
+/////////////////////////////////////////////////
+template <typename PolicyT, typename FeaturesT>
+bool SaveWorldState::World<PolicyT, FeaturesT>::RestoreState(
+    const std::vector<uint8_t> &_buffer)
+{
+  return this->template Interface<SaveWorldState>()
+      ->RestoreWorldState(this->identity, _buffer);
+}
+
 }
 }
 }